@@ -17,14 +17,30 @@
 #ifndef OTTER_ALLOCATOR_H_
 #define OTTER_ALLOCATOR_H_
 #include "inc.h"
+#include <stdalign.h>
+#include <stdbool.h>
 #include <stddef.h>
 
+#define OTTER_CACHE_LINE_SIZE 64
+
+typedef enum otter_allocator_capability {
+  /* The allocator may be used from several threads at once */
+  OTTER_ALLOCATOR_THREAD_SAFE = 1 << 0,
+} otter_allocator_capability;
+
 typedef struct otter_allocator otter_allocator;
 typedef struct otter_allocator_vtable {
   void (*free_allocator)(otter_allocator *);
   void *(*malloc)(otter_allocator *, size_t size);
   void *(*realloc)(otter_allocator *, void *ptr, size_t size);
   void (*free)(otter_allocator *, void *);
+  /* Optional.  Without it only fundamental alignments can be requested */
+  void *(*aligned_malloc)(otter_allocator *, size_t alignment, size_t size);
+  /* Optional.  Frees memory whose requested size the caller still knows,
+   * which lets size-class allocators skip looking the size up */
+  void (*free_sized)(otter_allocator *, void *ptr, size_t size);
+  /* Bitwise or of otter_allocator_capability, zero unless stated */
+  unsigned int capabilities;
 } otter_allocator_vtable;
 
 typedef struct otter_allocator {
@@ -37,16 +53,52 @@ static inline void otter_allocator_free(otter_allocator *allocator) {
 }
 
 OTTER_DECLARE_TRIVIAL_CLEANUP_FUNC(otter_allocator *, otter_allocator_free);
-static inline void *otter_realloc(otter_allocator *allocator, void *pointer,
-                                  size_t size) {
+static inline bool otter_allocator_thread_safe(otter_allocator *allocator) {
+  return (allocator->vtable->capabilities & OTTER_ALLOCATOR_THREAD_SAFE) != 0;
+}
+
+/* The wrappers are always inlined so that __builtin_return_address in an
+ * allocator implementation identifies the real call site */
+__attribute__((always_inline)) static inline void *
+otter_realloc(otter_allocator *allocator, void *pointer, size_t size) {
   return allocator->vtable->realloc(allocator, pointer, size);
 }
 
-static inline void *otter_malloc(otter_allocator *allocator, size_t size) {
+__attribute__((always_inline)) static inline void *
+otter_malloc(otter_allocator *allocator, size_t size) {
   return allocator->vtable->malloc(allocator, size);
 }
 
-static inline void otter_free(otter_allocator *allocator, void *pointer) {
+__attribute__((always_inline)) static inline void
+otter_free(otter_allocator *allocator, void *pointer) {
+  allocator->vtable->free(allocator, pointer);
+}
+
+/* Alignment has to be a power of two.  The memory is released with otter_free
+ * or otter_free_sized like any other allocation. */
+__attribute__((always_inline)) static inline void *
+otter_aligned_malloc(otter_allocator *allocator, size_t alignment,
+                     size_t size) {
+  if (allocator->vtable->aligned_malloc != NULL) {
+    return allocator->vtable->aligned_malloc(allocator, alignment, size);
+  }
+
+  if (alignment > alignof(max_align_t) || (alignment & (alignment - 1)) != 0) {
+    return NULL;
+  }
+
+  return allocator->vtable->malloc(allocator, size);
+}
+
+/* Size must be the size last passed to otter_malloc, otter_realloc or
+ * otter_aligned_malloc for pointer */
+__attribute__((always_inline)) static inline void
+otter_free_sized(otter_allocator *allocator, void *pointer, size_t size) {
+  if (allocator->vtable->free_sized != NULL) {
+    allocator->vtable->free_sized(allocator, pointer, size);
+    return;
+  }
+
   allocator->vtable->free(allocator, pointer);
 }
 #endif /* OTTER_ALLOCATOR_H_ */
@@ -0,0 +1,46 @@
+/*
+  otter Copyright (C) 2026 Nathaniel Wright
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef OTTER_ALLOCATOR_STATS_H_
+#define OTTER_ALLOCATOR_STATS_H_
+#include "allocator.h"
+#include <stdio.h>
+
+typedef struct otter_allocator_stats {
+  size_t allocations;
+  size_t reallocations;
+  size_t frees;
+  size_t bytes_allocated;
+  size_t live_allocations;
+  size_t live_bytes;
+  size_t peak_live_bytes;
+  /* otter_free_sized calls whose size differed from the allocation */
+  size_t size_mismatches;
+} otter_allocator_stats;
+
+/* Wraps parent and records how much is allocated and from where.  Call sites
+ * are the return addresses of the otter_malloc/otter_realloc wrappers, so
+ * each one is a line in the caller.  When report is not NULL,
+ * otter_allocator_free writes the totals and every call site that still owns
+ * memory to it before releasing the wrapper. */
+otter_allocator *otter_allocator_stats_create(otter_allocator *parent,
+                                              FILE *report);
+void otter_allocator_stats_get(otter_allocator *allocator,
+                               otter_allocator_stats *stats);
+/* Writes the totals and the call sites with live allocations to file */
+void otter_allocator_stats_report(otter_allocator *allocator, FILE *file);
+
+#endif /* OTTER_ALLOCATOR_STATS_H_ */
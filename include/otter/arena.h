@@ -0,0 +1,45 @@
+/*
+  otter Copyright (C) 2026 Nathaniel Wright
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef OTTER_ARENA_H_
+#define OTTER_ARENA_H_
+#include "allocator.h"
+#include "inc.h"
+#include <stddef.h>
+
+#define OTTER_ARENA_DEFAULT_CHUNK_SIZE ((size_t)64 * 1024)
+
+/* Position in an arena returned by otter_arena_mark.  Rewinding to it frees
+ * everything allocated after the mark in one call. */
+typedef struct otter_arena_mark {
+  void *chunk;
+  size_t used;
+} otter_arena_mark;
+
+/* Bump allocator for allocations that share a lifetime.  Memory is taken from
+ * parent in chunks of chunk_size bytes (larger requests get their own chunk),
+ * otter_free is a no-op and otter_allocator_free releases every chunk.  The
+ * returned allocator is not thread safe. */
+otter_allocator *otter_arena_create(otter_allocator *parent,
+                                    size_t chunk_size);
+otter_arena_mark otter_arena_mark_get(otter_allocator *arena);
+void otter_arena_rewind(otter_allocator *arena, otter_arena_mark mark);
+/* Frees everything allocated from the arena while keeping it usable */
+void otter_arena_reset(otter_allocator *arena);
+/* Bytes currently handed out, including per-allocation headers */
+size_t otter_arena_used(otter_allocator *arena);
+
+#endif /* OTTER_ARENA_H_ */
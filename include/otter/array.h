@@ -22,6 +22,7 @@
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define OTTER_ARRAY_LENGTH(arr, field) (arr)->field##_length
 #define OTTER_ARRAY_CAPACITY(arr, field) (arr)->field##_capacity
@@ -42,28 +43,100 @@
   })
 
 #define OTTER_ARRAY_DECLARE(type, field)                                       \
+  OTTER_SMALL_ARRAY_DECLARE(type, field, 0)
+
+/* An array whose first inline_capacity items live in the struct itself, the
+ * heap is only used once it outgrows them.  field points into the struct
+ * while the items are inline, so the struct must not be copied or moved. */
+#define OTTER_SMALL_ARRAY_DECLARE(type, field, inline_capacity)                \
   size_t field##_length;                                                       \
   size_t field##_capacity;                                                     \
   /* NOLINTBEGIN(bugprone-macro-parentheses) */                                \
-  type *field /* NOLINTEND(bugprone-macro-parentheses) */
+  type *field;                                                                 \
+  type field##_inline[inline_capacity]                                         \
+  /* NOLINTEND(bugprone-macro-parentheses) */
+
+#define OTTER_ARRAY_INLINE_CAPACITY(arr, field)                                \
+  (sizeof((arr)->field##_inline) / sizeof(*(arr)->field))
+/* NULL for arrays without inline storage */
+#define OTTER_ARRAY_INLINE_ITEMS(arr, field)                                   \
+  (OTTER_ARRAY_INLINE_CAPACITY(arr, field) > 0                                 \
+       ? (void *)(arr)->field##_inline                                         \
+       : NULL)
 
+/* Arrays start out empty and without an allocation, the first append past
+ * the inline items allocates OTTER_ARRAY_INITIAL_CAPACITY items.  allocator is
+ * unused and only kept so every OTTER_ARRAY_* call names its allocator. */
+#define OTTER_ARRAY_INITIAL_CAPACITY 5
 #define OTTER_ARRAY_INIT(arr, field, allocator)                                \
   do {                                                                         \
+    (void)(allocator);                                                         \
     OTTER_ARRAY_LENGTH(arr, field) = 0;                                        \
-    OTTER_ARRAY_CAPACITY(arr, field) = 5;                                      \
-    (arr)->field = otter_malloc(                                               \
-        allocator, sizeof(*(arr)->field) * OTTER_ARRAY_CAPACITY(arr, field));  \
+    OTTER_ARRAY_CAPACITY(arr, field) =                                         \
+        OTTER_ARRAY_INLINE_CAPACITY(arr, field);                               \
+    (arr)->field = OTTER_ARRAY_INLINE_ITEMS(arr, field);                       \
+  } while (0)
+
+/* Passes the allocated size along so size-class allocators can skip looking
+ * it up */
+#define OTTER_ARRAY_FREE(arr, field, allocator)                                \
+  do {                                                                         \
+    if ((arr)->field != NULL &&                                                \
+        (void *)(arr)->field != OTTER_ARRAY_INLINE_ITEMS(arr, field)) {        \
+      otter_free_sized(allocator, (arr)->field,                                \
+                       sizeof(*(arr)->field) *                                 \
+                           OTTER_ARRAY_CAPACITY(arr, field));                  \
+    }                                                                          \
   } while (0)
 
+/* inline_items is the array's inline storage or NULL, it is never passed to
+ * the allocator */
 bool otter_array_expand(otter_allocator *allocator, void **items,
-                        size_t items_size, size_t *items_capacity);
+                        size_t items_size, size_t *items_capacity,
+                        void *inline_items);
+/* Grows to exactly capacity items unless there is room already */
+bool otter_array_reserve(otter_allocator *allocator, void **items,
+                         size_t items_size, size_t *items_capacity,
+                         void *inline_items, size_t capacity);
+/* Grows geometrically until there is room for capacity items */
+bool otter_array_grow(otter_allocator *allocator, void **items,
+                      size_t items_size, size_t *items_capacity,
+                      void *inline_items, size_t capacity);
+/* Moves the items back inline when they fit */
+bool otter_array_shrink_to_fit(otter_allocator *allocator, void **items,
+                               size_t items_size, size_t *items_capacity,
+                               void *inline_items, size_t inline_capacity,
+                               size_t items_length);
+
+#define OTTER_ARRAY_RESERVE(arr, field, allocator, capacity)                   \
+  otter_array_reserve(allocator, (void **)&(arr)->field,                       \
+                      sizeof(*(arr)->field),                                   \
+                      &OTTER_ARRAY_CAPACITY(arr, field),                       \
+                      OTTER_ARRAY_INLINE_ITEMS(arr, field), capacity)
+
+/* For arrays whose final size is known up front, so they are allocated once
+ * instead of growing from OTTER_ARRAY_INITIAL_CAPACITY */
+#define OTTER_ARRAY_INIT_CAPACITY(arr, field, allocator, capacity)             \
+  ({                                                                           \
+    OTTER_ARRAY_INIT(arr, field, allocator);                                   \
+    OTTER_ARRAY_RESERVE(arr, field, allocator, capacity);                      \
+  })
+
+/* Releases the unused capacity, an empty array releases its allocation */
+#define OTTER_ARRAY_SHRINK_TO_FIT(arr, field, allocator)                       \
+  otter_array_shrink_to_fit(                                                   \
+      allocator, (void **)&(arr)->field, sizeof(*(arr)->field),                \
+      &OTTER_ARRAY_CAPACITY(arr, field), OTTER_ARRAY_INLINE_ITEMS(arr, field), \
+      OTTER_ARRAY_INLINE_CAPACITY(arr, field), OTTER_ARRAY_LENGTH(arr, field))
+
 #define OTTER_ARRAY_APPEND(arr, field, allocator, value)                       \
   ({                                                                           \
     bool should_append = true;                                                 \
     if (OTTER_ARRAY_LENGTH(arr, field) >= OTTER_ARRAY_CAPACITY(arr, field)) {  \
-      should_append = otter_array_expand(allocator, (void **)&(arr)->field,    \
-                                         sizeof(*(arr)->field),                \
-                                         &OTTER_ARRAY_CAPACITY(arr, field));   \
+      should_append = otter_array_expand(                                      \
+          allocator, (void **)&(arr)->field, sizeof(*(arr)->field),            \
+          &OTTER_ARRAY_CAPACITY(arr, field),                                   \
+          OTTER_ARRAY_INLINE_ITEMS(arr, field));                               \
     }                                                                          \
     if (should_append) {                                                       \
       (arr)->field[OTTER_ARRAY_LENGTH(arr, field)++] = value;                  \
@@ -71,6 +144,24 @@ bool otter_array_expand(otter_allocator *allocator, void **items,
     should_append;                                                             \
   })
 
+/* Appends count items copied from values with at most one reallocation */
+#define OTTER_ARRAY_APPEND_N(arr, field, allocator, values, count)             \
+  ({                                                                           \
+    const size_t OTTER_UNIQUE_VARNAME(append_count) = (count);                 \
+    bool OTTER_UNIQUE_VARNAME(appended) = otter_array_grow(                    \
+        allocator, (void **)&(arr)->field, sizeof(*(arr)->field),              \
+        &OTTER_ARRAY_CAPACITY(arr, field),                                     \
+        OTTER_ARRAY_INLINE_ITEMS(arr, field),                                  \
+        OTTER_ARRAY_LENGTH(arr, field) + OTTER_UNIQUE_VARNAME(append_count));  \
+    if (OTTER_UNIQUE_VARNAME(appended) &&                                      \
+        OTTER_UNIQUE_VARNAME(append_count) > 0) {                              \
+      memcpy(&(arr)->field[OTTER_ARRAY_LENGTH(arr, field)], values,            \
+             sizeof(*(arr)->field) * OTTER_UNIQUE_VARNAME(append_count));      \
+      OTTER_ARRAY_LENGTH(arr, field) += OTTER_UNIQUE_VARNAME(append_count);    \
+    }                                                                          \
+    OTTER_UNIQUE_VARNAME(appended);                                            \
+  })
+
 #define OTTER_ARRAY_FOREACH(arr, field, fn, ...)                               \
   for (size_t OTTER_UNIQUE_VARNAME(i) = 0;                                     \
        OTTER_UNIQUE_VARNAME(i) < OTTER_ARRAY_LENGTH(arr, field);               \
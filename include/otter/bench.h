@@ -0,0 +1,29 @@
+/*
+  otter Copyright (C) 2026 Nathaniel Wright
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef OTTER_BENCH_H_
+#define OTTER_BENCH_H_
+#include <stddef.h>
+#include <stdint.h>
+
+/* Reads the monotonic clock in nanoseconds */
+uint64_t otter_bench_now_ns(void);
+
+/* Prints a single result line with the time per iteration and the rate */
+void otter_bench_report(const char *name, size_t iterations,
+                        uint64_t elapsed_ns);
+
+#endif /* OTTER_BENCH_H_ */
@@ -145,6 +145,44 @@ OTTER_DECLARE_TRIVIAL_CLEANUP_FUNC(otter_build_context *,
  */
 bool otter_build_all(otter_build_context *ctx);
 
+/**
+ * Log the most expensive targets of a build, slowest first
+ *
+ * @param ctx Build context that has been built
+ */
+void otter_build_log_summary(const otter_build_context *ctx);
+
+/**
+ * Write a Chrome trace_event JSON file with the hash, queue, spawn and run
+ * times of every target
+ *
+ * @param ctx Build context that has been built
+ * @param path Path of the trace file
+ * @return true on success, false on error
+ */
+bool otter_build_write_trace(const otter_build_context *ctx, const char *path);
+
+/**
+ * Log why each out of date target would be executed and the critical path
+ * through the target graph, weighted by the historical cost of each target.
+ * Nothing is executed.
+ *
+ * @param ctx Build context
+ * @return true on success, false on error
+ */
+bool otter_build_explain(otter_build_context *ctx);
+
+/**
+ * Write the resolved target graph with the historical cost and staleness of
+ * each target.  Paths ending in ".json" produce JSON, anything else DOT.
+ * Nothing is executed.
+ *
+ * @param ctx Build context
+ * @param path Path of the graph file
+ * @return true on success, false on error
+ */
+bool otter_build_write_graph(otter_build_context *ctx, const char *path);
+
 /**
  * Callback function type for bootstrap builds
  * Returns true on success, false on failure
@@ -0,0 +1,40 @@
+/*
+  otter Copyright (C) 2026 Nathaniel Wright
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef OTTER_CLOCK_H_
+#define OTTER_CLOCK_H_
+#include <stdint.h>
+#include <sys/time.h>
+#include <time.h>
+
+#define OTTER_NANOSECONDS_PER_SECOND ((uint64_t)1000000000)
+#define OTTER_NANOSECONDS_PER_MICROSECOND ((uint64_t)1000)
+#define OTTER_NANOSECONDS_PER_MILLISECOND ((uint64_t)1000000)
+
+/* Reads the monotonic clock in nanoseconds */
+static inline uint64_t otter_clock_now_ns(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return ((uint64_t)now.tv_sec * OTTER_NANOSECONDS_PER_SECOND) +
+         (uint64_t)now.tv_nsec;
+}
+
+static inline uint64_t otter_clock_timeval_ns(const struct timeval *value) {
+  return ((uint64_t)value->tv_sec * OTTER_NANOSECONDS_PER_SECOND) +
+         ((uint64_t)value->tv_usec * OTTER_NANOSECONDS_PER_MICROSECOND);
+}
+
+#endif /* OTTER_CLOCK_H_ */
@@ -21,13 +21,36 @@
 #include "inc.h"
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 typedef struct otter_filesystem otter_filesystem;
+
+/* The metadata up-to-date checks need.  Missing files are not an error, they
+ * are reported with exists set to false. */
+typedef struct otter_file_status {
+  bool exists;
+  uint32_t mode;
+  uint64_t size;
+  int64_t mtime_ns;
+} otter_file_status;
+
+/* Read-only view of a file's contents.  Small files are read into a buffer,
+ * larger ones are mapped, so the data is not necessarily NUL terminated. */
+typedef struct otter_file_view {
+  const char *data;
+  size_t length;
+  void *storage; /* Owned by the filesystem that created the view */
+  bool mapped;
+} otter_file_view;
+
 typedef struct otter_filesystem_vtable {
   void (*free)(otter_filesystem *);
   otter_file *(*open_file)(otter_filesystem *, const char *path,
                            const char *mode);
   bool (*copy)(otter_filesystem *, const char *from_path, const char *to_path);
   bool (*remove)(otter_filesystem *, const char *path);
+  bool (*rename)(otter_filesystem *, const char *from_path,
+                 const char *to_path);
+  bool (*make_directory)(otter_filesystem *, const char *path);
   bool (*exists)(otter_filesystem *, const char *path);
   int (*get_attribute)(otter_filesystem *, const char *path,
                        const char *attribute, unsigned char *value,
@@ -35,6 +58,16 @@ typedef struct otter_filesystem_vtable {
   int (*set_attribute)(otter_filesystem *, const char *path,
                        const char *attribute, const unsigned char *value,
                        size_t value_size);
+  bool (*map_file)(otter_filesystem *, const char *path,
+                   otter_file_view *view);
+  void (*unmap_file)(otter_filesystem *, otter_file_view *view);
+  bool (*stat_many)(otter_filesystem *, const char *const *paths,
+                    size_t count, otter_file_status *statuses);
+  void (*invalidate)(otter_filesystem *, const char *path);
+  void (*get_attribute_many)(otter_filesystem *, const char *const *paths,
+                             size_t count, const char *attribute,
+                             unsigned char *values, size_t value_size,
+                             int *results);
 } otter_filesystem_vtable;
 
 struct otter_filesystem {
@@ -42,6 +75,14 @@ struct otter_filesystem {
 };
 
 otter_filesystem *otter_filesystem_create(otter_allocator *allocator);
+/* Remembers the status of every path stat'ed through it until the path is
+ * modified through the cache or invalidated.  Meant to live for one build, so
+ * each path is stat'ed at most once.  Does not take ownership of parent. */
+otter_filesystem *otter_filesystem_create_cached(otter_allocator *allocator,
+                                                 otter_filesystem *parent);
+/* Submits the batched operations through io_uring.  Falls back to the POSIX
+ * filesystem from otter_filesystem_create when the kernel lacks support. */
+otter_filesystem *otter_filesystem_create_uring(otter_allocator *allocator);
 void otter_filesystem_free(otter_filesystem *filesystem);
 OTTER_DECLARE_TRIVIAL_CLEANUP_FUNC(otter_filesystem *, otter_filesystem_free);
 otter_file *otter_filesystem_open_file(otter_filesystem *filesystem,
@@ -49,6 +90,12 @@ otter_file *otter_filesystem_open_file(otter_filesystem *filesystem,
 bool otter_filesystem_copy(otter_filesystem *filesystem, const char *from_path,
                            const char *to_path);
 bool otter_filesystem_remove(otter_filesystem *filesystem, const char *path);
+/* Atomically replaces to_path with from_path */
+bool otter_filesystem_rename(otter_filesystem *filesystem,
+                             const char *from_path, const char *to_path);
+/* Also succeeds if path already is a directory */
+bool otter_filesystem_make_directory(otter_filesystem *filesystem,
+                                     const char *path);
 bool otter_filesystem_exists(otter_filesystem *filesystem, const char *path);
 int otter_filesystem_get_attribute(otter_filesystem *filesystem,
                                    const char *path, const char *attribute,
@@ -57,5 +104,26 @@ int otter_filesystem_set_attribute(otter_filesystem *filesystem,
                                    const char *path, const char *attribute,
                                    const unsigned char *value,
                                    size_t value_size);
+bool otter_filesystem_map_file(otter_filesystem *filesystem, const char *path,
+                               otter_file_view *view);
+void otter_filesystem_unmap_file(otter_filesystem *filesystem,
+                                 otter_file_view *view);
+/* Returns false if a path could not be queried for a reason other than it
+ * not existing */
+bool otter_filesystem_stat_many(otter_filesystem *filesystem,
+                                const char *const *paths, size_t count,
+                                otter_file_status *statuses);
+/* Drops cached metadata for path, or for every path if path is NULL.  Needed
+ * after files are changed behind the filesystem's back. */
+void otter_filesystem_invalidate(otter_filesystem *filesystem,
+                                 const char *path);
+/* Reads attribute of every path.  The value of paths[i] is stored at
+ * values[i * value_size] and results[i] is what get_attribute would have
+ * returned for it. */
+void otter_filesystem_get_attribute_many(otter_filesystem *filesystem,
+                                         const char *const *paths,
+                                         size_t count, const char *attribute,
+                                         unsigned char *values,
+                                         size_t value_size, int *results);
 
 #endif /* OTTER_FILESYSTEM_H_ */
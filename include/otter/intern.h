@@ -0,0 +1,53 @@
+/*
+  otter Copyright (C) 2026 Nathaniel Wright
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef OTTER_INTERN_H_
+#define OTTER_INTERN_H_
+#include "allocator.h"
+#include "inc.h"
+#include "string.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/* A deduplicated, immutable string.  Interning equal strings into the same
+ * table returns the same handle, so handles from one table are compared with
+ * == and carry their hash for reuse in other tables. */
+typedef struct otter_interned_string {
+  const char *data; /* NUL terminated */
+  size_t length;
+  uint64_t hash;
+} otter_interned_string;
+
+/* Handles stay valid until the table is freed.  The table is not thread
+ * safe. */
+typedef struct otter_intern_table otter_intern_table;
+
+otter_intern_table *otter_intern_table_create(otter_allocator *allocator);
+void otter_intern_table_free(otter_intern_table *table);
+OTTER_DECLARE_TRIVIAL_CLEANUP_FUNC(otter_intern_table *,
+                                   otter_intern_table_free);
+/* Returns the handle for view, adding a copy of it on first use */
+const otter_interned_string *otter_intern(otter_intern_table *table,
+                                          otter_string_view view);
+const otter_interned_string *otter_intern_cstr(otter_intern_table *table,
+                                               const char *str);
+/* Returns the handle for view or NULL if it was never interned */
+const otter_interned_string *
+otter_intern_find(const otter_intern_table *table, otter_string_view view);
+size_t otter_intern_table_length(const otter_intern_table *table);
+uint64_t otter_intern_hash(otter_string_view view);
+
+#endif /* OTTER_INTERN_H_ */
@@ -17,7 +17,9 @@
 #ifndef OTTER_LEXER_H_
 #define OTTER_LEXER_H_
 #include "allocator.h"
+#include "filesystem.h"
 #include "inc.h"
+#include "intern.h"
 #include "token.h"
 #include <stddef.h>
 typedef struct otter_lexer {
@@ -27,9 +29,19 @@ typedef struct otter_lexer {
   const char *source;
   int line;
   int column;
+
+  /* Identifiers are interned here rather than copied when it is set.  The
+   * table has to outlive the tokens and the nodes parsed from them. */
+  otter_intern_table *strings;
+
+  /* Set when the source is a view of a file owned by the lexer */
+  otter_filesystem *filesystem;
+  otter_file_view view;
 } otter_lexer;
 
+/* Lexes the file directly from a view provided by the filesystem */
 otter_lexer *otter_lexer_create_from_file(otter_allocator *allocator,
+                                          otter_filesystem *filesystem,
                                           const char *file);
 otter_lexer *otter_lexer_create(otter_allocator *allocator, const char *source);
 void otter_lexer_free(otter_lexer *lexer);
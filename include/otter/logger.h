@@ -20,7 +20,42 @@
 #include "inc.h"
 #include <stdarg.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
 #include <time.h>
+typedef enum otter_log_level {
+  OTTER_LOG_LEVEL_CRITICAL = 0,
+  OTTER_LOG_LEVEL_ERROR = 1,
+  OTTER_LOG_LEVEL_WARNING = 2,
+  OTTER_LOG_LEVEL_INFO = 3,
+  OTTER_LOG_LEVEL_DEBUG = 4,
+} otter_log_level;
+
+typedef struct otter_log_field {
+  const char *key;
+  const char *value;
+} otter_log_field;
+
+/* What a message is about, e.g. the target being built.  target may be NULL,
+ * none of the keys and values may be. */
+typedef struct otter_log_context {
+  const char *target;
+  const otter_log_field *fields;
+  size_t fields_length;
+} otter_log_context;
+
+/* Everything a structured sink is told about a message */
+typedef struct otter_log_record {
+  otter_log_level log_level;
+  pid_t thread_id;
+  struct timespec wall_time;
+  uint64_t monotonic_ns;
+  /* NULL when the message was logged without one */
+  const otter_log_context *context;
+  const char *message;
+  size_t message_length;
+} otter_log_record;
+
 typedef struct otter_logger otter_logger;
 typedef struct otter_logger_vtable {
   void (*log_debug)(otter_logger *, const char *fmt, va_list args);
@@ -28,34 +63,145 @@ typedef struct otter_logger_vtable {
   void (*log_warning)(otter_logger *, const char *fmt, va_list args);
   void (*log_error)(otter_logger *, const char *fmt, va_list args);
   void (*log_critical)(otter_logger *, const char *fmt, va_list args);
+  void (*log_with)(otter_logger *, otter_log_level log_level,
+                   const otter_log_context *context, const char *fmt,
+                   va_list args);
 } otter_logger_vtable;
 
-typedef enum otter_log_level {
-  OTTER_LOG_LEVEL_CRITICAL = 0,
-  OTTER_LOG_LEVEL_ERROR = 1,
-  OTTER_LOG_LEVEL_WARNING = 2,
-  OTTER_LOG_LEVEL_INFO = 3,
-  OTTER_LOG_LEVEL_DEBUG = 4,
-} otter_log_level;
-
 typedef void (*otter_logger_sink_fn)(otter_log_level log_level,
                                      time_t timestamp, const char *);
+
+/* A sink that is handed whole records and may buffer what it writes */
+typedef struct otter_log_sink otter_log_sink;
+typedef struct otter_log_sink_vtable {
+  void (*write)(otter_log_sink *, const otter_log_record *record);
+  void (*flush)(otter_log_sink *);
+  void (*free)(otter_log_sink *);
+} otter_log_sink_vtable;
+
+struct otter_log_sink {
+  otter_log_sink_vtable *vtable;
+};
+
+/* A binary log starts with these 8 bytes.  Each record is an
+ * otter_log_binary_header followed by the target and the message, then an
+ * otter_log_binary_field with its key and value for every field.  Strings are
+ * not NUL terminated and integers are in host byte order. */
+#define OTTER_LOG_BINARY_MAGIC "OTTERLG1"
+#define OTTER_LOG_BINARY_MAGIC_SIZE 8
+typedef struct otter_log_binary_header {
+  /* Including the header itself */
+  uint32_t record_length;
+  uint32_t log_level;
+  int64_t wall_time_ns;
+  uint64_t monotonic_ns;
+  int32_t thread_id;
+  uint32_t target_length;
+  uint32_t message_length;
+  uint32_t fields_length;
+} otter_log_binary_header;
+
+typedef struct otter_log_binary_field {
+  uint32_t key_length;
+  uint32_t value_length;
+} otter_log_binary_field;
+
+/* What an asynchronous logger does with a message when its ring is full */
+typedef enum otter_logger_overflow {
+  /* Drop messages below OTTER_LOG_LEVEL_ERROR, errors always wait for room */
+  OTTER_LOGGER_OVERFLOW_DROP,
+  /* Wait for room for every message */
+  OTTER_LOGGER_OVERFLOW_BLOCK,
+} otter_logger_overflow;
+
+#define OTTER_LOGGER_ASYNC_DEFAULT_CAPACITY 1024
 struct otter_logger {
   otter_logger_vtable *vtable;
+  /* Messages less severe than this are skipped before their arguments are
+   * evaluated */
+  otter_log_level log_level;
 };
 
+/* The least severe level that is compiled in at all, release builds define
+ * it as OTTER_LOG_LEVEL_INFO */
+#ifndef OTTER_LOG_MIN_LEVEL
+#define OTTER_LOG_MIN_LEVEL OTTER_LOG_LEVEL_DEBUG
+#endif
+
+#define OTTER_LOG_ENABLED(logger, level)                                       \
+  ((level) <= OTTER_LOG_MIN_LEVEL && (logger) != NULL &&                       \
+   (level) <= (logger)->log_level)
+
+/* Checks the level inline, so a disabled message costs a load and a compare
+ * and none of its arguments are evaluated */
+#define OTTER_LOG_AT(level, log_fn, logger, ...)                               \
+  do {                                                                         \
+    otter_logger *otter_log_logger_ = (logger);                                \
+    if (OTTER_LOG_ENABLED(otter_log_logger_, level)) {                         \
+      (log_fn)(otter_log_logger_, __VA_ARGS__);                                \
+    }                                                                          \
+  } while (0)
+
 const char *otter_log_level_to_string(otter_log_level level);
 otter_logger *otter_logger_create(otter_allocator *allocator,
                                   otter_log_level log_level);
+/* Messages are formatted by the caller into a lock-free ring and a
+ * background thread hands them to the sinks.  capacity is rounded up to a
+ * power of two.  Sinks are only ever called from that thread.  Callers
+ * allocate the messages that thread frees, so allocator has to be thread safe
+ * or NULL is returned.  Loggers that are still alive when the program calls
+ * exit are flushed then, anything queued is lost on _exit, abort or a fatal
+ * signal. */
+otter_logger *otter_logger_create_async(otter_allocator *allocator,
+                                        otter_log_level log_level,
+                                        size_t capacity,
+                                        otter_logger_overflow overflow);
+/* Flushes anything still queued before freeing */
 void otter_logger_free(otter_logger *logger);
 OTTER_DECLARE_TRIVIAL_CLEANUP_FUNC(otter_logger *, otter_logger_free);
 void otter_logger_add_sink(otter_logger *logger, otter_logger_sink_fn sink);
-void otter_log_debug(otter_logger *logger, const char *fmt, ...);
-void otter_log_info(otter_logger *logger, const char *fmt, ...);
-void otter_log_warning(otter_logger *logger, const char *fmt, ...);
-void otter_log_error(otter_logger *logger, const char *fmt, ...);
-void otter_log_critical(otter_logger *logger, const char *fmt, ...);
+/* Waits until every message logged so far has reached the sinks.  Must not be
+ * called from a sink. */
+void otter_logger_flush(otter_logger *logger);
+/* Number of messages an asynchronous logger dropped because it was full */
+size_t otter_logger_dropped(otter_logger *logger);
+void(otter_log_debug)(otter_logger *logger, const char *fmt, ...);
+void(otter_log_info)(otter_logger *logger, const char *fmt, ...);
+void(otter_log_warning)(otter_logger *logger, const char *fmt, ...);
+void(otter_log_error)(otter_logger *logger, const char *fmt, ...);
+void(otter_log_critical)(otter_logger *logger, const char *fmt, ...);
+/* Logs with a context that structured sinks write next to the message.  The
+ * context is copied when needed, it only has to live until this returns. */
+void(otter_log_with)(otter_logger *logger, otter_log_level log_level,
+                     const otter_log_context *context, const char *fmt, ...);
+
+#define otter_log_debug(logger, ...)                                           \
+  OTTER_LOG_AT(OTTER_LOG_LEVEL_DEBUG, otter_log_debug, logger, __VA_ARGS__)
+#define otter_log_info(logger, ...)                                            \
+  OTTER_LOG_AT(OTTER_LOG_LEVEL_INFO, otter_log_info, logger, __VA_ARGS__)
+#define otter_log_warning(logger, ...)                                         \
+  OTTER_LOG_AT(OTTER_LOG_LEVEL_WARNING, otter_log_warning, logger, __VA_ARGS__)
+#define otter_log_error(logger, ...)                                           \
+  OTTER_LOG_AT(OTTER_LOG_LEVEL_ERROR, otter_log_error, logger, __VA_ARGS__)
+#define otter_log_critical(logger, ...)                                        \
+  OTTER_LOG_AT(OTTER_LOG_LEVEL_CRITICAL, otter_log_critical, logger,           \
+               __VA_ARGS__)
+/* level is evaluated twice */
+#define otter_log_with(logger, level, ...)                                     \
+  OTTER_LOG_AT(level, otter_log_with, logger, level, __VA_ARGS__)
 
 void otter_logger_console_sink(otter_log_level log_level, time_t timestamp,
                                const char *message);
+
+/* The logger owns the sink from here on, it is freed right away if it cannot
+ * be added.  Records are buffered until otter_logger_flush, and asynchronous
+ * loggers also flush whenever their ring runs empty. */
+bool otter_logger_add_record_sink(otter_logger *logger, otter_log_sink *sink);
+/* Both sinks own fd and close it when they are freed, or when creating them
+ * fails */
+otter_log_sink *otter_log_sink_jsonl_create(otter_allocator *allocator,
+                                            int fd);
+otter_log_sink *otter_log_sink_binary_create(otter_allocator *allocator,
+                                             int fd);
+void otter_log_sink_free(otter_log_sink *sink);
 #endif /* OTTER_LOGGER_H_ */
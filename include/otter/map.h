@@ -0,0 +1,357 @@
+/*
+  otter Copyright (C) 2026 Nathaniel Wright
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef OTTER_MAP_H_
+#define OTTER_MAP_H_
+#include "allocator.h"
+#include "inc.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Open addressing hash maps and sets in the style of OTTER_ARRAY.  The slots
+ * are laid out like a Swiss table: one control byte per slot holds either
+ * EMPTY, DELETED or the top 7 bits of the key's hash, and lookups compare
+ * the control bytes of a group of 8 slots at a time within a single 64-bit
+ * word before looking at any key.
+ *
+ * Hash functions take a pointer to a key and equality functions pointers to
+ * two keys, so the same functions work for the lookups in the macros and for
+ * rehashing in otter_map_rehash.
+ *
+ * The entries and control bytes share one allocation that is only made on
+ * the first insertion, so an initialized but unused map costs nothing. */
+typedef uint64_t (*otter_map_hash_fn)(const void *key);
+
+#define OTTER_MAP_GROUP_SIZE 8
+#define OTTER_MAP_MIN_CAPACITY 8
+#define OTTER_MAP_CONTROL_EMPTY 0x00
+#define OTTER_MAP_CONTROL_DELETED 0x7f
+#define OTTER_MAP_CONTROL_FULL 0x80
+#define OTTER_MAP_NOT_FOUND SIZE_MAX
+
+#define OTTER_MAP_LENGTH(map, field) (map)->field##_length
+#define OTTER_MAP_CAPACITY(map, field) (map)->field##_capacity
+
+/* The key has to be the first member of every entry, otter_map_rehash relies
+ * on it */
+#define OTTER_MAP_DECLARE(key_type, value_type, field)                         \
+  size_t field##_length;                                                       \
+  size_t field##_capacity;                                                     \
+  size_t field##_tombstones;                                                   \
+  uint8_t *field##_control;                                                    \
+  /* NOLINTBEGIN(bugprone-macro-parentheses) */                                \
+  struct {                                                                     \
+    key_type key;                                                              \
+    value_type value;                                                          \
+  } *field /* NOLINTEND(bugprone-macro-parentheses) */
+
+#define OTTER_SET_DECLARE(key_type, field)                                     \
+  size_t field##_length;                                                       \
+  size_t field##_capacity;                                                     \
+  size_t field##_tombstones;                                                   \
+  uint8_t *field##_control;                                                    \
+  /* NOLINTBEGIN(bugprone-macro-parentheses) */                                \
+  struct {                                                                     \
+    key_type key;                                                              \
+  } *field /* NOLINTEND(bugprone-macro-parentheses) */
+
+#define OTTER_MAP_INIT(map, field)                                             \
+  do {                                                                         \
+    OTTER_MAP_LENGTH(map, field) = 0;                                          \
+    OTTER_MAP_CAPACITY(map, field) = 0;                                        \
+    (map)->field##_tombstones = 0;                                             \
+    (map)->field##_control = NULL;                                             \
+    (map)->field = NULL;                                                       \
+  } while (0)
+
+#define OTTER_MAP_FREE(map, field, allocator)                                  \
+  do {                                                                         \
+    if ((map)->field != NULL) {                                                \
+      otter_free_sized(allocator, (map)->field,                                \
+                       (sizeof(*(map)->field) + 1) *                           \
+                           OTTER_MAP_CAPACITY(map, field));                    \
+    }                                                                          \
+    OTTER_MAP_INIT(map, field);                                                \
+  } while (0)
+
+/* Spreads the bits of value so that both the low bits, which pick the
+ * group, and the top bits, which form the tag, depend on all of them */
+static inline uint64_t otter_map_mix(uint64_t value) {
+  value ^= value >> 33;
+  value *= 0xff51afd7ed558ccdULL;
+  value ^= value >> 33;
+  value *= 0xc4ceb9fe1a85ec53ULL;
+  value ^= value >> 33;
+  return value;
+}
+
+/* For keys that are pointers compared by identity */
+static inline uint64_t otter_map_hash_pointer(const void *key) {
+  const void *pointer;
+  memcpy(&pointer, key, sizeof(pointer));
+  return otter_map_mix((uint64_t)(uintptr_t)pointer);
+}
+
+static inline bool otter_map_equal_pointer(const void *key1,
+                                           const void *key2) {
+  return memcmp(key1, key2, sizeof(void *)) == 0;
+}
+
+static inline uint64_t otter_map_hash_u64(const void *key) {
+  uint64_t value;
+  memcpy(&value, key, sizeof(value));
+  return otter_map_mix(value);
+}
+
+static inline bool otter_map_equal_u64(const void *key1, const void *key2) {
+  return memcmp(key1, key2, sizeof(uint64_t)) == 0;
+}
+
+/* For keys that are NUL terminated const char * compared by content */
+uint64_t otter_map_hash_cstr(const void *key);
+bool otter_map_equal_cstr(const void *key1, const void *key2);
+
+static inline uint8_t otter_map_tag(uint64_t hash) {
+  return (uint8_t)(OTTER_MAP_CONTROL_FULL | (hash >> 57));
+}
+
+static inline uint64_t otter_map_load_group(const uint8_t *control) {
+  uint64_t group;
+  memcpy(&group, control, sizeof(group));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  group = __builtin_bswap64(group);
+#endif
+  return group;
+}
+
+/* Sets the high bit of every byte of group that is zero.  A byte directly
+ * above a zero byte can be flagged as well when it is 0x01, which the
+ * callers either verify or cannot produce. */
+static inline uint64_t otter_map_match_zero(uint64_t group) {
+  return (group - 0x0101010101010101ULL) & ~group & 0x8080808080808080ULL;
+}
+
+/* Walks the slots whose tag matches hash, group by group, and stops after
+ * the first group that has an empty slot since the key cannot be further
+ * along its probe sequence */
+typedef struct otter_map_probe {
+  const uint8_t *control;
+  size_t group_mask;
+  size_t group;
+  size_t stride;
+  uint64_t tag;
+  uint64_t matches;
+  bool last_group;
+} otter_map_probe;
+
+static inline void otter_map_probe_load(otter_map_probe *probe) {
+  const uint64_t group = otter_map_load_group(
+      &probe->control[probe->group * OTTER_MAP_GROUP_SIZE]);
+  probe->matches = otter_map_match_zero(group ^ probe->tag);
+  probe->last_group = otter_map_match_zero(group) != 0;
+}
+
+static inline void otter_map_probe_init(otter_map_probe *probe,
+                                        const uint8_t *control,
+                                        size_t capacity, uint64_t hash) {
+  probe->control = control;
+  probe->group_mask = capacity / OTTER_MAP_GROUP_SIZE - 1;
+  probe->group = (size_t)hash & probe->group_mask;
+  probe->stride = 0;
+  probe->tag = otter_map_tag(hash) * 0x0101010101010101ULL;
+  otter_map_probe_load(probe);
+}
+
+static inline bool otter_map_probe_next(otter_map_probe *probe,
+                                        size_t *slot) {
+  for (;;) {
+    if (probe->matches != 0) {
+      *slot = probe->group * OTTER_MAP_GROUP_SIZE +
+              ((size_t)__builtin_ctzll(probe->matches) >> 3);
+      probe->matches &= probe->matches - 1;
+      return true;
+    }
+
+    if (probe->last_group || probe->stride >= probe->group_mask) {
+      return false;
+    }
+
+    /* Triangular steps visit every group when their count is a power of
+     * two */
+    probe->stride++;
+    probe->group = (probe->group + probe->stride) & probe->group_mask;
+    otter_map_probe_load(probe);
+  }
+}
+
+/* Returns the first empty or deleted slot along the probe sequence of hash */
+static inline size_t otter_map_free_slot(const uint8_t *control,
+                                         size_t capacity, uint64_t hash) {
+  const size_t group_mask = capacity / OTTER_MAP_GROUP_SIZE - 1;
+  size_t group = (size_t)hash & group_mask;
+  for (size_t stride = 1;; stride++) {
+    const uint64_t available =
+        ~otter_map_load_group(&control[group * OTTER_MAP_GROUP_SIZE]) &
+        0x8080808080808080ULL;
+    if (available != 0) {
+      return group * OTTER_MAP_GROUP_SIZE +
+             ((size_t)__builtin_ctzll(available) >> 3);
+    }
+    group = (group + stride) & group_mask;
+  }
+}
+
+/* Moves every entry into a table of capacity slots, dropping the tombstones.
+ * capacity has to be a power of two of at least OTTER_MAP_MIN_CAPACITY that
+ * leaves room for length entries below the maximum load. */
+bool otter_map_rehash(otter_allocator *allocator, void **entries,
+                      uint8_t **control, size_t *capacity, size_t *tombstones,
+                      size_t entry_size, size_t new_capacity,
+                      otter_map_hash_fn hash);
+/* The capacity needed to hold length entries below the maximum load of 7/8 */
+size_t otter_map_capacity_for(size_t length);
+
+/* Makes room for length entries in total without further rehashing */
+#define OTTER_MAP_RESERVE(map, field, allocator, length, hash_fn)              \
+  ({                                                                           \
+    bool OTTER_UNIQUE_VARNAME(map_reserved) = true;                            \
+    const size_t OTTER_UNIQUE_VARNAME(map_needed) =                            \
+        otter_map_capacity_for((length) + (map)->field##_tombstones);          \
+    if (OTTER_UNIQUE_VARNAME(map_needed) > OTTER_MAP_CAPACITY(map, field)) {   \
+      OTTER_UNIQUE_VARNAME(map_reserved) = otter_map_rehash(                   \
+          allocator, (void **)&(map)->field, &(map)->field##_control,          \
+          &OTTER_MAP_CAPACITY(map, field), &(map)->field##_tombstones,         \
+          sizeof(*(map)->field),                                               \
+          otter_map_capacity_for(length), hash_fn);                            \
+    }                                                                          \
+    OTTER_UNIQUE_VARNAME(map_reserved);                                        \
+  })
+
+/* Returns the slot holding key or OTTER_MAP_NOT_FOUND */
+#define OTTER_MAP_FIND_SLOT(map, field, key_, hash_fn, equal_fn)               \
+  ({                                                                           \
+    size_t OTTER_UNIQUE_VARNAME(map_found) = OTTER_MAP_NOT_FOUND;              \
+    const typeof((map)->field->key) OTTER_UNIQUE_VARNAME(map_key) = (key_);    \
+    if (OTTER_MAP_LENGTH(map, field) > 0) {                                    \
+      otter_map_probe OTTER_UNIQUE_VARNAME(map_probe);                         \
+      otter_map_probe_init(&OTTER_UNIQUE_VARNAME(map_probe),                   \
+                           (map)->field##_control,                             \
+                           OTTER_MAP_CAPACITY(map, field),                     \
+                           hash_fn(&OTTER_UNIQUE_VARNAME(map_key)));           \
+      size_t OTTER_UNIQUE_VARNAME(map_slot);                                   \
+      while (otter_map_probe_next(&OTTER_UNIQUE_VARNAME(map_probe),            \
+                                  &OTTER_UNIQUE_VARNAME(map_slot))) {          \
+        if (equal_fn(                                                          \
+                &(map)->field[OTTER_UNIQUE_VARNAME(map_slot)].key,             \
+                &OTTER_UNIQUE_VARNAME(map_key))) {                             \
+          OTTER_UNIQUE_VARNAME(map_found) = OTTER_UNIQUE_VARNAME(map_slot);    \
+          break;                                                               \
+        }                                                                      \
+      }                                                                        \
+    }                                                                          \
+    OTTER_UNIQUE_VARNAME(map_found);                                           \
+  })
+
+/* Returns the slot holding key, claiming a free one and storing key in it
+ * when it was missing, or OTTER_MAP_NOT_FOUND if the table could not grow */
+#define OTTER_MAP_INSERT_SLOT(map, field, allocator, key_, hash_fn, equal_fn)  \
+  ({                                                                           \
+    const typeof((map)->field->key) OTTER_UNIQUE_VARNAME(map_new_key) = (key_);\
+    size_t OTTER_UNIQUE_VARNAME(map_at) =                                      \
+        OTTER_MAP_FIND_SLOT(map, field, OTTER_UNIQUE_VARNAME(map_new_key),     \
+                            hash_fn, equal_fn);                                \
+    if (OTTER_UNIQUE_VARNAME(map_at) == OTTER_MAP_NOT_FOUND &&                 \
+        OTTER_MAP_RESERVE(map, field, allocator,                               \
+                          OTTER_MAP_LENGTH(map, field) + 1, hash_fn)) {        \
+      const uint64_t OTTER_UNIQUE_VARNAME(map_hash) =                          \
+          hash_fn(&OTTER_UNIQUE_VARNAME(map_new_key));                         \
+      OTTER_UNIQUE_VARNAME(map_at) = otter_map_free_slot(                      \
+          (map)->field##_control, OTTER_MAP_CAPACITY(map, field),              \
+          OTTER_UNIQUE_VARNAME(map_hash));                                     \
+      if ((map)->field##_control[OTTER_UNIQUE_VARNAME(map_at)] ==              \
+          OTTER_MAP_CONTROL_DELETED) {                                         \
+        (map)->field##_tombstones--;                                           \
+      }                                                                        \
+      (map)->field##_control[OTTER_UNIQUE_VARNAME(map_at)] =                   \
+          otter_map_tag(OTTER_UNIQUE_VARNAME(map_hash));                       \
+      (map)->field[OTTER_UNIQUE_VARNAME(map_at)].key =                         \
+          OTTER_UNIQUE_VARNAME(map_new_key);                                   \
+      OTTER_MAP_LENGTH(map, field)++;                                          \
+    }                                                                          \
+    OTTER_UNIQUE_VARNAME(map_at);                                              \
+  })
+
+/* Inserts key or replaces the value stored for it */
+#define OTTER_MAP_INSERT(map, field, allocator, key_, value_, hash_fn,         \
+                         equal_fn)                                             \
+  ({                                                                           \
+    const size_t OTTER_UNIQUE_VARNAME(map_inserted) = OTTER_MAP_INSERT_SLOT(   \
+        map, field, allocator, key_, hash_fn, equal_fn);                       \
+    if (OTTER_UNIQUE_VARNAME(map_inserted) != OTTER_MAP_NOT_FOUND) {           \
+      (map)->field[OTTER_UNIQUE_VARNAME(map_inserted)].value = (value_);       \
+    }                                                                          \
+    OTTER_UNIQUE_VARNAME(map_inserted) != OTTER_MAP_NOT_FOUND;                 \
+  })
+
+/* Returns a pointer to the value stored for key or NULL.  The pointer is
+ * invalidated by the next insertion. */
+#define OTTER_MAP_FIND(map, field, key_, hash_fn, equal_fn)                    \
+  ({                                                                           \
+    const size_t OTTER_UNIQUE_VARNAME(map_find) =                              \
+        OTTER_MAP_FIND_SLOT(map, field, key_, hash_fn, equal_fn);              \
+    OTTER_UNIQUE_VARNAME(map_find) != OTTER_MAP_NOT_FOUND                      \
+        ? &(map)->field[OTTER_UNIQUE_VARNAME(map_find)].value                  \
+        : NULL;                                                                \
+  })
+
+#define OTTER_MAP_CONTAINS(map, field, key_, hash_fn, equal_fn)                \
+  (OTTER_MAP_FIND_SLOT(map, field, key_, hash_fn, equal_fn) !=                 \
+   OTTER_MAP_NOT_FOUND)
+
+/* Removes key and returns whether it was present.  The slot becomes a
+ * tombstone so that probe sequences passing through it stay intact. */
+#define OTTER_MAP_REMOVE(map, field, key_, hash_fn, equal_fn)                  \
+  ({                                                                           \
+    const size_t OTTER_UNIQUE_VARNAME(map_removed) =                           \
+        OTTER_MAP_FIND_SLOT(map, field, key_, hash_fn, equal_fn);              \
+    if (OTTER_UNIQUE_VARNAME(map_removed) != OTTER_MAP_NOT_FOUND) {            \
+      (map)->field##_control[OTTER_UNIQUE_VARNAME(map_removed)] =              \
+          OTTER_MAP_CONTROL_DELETED;                                           \
+      (map)->field##_tombstones++;                                             \
+      OTTER_MAP_LENGTH(map, field)--;                                          \
+    }                                                                          \
+    OTTER_UNIQUE_VARNAME(map_removed) != OTTER_MAP_NOT_FOUND;                  \
+  })
+
+#define OTTER_SET_INSERT(set, field, allocator, key_, hash_fn, equal_fn)       \
+  (OTTER_MAP_INSERT_SLOT(set, field, allocator, key_, hash_fn, equal_fn) !=    \
+   OTTER_MAP_NOT_FOUND)
+
+/* Calls fn with the trailing arguments followed by a pointer to each entry */
+#define OTTER_MAP_FOREACH(map, field, fn, ...)                                 \
+  for (size_t OTTER_UNIQUE_VARNAME(i) = 0;                                     \
+       OTTER_UNIQUE_VARNAME(i) < OTTER_MAP_CAPACITY(map, field);               \
+       OTTER_UNIQUE_VARNAME(i)++) {                                            \
+    if ((map)->field##_control[OTTER_UNIQUE_VARNAME(i)] &                      \
+        OTTER_MAP_CONTROL_FULL) {                                              \
+      fn(__VA_ARGS__ __VA_OPT__(, ) &(map)->field[OTTER_UNIQUE_VARNAME(i)]);   \
+    }                                                                          \
+  }                                                                            \
+  struct otter_useless_struct_to_allow_trailing_semicolon
+
+#endif /* OTTER_MAP_H_ */
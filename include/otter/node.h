@@ -18,6 +18,7 @@
 #define OTTER_NODE_H_
 #include "allocator.h"
 #include "array.h"
+#include "intern.h"
 typedef enum otter_node_type {
   OTTER_NODE_IDENTIFIER,
   OTTER_NODE_INTEGER,
@@ -39,9 +40,15 @@ typedef struct otter_node {
 
 typedef struct otter_node_identifier {
   otter_node base;
-  char *value;
+  char *value; /* NULL when the identifier is interned */
+  const otter_interned_string *interned;
 } otter_node_identifier;
 
+static inline const char *
+otter_node_identifier_name(const otter_node_identifier *ident) {
+  return ident->interned != NULL ? ident->interned->data : ident->value;
+}
+
 typedef struct otter_node_integer {
   otter_node base;
   int value;
@@ -64,13 +71,16 @@ typedef struct otter_node_assignment {
   otter_node *value_expr;
 } otter_node_assignment;
 
+/* Loop bodies are usually a few statements long */
+#define OTTER_NODE_FOR_INLINE_STATEMENTS 4
 typedef struct otter_node_for {
   otter_node base;
   otter_node_assignment *assignment;
   otter_node *condition;
   otter_node *iteration;
 
-  OTTER_ARRAY_DECLARE(otter_node *, statements);
+  OTTER_SMALL_ARRAY_DECLARE(otter_node *, statements,
+                            OTTER_NODE_FOR_INLINE_STATEMENTS);
 } otter_node_for;
 
 void otter_node_free(otter_allocator *allocator, otter_node *node);
@@ -0,0 +1,34 @@
+/*
+  otter Copyright (C) 2026 Nathaniel Wright
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef OTTER_POOL_H_
+#define OTTER_POOL_H_
+#include "allocator.h"
+
+/* Largest request served from a size class, bigger ones go to the parent
+ * with a small header in front and are still released with the pool */
+#define OTTER_POOL_MAX_BLOCK_SIZE 256
+
+/* Allocator for many small objects of a few fixed sizes.  Requests are
+ * rounded up to a size class and served from slabs taken from parent, so
+ * allocating and freeing is a push or pop on the class free list.
+ * otter_allocator_free returns whole slabs to the parent without visiting
+ * the individual blocks.  otter_free_sized skips the slab lookup otter_free
+ * needs.  Only fundamental alignments are supported and the returned
+ * allocator is not thread safe. */
+otter_allocator *otter_pool_create(otter_allocator *parent);
+
+#endif /* OTTER_POOL_H_ */
@@ -20,19 +20,66 @@
 #include "inc.h"
 #include "logger.h"
 #include "string.h"
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 typedef struct otter_process_id {
   int value;
 } otter_process_id;
 
+/* Jobs are grouped into classes so that memory hungry work (e.g. LTO links)
+ * can be weighted differently from ordinary compiles during admission. */
+typedef enum otter_process_job_class {
+  OTTER_PROCESS_JOB_CLASS_COMPILE,
+  OTTER_PROCESS_JOB_CLASS_LINK,
+  OTTER_PROCESS_JOB_CLASS_COUNT_,
+} otter_process_job_class;
+
+typedef struct otter_process_admission {
+  /* Estimated peak memory of a single job of each class, in bytes.  Updated
+   * from the peak RSS reported by wait4 as jobs complete. */
+  size_t weights[OTTER_PROCESS_JOB_CLASS_COUNT_];
+  /* Total bytes that running jobs may reserve.  0 disables the check. */
+  size_t memory_budget;
+  /* One minute load average above which spawns are deferred.  0 disables the
+   * check. */
+  double max_load_average;
+} otter_process_admission;
+
+/* Timing and resource usage of a single job.  Timestamps come from
+ * otter_clock_now_ns. */
+typedef struct otter_process_stats {
+  uint64_t queued_ns;   /* When the job was handed to the process manager */
+  uint64_t started_ns;  /* When the child was spawned */
+  uint64_t finished_ns; /* When the child was reaped */
+  uint64_t queue_wait_ns; /* Time spent waiting for admission */
+  uint64_t spawn_ns;      /* Time spent inside posix_spawn */
+  uint64_t user_ns;
+  uint64_t system_ns;
+  size_t peak_rss; /* Bytes, as reported by wait4 */
+} otter_process_stats;
+
+#define OTTER_PROCESS_MANAGER_FINISHED_JOBS 64
+
 typedef struct otter_process_manager otter_process_manager;
 typedef struct otter_process_manager_vtable {
   void (*process_manager_free)(otter_process_manager *);
   otter_process_id (*process_manager_queue)(otter_process_manager *,
-                                            otter_string *command);
+                                            otter_string *command,
+                                            otter_process_job_class job_class);
   void (*process_manager_wait)(otter_process_manager *, otter_process_id *ids,
                                size_t ids_length, int *exit_statuses);
+  void (*process_manager_set_admission)(
+      otter_process_manager *, const otter_process_admission *admission);
+  void (*process_manager_get_admission)(otter_process_manager *,
+                                        otter_process_admission *admission);
+  size_t (*process_manager_peak_rss)(otter_process_manager *,
+                                     otter_process_id id);
+  const char *(*process_manager_resolve)(otter_process_manager *,
+                                         const char *program);
+  bool (*process_manager_stats)(otter_process_manager *, otter_process_id id,
+                                otter_process_stats *stats);
 } otter_process_manager_vtable;
 
 struct otter_process_manager {
@@ -47,7 +94,35 @@ OTTER_DECLARE_TRIVIAL_CLEANUP_FUNC(otter_process_manager *,
 otter_process_id
 otter_process_manager_queue(otter_process_manager *process_manager,
                             otter_string *command);
+otter_process_id
+otter_process_manager_queue_job(otter_process_manager *process_manager,
+                                otter_string *command,
+                                otter_process_job_class job_class);
 void otter_process_manager_wait(otter_process_manager *process_manager,
                                 otter_process_id *ids, size_t ids_length,
                                 int *exit_statuses);
+void otter_process_manager_set_admission(
+    otter_process_manager *process_manager,
+    const otter_process_admission *admission);
+void otter_process_manager_get_admission(
+    otter_process_manager *process_manager,
+    otter_process_admission *admission);
+/* Returns 0 for unknown jobs, see otter_process_manager_stats for how long a
+ * job stays known */
+size_t otter_process_manager_peak_rss(otter_process_manager *process_manager,
+                                      otter_process_id id);
+/* Fills in the statistics of a job.  Returns false if the job is unknown or
+ * has not been waited for yet.  Only the last
+ * OTTER_PROCESS_MANAGER_FINISHED_JOBS jobs that were waited for stay known,
+ * read them right after waiting. */
+bool otter_process_manager_stats(otter_process_manager *process_manager,
+                                 otter_process_id id,
+                                 otter_process_stats *stats);
+/* Returns the absolute path of the given program, searching PATH the first
+ * time it is requested and answering from a cache afterwards.  Returns NULL
+ * when the program cannot be found.  The returned string is owned by the
+ * process manager. */
+const char *
+otter_process_manager_resolve(otter_process_manager *process_manager,
+                              const char *program);
 #endif /* OTTER_PROCESS_MANAGER_ */
@@ -18,8 +18,21 @@
 #define OTTER_STRING_H_
 #include "allocator.h"
 #include "inc.h"
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 typedef struct otter_string otter_string;
+
+/* A borrowed range of characters. The data is not necessarily NUL terminated
+ * and has to outlive the view. */
+typedef struct otter_string_view {
+  const char *data;
+  size_t length;
+} otter_string_view;
+
+/* Use as printf("%.*s", OTTER_STRING_VIEW_ARG(view)) */
+#define OTTER_STRING_VIEW_ARG(view) (int)(view).length, (view).data
+
 otter_string *otter_string_create(otter_allocator *allocator, const char *str,
                                   size_t length);
 otter_string *otter_string_format(otter_allocator *allocator,
@@ -43,4 +56,65 @@ otter_string **otter_string_split(otter_allocator *allocator,
 char **otter_string_split_cstr(otter_allocator *allocator,
                                const otter_string *str, const char *delimiters);
 
+/* Set of delimiter bytes, one bit per byte value */
+typedef struct otter_string_delimiters {
+  uint64_t bits[4];
+} otter_string_delimiters;
+
+/* Walks the tokens of a view without allocating or modifying it.  Like strtok,
+ * runs of delimiters are skipped and no empty tokens are produced, but all of
+ * the state lives in the iterator so it can be used from any thread. */
+typedef struct otter_string_split_iterator {
+  const char *position;
+  const char *end;
+  otter_string_delimiters delimiters;
+} otter_string_split_iterator;
+
+void otter_string_split_iterator_init(otter_string_split_iterator *iterator,
+                                      otter_string_view str,
+                                      const char *delimiters);
+/* Stores the next token in token and returns false when there is none left */
+bool otter_string_split_next(otter_string_split_iterator *iterator,
+                             otter_string_view *token);
+/* Splits str into a NULL terminated array of NUL terminated tokens that
+ * shares a single allocation with the characters, so the result is released
+ * with one otter_free.  count receives the number of tokens when not NULL. */
+char **otter_string_split_packed(otter_allocator *allocator,
+                                 otter_string_view str, const char *delimiters,
+                                 size_t *count);
+
+otter_string_view otter_string_view_from_cstr(const char *str);
+otter_string_view otter_string_view_of(const otter_string *str);
+otter_string *otter_string_from_view(otter_allocator *allocator,
+                                     otter_string_view view);
+int otter_string_compare_view(const otter_string *str, otter_string_view view);
+
+/* Accumulates a string with geometric growth, so appending n bytes costs
+ * O(n) in total.  The first failed append is sticky: later appends are
+ * ignored and otter_string_builder_finish returns NULL, so callers only have
+ * to check the result once. */
+typedef struct otter_string_builder {
+  otter_allocator *allocator;
+  otter_string *str;
+  bool failed;
+} otter_string_builder;
+
+void otter_string_builder_init(otter_string_builder *builder,
+                               otter_allocator *allocator);
+/* Makes room for length more characters without further allocations */
+bool otter_string_builder_reserve(otter_string_builder *builder, size_t length);
+bool otter_string_builder_append(otter_string_builder *builder,
+                                 const char *append, size_t length);
+bool otter_string_builder_append_cstr(otter_string_builder *builder,
+                                      const char *append);
+bool otter_string_builder_append_view(otter_string_builder *builder,
+                                      otter_string_view append);
+/* Formats directly into the spare capacity, reallocating at most once */
+bool otter_string_builder_append_fmt(otter_string_builder *builder,
+                                     const char *format, ...);
+size_t otter_string_builder_length(const otter_string_builder *builder);
+/* Hands the accumulated string to the caller and resets the builder */
+otter_string *otter_string_builder_finish(otter_string_builder *builder);
+void otter_string_builder_free(otter_string_builder *builder);
+
 #endif /* OTTER_STRING_H_ */
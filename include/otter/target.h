@@ -20,13 +20,28 @@
 #include "array.h"
 #include "filesystem.h"
 #include "inc.h"
+#include "intern.h"
 #include "logger.h"
+#include "map.h"
 #include "process_manager.h"
 #include "string.h"
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #define OTTER_XATTR_NAME "user.otter-sha1"
+#define OTTER_XATTR_COMMAND_NAME "user.otter-command-sha1"
+#define OTTER_XATTR_COST_NAME "user.otter-cost-ns"
+#define OTTER_XATTR_OUTPUT_NAME "user.otter-output-sha1"
+#define OTTER_SHA1_DIGEST_SIZE 20
+/* Generated commands write their output under the same name into a
+ * directory named after the building process inside this directory next to
+ * it, and it is renamed into place once it is complete */
+#define OTTER_TARGET_TEMP_DIR ".otter-tmp"
+/* Most targets build from a single file and few depend on more than a handful
+ * of others */
+#define OTTER_TARGET_INLINE_FILES 2
+#define OTTER_TARGET_INLINE_DEPENDENCIES 4
 #ifdef __linux__
 #define OTTER_CC "cc"
 #elif _WIN32
@@ -39,6 +54,16 @@ typedef enum otter_target_type {
   OTTER_TARGET_EXECUTABLE,
 } otter_target_type;
 
+/* Why a target has to be executed, as decided by otter_target_check_stale */
+typedef enum otter_target_stale_reason {
+  OTTER_TARGET_UP_TO_DATE,
+  OTTER_TARGET_STALE_MISSING_OUTPUT,
+  OTTER_TARGET_STALE_NO_DIGEST,
+  OTTER_TARGET_STALE_DIGEST_MISMATCH,
+  OTTER_TARGET_STALE_DEPENDENCY_REBUILT,
+  OTTER_TARGET_STALE_FLAGS_CHANGED,
+} otter_target_stale_reason;
+
 typedef struct otter_target otter_target;
 struct otter_target {
   otter_allocator *allocator;
@@ -47,21 +72,63 @@ struct otter_target {
   otter_process_manager *process_manager;
   otter_string *name;
   otter_target_type type;
-  OTTER_ARRAY_DECLARE(otter_string *, files);
+  OTTER_SMALL_ARRAY_DECLARE(otter_string *, files, OTTER_TARGET_INLINE_FILES);
 
   otter_string *command;
   otter_string *cc_flags;
   otter_string *include_flags;
-  OTTER_ARRAY_DECLARE(otter_string *, argv);
-  OTTER_ARRAY_DECLARE(otter_target *, dependencies);
+  /* Arguments are interned, so duplicates are found by comparing handles */
+  otter_intern_table *strings;
+  bool owns_strings;
+  OTTER_ARRAY_DECLARE(const otter_interned_string *, argv);
+  /* Index of argv, only built once argv outgrows a linear scan */
+  OTTER_SET_DECLARE(const otter_interned_string *, argv_set);
+  OTTER_SMALL_ARRAY_DECLARE(otter_target *, dependencies,
+                            OTTER_TARGET_INLINE_DEPENDENCIES);
   unsigned char *hash;
   unsigned int hash_size;
   bool executed;
+  otter_target_stale_reason stale_reason;
+  /* Write the output to a temporary file and rename it into place */
+  bool atomic_output;
+
+  /* Timing recorded for build traces */
+  uint64_t hash_start_ns;
+  uint64_t hash_ns;
+  bool has_process_stats;
+  otter_process_stats process_stats;
 };
 
 int otter_target_execute(otter_target *target);
+/* Decides whether the target is out of date without executing anything.
+ * Dependencies count as rebuilt when their executed flag is set. */
+otter_target_stale_reason otter_target_check_stale(otter_target *target);
+const char *otter_target_stale_reason_str(otter_target_stale_reason reason);
+/* Wall time of the last successful execution, or 0 if it is unknown */
+uint64_t otter_target_historical_cost_ns(const otter_target *target);
 void otter_target_free(otter_target *target);
 OTTER_DECLARE_TRIVIAL_CLEANUP_FUNC(otter_target *, otter_target_free);
+/* Everything needed to create a target. The views are copied, so they only
+ * have to live for the duration of otter_target_create. */
+typedef struct otter_target_spec {
+  otter_target_type type;
+  otter_string_view name;
+  otter_string_view flags;
+  otter_string_view include_flags;
+  const otter_string_view *files;
+  size_t files_length;
+  /* NULL terminated, may be NULL when there are no dependencies */
+  otter_target **dependencies;
+  /* Table shared between targets for their arguments.  It has to outlive
+   * the target.  When NULL the target creates a table of its own. */
+  otter_intern_table *strings;
+} otter_target_spec;
+
+otter_target *otter_target_create(const otter_target_spec *spec,
+                                  otter_allocator *allocator,
+                                  otter_filesystem *filesystem,
+                                  otter_logger *logger,
+                                  otter_process_manager *process_manager);
 otter_target *otter_target_create_c_object(
     const otter_string *name, const otter_string *flags,
     const otter_string *include_flags, otter_allocator *allocator,
@@ -0,0 +1,32 @@
+/*
+  otter Copyright (C) 2026 Nathaniel Wright
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef OTTER_THREAD_CACHE_H_
+#define OTTER_THREAD_CACHE_H_
+#include "allocator.h"
+
+/* Largest request served from the per-thread caches */
+#define OTTER_THREAD_CACHE_MAX_BLOCK_SIZE 256
+
+/* Thread safe allocator for small objects.  Every thread keeps a magazine of
+ * free blocks per size class, so allocating and freeing takes no lock until
+ * a magazine runs empty or full and is exchanged with the shared depot.
+ * Blocks freed on another thread than they were allocated on are fine.
+ * Larger requests go to parent, which has to be thread safe itself.  All
+ * threads must stop using the allocator before it is freed. */
+otter_allocator *otter_thread_cache_create(otter_allocator *parent);
+
+#endif /* OTTER_THREAD_CACHE_H_ */
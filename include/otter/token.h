@@ -17,6 +17,7 @@
 #ifndef OTTER_TOKEN_H_
 #define OTTER_TOKEN_H_
 #include "allocator.h"
+#include "intern.h"
 
 #define OTTER_TOKEN_TYPES                                                      \
   X(OTTER_TOKEN_LEFT_PAREN, "(")                                               \
@@ -56,9 +57,15 @@ typedef struct otter_token {
 
 typedef struct otter_token_identifier {
   otter_token base;
-  char *value;
+  char *value; /* NULL when the identifier is interned */
+  const otter_interned_string *interned;
 } otter_token_identifier;
 
+static inline const char *
+otter_token_identifier_name(const otter_token_identifier *ident) {
+  return ident->interned != NULL ? ident->interned->data : ident->value;
+}
+
 typedef struct otter_token_integer {
   otter_token base;
   int value;
@@ -23,6 +23,8 @@
 #include "object.h"
 typedef struct otter_vm {
   otter_allocator *allocator;
+  /* Pool the VM allocates its objects from */
+  otter_allocator *object_allocator;
   otter_bytecode *bytecode;
   otter_logger *logger;
   size_t stack_index;
@@ -16,6 +16,7 @@
  */
 
 #include "otter/allocator.h"
+#include <stdint.h>
 #include <stdlib.h>
 static void otter_free_allocator_impl(otter_allocator *allocator) {
   free(allocator);
@@ -34,11 +35,36 @@ static void otter_free_impl(otter_allocator * /* unused */, void *ptr) {
   free(ptr);
 }
 
+static void *otter_aligned_malloc_impl(otter_allocator * /* unused */,
+                                       size_t alignment, size_t size) {
+  if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+    return NULL;
+  }
+
+  if (alignment < sizeof(void *)) {
+    alignment = sizeof(void *);
+  }
+
+  /* aligned_alloc wants a size that is a multiple of the alignment */
+  const size_t remainder = size % alignment;
+  if (remainder != 0) {
+    if (size > SIZE_MAX - (alignment - remainder)) {
+      return NULL;
+    }
+
+    size += alignment - remainder;
+  }
+
+  return aligned_alloc(alignment, size);
+}
+
 static otter_allocator_vtable vtable = {
     .free_allocator = &otter_free_allocator_impl,
     .malloc = &otter_malloc_impl,
     .realloc = &otter_realloc_impl,
     .free = &otter_free_impl,
+    .aligned_malloc = &otter_aligned_malloc_impl,
+    .capabilities = OTTER_ALLOCATOR_THREAD_SAFE,
 };
 
 otter_allocator *otter_allocator_create() {
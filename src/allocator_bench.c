@@ -0,0 +1,104 @@
+/*
+  otter Copyright (C) 2026 Nathaniel Wright
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "otter/allocator.h"
+#include "otter/arena.h"
+#include "otter/bench.h"
+#include "otter/lexer.h"
+#include "otter/token.h"
+#include <stdlib.h>
+
+/* Lexes sources the size of the ones in lexer_tests with the libc allocator,
+ * freeing every token afterwards, and with an arena that is rewound after
+ * each run instead. */
+
+#define OTTER_BENCH_ITERATIONS 200000
+
+static const char *bench_sources[] = {
+    "var x = 1 ;\n",
+    "fn add(a, b) { return a + b ; }\n",
+    "var greeting = \"hello world\" ;\nvar count = 42 ;\n",
+    "if (x == 10) { y = y - 1 ; } else { y = y + 1 ; }\n",
+};
+
+#define OTTER_BENCH_SOURCES_LENGTH                                             \
+  (sizeof(bench_sources) / sizeof(bench_sources[0]))
+
+static bool bench_lex(otter_allocator *allocator, const char *source,
+                      bool free_tokens) {
+  otter_lexer *lexer = otter_lexer_create(allocator, source);
+  if (lexer == NULL) {
+    return false;
+  }
+
+  size_t tokens_length = 0;
+  otter_token **tokens = otter_lexer_tokenize(lexer, &tokens_length);
+  if (free_tokens) {
+    for (size_t i = 0; i < tokens_length; i++) {
+      otter_token_free(allocator, tokens[i]);
+    }
+
+    otter_free(allocator, tokens);
+    otter_lexer_free(lexer);
+  }
+
+  return tokens != NULL;
+}
+
+int main(void) {
+  OTTER_CLEANUP(otter_allocator_free_p)
+  otter_allocator *allocator = otter_allocator_create();
+  if (allocator == NULL) {
+    return EXIT_FAILURE;
+  }
+
+  OTTER_CLEANUP(otter_allocator_free_p)
+  otter_allocator *arena =
+      otter_arena_create(allocator, OTTER_ARENA_DEFAULT_CHUNK_SIZE);
+  if (arena == NULL) {
+    return EXIT_FAILURE;
+  }
+
+  size_t completed = 0;
+  uint64_t start = otter_bench_now_ns();
+  for (; completed < OTTER_BENCH_ITERATIONS; completed++) {
+    const char *source =
+        bench_sources[completed % OTTER_BENCH_SOURCES_LENGTH];
+    if (!bench_lex(allocator, source, true)) {
+      break;
+    }
+  }
+
+  otter_bench_report("lexer libc allocator", completed,
+                     otter_bench_now_ns() - start);
+
+  completed = 0;
+  start = otter_bench_now_ns();
+  const otter_arena_mark mark = otter_arena_mark_get(arena);
+  for (; completed < OTTER_BENCH_ITERATIONS; completed++) {
+    const char *source =
+        bench_sources[completed % OTTER_BENCH_SOURCES_LENGTH];
+    const bool lexed = bench_lex(arena, source, false);
+    otter_arena_rewind(arena, mark);
+    if (!lexed) {
+      break;
+    }
+  }
+
+  otter_bench_report("lexer arena allocator", completed,
+                     otter_bench_now_ns() - start);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,348 @@
+/*
+  otter Copyright (C) 2026 Nathaniel Wright
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#define _GNU_SOURCE
+#include "otter/allocator_stats.h"
+#include <dlfcn.h>
+#include <stdalign.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#define OTTER_ALLOCATOR_STATS_INITIAL_SITES 64
+
+/* Placed right in front of every allocation so that frees know the size and
+ * call site they have to be accounted against.  Over-aligned allocations
+ * leave a gap before the header, offset is the distance from the start of
+ * the parent allocation to the returned memory. */
+typedef struct otter_allocator_stats_header {
+  alignas(max_align_t) size_t size;
+  void *site;
+  size_t offset;
+} otter_allocator_stats_header;
+
+typedef struct otter_allocator_stats_site {
+  void *address;
+  size_t allocations;
+  size_t bytes_allocated;
+  size_t live_allocations;
+  size_t live_bytes;
+} otter_allocator_stats_site;
+
+typedef struct otter_allocator_stats_impl {
+  otter_allocator base;
+  otter_allocator *parent;
+  FILE *report;
+  otter_allocator_stats stats;
+  /* Open addressing table keyed by call site address */
+  otter_allocator_stats_site *sites;
+  size_t sites_length;
+  size_t sites_capacity;
+} otter_allocator_stats_impl;
+
+static size_t otter_allocator_stats_hash(const void *address) {
+  uint64_t value = (uint64_t)(uintptr_t)address;
+  value ^= value >> 33;
+  value *= 0xff51afd7ed558ccdULL;
+  value ^= value >> 33;
+  return (size_t)value;
+}
+
+static otter_allocator_stats_site *
+otter_allocator_stats_find_site(otter_allocator_stats_site *sites,
+                                size_t capacity, void *address) {
+  size_t index = otter_allocator_stats_hash(address) & (capacity - 1);
+  while (sites[index].address != NULL && sites[index].address != address) {
+    index = (index + 1) & (capacity - 1);
+  }
+
+  return &sites[index];
+}
+
+static bool otter_allocator_stats_grow_sites(otter_allocator_stats_impl *impl) {
+  const size_t capacity = impl->sites_capacity == 0
+                              ? OTTER_ALLOCATOR_STATS_INITIAL_SITES
+                              : impl->sites_capacity * 2;
+  otter_allocator_stats_site *sites =
+      otter_malloc(impl->parent, capacity * sizeof(*sites));
+  if (sites == NULL) {
+    return false;
+  }
+
+  memset(sites, 0, capacity * sizeof(*sites));
+  for (size_t i = 0; i < impl->sites_capacity; i++) {
+    if (impl->sites[i].address != NULL) {
+      *otter_allocator_stats_find_site(sites, capacity,
+                                       impl->sites[i].address) =
+          impl->sites[i];
+    }
+  }
+
+  otter_free(impl->parent, impl->sites);
+  impl->sites = sites;
+  impl->sites_capacity = capacity;
+  return true;
+}
+
+/* Returns NULL only when the table cannot grow, in which case the totals are
+ * still recorded but the call site is not */
+static otter_allocator_stats_site *
+otter_allocator_stats_site_get(otter_allocator_stats_impl *impl,
+                               void *address) {
+  if ((impl->sites_length + 1) * 4 > impl->sites_capacity * 3 &&
+      !otter_allocator_stats_grow_sites(impl)) {
+    return NULL;
+  }
+
+  otter_allocator_stats_site *site = otter_allocator_stats_find_site(
+      impl->sites, impl->sites_capacity, address);
+  if (site->address == NULL) {
+    site->address = address;
+    impl->sites_length++;
+  }
+
+  return site;
+}
+
+static void otter_allocator_stats_add(otter_allocator_stats_impl *impl,
+                                      size_t size, void *address) {
+  impl->stats.bytes_allocated += size;
+  impl->stats.live_allocations++;
+  impl->stats.live_bytes += size;
+  if (impl->stats.live_bytes > impl->stats.peak_live_bytes) {
+    impl->stats.peak_live_bytes = impl->stats.live_bytes;
+  }
+
+  otter_allocator_stats_site *site =
+      otter_allocator_stats_site_get(impl, address);
+  if (site != NULL) {
+    site->allocations++;
+    site->bytes_allocated += size;
+    site->live_allocations++;
+    site->live_bytes += size;
+  }
+}
+
+static void otter_allocator_stats_remove(otter_allocator_stats_impl *impl,
+                                         size_t size, void *address) {
+  impl->stats.live_allocations--;
+  impl->stats.live_bytes -= size;
+  if (impl->sites_capacity == 0) {
+    return;
+  }
+
+  otter_allocator_stats_site *site = otter_allocator_stats_find_site(
+      impl->sites, impl->sites_capacity, address);
+  if (site->address != NULL) {
+    site->live_allocations--;
+    site->live_bytes -= size;
+  }
+}
+
+static otter_allocator_stats_header *
+otter_allocator_stats_header_of(void *pointer) {
+  return (otter_allocator_stats_header *)pointer - 1;
+}
+
+static void *otter_allocator_stats_allocate(otter_allocator_stats_impl *impl,
+                                            size_t alignment, size_t size,
+                                            void *address) {
+  size_t offset = sizeof(otter_allocator_stats_header);
+  if (alignment > offset) {
+    offset = alignment;
+  }
+
+  if (size > SIZE_MAX - offset) {
+    return NULL;
+  }
+
+  unsigned char *base =
+      otter_aligned_malloc(impl->parent, alignment, offset + size);
+  if (base == NULL) {
+    return NULL;
+  }
+
+  otter_allocator_stats_header *header =
+      otter_allocator_stats_header_of(base + offset);
+  header->size = size;
+  header->site = address;
+  header->offset = offset;
+  impl->stats.allocations++;
+  otter_allocator_stats_add(impl, size, address);
+  return base + offset;
+}
+
+static void *otter_allocator_stats_malloc_impl(otter_allocator *allocator,
+                                               size_t size) {
+  return otter_allocator_stats_allocate(
+      (otter_allocator_stats_impl *)allocator, alignof(max_align_t), size,
+      __builtin_return_address(0));
+}
+
+static void *
+otter_allocator_stats_aligned_malloc_impl(otter_allocator *allocator,
+                                          size_t alignment, size_t size) {
+  return otter_allocator_stats_allocate(
+      (otter_allocator_stats_impl *)allocator, alignment, size,
+      __builtin_return_address(0));
+}
+
+static void *otter_allocator_stats_realloc_impl(otter_allocator *allocator,
+                                                void *pointer, size_t size) {
+  otter_allocator_stats_impl *impl = (otter_allocator_stats_impl *)allocator;
+  if (pointer == NULL) {
+    return otter_allocator_stats_allocate(impl, alignof(max_align_t), size,
+                                          __builtin_return_address(0));
+  }
+
+  otter_allocator_stats_header *header =
+      otter_allocator_stats_header_of(pointer);
+  const size_t offset = header->offset;
+  const size_t old_size = header->size;
+  void *old_site = header->site;
+  if (size > SIZE_MAX - offset) {
+    return NULL;
+  }
+
+  unsigned char *base = otter_realloc(
+      impl->parent, (unsigned char *)pointer - offset, offset + size);
+  if (base == NULL) {
+    return NULL;
+  }
+
+  header = otter_allocator_stats_header_of(base + offset);
+  header->size = size;
+  header->site = __builtin_return_address(0);
+  impl->stats.reallocations++;
+  otter_allocator_stats_remove(impl, old_size, old_site);
+  otter_allocator_stats_add(impl, size, header->site);
+  return base + offset;
+}
+
+static void otter_allocator_stats_free_impl(otter_allocator *allocator,
+                                            void *pointer) {
+  otter_allocator_stats_impl *impl = (otter_allocator_stats_impl *)allocator;
+  if (pointer == NULL) {
+    return;
+  }
+
+  otter_allocator_stats_header *header =
+      otter_allocator_stats_header_of(pointer);
+  impl->stats.frees++;
+  otter_allocator_stats_remove(impl, header->size, header->site);
+  otter_free(impl->parent, (unsigned char *)pointer - header->offset);
+}
+
+static void otter_allocator_stats_free_sized_impl(otter_allocator *allocator,
+                                                  void *pointer, size_t size) {
+  otter_allocator_stats_impl *impl = (otter_allocator_stats_impl *)allocator;
+  if (pointer == NULL) {
+    return;
+  }
+
+  otter_allocator_stats_header *header =
+      otter_allocator_stats_header_of(pointer);
+  if (header->size != size) {
+    impl->stats.size_mismatches++;
+  }
+
+  impl->stats.frees++;
+  otter_allocator_stats_remove(impl, header->size, header->site);
+  otter_free_sized(impl->parent, (unsigned char *)pointer - header->offset,
+                   header->offset + header->size);
+}
+
+void otter_allocator_stats_report(otter_allocator *allocator, FILE *file) {
+  otter_allocator_stats_impl *impl = (otter_allocator_stats_impl *)allocator;
+  fprintf(file,
+          "%zu allocations, %zu reallocations, %zu frees, %zu bytes "
+          "allocated, %zu bytes peak\n",
+          impl->stats.allocations, impl->stats.reallocations,
+          impl->stats.frees, impl->stats.bytes_allocated,
+          impl->stats.peak_live_bytes);
+  if (impl->stats.size_mismatches != 0) {
+    fprintf(file, "%zu sized frees did not match the allocated size\n",
+            impl->stats.size_mismatches);
+  }
+
+  if (impl->stats.live_allocations == 0) {
+    return;
+  }
+
+  fprintf(file, "%zu bytes leaked in %zu allocations\n",
+          impl->stats.live_bytes, impl->stats.live_allocations);
+  for (size_t i = 0; i < impl->sites_capacity; i++) {
+    const otter_allocator_stats_site *site = &impl->sites[i];
+    if (site->address == NULL || site->live_allocations == 0) {
+      continue;
+    }
+
+    Dl_info info;
+    if (dladdr(site->address, &info) != 0 && info.dli_sname != NULL) {
+      fprintf(file, "  %zu bytes in %zu allocations from %s+%#tx (%s)\n",
+              site->live_bytes, site->live_allocations, info.dli_sname,
+              (char *)site->address - (char *)info.dli_saddr,
+              info.dli_fname);
+    } else {
+      fprintf(file, "  %zu bytes in %zu allocations from %p\n",
+              site->live_bytes, site->live_allocations, site->address);
+    }
+  }
+}
+
+static void otter_allocator_stats_free_allocator_impl(
+    otter_allocator *allocator) {
+  otter_allocator_stats_impl *impl = (otter_allocator_stats_impl *)allocator;
+  if (impl->report != NULL) {
+    otter_allocator_stats_report(allocator, impl->report);
+  }
+
+  otter_free(impl->parent, impl->sites);
+  otter_free(impl->parent, impl);
+}
+
+otter_allocator *otter_allocator_stats_create(otter_allocator *parent,
+                                              FILE *report) {
+  if (parent == NULL) {
+    return NULL;
+  }
+
+  otter_allocator_stats_impl *impl = otter_malloc(parent, sizeof(*impl));
+  if (impl == NULL) {
+    return NULL;
+  }
+
+  static otter_allocator_vtable vtable = {
+      .free_allocator = otter_allocator_stats_free_allocator_impl,
+      .malloc = otter_allocator_stats_malloc_impl,
+      .realloc = otter_allocator_stats_realloc_impl,
+      .free = otter_allocator_stats_free_impl,
+      .aligned_malloc = otter_allocator_stats_aligned_malloc_impl,
+      .free_sized = otter_allocator_stats_free_sized_impl,
+  };
+
+  memset(impl, 0, sizeof(*impl));
+  impl->base.vtable = &vtable;
+  impl->parent = parent;
+  impl->report = report;
+  return (otter_allocator *)impl;
+}
+
+void otter_allocator_stats_get(otter_allocator *allocator,
+                               otter_allocator_stats *stats) {
+  otter_allocator_stats_impl *impl = (otter_allocator_stats_impl *)allocator;
+  *stats = impl->stats;
+}
@@ -0,0 +1,571 @@
+/*
+  otter Copyright (C) 2026 Nathaniel Wright
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "otter/allocator_stats.h"
+#include "otter/arena.h"
+#include "otter/pool.h"
+#include "otter/test.h"
+#include "otter/thread_cache.h"
+#include <pthread.h>
+#include <stdalign.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+OTTER_TEST(arena_allocations_are_aligned) {
+  otter_allocator *arena = NULL;
+
+  arena = otter_arena_create(OTTER_TEST_ALLOCATOR, 256);
+  OTTER_ASSERT(arena != NULL);
+
+  for (size_t size = 1; size < 64; size++) {
+    void *pointer = otter_malloc(arena, size);
+    OTTER_ASSERT(pointer != NULL);
+    OTTER_ASSERT((uintptr_t)pointer % alignof(max_align_t) == 0);
+    memset(pointer, 0xAB, size);
+    otter_free(arena, pointer);
+  }
+
+  OTTER_TEST_END(if (arena) otter_allocator_free(arena););
+}
+
+OTTER_TEST(arena_realloc_preserves_contents) {
+  otter_allocator *arena = NULL;
+
+  arena = otter_arena_create(OTTER_TEST_ALLOCATOR, 128);
+  OTTER_ASSERT(arena != NULL);
+
+  char *first = otter_malloc(arena, 8);
+  OTTER_ASSERT(first != NULL);
+  memcpy(first, "otter", 6);
+
+  /* The most recent allocation grows in place */
+  char *grown = otter_realloc(arena, first, 32);
+  OTTER_ASSERT(grown == first);
+  OTTER_ASSERT(strcmp(grown, "otter") == 0);
+
+  /* Once something else is allocated the contents have to be copied */
+  char *other = otter_malloc(arena, 8);
+  OTTER_ASSERT(other != NULL);
+  char *moved = otter_realloc(arena, grown, 512);
+  OTTER_ASSERT(moved != NULL);
+  OTTER_ASSERT(moved != grown);
+  OTTER_ASSERT(strcmp(moved, "otter") == 0);
+
+  OTTER_TEST_END(if (arena) otter_allocator_free(arena););
+}
+
+OTTER_TEST(arena_rewind_reuses_memory) {
+  otter_allocator *arena = NULL;
+
+  arena = otter_arena_create(OTTER_TEST_ALLOCATOR, 256);
+  OTTER_ASSERT(arena != NULL);
+
+  void *kept = otter_malloc(arena, 16);
+  OTTER_ASSERT(kept != NULL);
+  const size_t used = otter_arena_used(arena);
+
+  otter_arena_mark mark = otter_arena_mark_get(arena);
+  void *first = otter_malloc(arena, 16);
+  OTTER_ASSERT(first != NULL);
+  /* Spill over into further chunks so rewinding has to release them */
+  for (int i = 0; i < 32; i++) {
+    OTTER_ASSERT(otter_malloc(arena, 100) != NULL);
+  }
+
+  otter_arena_rewind(arena, mark);
+  OTTER_ASSERT(otter_arena_used(arena) == used);
+  OTTER_ASSERT(otter_malloc(arena, 16) == first);
+
+  OTTER_TEST_END(if (arena) otter_allocator_free(arena););
+}
+
+OTTER_TEST(arena_large_allocation_gets_own_chunk) {
+  otter_allocator *arena = NULL;
+
+  arena = otter_arena_create(OTTER_TEST_ALLOCATOR, 64);
+  OTTER_ASSERT(arena != NULL);
+
+  unsigned char *large = otter_malloc(arena, 4096);
+  OTTER_ASSERT(large != NULL);
+  memset(large, 0x5A, 4096);
+  OTTER_ASSERT(large[4095] == 0x5A);
+  OTTER_ASSERT(otter_malloc(arena, 8) != NULL);
+
+  OTTER_TEST_END(if (arena) otter_allocator_free(arena););
+}
+
+OTTER_TEST(arena_reset_releases_everything) {
+  otter_allocator *arena = NULL;
+
+  arena = otter_arena_create(OTTER_TEST_ALLOCATOR, 128);
+  OTTER_ASSERT(arena != NULL);
+
+  for (int i = 0; i < 16; i++) {
+    OTTER_ASSERT(otter_malloc(arena, 48) != NULL);
+  }
+
+  otter_arena_reset(arena);
+  OTTER_ASSERT(otter_arena_used(arena) == 0);
+  OTTER_ASSERT(otter_malloc(arena, 48) != NULL);
+
+  OTTER_TEST_END(if (arena) otter_allocator_free(arena););
+}
+
+OTTER_TEST(arena_create_rejects_invalid_arguments) {
+  OTTER_ASSERT(otter_arena_create(NULL, 64) == NULL);
+  OTTER_ASSERT(otter_arena_create(OTTER_TEST_ALLOCATOR, 0) == NULL);
+  OTTER_TEST_END();
+}
+
+OTTER_TEST(pool_reuses_freed_blocks_of_same_class) {
+  otter_allocator *pool = NULL;
+
+  pool = otter_pool_create(OTTER_TEST_ALLOCATOR);
+  OTTER_ASSERT(pool != NULL);
+
+  void *first = otter_malloc(pool, 24);
+  void *second = otter_malloc(pool, 24);
+  OTTER_ASSERT(first != NULL && second != NULL && first != second);
+  OTTER_ASSERT((uintptr_t)first % alignof(max_align_t) == 0);
+
+  otter_free(pool, first);
+  /* Sizes that round up to the same class share the free list */
+  OTTER_ASSERT(otter_malloc(pool, 20) == first);
+
+  void *other_class = otter_malloc(pool, 64);
+  OTTER_ASSERT(other_class != NULL);
+  otter_free(pool, other_class);
+  OTTER_ASSERT(otter_malloc(pool, 24) != other_class);
+
+  OTTER_TEST_END(if (pool) otter_allocator_free(pool););
+}
+
+OTTER_TEST(pool_serves_many_objects_across_slabs) {
+  otter_allocator *pool = NULL;
+  int **objects = NULL;
+
+  pool = otter_pool_create(OTTER_TEST_ALLOCATOR);
+  OTTER_ASSERT(pool != NULL);
+
+  const size_t count = 20000;
+  objects = otter_malloc(OTTER_TEST_ALLOCATOR, count * sizeof(*objects));
+  OTTER_ASSERT(objects != NULL);
+  for (size_t i = 0; i < count; i++) {
+    objects[i] = otter_malloc(pool, 16);
+    OTTER_ASSERT(objects[i] != NULL);
+    *objects[i] = (int)i;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    OTTER_ASSERT(*objects[i] == (int)i);
+  }
+
+  /* Freeing individual blocks is optional, the slabs go with the pool */
+  for (size_t i = 0; i < count; i += 2) {
+    otter_free(pool, objects[i]);
+  }
+
+  OTTER_TEST_END(if (objects) otter_free(OTTER_TEST_ALLOCATOR, objects);
+                 if (pool) otter_allocator_free(pool););
+}
+
+OTTER_TEST(pool_forwards_large_allocations_and_realloc) {
+  otter_allocator *pool = NULL;
+
+  pool = otter_pool_create(OTTER_TEST_ALLOCATOR);
+  OTTER_ASSERT(pool != NULL);
+
+  char *small = otter_malloc(pool, 16);
+  OTTER_ASSERT(small != NULL);
+  memcpy(small, "otter", 6);
+
+  char *large = otter_realloc(pool, small, OTTER_POOL_MAX_BLOCK_SIZE * 4);
+  OTTER_ASSERT(large != NULL);
+  OTTER_ASSERT(strcmp(large, "otter") == 0);
+
+  large = otter_realloc(pool, large, OTTER_POOL_MAX_BLOCK_SIZE * 8);
+  OTTER_ASSERT(large != NULL);
+  OTTER_ASSERT(strcmp(large, "otter") == 0);
+  otter_free(pool, large);
+
+  OTTER_TEST_END(if (pool) otter_allocator_free(pool););
+}
+
+OTTER_TEST(pool_releases_large_allocations_with_the_pool) {
+  otter_allocator *stats = NULL;
+  otter_allocator *pool = NULL;
+
+  stats = otter_allocator_stats_create(OTTER_TEST_ALLOCATOR, NULL);
+  OTTER_ASSERT(stats != NULL);
+  pool = otter_pool_create(stats);
+  OTTER_ASSERT(pool != NULL);
+
+  char *large = otter_malloc(pool, OTTER_POOL_MAX_BLOCK_SIZE + 1);
+  OTTER_ASSERT(large != NULL);
+  OTTER_ASSERT((uintptr_t)large % alignof(max_align_t) == 0);
+  char *grown = otter_malloc(pool, 16);
+  OTTER_ASSERT(grown != NULL);
+  grown = otter_realloc(pool, grown, OTTER_POOL_MAX_BLOCK_SIZE * 4);
+  OTTER_ASSERT(grown != NULL);
+  char *freed = otter_malloc(pool, OTTER_POOL_MAX_BLOCK_SIZE * 2);
+  OTTER_ASSERT(freed != NULL);
+  otter_free_sized(pool, freed, OTTER_POOL_MAX_BLOCK_SIZE * 2);
+
+  /* Neither large block is freed on its own */
+  otter_allocator_free(pool);
+  pool = NULL;
+
+  otter_allocator_stats counts;
+  otter_allocator_stats_get(stats, &counts);
+  OTTER_ASSERT(counts.live_allocations == 0);
+  OTTER_ASSERT(counts.size_mismatches == 0);
+
+  OTTER_TEST_END(if (pool) otter_allocator_free(pool);
+                 if (stats) otter_allocator_free(stats););
+}
+
+OTTER_TEST(allocator_stats_counts_allocations_and_peak) {
+  otter_allocator *stats = NULL;
+
+  stats = otter_allocator_stats_create(OTTER_TEST_ALLOCATOR, NULL);
+  OTTER_ASSERT(stats != NULL);
+
+  void *first = otter_malloc(stats, 100);
+  void *second = otter_malloc(stats, 50);
+  OTTER_ASSERT(first != NULL && second != NULL);
+  OTTER_ASSERT((uintptr_t)first % alignof(max_align_t) == 0);
+  otter_free(stats, first);
+
+  second = otter_realloc(stats, second, 200);
+  OTTER_ASSERT(second != NULL);
+
+  otter_allocator_stats totals;
+  otter_allocator_stats_get(stats, &totals);
+  OTTER_ASSERT(totals.allocations == 2);
+  OTTER_ASSERT(totals.reallocations == 1);
+  OTTER_ASSERT(totals.frees == 1);
+  OTTER_ASSERT(totals.bytes_allocated == 350);
+  OTTER_ASSERT(totals.peak_live_bytes == 200);
+  OTTER_ASSERT(totals.live_allocations == 1);
+  OTTER_ASSERT(totals.live_bytes == 200);
+
+  otter_free(stats, second);
+  otter_allocator_stats_get(stats, &totals);
+  OTTER_ASSERT(totals.live_allocations == 0);
+  OTTER_ASSERT(totals.live_bytes == 0);
+
+  OTTER_TEST_END(if (stats) otter_allocator_free(stats););
+}
+
+OTTER_TEST(allocator_stats_reports_leaking_call_sites) {
+  otter_allocator *stats = NULL;
+  FILE *report = NULL;
+  char *contents = NULL;
+  size_t contents_length = 0;
+  void *leaked = NULL;
+
+  stats = otter_allocator_stats_create(OTTER_TEST_ALLOCATOR, NULL);
+  OTTER_ASSERT(stats != NULL);
+
+  leaked = otter_malloc(stats, 64);
+  OTTER_ASSERT(leaked != NULL);
+
+  report = open_memstream(&contents, &contents_length);
+  OTTER_ASSERT(report != NULL);
+  otter_allocator_stats_report(stats, report);
+  fclose(report);
+  report = NULL;
+
+  OTTER_ASSERT(strstr(contents, "64 bytes leaked in 1 allocations") != NULL);
+  OTTER_ASSERT(strstr(contents, "64 bytes in 1 allocations from") != NULL);
+
+  OTTER_TEST_END(if (report) fclose(report); free(contents);
+                 if (leaked) otter_free(stats, leaked);
+                 if (stats) otter_allocator_free(stats););
+}
+
+OTTER_TEST(allocator_thread_safety_capability) {
+  otter_allocator *libc = NULL;
+  otter_allocator *arena = NULL;
+  otter_allocator *pool = NULL;
+
+  /* Not the test allocator, test_driver --stats wraps it in one that is not
+   * safe to share */
+  libc = otter_allocator_create();
+  OTTER_ASSERT(libc != NULL);
+  OTTER_ASSERT(otter_allocator_thread_safe(libc));
+
+  arena = otter_arena_create(OTTER_TEST_ALLOCATOR, 64);
+  OTTER_ASSERT(arena != NULL);
+  OTTER_ASSERT(!otter_allocator_thread_safe(arena));
+
+  pool = otter_pool_create(OTTER_TEST_ALLOCATOR);
+  OTTER_ASSERT(pool != NULL);
+  OTTER_ASSERT(!otter_allocator_thread_safe(pool));
+
+  /* A thread cache needs a parent that is safe to share */
+  OTTER_ASSERT(otter_thread_cache_create(pool) == NULL);
+
+  OTTER_TEST_END(if (pool) otter_allocator_free(pool);
+                 if (arena) otter_allocator_free(arena);
+                 if (libc) otter_allocator_free(libc););
+}
+
+OTTER_TEST(thread_cache_reuses_blocks_and_forwards_large) {
+  otter_allocator *libc = NULL;
+  otter_allocator *cache = NULL;
+
+  libc = otter_allocator_create();
+  OTTER_ASSERT(libc != NULL);
+
+  cache = otter_thread_cache_create(libc);
+  OTTER_ASSERT(cache != NULL);
+  OTTER_ASSERT(otter_allocator_thread_safe(cache));
+
+  char *small = otter_malloc(cache, 24);
+  OTTER_ASSERT(small != NULL);
+  OTTER_ASSERT((uintptr_t)small % alignof(max_align_t) == 0);
+  otter_free(cache, small);
+  OTTER_ASSERT(otter_malloc(cache, 32) == small);
+  memcpy(small, "otter", 6);
+
+  char *large =
+      otter_realloc(cache, small, OTTER_THREAD_CACHE_MAX_BLOCK_SIZE * 2);
+  OTTER_ASSERT(large != NULL);
+  OTTER_ASSERT(strcmp(large, "otter") == 0);
+
+  small = otter_realloc(cache, large, 8);
+  OTTER_ASSERT(small != NULL);
+  OTTER_ASSERT(memcmp(small, "otter", 6) == 0);
+  otter_free(cache, small);
+
+  OTTER_TEST_END(if (cache) otter_allocator_free(cache);
+                 if (libc) otter_allocator_free(libc););
+}
+
+#define THREAD_CACHE_TEST_THREADS 4
+#define THREAD_CACHE_TEST_OBJECTS 4096
+
+typedef struct thread_cache_test_thread {
+  otter_allocator *cache;
+  size_t **objects;
+  bool failed;
+} thread_cache_test_thread;
+
+static void *thread_cache_test_allocate(void *argument) {
+  thread_cache_test_thread *thread = argument;
+  for (size_t i = 0; i < THREAD_CACHE_TEST_OBJECTS; i++) {
+    thread->objects[i] = otter_malloc(thread->cache, 16 + (i % 8) * 16);
+    if (thread->objects[i] == NULL) {
+      thread->failed = true;
+      return NULL;
+    }
+
+    *thread->objects[i] = i;
+  }
+
+  return NULL;
+}
+
+static void *thread_cache_test_free(void *argument) {
+  thread_cache_test_thread *thread = argument;
+  for (size_t i = 0; i < THREAD_CACHE_TEST_OBJECTS; i++) {
+    if (*thread->objects[i] != i) {
+      thread->failed = true;
+    }
+
+    otter_free(thread->cache, thread->objects[i]);
+  }
+
+  return NULL;
+}
+
+OTTER_TEST(thread_cache_shared_between_threads) {
+  otter_allocator *libc = NULL;
+  otter_allocator *cache = NULL;
+  size_t **objects = NULL;
+
+  libc = otter_allocator_create();
+  OTTER_ASSERT(libc != NULL);
+
+  cache = otter_thread_cache_create(libc);
+  OTTER_ASSERT(cache != NULL);
+
+  objects = otter_malloc(OTTER_TEST_ALLOCATOR,
+                         sizeof(*objects) * THREAD_CACHE_TEST_THREADS *
+                             THREAD_CACHE_TEST_OBJECTS);
+  OTTER_ASSERT(objects != NULL);
+
+  thread_cache_test_thread threads[THREAD_CACHE_TEST_THREADS];
+  pthread_t handles[THREAD_CACHE_TEST_THREADS];
+  for (size_t i = 0; i < THREAD_CACHE_TEST_THREADS; i++) {
+    threads[i] = (thread_cache_test_thread){
+        .cache = cache,
+        .objects = &objects[i * THREAD_CACHE_TEST_OBJECTS],
+        .failed = false,
+    };
+    OTTER_ASSERT(pthread_create(&handles[i], NULL, thread_cache_test_allocate,
+                                &threads[i]) == 0);
+  }
+
+  for (size_t i = 0; i < THREAD_CACHE_TEST_THREADS; i++) {
+    pthread_join(handles[i], NULL);
+    OTTER_ASSERT(!threads[i].failed);
+  }
+
+  /* Every block is freed by a different thread than the one that
+   * allocated it */
+  for (size_t i = 0; i < THREAD_CACHE_TEST_THREADS; i++) {
+    thread_cache_test_thread *thread =
+        &threads[(i + 1) % THREAD_CACHE_TEST_THREADS];
+    OTTER_ASSERT(pthread_create(&handles[i], NULL, thread_cache_test_free,
+                                thread) == 0);
+  }
+
+  bool failed = false;
+  for (size_t i = 0; i < THREAD_CACHE_TEST_THREADS; i++) {
+    pthread_join(handles[i], NULL);
+  }
+
+  for (size_t i = 0; i < THREAD_CACHE_TEST_THREADS; i++) {
+    failed = failed || threads[i].failed;
+  }
+
+  OTTER_ASSERT(!failed);
+
+  OTTER_TEST_END(if (objects) otter_free(OTTER_TEST_ALLOCATOR, objects);
+                 if (cache) otter_allocator_free(cache);
+                 if (libc) otter_allocator_free(libc););
+}
+
+OTTER_TEST(allocator_aligned_malloc_honours_alignment) {
+  otter_allocator *arena = NULL;
+  otter_allocator *stats = NULL;
+  void *libc_block = NULL;
+  void *stats_block = NULL;
+
+  libc_block = otter_aligned_malloc(OTTER_TEST_ALLOCATOR, 256, 100);
+  OTTER_ASSERT(libc_block != NULL);
+  OTTER_ASSERT((uintptr_t)libc_block % 256 == 0);
+
+  arena = otter_arena_create(OTTER_TEST_ALLOCATOR, 1024);
+  OTTER_ASSERT(arena != NULL);
+  OTTER_ASSERT(otter_malloc(arena, 8) != NULL);
+  void *arena_block = otter_aligned_malloc(arena, OTTER_CACHE_LINE_SIZE, 40);
+  OTTER_ASSERT(arena_block != NULL);
+  OTTER_ASSERT((uintptr_t)arena_block % OTTER_CACHE_LINE_SIZE == 0);
+  /* Larger than a chunk once the padding is included */
+  void *arena_large = otter_aligned_malloc(arena, 512, 1000);
+  OTTER_ASSERT(arena_large != NULL);
+  OTTER_ASSERT((uintptr_t)arena_large % 512 == 0);
+  OTTER_ASSERT(otter_aligned_malloc(arena, 24, 8) == NULL);
+
+  stats = otter_allocator_stats_create(OTTER_TEST_ALLOCATOR, NULL);
+  OTTER_ASSERT(stats != NULL);
+  stats_block = otter_aligned_malloc(stats, OTTER_CACHE_LINE_SIZE, 10);
+  OTTER_ASSERT(stats_block != NULL);
+  OTTER_ASSERT((uintptr_t)stats_block % OTTER_CACHE_LINE_SIZE == 0);
+  stats_block = otter_realloc(stats, stats_block, 4096);
+  OTTER_ASSERT(stats_block != NULL);
+  otter_free_sized(stats, stats_block, 4096);
+  stats_block = NULL;
+
+  otter_allocator_stats totals;
+  otter_allocator_stats_get(stats, &totals);
+  OTTER_ASSERT(totals.live_allocations == 0);
+  OTTER_ASSERT(totals.size_mismatches == 0);
+
+  OTTER_TEST_END(if (stats_block) otter_free(stats, stats_block);
+                 if (stats) otter_allocator_free(stats);
+                 if (arena) otter_allocator_free(arena);
+                 if (libc_block) otter_free(OTTER_TEST_ALLOCATOR, libc_block););
+}
+
+static void *allocator_forwarding_malloc(otter_allocator * /* unused */,
+                                         size_t size) {
+  return malloc(size);
+}
+
+static void allocator_forwarding_free(otter_allocator * /* unused */,
+                                      void *pointer) {
+  free(pointer);
+}
+
+OTTER_TEST(allocator_defaults_forward_to_malloc_and_free) {
+  otter_allocator_vtable vtable = {
+      .malloc = allocator_forwarding_malloc,
+      .free = allocator_forwarding_free,
+  };
+  otter_allocator allocator = {
+      .vtable = &vtable,
+  };
+
+  void *pointer = otter_aligned_malloc(&allocator, alignof(max_align_t), 32);
+  OTTER_ASSERT(pointer != NULL);
+  otter_free_sized(&allocator, pointer, 32);
+
+  /* Extended alignments need an aligned_malloc implementation */
+  OTTER_ASSERT(otter_aligned_malloc(&allocator, 4096, 32) == NULL);
+
+  OTTER_TEST_END();
+}
+
+OTTER_TEST(pool_free_sized_returns_block_to_its_class) {
+  otter_allocator *pool = NULL;
+
+  pool = otter_pool_create(OTTER_TEST_ALLOCATOR);
+  OTTER_ASSERT(pool != NULL);
+
+  void *block = otter_malloc(pool, 40);
+  OTTER_ASSERT(block != NULL);
+  otter_free_sized(pool, block, 40);
+  OTTER_ASSERT(otter_malloc(pool, 48) == block);
+
+  /* Growing within the class keeps the block, leaving it moves it */
+  OTTER_ASSERT(otter_realloc(pool, block, 36) == block);
+  void *moved = otter_realloc(pool, block, 100);
+  OTTER_ASSERT(moved != NULL && moved != block);
+  otter_free_sized(pool, moved, 100);
+
+  void *large = otter_malloc(pool, OTTER_POOL_MAX_BLOCK_SIZE * 2);
+  OTTER_ASSERT(large != NULL);
+  void *shrunk = otter_realloc(pool, large, 16);
+  OTTER_ASSERT(shrunk != NULL);
+  otter_free_sized(pool, shrunk, 16);
+  OTTER_ASSERT(otter_malloc(pool, 16) == shrunk);
+
+  OTTER_TEST_END(if (pool) otter_allocator_free(pool););
+}
+
+OTTER_TEST(allocator_stats_counts_size_mismatches) {
+  otter_allocator *stats = NULL;
+
+  stats = otter_allocator_stats_create(OTTER_TEST_ALLOCATOR, NULL);
+  OTTER_ASSERT(stats != NULL);
+
+  void *pointer = otter_malloc(stats, 64);
+  OTTER_ASSERT(pointer != NULL);
+  otter_free_sized(stats, pointer, 32);
+
+  otter_allocator_stats totals;
+  otter_allocator_stats_get(stats, &totals);
+  OTTER_ASSERT(totals.size_mismatches == 1);
+  OTTER_ASSERT(totals.live_allocations == 0);
+
+  OTTER_TEST_END(if (stats) otter_allocator_free(stats););
+}
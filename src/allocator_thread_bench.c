@@ -0,0 +1,117 @@
+/*
+  otter Copyright (C) 2026 Nathaniel Wright
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "otter/allocator.h"
+#include "otter/bench.h"
+#include "otter/thread_cache.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Every thread keeps a window of live small objects and replaces one of them
+ * per iteration, which is the allocation pattern of tokens, nodes and VM
+ * objects.  The libc allocator and the thread cache run the same pattern with
+ * 1 to 8 threads. */
+
+#define OTTER_BENCH_ITERATIONS_PER_THREAD 2000000
+#define OTTER_BENCH_WINDOW 64
+#define OTTER_BENCH_MAX_THREADS 8
+
+typedef struct bench_thread {
+  otter_allocator *allocator;
+  pthread_t thread;
+  bool failed;
+} bench_thread;
+
+static void *bench_thread_run(void *argument) {
+  bench_thread *thread = argument;
+  void *window[OTTER_BENCH_WINDOW] = {0};
+  uint32_t state = 2463534242u;
+  for (size_t i = 0; i < OTTER_BENCH_ITERATIONS_PER_THREAD; i++) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    const size_t slot = i % OTTER_BENCH_WINDOW;
+    otter_free(thread->allocator, window[slot]);
+    window[slot] = otter_malloc(thread->allocator, 16 + (state % 16) * 16);
+    if (window[slot] == NULL) {
+      thread->failed = true;
+      break;
+    }
+
+    *(volatile unsigned char *)window[slot] = (unsigned char)i;
+  }
+
+  for (size_t i = 0; i < OTTER_BENCH_WINDOW; i++) {
+    otter_free(thread->allocator, window[i]);
+  }
+
+  return NULL;
+}
+
+static void bench_threads(const char *allocator_name,
+                          otter_allocator *allocator, size_t thread_count) {
+  bench_thread threads[OTTER_BENCH_MAX_THREADS];
+  uint64_t start = otter_bench_now_ns();
+  size_t started = 0;
+  for (; started < thread_count; started++) {
+    threads[started] = (bench_thread){.allocator = allocator};
+    if (pthread_create(&threads[started].thread, NULL, bench_thread_run,
+                       &threads[started]) != 0) {
+      break;
+    }
+  }
+
+  bool failed = started != thread_count;
+  for (size_t i = 0; i < started; i++) {
+    pthread_join(threads[i].thread, NULL);
+    failed = failed || threads[i].failed;
+  }
+
+  const uint64_t elapsed = otter_bench_now_ns() - start;
+  if (failed) {
+    fprintf(stderr, "%s with %zu threads failed\n", allocator_name,
+            thread_count);
+    return;
+  }
+
+  char name[64];
+  snprintf(name, sizeof(name), "%s %zu threads", allocator_name,
+           thread_count);
+  otter_bench_report(name, started * OTTER_BENCH_ITERATIONS_PER_THREAD,
+                     elapsed);
+}
+
+int main(void) {
+  OTTER_CLEANUP(otter_allocator_free_p)
+  otter_allocator *allocator = otter_allocator_create();
+  if (allocator == NULL) {
+    return EXIT_FAILURE;
+  }
+
+  OTTER_CLEANUP(otter_allocator_free_p)
+  otter_allocator *thread_cache = otter_thread_cache_create(allocator);
+  if (thread_cache == NULL) {
+    return EXIT_FAILURE;
+  }
+
+  for (size_t threads = 1; threads <= OTTER_BENCH_MAX_THREADS; threads *= 2) {
+    bench_threads("libc allocator", allocator, threads);
+    bench_threads("thread cache", thread_cache, threads);
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,253 @@
+/*
+  otter Copyright (C) 2026 Nathaniel Wright
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "otter/arena.h"
+#include <stdalign.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Every allocation is preceded by its size so realloc knows how much to copy.
+ * The header is padded to keep the returned memory maximally aligned. */
+#define OTTER_ARENA_ALIGNMENT alignof(max_align_t)
+#define OTTER_ARENA_HEADER_SIZE OTTER_ARENA_ALIGNMENT
+
+typedef struct otter_arena_chunk otter_arena_chunk;
+struct otter_arena_chunk {
+  otter_arena_chunk *previous;
+  size_t capacity;
+  size_t used;
+  alignas(max_align_t) unsigned char data[];
+};
+
+typedef struct otter_arena {
+  otter_allocator base;
+  otter_allocator *parent;
+  size_t chunk_size;
+  otter_arena_chunk *current;
+  /* A rewound chunk is kept so that repeated mark/rewind cycles do not go
+   * back to the parent allocator */
+  otter_arena_chunk *spare;
+  size_t used;
+} otter_arena;
+
+static size_t otter_arena_align(size_t size) {
+  return (size + OTTER_ARENA_ALIGNMENT - 1) & ~(OTTER_ARENA_ALIGNMENT - 1);
+}
+
+static otter_arena_chunk *otter_arena_new_chunk(otter_arena *arena,
+                                                size_t needed) {
+  if (arena->spare != NULL && arena->spare->capacity >= needed) {
+    otter_arena_chunk *chunk = arena->spare;
+    arena->spare = NULL;
+    return chunk;
+  }
+
+  const size_t capacity =
+      needed > arena->chunk_size ? needed : arena->chunk_size;
+  otter_arena_chunk *chunk =
+      otter_malloc(arena->parent, sizeof(*chunk) + capacity);
+  if (chunk == NULL) {
+    return NULL;
+  }
+
+  chunk->capacity = capacity;
+  return chunk;
+}
+
+static void otter_arena_release_chunk(otter_arena *arena,
+                                      otter_arena_chunk *chunk) {
+  if (arena->spare == NULL && chunk->capacity == arena->chunk_size) {
+    arena->spare = chunk;
+    return;
+  }
+
+  otter_free(arena->parent, chunk);
+}
+
+/* Bytes needed in front of the header of an allocation placed at used so
+ * that the memory after the header has the requested alignment */
+static size_t otter_arena_padding(otter_arena_chunk *chunk, size_t used,
+                                  size_t alignment) {
+  const uintptr_t address =
+      (uintptr_t)&chunk->data[used] + OTTER_ARENA_HEADER_SIZE;
+  return (size_t)(-address & (alignment - 1));
+}
+
+static void *otter_arena_allocate(otter_arena *arena, size_t alignment,
+                                  size_t size) {
+  if (alignment < OTTER_ARENA_ALIGNMENT) {
+    alignment = OTTER_ARENA_ALIGNMENT;
+  }
+
+  if (size > SIZE_MAX / 2 || alignment > SIZE_MAX / 4) {
+    return NULL;
+  }
+
+  const size_t needed = OTTER_ARENA_HEADER_SIZE + otter_arena_align(size);
+  otter_arena_chunk *chunk = arena->current;
+  size_t padding =
+      chunk != NULL ? otter_arena_padding(chunk, chunk->used, alignment) : 0;
+  if (chunk == NULL || chunk->capacity - chunk->used < padding + needed) {
+    chunk = otter_arena_new_chunk(arena,
+                                  needed + alignment - OTTER_ARENA_ALIGNMENT);
+    if (chunk == NULL) {
+      return NULL;
+    }
+
+    chunk->previous = arena->current;
+    chunk->used = 0;
+    arena->current = chunk;
+    padding = otter_arena_padding(chunk, 0, alignment);
+  }
+
+  unsigned char *header = &chunk->data[chunk->used + padding];
+  memcpy(header, &size, sizeof(size));
+  chunk->used += padding + needed;
+  arena->used += padding + needed;
+  return header + OTTER_ARENA_HEADER_SIZE;
+}
+
+static void *otter_arena_malloc_impl(otter_allocator *allocator, size_t size) {
+  return otter_arena_allocate((otter_arena *)allocator, OTTER_ARENA_ALIGNMENT,
+                              size);
+}
+
+static void *otter_arena_aligned_malloc_impl(otter_allocator *allocator,
+                                             size_t alignment, size_t size) {
+  if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+    return NULL;
+  }
+
+  return otter_arena_allocate((otter_arena *)allocator, alignment, size);
+}
+
+static size_t otter_arena_allocation_size(const void *pointer) {
+  size_t size;
+  memcpy(&size, (const unsigned char *)pointer - OTTER_ARENA_HEADER_SIZE,
+         sizeof(size));
+  return size;
+}
+
+static void *otter_arena_realloc_impl(otter_allocator *allocator,
+                                      void *pointer, size_t size) {
+  otter_arena *arena = (otter_arena *)allocator;
+  if (pointer == NULL) {
+    return otter_arena_malloc_impl(allocator, size);
+  }
+
+  const size_t old_size = otter_arena_allocation_size(pointer);
+  otter_arena_chunk *chunk = arena->current;
+  unsigned char *header = (unsigned char *)pointer - OTTER_ARENA_HEADER_SIZE;
+  const size_t old_needed =
+      OTTER_ARENA_HEADER_SIZE + otter_arena_align(old_size);
+  /* The most recent allocation can grow or shrink in place, which is what
+   * arrays appended to in a loop do */
+  if (size <= SIZE_MAX - OTTER_ARENA_HEADER_SIZE - OTTER_ARENA_ALIGNMENT &&
+      chunk != NULL && header + old_needed == &chunk->data[chunk->used]) {
+    const size_t needed = OTTER_ARENA_HEADER_SIZE + otter_arena_align(size);
+    const size_t offset = (size_t)(header - chunk->data);
+    if (chunk->capacity - offset >= needed) {
+      chunk->used = offset + needed;
+      arena->used = arena->used - old_needed + needed;
+      memcpy(header, &size, sizeof(size));
+      return pointer;
+    }
+  }
+
+  if (size <= old_size) {
+    return pointer;
+  }
+
+  void *resized = otter_arena_malloc_impl(allocator, size);
+  if (resized == NULL) {
+    return NULL;
+  }
+
+  memcpy(resized, pointer, old_size);
+  return resized;
+}
+
+static void otter_arena_free_impl(otter_allocator * /* unused */,
+                                  void * /* unused */) {
+  /* Memory is only released by rewinding, resetting or freeing the arena */
+}
+
+static void otter_arena_free_allocator_impl(otter_allocator *allocator) {
+  otter_arena *arena = (otter_arena *)allocator;
+  otter_arena_reset(allocator);
+  otter_free(arena->parent, arena->spare);
+  otter_free(arena->parent, arena);
+}
+
+otter_allocator *otter_arena_create(otter_allocator *parent,
+                                    size_t chunk_size) {
+  if (parent == NULL || chunk_size == 0) {
+    return NULL;
+  }
+
+  otter_arena *arena = otter_malloc(parent, sizeof(*arena));
+  if (arena == NULL) {
+    return NULL;
+  }
+
+  static otter_allocator_vtable vtable = {
+      .free_allocator = otter_arena_free_allocator_impl,
+      .malloc = otter_arena_malloc_impl,
+      .realloc = otter_arena_realloc_impl,
+      .free = otter_arena_free_impl,
+      .aligned_malloc = otter_arena_aligned_malloc_impl,
+  };
+
+  arena->base.vtable = &vtable;
+  arena->parent = parent;
+  arena->chunk_size = otter_arena_align(chunk_size);
+  arena->current = NULL;
+  arena->spare = NULL;
+  arena->used = 0;
+  return (otter_allocator *)arena;
+}
+
+otter_arena_mark otter_arena_mark_get(otter_allocator *allocator) {
+  otter_arena *arena = (otter_arena *)allocator;
+  return (otter_arena_mark){
+      .chunk = arena->current,
+      .used = arena->current != NULL ? arena->current->used : 0,
+  };
+}
+
+void otter_arena_rewind(otter_allocator *allocator, otter_arena_mark mark) {
+  otter_arena *arena = (otter_arena *)allocator;
+  while (arena->current != NULL && arena->current != mark.chunk) {
+    otter_arena_chunk *chunk = arena->current;
+    arena->current = chunk->previous;
+    arena->used -= chunk->used;
+    otter_arena_release_chunk(arena, chunk);
+  }
+
+  if (arena->current != NULL) {
+    arena->used -= arena->current->used - mark.used;
+    arena->current->used = mark.used;
+  }
+}
+
+void otter_arena_reset(otter_allocator *allocator) {
+  otter_arena_rewind(allocator, (otter_arena_mark){.chunk = NULL, .used = 0});
+}
+
+size_t otter_arena_used(otter_allocator *allocator) {
+  otter_arena *arena = (otter_arena *)allocator;
+  return arena->used;
+}
@@ -15,15 +15,98 @@
   along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 #include "otter/array.h"
-bool otter_array_expand(otter_allocator *allocator, void **items,
-                        size_t items_size, size_t *items_capacity) {
-  size_t new_capacity = *items_capacity * 2;
-  void *result = otter_realloc(allocator, *items, items_size * new_capacity);
+#include <stdint.h>
+#include <string.h>
+
+/* Moves items into an allocation of exactly capacity items */
+static bool otter_array_resize(otter_allocator *allocator, void **items,
+                               size_t items_size, size_t *items_capacity,
+                               void *inline_items, size_t capacity) {
+  if (items_size != 0 && capacity > SIZE_MAX / items_size) {
+    return false;
+  }
+
+  /* The first allocation goes through malloc so allocators never see a
+   * realloc of NULL, or of the inline items */
+  void *result = NULL;
+  if (*items == NULL || *items == inline_items) {
+    result = otter_malloc(allocator, items_size * capacity);
+    if (result != NULL && *items != NULL) {
+      const size_t count =
+          *items_capacity < capacity ? *items_capacity : capacity;
+      memcpy(result, *items, items_size * count);
+    }
+  } else {
+    result = otter_realloc(allocator, *items, items_size * capacity);
+  }
+
   if (result == NULL) {
     return false;
   }
 
   *items = result;
-  *items_capacity = new_capacity;
+  *items_capacity = capacity;
   return true;
 }
+
+bool otter_array_expand(otter_allocator *allocator, void **items,
+                        size_t items_size, size_t *items_capacity,
+                        void *inline_items) {
+  return otter_array_grow(allocator, items, items_size, items_capacity,
+                          inline_items, *items_capacity + 1);
+}
+
+bool otter_array_reserve(otter_allocator *allocator, void **items,
+                         size_t items_size, size_t *items_capacity,
+                         void *inline_items, size_t capacity) {
+  if (capacity <= *items_capacity) {
+    return true;
+  }
+
+  return otter_array_resize(allocator, items, items_size, items_capacity,
+                            inline_items, capacity);
+}
+
+bool otter_array_grow(otter_allocator *allocator, void **items,
+                      size_t items_size, size_t *items_capacity,
+                      void *inline_items, size_t capacity) {
+  if (capacity <= *items_capacity) {
+    return true;
+  }
+
+  size_t new_capacity = *items_capacity > 0 ? *items_capacity
+                                            : OTTER_ARRAY_INITIAL_CAPACITY;
+  while (new_capacity < capacity) {
+    if (new_capacity > SIZE_MAX / 2) {
+      new_capacity = capacity;
+      break;
+    }
+    new_capacity *= 2;
+  }
+
+  return otter_array_resize(allocator, items, items_size, items_capacity,
+                            inline_items, new_capacity);
+}
+
+bool otter_array_shrink_to_fit(otter_allocator *allocator, void **items,
+                               size_t items_size, size_t *items_capacity,
+                               void *inline_items, size_t inline_capacity,
+                               size_t items_length) {
+  if (items_length >= *items_capacity || *items == inline_items) {
+    return true;
+  }
+
+  if (items_length <= inline_capacity) {
+    if (items_length > 0) {
+      memcpy(inline_items, *items, items_size * items_length);
+    }
+
+    otter_free_sized(allocator, *items, items_size * *items_capacity);
+    *items = inline_items;
+    *items_capacity = inline_capacity;
+    return true;
+  }
+
+  return otter_array_resize(allocator, items, items_size, items_capacity,
+                            inline_items, items_length);
+}
@@ -30,22 +30,26 @@ OTTER_TEST(array_init_length_is_zero) {
   OTTER_TEST_END(otter_free(OTTER_TEST_ALLOCATOR, list.integers););
 }
 
-OTTER_TEST(array_init_capacity_is_greater_than_zero) {
+OTTER_TEST(array_init_does_not_allocate) {
   integer_list list;
   OTTER_ARRAY_INIT(&list, integers, OTTER_TEST_ALLOCATOR);
 
-  OTTER_ASSERT(OTTER_ARRAY_CAPACITY(&list, integers) > 0);
+  OTTER_ASSERT(OTTER_ARRAY_CAPACITY(&list, integers) == 0);
+  OTTER_ASSERT(list.integers == NULL);
 
-  OTTER_TEST_END(otter_free(OTTER_TEST_ALLOCATOR, list.integers););
+  OTTER_TEST_END(OTTER_ARRAY_FREE(&list, integers, OTTER_TEST_ALLOCATOR););
 }
 
-OTTER_TEST(array_init_non_null_allocation) {
+OTTER_TEST(array_init_capacity_non_null_allocation) {
   integer_list list;
-  OTTER_ARRAY_INIT(&list, integers, OTTER_TEST_ALLOCATOR);
+  OTTER_ASSERT(
+      OTTER_ARRAY_INIT_CAPACITY(&list, integers, OTTER_TEST_ALLOCATOR, 16));
 
   OTTER_ASSERT(list.integers != NULL);
+  OTTER_ASSERT(OTTER_ARRAY_LENGTH(&list, integers) == 0);
+  OTTER_ASSERT(OTTER_ARRAY_CAPACITY(&list, integers) == 16);
 
-  OTTER_TEST_END(otter_free(OTTER_TEST_ALLOCATOR, list.integers););
+  OTTER_TEST_END(OTTER_ARRAY_FREE(&list, integers, OTTER_TEST_ALLOCATOR););
 }
 
 static void *malloc_mock(otter_allocator * /* unused */, size_t /*unused */) {
@@ -62,9 +66,10 @@ OTTER_TEST(array_init_malloc_returns_null) {
   };
 
   integer_list list;
-  OTTER_ARRAY_INIT(&list, integers, &allocator);
-
+  OTTER_ASSERT(!OTTER_ARRAY_INIT_CAPACITY(&list, integers, &allocator, 16));
   OTTER_ASSERT(list.integers == NULL);
+  OTTER_ASSERT(!OTTER_ARRAY_APPEND(&list, integers, &allocator, 1));
+  OTTER_ASSERT(OTTER_ARRAY_LENGTH(&list, integers) == 0);
 
   OTTER_TEST_END();
 }
@@ -91,23 +96,46 @@ static void *realloc_mock(otter_allocator * /*unused */, void * /*unused */,
                           size_t /*unused*/) {
   return NULL;
 }
+
+/* Hands whatever a test does not mock on to the test allocator */
+typedef struct otter_allocator_mock_forwarding {
+  otter_allocator base;
+  otter_allocator *parent;
+} otter_allocator_mock_forwarding;
+
+static void *otter_allocator_mock_forwarding_malloc_impl(
+    otter_allocator *allocator, size_t size) {
+  otter_allocator_mock_forwarding *mock =
+      (otter_allocator_mock_forwarding *)allocator;
+  return otter_malloc(mock->parent, size);
+}
+
+static void
+otter_allocator_mock_forwarding_free_impl(otter_allocator *allocator,
+                                          void *pointer) {
+  otter_allocator_mock_forwarding *mock =
+      (otter_allocator_mock_forwarding *)allocator;
+  otter_free(mock->parent, pointer);
+}
+
 OTTER_TEST(array_append_realloc_returns_null) {
   otter_allocator_vtable vtable = {
-      .malloc = OTTER_TEST_ALLOCATOR->vtable->malloc,
+      .malloc = otter_allocator_mock_forwarding_malloc_impl,
       .realloc = realloc_mock,
       .free = NULL,
   };
-  otter_allocator allocator = {
-      .vtable = &vtable,
+  otter_allocator_mock_forwarding allocator = {
+      .base = {.vtable = &vtable},
+      .parent = OTTER_TEST_ALLOCATOR,
   };
 
   integer_list list;
-  OTTER_ARRAY_INIT(&list, integers, &allocator);
+  OTTER_ARRAY_INIT(&list, integers, &allocator.base);
   bool append_failed = false;
   int index;
   const int max_array_size = 1000;
   for (index = 0; index < max_array_size; index++) {
-    if (!OTTER_ARRAY_APPEND(&list, integers, &allocator, index)) {
+    if (!OTTER_ARRAY_APPEND(&list, integers, &allocator.base, index)) {
       append_failed = true;
       break;
     }
@@ -124,3 +152,144 @@ OTTER_TEST(array_append_realloc_returns_null) {
 
   OTTER_TEST_END(otter_free(OTTER_TEST_ALLOCATOR, list.integers););
 }
+
+OTTER_TEST(array_reserve_avoids_realloc) {
+  otter_allocator_vtable vtable = {
+      .malloc = otter_allocator_mock_forwarding_malloc_impl,
+      .realloc = realloc_mock,
+      .free = otter_allocator_mock_forwarding_free_impl,
+  };
+  otter_allocator_mock_forwarding allocator = {
+      .base = {.vtable = &vtable},
+      .parent = OTTER_TEST_ALLOCATOR,
+  };
+
+  integer_list list;
+  OTTER_ARRAY_INIT(&list, integers, &allocator.base);
+  OTTER_ASSERT(OTTER_ARRAY_RESERVE(&list, integers, &allocator.base, 100));
+  OTTER_ASSERT(OTTER_ARRAY_CAPACITY(&list, integers) == 100);
+
+  /* Reserving less than the capacity never shrinks */
+  OTTER_ASSERT(OTTER_ARRAY_RESERVE(&list, integers, &allocator.base, 10));
+  OTTER_ASSERT(OTTER_ARRAY_CAPACITY(&list, integers) == 100);
+
+  for (int i = 0; i < 100; i++) {
+    OTTER_ASSERT(OTTER_ARRAY_APPEND(&list, integers, &allocator.base, i));
+  }
+  OTTER_ASSERT(!OTTER_ARRAY_APPEND(&list, integers, &allocator.base, 100));
+
+  OTTER_TEST_END(OTTER_ARRAY_FREE(&list, integers, &allocator.base););
+}
+
+OTTER_TEST(array_append_n_copies_values) {
+  integer_list list;
+  OTTER_ARRAY_INIT(&list, integers, OTTER_TEST_ALLOCATOR);
+
+  const int values[] = {1, 2, 3, 4, 5, 6, 7};
+  OTTER_ASSERT(OTTER_ARRAY_APPEND_N(&list, integers, OTTER_TEST_ALLOCATOR,
+                                    values, 7));
+  OTTER_ASSERT(OTTER_ARRAY_APPEND_N(&list, integers, OTTER_TEST_ALLOCATOR,
+                                    values, 3));
+  OTTER_ASSERT(
+      OTTER_ARRAY_APPEND_N(&list, integers, OTTER_TEST_ALLOCATOR, values, 0));
+
+  OTTER_ASSERT(OTTER_ARRAY_LENGTH(&list, integers) == 10);
+  OTTER_ASSERT(OTTER_ARRAY_CAPACITY(&list, integers) >= 10);
+  OTTER_ASSERT(OTTER_ARRAY_AT(&list, integers, 6) == 7);
+  OTTER_ASSERT(OTTER_ARRAY_AT(&list, integers, 7) == 1);
+  OTTER_ASSERT(OTTER_ARRAY_AT(&list, integers, 9) == 3);
+
+  OTTER_TEST_END(OTTER_ARRAY_FREE(&list, integers, OTTER_TEST_ALLOCATOR););
+}
+
+OTTER_TEST(array_shrink_to_fit) {
+  integer_list list;
+  OTTER_ARRAY_INIT(&list, integers, OTTER_TEST_ALLOCATOR);
+  for (int i = 0; i < 6; i++) {
+    OTTER_ASSERT(OTTER_ARRAY_APPEND(&list, integers, OTTER_TEST_ALLOCATOR, i));
+  }
+  OTTER_ASSERT(OTTER_ARRAY_CAPACITY(&list, integers) > 6);
+
+  OTTER_ASSERT(
+      OTTER_ARRAY_SHRINK_TO_FIT(&list, integers, OTTER_TEST_ALLOCATOR));
+  OTTER_ASSERT(OTTER_ARRAY_CAPACITY(&list, integers) == 6);
+  OTTER_ASSERT(OTTER_ARRAY_AT(&list, integers, 5) == 5);
+
+  /* An empty array gives its allocation back */
+  OTTER_ARRAY_LENGTH(&list, integers) = 0;
+  OTTER_ASSERT(
+      OTTER_ARRAY_SHRINK_TO_FIT(&list, integers, OTTER_TEST_ALLOCATOR));
+  OTTER_ASSERT(OTTER_ARRAY_CAPACITY(&list, integers) == 0);
+  OTTER_ASSERT(list.integers == NULL);
+
+  OTTER_TEST_END(OTTER_ARRAY_FREE(&list, integers, OTTER_TEST_ALLOCATOR););
+}
+
+typedef struct {
+  OTTER_SMALL_ARRAY_DECLARE(int, integers, 3);
+} small_integer_list;
+
+OTTER_TEST(small_array_stays_inline) {
+  otter_allocator_vtable vtable = {
+      .malloc = malloc_mock,
+      .realloc = realloc_mock,
+      .free = otter_allocator_mock_forwarding_free_impl,
+  };
+  otter_allocator_mock_forwarding allocator = {
+      .base = {.vtable = &vtable},
+      .parent = OTTER_TEST_ALLOCATOR,
+  };
+
+  small_integer_list list;
+  OTTER_ARRAY_INIT(&list, integers, &allocator.base);
+  OTTER_ASSERT(OTTER_ARRAY_CAPACITY(&list, integers) == 3);
+  OTTER_ASSERT(list.integers == list.integers_inline);
+
+  /* Neither reserving nor appending within the inline items allocates */
+  OTTER_ASSERT(OTTER_ARRAY_RESERVE(&list, integers, &allocator.base, 3));
+  for (int i = 0; i < 3; i++) {
+    OTTER_ASSERT(OTTER_ARRAY_APPEND(&list, integers, &allocator.base, i));
+  }
+  OTTER_ASSERT(OTTER_ARRAY_AT(&list, integers, 2) == 2);
+  OTTER_ASSERT(!OTTER_ARRAY_APPEND(&list, integers, &allocator.base, 3));
+  OTTER_ASSERT(list.integers == list.integers_inline);
+
+  OTTER_TEST_END(OTTER_ARRAY_FREE(&list, integers, &allocator.base););
+}
+
+OTTER_TEST(small_array_spills_to_heap) {
+  small_integer_list list;
+  OTTER_ARRAY_INIT(&list, integers, OTTER_TEST_ALLOCATOR);
+
+  for (int i = 0; i < 10; i++) {
+    OTTER_ASSERT(OTTER_ARRAY_APPEND(&list, integers, OTTER_TEST_ALLOCATOR, i));
+  }
+
+  OTTER_ASSERT(list.integers != list.integers_inline);
+  OTTER_ASSERT(OTTER_ARRAY_LENGTH(&list, integers) == 10);
+  for (int i = 0; i < 10; i++) {
+    OTTER_ASSERT(OTTER_ARRAY_AT(&list, integers, i) == i);
+  }
+
+  OTTER_TEST_END(OTTER_ARRAY_FREE(&list, integers, OTTER_TEST_ALLOCATOR););
+}
+
+OTTER_TEST(small_array_shrink_moves_back_inline) {
+  small_integer_list list;
+  OTTER_ARRAY_INIT(&list, integers, OTTER_TEST_ALLOCATOR);
+
+  const int values[] = {1, 2, 3, 4, 5};
+  OTTER_ASSERT(OTTER_ARRAY_APPEND_N(&list, integers, OTTER_TEST_ALLOCATOR,
+                                    values, 5));
+  OTTER_ASSERT(list.integers != list.integers_inline);
+
+  OTTER_ARRAY_LENGTH(&list, integers) = 2;
+  OTTER_ASSERT(
+      OTTER_ARRAY_SHRINK_TO_FIT(&list, integers, OTTER_TEST_ALLOCATOR));
+  OTTER_ASSERT(list.integers == list.integers_inline);
+  OTTER_ASSERT(OTTER_ARRAY_CAPACITY(&list, integers) == 3);
+  OTTER_ASSERT(OTTER_ARRAY_AT(&list, integers, 0) == 1);
+  OTTER_ASSERT(OTTER_ARRAY_AT(&list, integers, 1) == 2);
+
+  OTTER_TEST_END(OTTER_ARRAY_FREE(&list, integers, OTTER_TEST_ALLOCATOR););
+}
@@ -0,0 +1,34 @@
+/*
+  otter Copyright (C) 2026 Nathaniel Wright
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "otter/bench.h"
+#include "otter/clock.h"
+#include <stdio.h>
+
+uint64_t otter_bench_now_ns(void) { return otter_clock_now_ns(); }
+
+void otter_bench_report(const char *name, size_t iterations,
+                        uint64_t elapsed_ns) {
+  if (iterations == 0 || elapsed_ns == 0) {
+    printf("%-48s no samples\n", name);
+    return;
+  }
+
+  const double per_iteration = (double)elapsed_ns / (double)iterations;
+  printf("%-48s %10zu iterations %14.1f ns/op %14.1f ops/s\n", name,
+         iterations, per_iteration,
+         (double)OTTER_NANOSECONDS_PER_SECOND / per_iteration);
+}
@@ -17,16 +17,22 @@
 #include "otter/build.h"
 #include "otter/allocator.h"
 #include "otter/array.h"
+#include "otter/clock.h"
 #include "otter/filesystem.h"
+#include "otter/intern.h"
 #include "otter/logger.h"
+#include "otter/map.h"
 #include "otter/process_manager.h"
 #include "otter/string.h"
 #include "otter/target.h"
 
+#include <fcntl.h>
+#include <limits.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 /**
@@ -40,11 +46,22 @@ struct otter_build_context {
   otter_logger *logger;
   otter_process_manager *process_manager;
   const otter_build_config *config;
+  /* Arguments of every target and the target names, which makes resolving a
+   * dependency a comparison of handles */
+  otter_intern_table *strings;
+  const otter_interned_string **target_names;
+  size_t target_names_length;
+  /* Index of the first definition with each name */
+  OTTER_MAP_DECLARE(const otter_interned_string *, size_t, target_indices);
   otter_string *cc_flags_str;
   otter_string *include_flags_str;
   otter_string *exe_flags_str;
+  uint64_t start_ns; /* Origin of the timestamps in build traces */
+  bool targets_created;
 };
 
+#define OTTER_BUILD_SUMMARY_LENGTH 10
+
 static const char *get_extension_for_type(otter_target_type type) {
   switch (type) {
   case OTTER_TARGET_OBJECT:
@@ -58,26 +75,97 @@ static const char *get_extension_for_type(otter_target_type type) {
   }
 }
 
-static otter_string *create_path(otter_allocator *allocator, const char *dir,
-                                 const char *name, const char *suffix,
-                                 const char *ext) {
-  return otter_string_format(allocator, "%s/%s%s%s", dir, name, suffix, ext);
+/* Paths are only needed while the target copies them, so they are formatted
+ * on the stack rather than allocated */
+static otter_string_view format_path(char *buffer, size_t size,
+                                     const char *dir, const char *name,
+                                     const char *suffix, const char *ext) {
+  const int length =
+      snprintf(buffer, size, "%s/%s%s%s", dir, name, suffix, ext);
+  if (length < 0 || (size_t)length >= size) {
+    return (otter_string_view){.data = NULL, .length = 0};
+  }
+
+  return (otter_string_view){.data = buffer, .length = (size_t)length};
+}
+
+/* Interned names carry their hash */
+static uint64_t hash_interned(const void *key) {
+  const otter_interned_string *handle;
+  memcpy(&handle, key, sizeof(handle));
+  return otter_map_mix(handle->hash);
+}
+
+/**
+ * Find target definition index by name
+ * Returns -1 if not found
+ */
+static int find_target_def_index(const otter_build_context *ctx,
+                                 const char *name) {
+  if (ctx == NULL || name == NULL) {
+    return -1;
+  }
+
+  /* A name that was never interned can't belong to any definition */
+  const otter_interned_string *handle =
+      otter_intern_find(ctx->strings, otter_string_view_from_cstr(name));
+  if (handle == NULL) {
+    return -1;
+  }
+
+  const size_t *index = OTTER_MAP_FIND(ctx, target_indices, handle,
+                                       hash_interned, otter_map_equal_pointer);
+  return index != NULL ? (int)*index : -1;
 }
 
 static otter_target *find_target_by_name(const otter_build_context *ctx,
                                          const char *name) {
-  if (ctx == NULL || name == NULL) {
+  const int index = find_target_def_index(ctx, name);
+  if (index < 0 || (size_t)index >= OTTER_ARRAY_LENGTH(ctx, targets)) {
     return NULL;
   }
 
-  for (size_t i = 0;
-       i < OTTER_ARRAY_LENGTH(ctx, targets) && ctx->target_defs[i].name != NULL;
-       i++) {
-    if (strcmp(ctx->target_defs[i].name, name) == 0) {
-      return OTTER_ARRAY_AT_UNSAFE(ctx, targets, i);
+  return OTTER_ARRAY_AT_UNSAFE(ctx, targets, index);
+}
+
+/* Interns the name of every definition in order */
+static bool intern_target_names(otter_build_context *ctx) {
+  size_t length = 0;
+  while (ctx->target_defs[length].name != NULL) {
+    length++;
+  }
+
+  /* The spare slot keeps the allocation non-empty without definitions */
+  ctx->target_names =
+      otter_malloc(ctx->allocator, sizeof(*ctx->target_names) * (length + 1));
+  if (ctx->target_names == NULL) {
+    return false;
+  }
+
+  ctx->target_names_length = length;
+  if (!OTTER_MAP_RESERVE(ctx, target_indices, ctx->allocator, length,
+                         hash_interned)) {
+    return false;
+  }
+
+  for (size_t i = 0; i < length; i++) {
+    ctx->target_names[i] =
+        otter_intern_cstr(ctx->strings, ctx->target_defs[i].name);
+    if (ctx->target_names[i] == NULL) {
+      return false;
+    }
+
+    /* Duplicates keep pointing at the first definition */
+    if (!OTTER_MAP_CONTAINS(ctx, target_indices, ctx->target_names[i],
+                            hash_interned, otter_map_equal_pointer) &&
+        !OTTER_MAP_INSERT(ctx, target_indices, ctx->allocator,
+                          ctx->target_names[i], i, hash_interned,
+                          otter_map_equal_pointer)) {
+      return false;
     }
   }
-  return NULL;
+
+  return true;
 }
 
 otter_build_context *otter_build_context_create(
@@ -98,18 +186,43 @@ otter_build_context *otter_build_context_create(
 
   ctx->target_defs = target_defs;
   ctx->allocator = allocator;
-  ctx->filesystem = filesystem;
+  ctx->filesystem = NULL;
   ctx->logger = logger;
   ctx->process_manager = process_manager;
   ctx->config = config;
+  ctx->start_ns = otter_clock_now_ns();
+  ctx->targets_created = false;
 
   /* Initialize string pointers to NULL for safe cleanup */
   ctx->cc_flags_str = NULL;
   ctx->include_flags_str = NULL;
   ctx->exe_flags_str = NULL;
+  ctx->target_names = NULL;
+  ctx->target_names_length = 0;
+  OTTER_MAP_INIT(ctx, target_indices);
 
   OTTER_ARRAY_INIT(ctx, targets, allocator);
 
+  ctx->strings = otter_intern_table_create(allocator);
+  if (ctx->strings == NULL || !intern_target_names(ctx)) {
+    otter_build_context_free(ctx);
+    return NULL;
+  }
+
+  /* Every definition becomes exactly one target */
+  if (!OTTER_ARRAY_RESERVE(ctx, targets, allocator,
+                           ctx->target_names_length)) {
+    otter_build_context_free(ctx);
+    return NULL;
+  }
+
+  /* Metadata is cached for the lifetime of the context, i.e. one build */
+  ctx->filesystem = otter_filesystem_create_cached(allocator, filesystem);
+  if (ctx->filesystem == NULL) {
+    otter_build_context_free(ctx);
+    return NULL;
+  }
+
   /* Create compiler flags string */
   ctx->cc_flags_str = otter_string_from_cstr(allocator, config->flags.cc_flags);
   if (ctx->cc_flags_str == NULL) {
@@ -147,7 +260,7 @@ void otter_build_context_free(otter_build_context *ctx) {
   for (size_t i = 0; i < OTTER_ARRAY_LENGTH(ctx, targets); i++) {
     otter_target_free(OTTER_ARRAY_AT_UNSAFE(ctx, targets, i));
   }
-  otter_free(ctx->allocator, ctx->targets);
+  OTTER_ARRAY_FREE(ctx, targets, ctx->allocator);
 
   /* Free flag strings */
   if (ctx->cc_flags_str != NULL) {
@@ -160,6 +273,17 @@ void otter_build_context_free(otter_build_context *ctx) {
     otter_string_free(ctx->exe_flags_str);
   }
 
+  if (ctx->filesystem != NULL) {
+    otter_filesystem_free(ctx->filesystem);
+  }
+
+  if (ctx->target_names != NULL) {
+    otter_free_sized(ctx->allocator, (void *)ctx->target_names,
+                     sizeof(*ctx->target_names) *
+                         (ctx->target_names_length + 1));
+  }
+  OTTER_MAP_FREE(ctx, target_indices, ctx->allocator);
+  otter_intern_table_free(ctx->strings);
   otter_free(ctx->allocator, ctx);
 }
 
@@ -285,19 +409,24 @@ static otter_target *create_target(otter_build_context *ctx,
     return NULL;
   }
 
-  OTTER_CLEANUP(otter_string_free_p)
-  otter_string *output_file = create_path(
-      ctx->allocator, ctx->config->paths.out_dir, def->name, suffix, extension);
-
-  if (output_file == NULL) {
+  char output_buffer[PATH_MAX];
+  const otter_string_view output_file =
+      format_path(output_buffer, sizeof(output_buffer),
+                  ctx->config->paths.out_dir, def->name, suffix, extension);
+  if (output_file.data == NULL) {
+    otter_log_error(ctx->logger, "Output path for target '%s' is too long",
+                    def->name);
     return NULL;
   }
 
   /* Create source file path */
-  OTTER_CLEANUP(otter_string_free_p)
-  otter_string *src_file = create_path(
-      ctx->allocator, ctx->config->paths.src_dir, source_name, "", ".c");
-  if (src_file == NULL) {
+  char src_buffer[PATH_MAX];
+  const otter_string_view src_file =
+      format_path(src_buffer, sizeof(src_buffer), ctx->config->paths.src_dir,
+                  source_name, "", ".c");
+  if (src_file.data == NULL) {
+    otter_log_error(ctx->logger, "Source path for target '%s' is too long",
+                    def->name);
     return NULL;
   }
 
@@ -309,46 +438,38 @@ static otter_target *create_target(otter_build_context *ctx,
     return NULL;
   }
 
-  /* Create target based on type */
-  otter_target *target = NULL;
-
-  switch (def->type) {
-  case OTTER_TARGET_OBJECT:
-    target = otter_target_create_c_object(
-        output_file, flags, ctx->include_flags_str, ctx->allocator,
-        ctx->filesystem, ctx->logger, ctx->process_manager, src_file, NULL);
-    break;
-
-  case OTTER_TARGET_EXECUTABLE:
-  case OTTER_TARGET_SHARED_OBJECT: {
-    /* Create dependency array for linked targets */
+  otter_target_spec spec = {
+      .type = def->type,
+      .name = output_file,
+      .flags = otter_string_view_of(flags),
+      .include_flags = otter_string_view_of(ctx->include_flags_str),
+      .files = &src_file,
+      .files_length = 1,
+      .dependencies = NULL,
+      .strings = ctx->strings,
+  };
+
+  /* Create dependency array for linked targets */
+  otter_target **deps = NULL;
+  if (def->type != OTTER_TARGET_OBJECT) {
     size_t dep_count;
-    otter_target **deps = create_dependency_array(ctx, def, &dep_count);
+    deps = create_dependency_array(ctx, def, &dep_count);
 
     /* deps can be NULL if there are no dependencies, which is valid */
     if (def->deps != NULL && deps == NULL) {
       return NULL; /* Error already logged */
     }
 
-    /* Create the target */
-    if (def->type == OTTER_TARGET_EXECUTABLE) {
-      target = otter_target_create_c_executable(
-          output_file, flags, ctx->include_flags_str, ctx->allocator,
-          ctx->filesystem, ctx->logger, ctx->process_manager,
-          (const otter_string *[]){src_file, NULL}, deps);
-    } else {
-      target = otter_target_create_c_shared_object(
-          output_file, flags, ctx->include_flags_str, ctx->allocator,
-          ctx->filesystem, ctx->logger, ctx->process_manager,
-          (const otter_string *[]){src_file, NULL}, deps);
-    }
-
-    /* Free the deps array (ownership passed to target) */
-    if (deps != NULL) {
-      otter_free(ctx->allocator, deps);
-    }
-    break;
+    spec.dependencies = deps;
   }
+
+  otter_target *target =
+      otter_target_create(&spec, ctx->allocator, ctx->filesystem, ctx->logger,
+                          ctx->process_manager);
+
+  /* Free the deps array (the target keeps its own copy) */
+  if (deps != NULL) {
+    otter_free(ctx->allocator, deps);
   }
 
   return target;
@@ -409,7 +530,34 @@ static bool create_targets(otter_build_context *ctx) {
     }
   }
 
-  /* Fourth pass: execute all targets */
+  return true;
+}
+
+/**
+ * Query every output in one batch up front so that the staleness checks are
+ * answered from the cache
+ */
+static void stat_targets(otter_build_context *ctx) {
+  const size_t target_count = OTTER_ARRAY_LENGTH(ctx, targets);
+  const char **paths =
+      otter_malloc(ctx->allocator, sizeof(*paths) * target_count);
+  otter_file_status *statuses =
+      otter_malloc(ctx->allocator, sizeof(*statuses) * target_count);
+  if (paths != NULL && statuses != NULL) {
+    for (size_t i = 0; i < target_count; i++) {
+      const otter_target *target = OTTER_ARRAY_AT_UNSAFE(ctx, targets, i);
+      paths[i] = otter_string_cstr(target->name);
+    }
+
+    otter_filesystem_stat_many(ctx->filesystem, paths, target_count, statuses);
+  }
+
+  otter_free(ctx->allocator, paths);
+  otter_free(ctx->allocator, statuses);
+}
+
+static bool execute_targets(otter_build_context *ctx) {
+  stat_targets(ctx);
   for (size_t i = 0; ctx->target_defs[i].name != NULL; i++) {
     otter_target *target = OTTER_ARRAY_AT_UNSAFE(ctx, targets, i);
     int result = otter_target_execute(target);
@@ -421,20 +569,6 @@ static bool create_targets(otter_build_context *ctx) {
   return true;
 }
 
-/**
- * Find target definition index by name
- * Returns -1 if not found
- */
-static int find_target_def_index(const otter_build_context *ctx,
-                                 const char *name) {
-  for (size_t i = 0; ctx->target_defs[i].name != NULL; i++) {
-    if (strcmp(ctx->target_defs[i].name, name) == 0) {
-      return (int)i;
-    }
-  }
-  return -1;
-}
-
 /**
  * Detect circular dependencies using DFS
  * Returns true if a cycle is detected
@@ -567,14 +701,16 @@ static bool validate_target_definitions(const otter_build_context *ctx) {
     target_count++;
   }
 
-  /* Check for duplicate target names */
+  /* Check for duplicate target names, only the first definition of each
+   * name is indexed */
   for (size_t i = 0; i < target_count; i++) {
-    const char *name = ctx->target_defs[i].name;
-    for (size_t j = i + 1; j < target_count; j++) {
-      if (strcmp(name, ctx->target_defs[j].name) == 0) {
-        otter_log_error(ctx->logger, "Duplicate target name: '%s'", name);
-        return false;
-      }
+    const otter_interned_string *name = ctx->target_names[i];
+    const size_t *index = OTTER_MAP_FIND(ctx, target_indices, name,
+                                         hash_interned,
+                                         otter_map_equal_pointer);
+    if (index == NULL || *index != i) {
+      otter_log_error(ctx->logger, "Duplicate target name: '%s'", name->data);
+      return false;
     }
   }
 
@@ -591,17 +727,556 @@ static bool validate_target_definitions(const otter_build_context *ctx) {
   return true;
 }
 
-bool otter_build_all(otter_build_context *ctx) {
+
+static double ns_to_ms(uint64_t nanoseconds) {
+  return (double)nanoseconds / (double)OTTER_NANOSECONDS_PER_MILLISECOND;
+}
+
+/* Time a target cost to build: hashing plus everything its job waited on */
+static uint64_t target_cost_ns(const otter_target *target) {
+  uint64_t cost = target->hash_ns;
+  if (target->has_process_stats) {
+    cost += target->process_stats.finished_ns - target->process_stats.queued_ns;
+  }
+
+  return cost;
+}
+
+static int compare_target_cost(const void *lhs, const void *rhs) {
+  const uint64_t lhs_cost = target_cost_ns(*(otter_target *const *)lhs);
+  const uint64_t rhs_cost = target_cost_ns(*(otter_target *const *)rhs);
+  if (lhs_cost == rhs_cost) {
+    return 0;
+  }
+
+  return lhs_cost < rhs_cost ? 1 : -1;
+}
+
+void otter_build_log_summary(const otter_build_context *ctx) {
   if (ctx == NULL) {
+    return;
+  }
+
+  const size_t target_count = OTTER_ARRAY_LENGTH(ctx, targets);
+  otter_target **sorted =
+      otter_malloc(ctx->allocator, sizeof(*sorted) * (target_count + 1));
+  if (sorted == NULL) {
+    otter_log_critical(ctx->logger, "Failed to allocate build summary");
+    return;
+  }
+
+  size_t sorted_count = 0;
+  uint64_t total_ns = 0;
+  for (size_t i = 0; i < target_count; i++) {
+    otter_target *target = OTTER_ARRAY_AT_UNSAFE(ctx, targets, i);
+    if (target != NULL) {
+      sorted[sorted_count++] = target;
+      total_ns += target_cost_ns(target);
+    }
+  }
+
+  qsort((void *)sorted, sorted_count, sizeof(*sorted), compare_target_cost);
+  otter_log_info(ctx->logger,
+                 "Build summary: %zu targets, %.1f ms of hashing and jobs",
+                 sorted_count, ns_to_ms(total_ns));
+  otter_log_info(ctx->logger, "%10s %10s %10s %10s %10s %10s %10s %10s  %s",
+                 "total ms", "hash ms", "wait ms", "spawn ms", "wall ms",
+                 "user ms", "sys ms", "rss MiB", "target");
+  for (size_t i = 0; i < sorted_count && i < OTTER_BUILD_SUMMARY_LENGTH; i++) {
+    const otter_target *target = sorted[i];
+    const otter_process_stats *stats = &target->process_stats;
+    if (!target->has_process_stats) {
+      otter_log_info(
+          ctx->logger, "%10.1f %10.1f %10s %10s %10s %10s %10s %10s  %s",
+          ns_to_ms(target_cost_ns(target)), ns_to_ms(target->hash_ns), "-",
+          "-", "-", "-", "-", "-", otter_string_cstr(target->name));
+      continue;
+    }
+
+    otter_log_info(
+        ctx->logger,
+        "%10.1f %10.1f %10.1f %10.3f %10.1f %10.1f %10.1f %10.1f  %s",
+        ns_to_ms(target_cost_ns(target)), ns_to_ms(target->hash_ns),
+        ns_to_ms(stats->queue_wait_ns), ns_to_ms(stats->spawn_ns),
+        ns_to_ms(stats->finished_ns - stats->started_ns),
+        ns_to_ms(stats->user_ns), ns_to_ms(stats->system_ns),
+        (double)stats->peak_rss / (1024.0 * 1024.0),
+        otter_string_cstr(target->name));
+  }
+
+  otter_free(ctx->allocator, (void *)sorted);
+}
+
+/* Appends value with the characters a JSON string requires escaped, without
+ * the surrounding quotes */
+static void append_escaped(otter_string **json, const char *value) {
+  for (const char *character = value; *character != '\0'; character++) {
+    if (*character == '"' || *character == '\\') {
+      otter_string_append_cstr(json, "\\");
+      otter_string_append(json, character, 1);
+    } else if ((unsigned char)*character < 0x20) {
+      char escaped[sizeof("\\u0000")];
+      snprintf(escaped, sizeof(escaped), "\\u%04x",
+               (unsigned int)(unsigned char)*character);
+      otter_string_append_cstr(json, escaped);
+    } else {
+      otter_string_append(json, character, 1);
+    }
+  }
+}
+
+/* Appends a JSON string literal, escaping the characters JSON requires */
+static void append_json_string(otter_string **json, const char *value) {
+  otter_string_append_cstr(json, "\"");
+  append_escaped(json, value);
+  otter_string_append_cstr(json, "\"");
+}
+
+static bool write_report(const otter_build_context *ctx, const char *path,
+                         const otter_string *contents) {
+  OTTER_CLEANUP(otter_file_close_p)
+  otter_file *file = otter_filesystem_open_file(ctx->filesystem, path, "w");
+  if (file == NULL) {
+    otter_log_error(ctx->logger, "Failed to open '%s'", path);
+    return false;
+  }
+
+  const size_t length = otter_string_length(contents);
+  if (otter_file_write(file, otter_string_cstr(contents), length) != length) {
+    otter_log_error(ctx->logger, "Failed to write '%s'", path);
+    return false;
+  }
+
+  return true;
+}
+
+/* Appends one complete ("X") trace event.  Times are in microseconds. */
+static void append_trace_event(const otter_build_context *ctx,
+                               otter_string **json, bool *first,
+                               const otter_target *target,
+                               const char *category, uint64_t start_ns,
+                               uint64_t duration_ns, const char *args) {
+  if (!*first) {
+    otter_string_append_cstr(json, ",\n");
+  }
+  *first = false;
+
+  otter_string_append_cstr(json, "{\"name\":");
+  append_json_string(json, otter_string_cstr(target->name));
+  OTTER_CLEANUP(otter_string_free_p)
+  otter_string *event = otter_string_format(
+      ctx->allocator,
+      ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+      "\"pid\":1,\"tid\":1,\"args\":{%s}}",
+      category,
+      (double)(start_ns - ctx->start_ns) /
+          (double)OTTER_NANOSECONDS_PER_MICROSECOND,
+      (double)duration_ns / (double)OTTER_NANOSECONDS_PER_MICROSECOND,
+      args != NULL ? args : "");
+  if (event != NULL) {
+    otter_string_append_cstr(json, otter_string_cstr(event));
+  }
+}
+
+bool otter_build_write_trace(const otter_build_context *ctx, const char *path) {
+  if (ctx == NULL || path == NULL) {
+    return false;
+  }
+
+  OTTER_CLEANUP(otter_string_free_p)
+  otter_string *json =
+      otter_string_from_cstr(ctx->allocator, "{\"traceEvents\":[\n");
+  if (json == NULL) {
+    otter_log_critical(ctx->logger, "Failed to allocate build trace");
+    return false;
+  }
+
+  bool first = true;
+  for (size_t i = 0; i < OTTER_ARRAY_LENGTH(ctx, targets); i++) {
+    const otter_target *target = OTTER_ARRAY_AT_UNSAFE(ctx, targets, i);
+    if (target == NULL) {
+      continue;
+    }
+
+    if (target->hash_ns > 0) {
+      append_trace_event(ctx, &json, &first, target, "hash",
+                         target->hash_start_ns, target->hash_ns, NULL);
+    }
+
+    if (!target->has_process_stats) {
+      continue;
+    }
+
+    const otter_process_stats *stats = &target->process_stats;
+    append_trace_event(ctx, &json, &first, target, "queue", stats->queued_ns,
+                       stats->queue_wait_ns, NULL);
+    append_trace_event(ctx, &json, &first, target, "spawn",
+                       stats->queued_ns + stats->queue_wait_ns,
+                       stats->spawn_ns, NULL);
+
+    OTTER_CLEANUP(otter_string_free_p)
+    otter_string *args = otter_string_format(
+        ctx->allocator,
+        "\"user_ms\":%.3f,\"sys_ms\":%.3f,\"max_rss_bytes\":%zu",
+        ns_to_ms(stats->user_ns), ns_to_ms(stats->system_ns),
+        stats->peak_rss);
+    append_trace_event(ctx, &json, &first, target, "run", stats->started_ns,
+                       stats->finished_ns - stats->started_ns,
+                       args != NULL ? otter_string_cstr(args) : NULL);
+  }
+
+  otter_string_append_cstr(&json, "\n],\"displayTimeUnit\":\"ms\"}\n");
+  if (!write_report(ctx, path, json)) {
     return false;
   }
 
+  otter_log_info(ctx->logger, "Wrote build trace to '%s'", path);
+  return true;
+}
+
+/**
+ * Validate the definitions and create every target (hashing their sources)
+ * without executing anything.  Only done once per context.
+ */
+static bool prepare_targets(otter_build_context *ctx) {
+  if (ctx->targets_created) {
+    return true;
+  }
+
   /* Validate target definitions first */
   if (!validate_target_definitions(ctx)) {
     return false;
   }
 
-  return create_targets(ctx);
+  if (!create_targets(ctx)) {
+    return false;
+  }
+
+  ctx->targets_created = true;
+  return true;
+}
+
+bool otter_build_all(otter_build_context *ctx) {
+  if (ctx == NULL) {
+    return false;
+  }
+
+  if (!prepare_targets(ctx)) {
+    return false;
+  }
+
+  return execute_targets(ctx);
+}
+
+static size_t count_targets(const otter_build_context *ctx) {
+  size_t target_count = 0;
+  while (ctx->target_defs[target_count].name != NULL) {
+    target_count++;
+  }
+
+  return target_count;
+}
+
+/**
+ * Decide staleness the same way a build would, dependencies first.  Targets
+ * that would execute are marked as executed so that their dependents see
+ * the same decisions as in a real build.
+ */
+static void plan_target(otter_build_context *ctx, size_t index, bool *planned) {
+  if (planned[index]) {
+    return;
+  }
+  planned[index] = true;
+
+  const otter_target_definition *def = &ctx->target_defs[index];
+  if (def->deps != NULL) {
+    for (size_t i = 0; def->deps[i] != NULL; i++) {
+      const int dep_index = find_target_def_index(ctx, def->deps[i]);
+      if (dep_index >= 0) {
+        plan_target(ctx, (size_t)dep_index, planned);
+      }
+    }
+  }
+
+  otter_target *target = OTTER_ARRAY_AT_UNSAFE(ctx, targets, index);
+  target->stale_reason = otter_target_check_stale(target);
+  target->executed = target->stale_reason != OTTER_TARGET_UP_TO_DATE;
+}
+
+static bool plan_targets(otter_build_context *ctx) {
+  if (!prepare_targets(ctx)) {
+    return false;
+  }
+
+  stat_targets(ctx);
+  const size_t target_count = count_targets(ctx);
+  bool *planned = otter_malloc(ctx->allocator, sizeof(bool) * target_count);
+  if (planned == NULL) {
+    otter_log_critical(ctx->logger, "Failed to allocate build plan");
+    return false;
+  }
+
+  for (size_t i = 0; i < target_count; i++) {
+    planned[i] = false;
+  }
+
+  for (size_t i = 0; i < target_count; i++) {
+    plan_target(ctx, i, planned);
+  }
+
+  otter_free(ctx->allocator, planned);
+  return true;
+}
+
+/**
+ * Longest chain of dependencies weighted by historical cost.  path_ns[i] is
+ * the cost of the heaviest chain ending in target i and next[i] is the
+ * dependency that chain continues through (SIZE_MAX at its start).
+ */
+static uint64_t critical_path_to(const otter_build_context *ctx, size_t index,
+                                 uint64_t *path_ns, size_t *next,
+                                 bool *visited) {
+  if (visited[index]) {
+    return path_ns[index];
+  }
+  visited[index] = true;
+
+  uint64_t longest_dep_ns = 0;
+  next[index] = SIZE_MAX;
+  const otter_target_definition *def = &ctx->target_defs[index];
+  if (def->deps != NULL) {
+    for (size_t i = 0; def->deps[i] != NULL; i++) {
+      const int dep_index = find_target_def_index(ctx, def->deps[i]);
+      if (dep_index < 0) {
+        continue;
+      }
+
+      const uint64_t dep_ns =
+          critical_path_to(ctx, (size_t)dep_index, path_ns, next, visited);
+      if (next[index] == SIZE_MAX || dep_ns > longest_dep_ns) {
+        longest_dep_ns = dep_ns;
+        next[index] = (size_t)dep_index;
+      }
+    }
+  }
+
+  path_ns[index] = otter_target_historical_cost_ns(
+                       OTTER_ARRAY_AT_UNSAFE(ctx, targets, index)) +
+                   longest_dep_ns;
+  return path_ns[index];
+}
+
+static void log_critical_path(const otter_build_context *ctx) {
+  const size_t target_count = count_targets(ctx);
+  if (target_count == 0) {
+    return;
+  }
+
+  uint64_t *path_ns =
+      otter_malloc(ctx->allocator, sizeof(uint64_t) * target_count);
+  size_t *next = otter_malloc(ctx->allocator, sizeof(size_t) * target_count);
+  bool *visited = otter_malloc(ctx->allocator, sizeof(bool) * target_count);
+  if (path_ns == NULL || next == NULL || visited == NULL) {
+    otter_log_critical(ctx->logger, "Failed to allocate critical path");
+    goto cleanup;
+  }
+
+  for (size_t i = 0; i < target_count; i++) {
+    visited[i] = false;
+  }
+
+  size_t end = 0;
+  uint64_t total_ns = 0;
+  size_t unknown_costs = 0;
+  for (size_t i = 0; i < target_count; i++) {
+    critical_path_to(ctx, i, path_ns, next, visited);
+    if (path_ns[i] > path_ns[end]) {
+      end = i;
+    }
+
+    const uint64_t cost_ns =
+        otter_target_historical_cost_ns(OTTER_ARRAY_AT_UNSAFE(ctx, targets, i));
+    total_ns += cost_ns;
+    if (cost_ns == 0) {
+      unknown_costs++;
+    }
+  }
+
+  const double parallelism =
+      path_ns[end] > 0 ? (double)total_ns / (double)path_ns[end] : 0;
+  otter_log_info(ctx->logger,
+                 "Critical path: %.1f ms of %.1f ms total work (at most %.1f "
+                 "jobs can usefully run in parallel)",
+                 ns_to_ms(path_ns[end]), ns_to_ms(total_ns), parallelism);
+  for (size_t i = end; i != SIZE_MAX; i = next[i]) {
+    const otter_target *target = OTTER_ARRAY_AT_UNSAFE(ctx, targets, i);
+    otter_log_info(ctx->logger, "  %10.1f ms  %s",
+                   ns_to_ms(otter_target_historical_cost_ns(target)),
+                   otter_string_cstr(target->name));
+  }
+
+  if (unknown_costs > 0) {
+    otter_log_info(ctx->logger,
+                   "%zu targets have no recorded cost and count as 0 ms",
+                   unknown_costs);
+  }
+
+cleanup:
+  otter_free(ctx->allocator, path_ns);
+  otter_free(ctx->allocator, next);
+  otter_free(ctx->allocator, visited);
+}
+
+bool otter_build_explain(otter_build_context *ctx) {
+  if (ctx == NULL) {
+    return false;
+  }
+
+  if (!plan_targets(ctx)) {
+    return false;
+  }
+
+  size_t stale_count = 0;
+  const size_t target_count = count_targets(ctx);
+  for (size_t i = 0; i < target_count; i++) {
+    const otter_target *target = OTTER_ARRAY_AT_UNSAFE(ctx, targets, i);
+    if (target->stale_reason != OTTER_TARGET_UP_TO_DATE) {
+      otter_log_info(ctx->logger, "'%s' is out of date: %s",
+                     otter_string_cstr(target->name),
+                     otter_target_stale_reason_str(target->stale_reason));
+      stale_count++;
+    }
+  }
+
+  otter_log_info(ctx->logger, "%zu of %zu targets would be executed",
+                 stale_count, target_count);
+  log_critical_path(ctx);
+  return true;
+}
+
+static const char *target_type_name(otter_target_type type) {
+  switch (type) {
+  case OTTER_TARGET_OBJECT:
+    return "object";
+  case OTTER_TARGET_SHARED_OBJECT:
+    return "shared_object";
+  case OTTER_TARGET_EXECUTABLE:
+    return "executable";
+  default:
+    return "unknown";
+  }
+}
+
+static bool has_suffix(const char *value, const char *suffix) {
+  const size_t value_length = strlen(value);
+  const size_t suffix_length = strlen(suffix);
+  return value_length >= suffix_length &&
+         strcmp(&value[value_length - suffix_length], suffix) == 0;
+}
+
+static void append_graph_json(const otter_build_context *ctx,
+                              otter_string **graph) {
+  const size_t target_count = count_targets(ctx);
+  otter_string_append_cstr(graph, "{\"nodes\":[\n");
+  for (size_t i = 0; i < target_count; i++) {
+    const otter_target *target = OTTER_ARRAY_AT_UNSAFE(ctx, targets, i);
+    otter_string_append_cstr(graph, i == 0 ? "{\"name\":" : ",\n{\"name\":");
+    append_json_string(graph, otter_string_cstr(target->name));
+
+    OTTER_CLEANUP(otter_string_free_p)
+    otter_string *node = otter_string_format(
+        ctx->allocator, ",\"type\":\"%s\",\"cost_ms\":%.3f,\"stale\":\"%s\"}",
+        target_type_name(target->type),
+        ns_to_ms(otter_target_historical_cost_ns(target)),
+        otter_target_stale_reason_str(target->stale_reason));
+    if (node != NULL) {
+      otter_string_append_cstr(graph, otter_string_cstr(node));
+    }
+  }
+
+  otter_string_append_cstr(graph, "\n],\"edges\":[\n");
+  bool first = true;
+  for (size_t i = 0; i < target_count; i++) {
+    const otter_target *target = OTTER_ARRAY_AT_UNSAFE(ctx, targets, i);
+    for (size_t j = 0; j < OTTER_ARRAY_LENGTH(target, dependencies); j++) {
+      const otter_target *dep = OTTER_ARRAY_AT_UNSAFE(target, dependencies, j);
+      otter_string_append_cstr(graph, first ? "{\"from\":" : ",\n{\"from\":");
+      append_json_string(graph, otter_string_cstr(dep->name));
+      otter_string_append_cstr(graph, ",\"to\":");
+      append_json_string(graph, otter_string_cstr(target->name));
+      otter_string_append_cstr(graph, "}");
+      first = false;
+    }
+  }
+
+  otter_string_append_cstr(graph, "\n]}\n");
+}
+
+static void append_graph_dot(const otter_build_context *ctx,
+                             otter_string **graph) {
+  const size_t target_count = count_targets(ctx);
+  otter_string_append_cstr(graph, "digraph otter {\n  rankdir=LR;\n");
+  for (size_t i = 0; i < target_count; i++) {
+    const otter_target *target = OTTER_ARRAY_AT_UNSAFE(ctx, targets, i);
+    /* DOT strings use the same escaping as JSON for quotes and backslashes */
+    otter_string_append_cstr(graph, "  ");
+    append_json_string(graph, otter_string_cstr(target->name));
+    otter_string_append_cstr(graph, " [label=\"");
+    append_escaped(graph, otter_string_cstr(target->name));
+    OTTER_CLEANUP(otter_string_free_p)
+    otter_string *node = otter_string_format(
+        ctx->allocator, "\\n%.1f ms\\n%s\"%s];\n",
+        ns_to_ms(otter_target_historical_cost_ns(target)),
+        otter_target_stale_reason_str(target->stale_reason),
+        target->stale_reason != OTTER_TARGET_UP_TO_DATE ? ", color=red" : "");
+    if (node != NULL) {
+      otter_string_append_cstr(graph, otter_string_cstr(node));
+    }
+  }
+
+  for (size_t i = 0; i < target_count; i++) {
+    const otter_target *target = OTTER_ARRAY_AT_UNSAFE(ctx, targets, i);
+    for (size_t j = 0; j < OTTER_ARRAY_LENGTH(target, dependencies); j++) {
+      const otter_target *dep = OTTER_ARRAY_AT_UNSAFE(target, dependencies, j);
+      otter_string_append_cstr(graph, "  ");
+      append_json_string(graph, otter_string_cstr(dep->name));
+      otter_string_append_cstr(graph, " -> ");
+      append_json_string(graph, otter_string_cstr(target->name));
+      otter_string_append_cstr(graph, ";\n");
+    }
+  }
+
+  otter_string_append_cstr(graph, "}\n");
+}
+
+bool otter_build_write_graph(otter_build_context *ctx, const char *path) {
+  if (ctx == NULL || path == NULL) {
+    return false;
+  }
+
+  if (!plan_targets(ctx)) {
+    return false;
+  }
+
+  OTTER_CLEANUP(otter_string_free_p)
+  otter_string *graph = otter_string_create(ctx->allocator, "", 0);
+  if (graph == NULL) {
+    otter_log_critical(ctx->logger, "Failed to allocate build graph");
+    return false;
+  }
+
+  if (has_suffix(path, ".json")) {
+    append_graph_json(ctx, &graph);
+  } else {
+    append_graph_dot(ctx, &graph);
+  }
+
+  if (!write_report(ctx, path, graph)) {
+    return false;
+  }
+
+  otter_log_info(ctx->logger, "Wrote build graph to '%s'", path);
+  return true;
 }
 
 static void print_build_driver_usage(const char *prog,
@@ -616,6 +1291,16 @@ static void print_build_driver_usage(const char *prog,
             modes[i].name, default_marker);
   }
 
+  fprintf(stderr, "  --max-load N   Defer spawning jobs while the load average "
+                  "exceeds N\n");
+  fprintf(stderr, "  --trace FILE   Write a Chrome trace of the build to FILE "
+                  "and log a timing summary\n");
+  fprintf(stderr, "  --explain      Explain why targets are out of date and "
+                  "report the critical path without building\n");
+  fprintf(stderr, "  --graph FILE   Write the target graph to FILE (JSON if it "
+                  "ends in .json, DOT otherwise) without building\n");
+  fprintf(stderr, "  --log FILE     Also write structured log records to FILE "
+                  "(binary if it ends in .bin, JSON lines otherwise)\n");
   fprintf(stderr, "  --help, -h     Show this help message\n");
 }
 
@@ -638,6 +1323,11 @@ int otter_build_driver_main(int argc, char *argv[],
 
   /* Parse command line arguments */
   size_t selected_mode_index = default_mode_index;
+  double max_load_average = 0;
+  const char *trace_path = NULL;
+  const char *graph_path = NULL;
+  const char *log_path = NULL;
+  bool explain = false;
 
   for (int i = 1; i < argc; i++) {
     if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
@@ -645,6 +1335,64 @@ int otter_build_driver_main(int argc, char *argv[],
       return 0;
     }
 
+    if (strcmp(argv[i], "--max-load") == 0) {
+      char *end = NULL;
+      if (i + 1 < argc) {
+        max_load_average = strtod(argv[i + 1], &end);
+      }
+
+      if (end == NULL || *end != '\0' || max_load_average <= 0) {
+        fprintf(stderr, "--max-load expects a positive number\n");
+        print_build_driver_usage(argv[0], modes, mode_count,
+                                 default_mode_index);
+        return 1;
+      }
+
+      i++;
+      continue;
+    }
+
+    if (strcmp(argv[i], "--trace") == 0) {
+      if (i + 1 >= argc) {
+        fprintf(stderr, "--trace expects a file name\n");
+        print_build_driver_usage(argv[0], modes, mode_count,
+                                 default_mode_index);
+        return 1;
+      }
+
+      trace_path = argv[++i];
+      continue;
+    }
+
+    if (strcmp(argv[i], "--graph") == 0) {
+      if (i + 1 >= argc) {
+        fprintf(stderr, "--graph expects a file name\n");
+        print_build_driver_usage(argv[0], modes, mode_count,
+                                 default_mode_index);
+        return 1;
+      }
+
+      graph_path = argv[++i];
+      continue;
+    }
+
+    if (strcmp(argv[i], "--log") == 0) {
+      if (i + 1 >= argc) {
+        fprintf(stderr, "--log expects a file name\n");
+        print_build_driver_usage(argv[0], modes, mode_count,
+                                 default_mode_index);
+        return 1;
+      }
+
+      log_path = argv[++i];
+      continue;
+    }
+
+    if (strcmp(argv[i], "--explain") == 0) {
+      explain = true;
+      continue;
+    }
+
     bool found = false;
     for (size_t j = 0; j < mode_count; j++) {
       OTTER_CLEANUP(otter_string_free_p)
@@ -672,6 +1420,24 @@ int otter_build_driver_main(int argc, char *argv[],
     return 1;
   }
   otter_logger_add_sink(logger, otter_logger_console_sink);
+  if (log_path != NULL) {
+    const int log_fd =
+        open(log_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (log_fd < 0) {
+      otter_log_error(logger, "Failed to open '%s'", log_path);
+      return 1;
+    }
+
+    /* The sink owns the descriptor from here on */
+    otter_log_sink *log_sink =
+        has_suffix(log_path, ".bin")
+            ? otter_log_sink_binary_create(allocator, log_fd)
+            : otter_log_sink_jsonl_create(allocator, log_fd);
+    if (log_sink == NULL || !otter_logger_add_record_sink(logger, log_sink)) {
+      otter_log_error(logger, "Failed to log to '%s'", log_path);
+      return 1;
+    }
+  }
 
   OTTER_CLEANUP(otter_process_manager_free_p)
   otter_process_manager *process_manager =
@@ -681,14 +1447,22 @@ int otter_build_driver_main(int argc, char *argv[],
     return 1;
   }
 
+  if (max_load_average > 0) {
+    otter_process_admission admission;
+    otter_process_manager_get_admission(process_manager, &admission);
+    admission.max_load_average = max_load_average;
+    otter_process_manager_set_admission(process_manager, &admission);
+  }
+
   OTTER_CLEANUP(otter_filesystem_free_p)
   otter_filesystem *filesystem = otter_filesystem_create(allocator);
   if (filesystem == NULL) {
     return 1;
   }
 
-  /* Run bootstrap if provided */
-  if (bootstrap_fn != NULL) {
+  /* Run bootstrap if provided.  Introspection never builds anything. */
+  const bool introspect = explain || graph_path != NULL;
+  if (bootstrap_fn != NULL && !introspect) {
     if (!bootstrap_fn(allocator, filesystem, logger, process_manager)) {
       return 1;
     }
@@ -706,7 +1480,25 @@ int otter_build_driver_main(int argc, char *argv[],
     return 1;
   }
 
-  if (!otter_build_all(ctx)) {
+  if (introspect) {
+    if (graph_path != NULL && !otter_build_write_graph(ctx, graph_path)) {
+      return 1;
+    }
+
+    if (explain && !otter_build_explain(ctx)) {
+      return 1;
+    }
+
+    return 0;
+  }
+
+  const bool built = otter_build_all(ctx);
+  if (trace_path != NULL) {
+    otter_build_log_summary(ctx);
+    otter_build_write_trace(ctx, trace_path);
+  }
+
+  if (!built) {
     otter_log_critical(logger, "Build failed");
     return 1;
   }
@@ -22,6 +22,7 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/stat.h>
 #include <sys/wait.h>
 #include <unistd.h>
@@ -918,3 +919,242 @@ OTTER_TEST(build_integration_complex_transitive_deps) {
                  if (filesystem) otter_filesystem_free(filesystem);
                  system("rm -rf " TEST_DIR););
 }
+
+/* Test: Trace file records the hash and job of every target */
+OTTER_TEST(build_integration_writes_trace) {
+  otter_filesystem *filesystem = NULL;
+  otter_logger *logger = NULL;
+  otter_process_manager *proc_mgr = NULL;
+  otter_build_context *build_ctx = NULL;
+  FILE *trace = NULL;
+
+  OTTER_ASSERT(setup_test_dirs());
+
+  const char *source = "int add(int a, int b) { return a + b; }\n";
+  OTTER_ASSERT(create_source_file("math", source));
+
+  filesystem = otter_filesystem_create(OTTER_TEST_ALLOCATOR);
+  OTTER_ASSERT(filesystem != NULL);
+
+  logger = otter_logger_create(OTTER_TEST_ALLOCATOR, OTTER_LOG_LEVEL_ERROR);
+  OTTER_ASSERT(logger != NULL);
+
+  proc_mgr = otter_process_manager_create(OTTER_TEST_ALLOCATOR, logger);
+  OTTER_ASSERT(proc_mgr != NULL);
+
+  static const otter_target_definition targets[] = {
+      OBJECT_TARGET("math", no_deps), TARGET_LIST_END};
+
+  otter_build_config config = {
+      .paths = {.src_dir = TEST_SRC_DIR,
+                .out_dir = TEST_OUT_DIR,
+                .object_suffix = "",
+                .shared_object_suffix = "",
+                .executable_suffix = ""},
+      .flags = {.cc_flags = "-Wall", .ll_flags = "", .include_flags = ""}};
+
+  build_ctx = otter_build_context_create(targets, OTTER_TEST_ALLOCATOR,
+                                         filesystem, logger, proc_mgr, &config);
+  OTTER_ASSERT(build_ctx != NULL);
+  OTTER_ASSERT(otter_build_all(build_ctx));
+  OTTER_ASSERT(otter_build_write_trace(build_ctx, TEST_DIR "/trace.json"));
+
+  trace = fopen(TEST_DIR "/trace.json", "r");
+  OTTER_ASSERT(trace != NULL);
+  char contents[4096] = {0};
+  fread(contents, 1, sizeof(contents) - 1, trace);
+
+  OTTER_ASSERT(strncmp(contents, "{\"traceEvents\":[", 16) == 0);
+  OTTER_ASSERT(strstr(contents, "\"cat\":\"hash\"") != NULL);
+  OTTER_ASSERT(strstr(contents, "\"cat\":\"spawn\"") != NULL);
+  OTTER_ASSERT(strstr(contents, "\"cat\":\"run\"") != NULL);
+  OTTER_ASSERT(strstr(contents, "\"max_rss_bytes\":") != NULL);
+  OTTER_ASSERT(strstr(contents, "\"name\":\"" TEST_OUT_DIR "/math.o\"") !=
+               NULL);
+
+  OTTER_TEST_END(if (trace) fclose(trace);
+                 if (build_ctx) otter_build_context_free(build_ctx);
+                 if (proc_mgr) otter_process_manager_free(proc_mgr);
+                 if (logger) otter_logger_free(logger);
+                 if (filesystem) otter_filesystem_free(filesystem);
+                 system("rm -rf " TEST_DIR););
+}
+
+/* Sinks have no context, so the messages they see are appended here */
+#define CAPTURED_LOG_SIZE 4096
+static char captured_log[CAPTURED_LOG_SIZE];
+static size_t captured_log_length = 0;
+
+static void capture_sink(otter_log_level /* unused */, time_t /* unused */,
+                         const char *message) {
+  const int written =
+      snprintf(&captured_log[captured_log_length],
+               sizeof(captured_log) - captured_log_length, "%s\n", message);
+  if (written > 0) {
+    captured_log_length += (size_t)written;
+    if (captured_log_length >= sizeof(captured_log)) {
+      captured_log_length = sizeof(captured_log) - 1;
+    }
+  }
+}
+
+/* Reads a whole report written by the build into contents */
+static bool read_report(const char *path, char *contents, size_t size) {
+  FILE *file = fopen(path, "r");
+  if (file == NULL) {
+    return false;
+  }
+
+  const size_t length = fread(contents, 1, size - 1, file);
+  contents[length] = '\0';
+  fclose(file);
+  return true;
+}
+
+/* Test: Explain names the stale target and why, without building */
+OTTER_TEST(build_integration_explain_reports_stale_target) {
+  otter_filesystem *filesystem = NULL;
+  otter_logger *logger = NULL;
+  otter_process_manager *proc_mgr = NULL;
+  otter_build_context *build_ctx = NULL;
+
+  OTTER_ASSERT(setup_test_dirs());
+  OTTER_ASSERT(
+      create_source_file("base", "int base_value(void) { return 42; }\n"));
+  OTTER_ASSERT(create_source_file("derived",
+                                  "int derived_value(void) { return 100; }\n"));
+
+  filesystem = otter_filesystem_create(OTTER_TEST_ALLOCATOR);
+  OTTER_ASSERT(filesystem != NULL);
+
+  logger = otter_logger_create(OTTER_TEST_ALLOCATOR, OTTER_LOG_LEVEL_INFO);
+  OTTER_ASSERT(logger != NULL);
+
+  proc_mgr = otter_process_manager_create(OTTER_TEST_ALLOCATOR, logger);
+  OTTER_ASSERT(proc_mgr != NULL);
+
+  static const char *derived_deps[] = {"base", NULL};
+  static const otter_target_definition targets[] = {
+      OBJECT_TARGET("base", no_deps), OBJECT_TARGET("derived", derived_deps),
+      TARGET_LIST_END};
+
+  otter_build_config config = {
+      .paths = {.src_dir = TEST_SRC_DIR,
+                .out_dir = TEST_OUT_DIR,
+                .object_suffix = "",
+                .shared_object_suffix = "",
+                .executable_suffix = ""},
+      .flags = {.cc_flags = "-Wall", .ll_flags = "", .include_flags = ""}};
+
+  build_ctx = otter_build_context_create(targets, OTTER_TEST_ALLOCATOR,
+                                         filesystem, logger, proc_mgr, &config);
+  OTTER_ASSERT(build_ctx != NULL);
+  OTTER_ASSERT(otter_build_all(build_ctx));
+
+  /* Only base changes, derived loses its output */
+  OTTER_ASSERT(
+      create_source_file("base", "int base_value(void) { return 4242; }\n"));
+  OTTER_ASSERT(remove(TEST_OUT_DIR "/derived.o") == 0);
+
+  /* Explain runs in a fresh invocation, the way --explain does */
+  otter_build_context_free(build_ctx);
+  build_ctx = otter_build_context_create(targets, OTTER_TEST_ALLOCATOR,
+                                         filesystem, logger, proc_mgr, &config);
+  OTTER_ASSERT(build_ctx != NULL);
+
+  captured_log_length = 0;
+  captured_log[0] = '\0';
+  otter_logger_add_sink(logger, capture_sink);
+  OTTER_ASSERT(otter_build_explain(build_ctx));
+
+  OTTER_ASSERT(strstr(captured_log, "'" TEST_OUT_DIR
+                                    "/base.o' is out of date: digest "
+                                    "mismatch\n") != NULL);
+  OTTER_ASSERT(strstr(captured_log, "'" TEST_OUT_DIR
+                                    "/derived.o' is out of date: missing "
+                                    "output\n") != NULL);
+  OTTER_ASSERT(strstr(captured_log, "2 of 2 targets would be executed\n") !=
+               NULL);
+  OTTER_ASSERT(strstr(captured_log, "Critical path: ") != NULL);
+
+  /* Explaining does not build anything */
+  OTTER_ASSERT(!file_exists(TEST_OUT_DIR "/derived.o"));
+
+  OTTER_TEST_END(if (build_ctx) otter_build_context_free(build_ctx);
+                 if (proc_mgr) otter_process_manager_free(proc_mgr);
+                 if (logger) otter_logger_free(logger);
+                 if (filesystem) otter_filesystem_free(filesystem);
+                 system("rm -rf " TEST_DIR););
+}
+
+/* Test: The graph lists every target and dependency as JSON and as DOT */
+OTTER_TEST(build_integration_writes_graph) {
+  otter_filesystem *filesystem = NULL;
+  otter_logger *logger = NULL;
+  otter_process_manager *proc_mgr = NULL;
+  otter_build_context *build_ctx = NULL;
+
+  OTTER_ASSERT(setup_test_dirs());
+  OTTER_ASSERT(
+      create_source_file("base", "int base_value(void) { return 42; }\n"));
+  OTTER_ASSERT(create_source_file("derived",
+                                  "int derived_value(void) { return 100; }\n"));
+
+  filesystem = otter_filesystem_create(OTTER_TEST_ALLOCATOR);
+  OTTER_ASSERT(filesystem != NULL);
+
+  logger = otter_logger_create(OTTER_TEST_ALLOCATOR, OTTER_LOG_LEVEL_ERROR);
+  OTTER_ASSERT(logger != NULL);
+
+  proc_mgr = otter_process_manager_create(OTTER_TEST_ALLOCATOR, logger);
+  OTTER_ASSERT(proc_mgr != NULL);
+
+  static const char *derived_deps[] = {"base", NULL};
+  static const otter_target_definition targets[] = {
+      OBJECT_TARGET("base", no_deps), OBJECT_TARGET("derived", derived_deps),
+      TARGET_LIST_END};
+
+  otter_build_config config = {
+      .paths = {.src_dir = TEST_SRC_DIR,
+                .out_dir = TEST_OUT_DIR,
+                .object_suffix = "",
+                .shared_object_suffix = "",
+                .executable_suffix = ""},
+      .flags = {.cc_flags = "-Wall", .ll_flags = "", .include_flags = ""}};
+
+  build_ctx = otter_build_context_create(targets, OTTER_TEST_ALLOCATOR,
+                                         filesystem, logger, proc_mgr, &config);
+  OTTER_ASSERT(build_ctx != NULL);
+
+  char contents[4096];
+  OTTER_ASSERT(otter_build_write_graph(build_ctx, TEST_DIR "/graph.json"));
+  OTTER_ASSERT(read_report(TEST_DIR "/graph.json", contents, sizeof(contents)));
+  OTTER_ASSERT(strncmp(contents, "{\"nodes\":[", 10) == 0);
+  OTTER_ASSERT(strstr(contents, "{\"name\":\"" TEST_OUT_DIR
+                                "/base.o\",\"type\":\"object\"") != NULL);
+  OTTER_ASSERT(strstr(contents, "\"stale\":\"missing output\"}") != NULL);
+  OTTER_ASSERT(strstr(contents, "{\"from\":\"" TEST_OUT_DIR
+                                "/base.o\",\"to\":\"" TEST_OUT_DIR
+                                "/derived.o\"}") != NULL);
+
+  OTTER_ASSERT(otter_build_write_graph(build_ctx, TEST_DIR "/graph.dot"));
+  OTTER_ASSERT(read_report(TEST_DIR "/graph.dot", contents, sizeof(contents)));
+  OTTER_ASSERT(strncmp(contents, "digraph otter {\n", 16) == 0);
+  OTTER_ASSERT(strstr(contents, "  \"" TEST_OUT_DIR
+                                "/base.o\" [label=\"" TEST_OUT_DIR
+                                "/base.o\\n") != NULL);
+  OTTER_ASSERT(strstr(contents, "\\nmissing output\", color=red];\n") !=
+               NULL);
+  OTTER_ASSERT(strstr(contents, "  \"" TEST_OUT_DIR
+                                "/base.o\" -> \"" TEST_OUT_DIR
+                                "/derived.o\";\n") != NULL);
+
+  /* Writing the graph does not build anything */
+  OTTER_ASSERT(!file_exists(TEST_OUT_DIR "/base.o"));
+
+  OTTER_TEST_END(if (build_ctx) otter_build_context_free(build_ctx);
+                 if (proc_mgr) otter_process_manager_free(proc_mgr);
+                 if (logger) otter_logger_free(logger);
+                 if (filesystem) otter_filesystem_free(filesystem);
+                 system("rm -rf " TEST_DIR););
+}
@@ -44,6 +44,17 @@ otter_bytecode *otter_bytecode_create(otter_allocator *allocator,
     return NULL;
   }
 
+  /* Every constant takes at least a type and a value, so a count the source
+   * cannot hold is rejected before it is used to size the array */
+  const size_t constants_limit =
+      (source_length - sizeof(header)) / (sizeof(int) * 2);
+  if ((size_t)header.constants_length > constants_limit) {
+    otter_log_error(logger, "%s of %d does not fit in %zd bytes",
+                    OTTER_NAMEOF(header.constants_length),
+                    header.constants_length, source_length);
+    return NULL;
+  }
+
   otter_bytecode *bytecode = otter_malloc(allocator, sizeof(*bytecode));
   if (bytecode == NULL) {
     otter_log_critical(logger, "Failure to allocate %zd bytes",
@@ -51,8 +62,9 @@ otter_bytecode *otter_bytecode_create(otter_allocator *allocator,
     return NULL;
   }
 
-  OTTER_ARRAY_INIT(bytecode, constants, allocator);
-  if (bytecode->constants == NULL) {
+  /* The header states how many constants follow */
+  if (!OTTER_ARRAY_INIT_CAPACITY(bytecode, constants, allocator,
+                                 (size_t)header.constants_length)) {
     otter_log_critical(logger, "Failure to initialize array");
     goto failure;
   }
@@ -113,7 +125,7 @@ void otter_bytecode_free(otter_bytecode *bytecode) {
     return;
   }
 
-  otter_free(bytecode->allocator, bytecode->constants);
+  OTTER_ARRAY_FREE(bytecode, constants, bytecode->allocator);
   otter_free(bytecode->allocator, bytecode);
 }
 
@@ -14,10 +14,18 @@
   You should have received a copy of the GNU General Public License
   along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
+#define _GNU_SOURCE
 #include "otter/filesystem.h"
+#include "otter/clock.h"
 #include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <limits.h>
+#include <linux/fs.h>
 #include <stdio.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
 #include <sys/stat.h>
 #include <sys/xattr.h>
 #include <unistd.h>
@@ -108,59 +116,174 @@ otter_filesystem_open_file_impl(otter_filesystem *filesystem_, const char *path,
   return (otter_file *)file;
 }
 
-static bool otter_filesystem_copy_impl(otter_filesystem *filesystem_,
-                                       const char *from_path,
-                                       const char *to_path) {
-  OTTER_CLEANUP(otter_file_close_p)
-  otter_file *from_file =
-      otter_filesystem_open_file(filesystem_, from_path, "rb");
-  if (from_file == NULL) {
-    return false;
+/* Copies from_fd into to_fd.  Cloning shares the extents on filesystems that
+ * support reflinks, copy_file_range and sendfile let the kernel copy without
+ * bouncing the data through userspace (copy_file_range fails across
+ * filesystems on older kernels, sendfile does not) and the read/write loop
+ * covers everything else. */
+static bool otter_filesystem_copy_fd(int from_fd, int to_fd, off_t size) {
+  if (ioctl(to_fd, FICLONE, from_fd) == 0) {
+    return true;
   }
 
-  OTTER_CLEANUP(otter_file_close_p)
-  otter_file *to_file = otter_filesystem_open_file(filesystem_, to_path, "wb");
-  if (to_file == NULL) {
-    return false;
+  off_t copied = 0;
+  while (copied < size) {
+    const ssize_t result = copy_file_range(from_fd, NULL, to_fd, NULL,
+                                           (size_t)(size - copied), 0);
+    if (result <= 0) {
+      break;
+    }
+
+    copied += result;
   }
 
-  otter_file_info stat_info;
-  if (!otter_file_stat(from_file, &stat_info)) {
-    return false;
+  while (copied < size) {
+    const ssize_t result =
+        sendfile(to_fd, from_fd, NULL, (size_t)(size - copied));
+    if (result <= 0) {
+      break;
+    }
+
+    copied += result;
   }
 
-  otter_file_owner owner = otter_file_info_get_owner(&stat_info);
-  otter_file_permissions permissions =
-      otter_file_info_get_permissions(&stat_info);
-  if (!otter_file_set_owner(to_file, &owner)) {
-    return false;
+  if (copied == size) {
+    return true;
   }
 
-  if (!otter_file_set_permissions(to_file, &permissions)) {
+  if (lseek(from_fd, copied, SEEK_SET) < 0 ||
+      lseek(to_fd, copied, SEEK_SET) < 0) {
     return false;
   }
 
-#define buffer_size 4096
+#define buffer_size 65536
   char buffer[buffer_size];
-  size_t bytes_read = otter_file_read(from_file, buffer, buffer_size);
-  while (bytes_read > 0) {
-    const size_t bytes_written = otter_file_write(to_file, buffer, bytes_read);
-    if (bytes_written != bytes_read) {
+  ssize_t bytes_read;
+  while ((bytes_read = read(from_fd, buffer, buffer_size)) != 0) {
+    if (bytes_read < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
       return false;
     }
 
-    bytes_read = otter_file_read(from_file, buffer, buffer_size);
+    ssize_t offset = 0;
+    while (offset < bytes_read) {
+      const ssize_t bytes_written =
+          write(to_fd, &buffer[offset], (size_t)(bytes_read - offset));
+      if (bytes_written < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+
+        return false;
+      }
+
+      offset += bytes_written;
+    }
   }
+#undef buffer_size
 
   return true;
 }
 
+/* The copy is written to a temporary file next to to_path and renamed over
+ * it, so readers only ever observe the old or the complete new file.  This
+ * also allows replacing an executable that is currently running. */
+static bool otter_filesystem_copy_impl(otter_filesystem *filesystem_,
+                                       const char *from_path,
+                                       const char *to_path) {
+  otter_filesystem_impl *filesystem = (otter_filesystem_impl *)filesystem_;
+  const int from_fd = open(from_path, O_RDONLY | O_CLOEXEC);
+  if (from_fd < 0) {
+    return false;
+  }
+
+  bool result = false;
+  int to_fd = -1;
+  char *temp_path = NULL;
+  struct stat stat_info;
+  if (fstat(from_fd, &stat_info) != 0) {
+    goto cleanup;
+  }
+
+  const int temp_path_length =
+      snprintf(NULL, 0, "%s.tmp.%d", to_path, (int)getpid());
+  if (temp_path_length < 0) {
+    goto cleanup;
+  }
+
+  temp_path =
+      otter_malloc(filesystem->allocator, (size_t)temp_path_length + 1);
+  if (temp_path == NULL) {
+    goto cleanup;
+  }
+
+  snprintf(temp_path, (size_t)temp_path_length + 1, "%s.tmp.%d", to_path,
+           (int)getpid());
+  to_fd = open(temp_path, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC,
+               stat_info.st_mode & (mode_t)~S_IFMT);
+  if (to_fd < 0) {
+    goto cleanup;
+  }
+
+  if (fchown(to_fd, stat_info.st_uid, stat_info.st_gid) != 0 ||
+      fchmod(to_fd, stat_info.st_mode & (mode_t)~S_IFMT) != 0) {
+    goto cleanup;
+  }
+
+  if (!otter_filesystem_copy_fd(from_fd, to_fd, stat_info.st_size)) {
+    goto cleanup;
+  }
+
+  if (close(to_fd) != 0) {
+    to_fd = -1;
+    goto cleanup;
+  }
+
+  to_fd = -1;
+  result = rename(temp_path, to_path) == 0;
+
+cleanup:
+  if (to_fd >= 0) {
+    close(to_fd);
+  }
+
+  if (!result && temp_path != NULL) {
+    unlink(temp_path);
+  }
+
+  otter_free(filesystem->allocator, temp_path);
+  close(from_fd);
+  return result;
+}
+
 static bool otter_filesystem_remove_impl(otter_filesystem * /*unused*/,
                                          const char *path) {
   const int result = remove(path);
   return result == 0;
 }
 
+static bool otter_filesystem_rename_impl(otter_filesystem * /*unused*/,
+                                         const char *from_path,
+                                         const char *to_path) {
+  const int result = rename(from_path, to_path);
+  return result == 0;
+}
+
+static bool otter_filesystem_make_directory_impl(otter_filesystem * /*unused*/,
+                                                 const char *path) {
+  const mode_t permissions = 0755;
+  if (mkdir(path, permissions) == 0) {
+    return true;
+  }
+
+  struct stat status;
+  return errno == EEXIST && stat(path, &status) == 0 &&
+         S_ISDIR(status.st_mode);
+}
+
 static bool otter_filesystem_exists_impl(otter_filesystem * /*unused*/,
                                          const char *path) {
   if (access(path, F_OK) == 0) {
@@ -189,6 +312,149 @@ static int otter_filesystem_set_attribute_impl(otter_filesystem * /*unused */,
   return setxattr(path, attribute, value, value_size, 0);
 }
 
+/* Files below this size are cheaper to read than to map */
+#define OTTER_FILESYSTEM_MAP_THRESHOLD 16384
+
+static bool otter_filesystem_read_fd(otter_filesystem_impl *filesystem,
+                                     int file_descriptor, size_t length,
+                                     otter_file_view *view) {
+  char *buffer = otter_malloc(filesystem->allocator, length + 1);
+  if (buffer == NULL) {
+    return false;
+  }
+
+  size_t offset = 0;
+  while (offset < length) {
+    const ssize_t bytes_read =
+        read(file_descriptor, &buffer[offset], length - offset);
+    if (bytes_read < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if (bytes_read <= 0) {
+      otter_free(filesystem->allocator, buffer);
+      return false;
+    }
+
+    offset += (size_t)bytes_read;
+  }
+
+  buffer[length] = '\0';
+  view->data = buffer;
+  view->length = length;
+  view->storage = buffer;
+  view->mapped = false;
+  return true;
+}
+
+static bool otter_filesystem_map_file_impl(otter_filesystem *filesystem_,
+                                           const char *path,
+                                           otter_file_view *view) {
+  otter_filesystem_impl *filesystem = (otter_filesystem_impl *)filesystem_;
+  const int file_descriptor = open(path, O_RDONLY | O_CLOEXEC);
+  if (file_descriptor < 0) {
+    return false;
+  }
+
+  bool result = false;
+  struct stat stat_info;
+  if (fstat(file_descriptor, &stat_info) != 0 || stat_info.st_size < 0) {
+    goto cleanup;
+  }
+
+  const size_t length = (size_t)stat_info.st_size;
+  if (length < OTTER_FILESYSTEM_MAP_THRESHOLD) {
+    result = otter_filesystem_read_fd(filesystem, file_descriptor, length,
+                                      view);
+    goto cleanup;
+  }
+
+  void *mapping =
+      mmap(NULL, length, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+  if (mapping == MAP_FAILED) {
+    result = otter_filesystem_read_fd(filesystem, file_descriptor, length,
+                                      view);
+    goto cleanup;
+  }
+
+  /* Consumers stream through the file once */
+  madvise(mapping, length, MADV_SEQUENTIAL);
+  view->data = mapping;
+  view->length = length;
+  view->storage = mapping;
+  view->mapped = true;
+  result = true;
+
+cleanup:
+  close(file_descriptor);
+  return result;
+}
+
+static void otter_filesystem_unmap_file_impl(otter_filesystem *filesystem_,
+                                             otter_file_view *view) {
+  otter_filesystem_impl *filesystem = (otter_filesystem_impl *)filesystem_;
+  if (view->mapped) {
+    munmap(view->storage, view->length);
+  } else {
+    otter_free(filesystem->allocator, view->storage);
+  }
+
+  view->data = NULL;
+  view->length = 0;
+  view->storage = NULL;
+  view->mapped = false;
+}
+
+/* Only the fields of otter_file_status are requested, which lets network
+ * filesystems skip fetching the rest */
+#define OTTER_FILESYSTEM_STATX_MASK                                            \
+  (STATX_TYPE | STATX_MODE | STATX_SIZE | STATX_MTIME)
+
+static bool otter_filesystem_stat_many_impl(otter_filesystem * /*unused*/,
+                                            const char *const *paths,
+                                            size_t count,
+                                            otter_file_status *statuses) {
+  bool result = true;
+  for (size_t i = 0; i < count; i++) {
+    struct statx statx_info;
+    if (statx(AT_FDCWD, paths[i], 0, OTTER_FILESYSTEM_STATX_MASK,
+              &statx_info) != 0) {
+      statuses[i] = (otter_file_status){.exists = false};
+      if (errno != ENOENT && errno != ENOTDIR) {
+        result = false;
+      }
+
+      continue;
+    }
+
+    statuses[i] = (otter_file_status){
+        .exists = true,
+        .mode = statx_info.stx_mode,
+        .size = statx_info.stx_size,
+        .mtime_ns = (statx_info.stx_mtime.tv_sec *
+                     (int64_t)OTTER_NANOSECONDS_PER_SECOND) +
+                    statx_info.stx_mtime.tv_nsec,
+    };
+  }
+
+  return result;
+}
+
+static void otter_filesystem_get_attribute_many_impl(
+    otter_filesystem *filesystem, const char *const *paths, size_t count,
+    const char *attribute, unsigned char *values, size_t value_size,
+    int *results) {
+  for (size_t i = 0; i < count; i++) {
+    results[i] = otter_filesystem_get_attribute_impl(
+        filesystem, paths[i], attribute, &values[i * value_size], value_size);
+  }
+}
+
+static void otter_filesystem_invalidate_impl(otter_filesystem * /*unused*/,
+                                             const char * /*unused*/) {
+  /* Nothing is cached */
+}
+
 otter_filesystem *otter_filesystem_create(otter_allocator *allocator) {
   otter_filesystem_impl *filesystem =
       otter_malloc(allocator, sizeof(*filesystem));
@@ -201,9 +467,16 @@ otter_filesystem *otter_filesystem_create(otter_allocator *allocator) {
       .open_file = otter_filesystem_open_file_impl,
       .copy = otter_filesystem_copy_impl,
       .remove = otter_filesystem_remove_impl,
+      .rename = otter_filesystem_rename_impl,
+      .make_directory = otter_filesystem_make_directory_impl,
       .exists = otter_filesystem_exists_impl,
       .set_attribute = otter_filesystem_set_attribute_impl,
       .get_attribute = otter_filesystem_get_attribute_impl,
+      .map_file = otter_filesystem_map_file_impl,
+      .unmap_file = otter_filesystem_unmap_file_impl,
+      .stat_many = otter_filesystem_stat_many_impl,
+      .invalidate = otter_filesystem_invalidate_impl,
+      .get_attribute_many = otter_filesystem_get_attribute_many_impl,
   };
 
   filesystem->base.vtable = &vtable;
@@ -231,6 +504,16 @@ bool otter_filesystem_remove(otter_filesystem *filesystem, const char *path) {
   return filesystem->vtable->remove(filesystem, path);
 }
 
+bool otter_filesystem_rename(otter_filesystem *filesystem,
+                             const char *from_path, const char *to_path) {
+  return filesystem->vtable->rename(filesystem, from_path, to_path);
+}
+
+bool otter_filesystem_make_directory(otter_filesystem *filesystem,
+                                     const char *path) {
+  return filesystem->vtable->make_directory(filesystem, path);
+}
+
 bool otter_filesystem_exists(otter_filesystem *filesystem, const char *path) {
   return filesystem->vtable->exists(filesystem, path);
 }
@@ -248,3 +531,33 @@ int otter_filesystem_set_attribute(otter_filesystem *filesystem,
   return filesystem->vtable->set_attribute(filesystem, path, attribute, value,
                                            value_size);
 }
+
+bool otter_filesystem_map_file(otter_filesystem *filesystem, const char *path,
+                               otter_file_view *view) {
+  return filesystem->vtable->map_file(filesystem, path, view);
+}
+
+void otter_filesystem_unmap_file(otter_filesystem *filesystem,
+                                 otter_file_view *view) {
+  filesystem->vtable->unmap_file(filesystem, view);
+}
+
+bool otter_filesystem_stat_many(otter_filesystem *filesystem,
+                                const char *const *paths, size_t count,
+                                otter_file_status *statuses) {
+  return filesystem->vtable->stat_many(filesystem, paths, count, statuses);
+}
+
+void otter_filesystem_invalidate(otter_filesystem *filesystem,
+                                 const char *path) {
+  filesystem->vtable->invalidate(filesystem, path);
+}
+
+void otter_filesystem_get_attribute_many(otter_filesystem *filesystem,
+                                         const char *const *paths,
+                                         size_t count, const char *attribute,
+                                         unsigned char *values,
+                                         size_t value_size, int *results) {
+  filesystem->vtable->get_attribute_many(filesystem, paths, count, attribute,
+                                         values, value_size, results);
+}
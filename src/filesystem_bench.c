@@ -0,0 +1,154 @@
+/*
+  otter Copyright (C) 2026 Nathaniel Wright
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "otter/allocator.h"
+#include "otter/bench.h"
+#include "otter/filesystem.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Measures otter_filesystem_copy against the stdio loop it replaced for files
+ * from 1 MiB up to 1 GiB.  Each size copies roughly the same total number of
+ * bytes so small files are not dominated by timer noise.  The files are
+ * created in the directory given as the first argument, which defaults to the
+ * current directory. */
+
+#define OTTER_BENCH_MEBIBYTE ((size_t)1024 * 1024)
+#define OTTER_BENCH_BYTES_PER_SIZE (512 * OTTER_BENCH_MEBIBYTE)
+#define OTTER_BENCH_STDIO_BUFFER_SIZE 4096
+#define OTTER_BENCH_PATH_SIZE 4096
+
+static bool bench_create_file(const char *path, size_t size) {
+  FILE *file = fopen(path, "wb");
+  if (file == NULL) {
+    return false;
+  }
+
+  static unsigned char block[OTTER_BENCH_MEBIBYTE];
+  for (size_t i = 0; i < sizeof(block); i++) {
+    block[i] = (unsigned char)(i * 31);
+  }
+
+  bool result = true;
+  for (size_t written = 0; written < size; written += sizeof(block)) {
+    if (fwrite(block, 1, sizeof(block), file) != sizeof(block)) {
+      result = false;
+      break;
+    }
+  }
+
+  fclose(file);
+  return result;
+}
+
+static bool bench_stdio_copy(const char *from_path, const char *to_path) {
+  FILE *from_file = fopen(from_path, "rb");
+  if (from_file == NULL) {
+    return false;
+  }
+
+  FILE *to_file = fopen(to_path, "wb");
+  if (to_file == NULL) {
+    fclose(from_file);
+    return false;
+  }
+
+  bool result = true;
+  char buffer[OTTER_BENCH_STDIO_BUFFER_SIZE];
+  size_t bytes_read;
+  while ((bytes_read = fread(buffer, 1, sizeof(buffer), from_file)) > 0) {
+    if (fwrite(buffer, 1, bytes_read, to_file) != bytes_read) {
+      result = false;
+      break;
+    }
+  }
+
+  fclose(to_file);
+  fclose(from_file);
+  return result;
+}
+
+static void bench_copy_size(otter_filesystem *filesystem,
+                            const char *directory, size_t size) {
+  char from_path[OTTER_BENCH_PATH_SIZE];
+  char to_path[OTTER_BENCH_PATH_SIZE];
+  snprintf(from_path, sizeof(from_path), "%s/otter_copy_bench.src", directory);
+  snprintf(to_path, sizeof(to_path), "%s/otter_copy_bench.dst", directory);
+  if (!bench_create_file(from_path, size)) {
+    fprintf(stderr, "Unable to create '%s'\n", from_path);
+    return;
+  }
+
+  size_t copies = OTTER_BENCH_BYTES_PER_SIZE / size;
+  if (copies == 0) {
+    copies = 1;
+  }
+
+  char name[64];
+  size_t completed = 0;
+  uint64_t start = otter_bench_now_ns();
+  for (; completed < copies; completed++) {
+    if (!bench_stdio_copy(from_path, to_path)) {
+      break;
+    }
+  }
+
+  snprintf(name, sizeof(name), "stdio copy %zu MiB",
+           size / OTTER_BENCH_MEBIBYTE);
+  otter_bench_report(name, completed, otter_bench_now_ns() - start);
+  remove(to_path);
+
+  completed = 0;
+  start = otter_bench_now_ns();
+  for (; completed < copies; completed++) {
+    if (!otter_filesystem_copy(filesystem, from_path, to_path)) {
+      break;
+    }
+  }
+
+  snprintf(name, sizeof(name), "otter_filesystem_copy %zu MiB",
+           size / OTTER_BENCH_MEBIBYTE);
+  otter_bench_report(name, completed, otter_bench_now_ns() - start);
+  remove(to_path);
+  remove(from_path);
+}
+
+int main(int argc, char *argv[]) {
+  const char *directory = ".";
+  if (argc > 1) {
+    directory = argv[1];
+  }
+
+  OTTER_CLEANUP(otter_allocator_free_p)
+  otter_allocator *allocator = otter_allocator_create();
+  if (allocator == NULL) {
+    return EXIT_FAILURE;
+  }
+
+  OTTER_CLEANUP(otter_filesystem_free_p)
+  otter_filesystem *filesystem = otter_filesystem_create(allocator);
+  if (filesystem == NULL) {
+    return EXIT_FAILURE;
+  }
+
+  static const size_t sizes[] = {1, 16, 128, 1024};
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    bench_copy_size(filesystem, directory, sizes[i] * OTTER_BENCH_MEBIBYTE);
+  }
+
+  return EXIT_SUCCESS;
+}
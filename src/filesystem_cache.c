@@ -0,0 +1,349 @@
+/*
+  otter Copyright (C) 2026 Nathaniel Wright
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "otter/cstring.h"
+#include "otter/filesystem.h"
+#include <stdint.h>
+#include <string.h>
+
+#define OTTER_FILESYSTEM_CACHE_INITIAL_CAPACITY 256
+#define OTTER_FILESYSTEM_CACHE_FNV_OFFSET 14695981039346656037ULL
+#define OTTER_FILESYSTEM_CACHE_FNV_PRIME 1099511628211ULL
+
+/* Entries are never removed, invalidating only clears valid, so the open
+ * addressed table does not need tombstones */
+typedef struct otter_filesystem_cache_entry {
+  char *path; /* NULL marks an empty slot */
+  uint64_t hash;
+  bool valid;
+  otter_file_status status;
+} otter_filesystem_cache_entry;
+
+typedef struct otter_filesystem_cache {
+  otter_filesystem base;
+  otter_allocator *allocator;
+  otter_filesystem *parent;
+  otter_filesystem_cache_entry *entries;
+  size_t capacity; /* Always a power of two */
+  size_t length;
+} otter_filesystem_cache;
+
+static uint64_t otter_filesystem_cache_hash(const char *path) {
+  uint64_t hash = OTTER_FILESYSTEM_CACHE_FNV_OFFSET;
+  for (const char *character = path; *character != '\0'; character++) {
+    hash ^= (unsigned char)*character;
+    hash *= OTTER_FILESYSTEM_CACHE_FNV_PRIME;
+  }
+
+  return hash;
+}
+
+static otter_filesystem_cache_entry *
+otter_filesystem_cache_slot(otter_filesystem_cache_entry *entries,
+                            size_t capacity, const char *path,
+                            uint64_t hash) {
+  size_t index = (size_t)hash & (capacity - 1);
+  while (entries[index].path != NULL) {
+    if (entries[index].hash == hash &&
+        0 == strcmp(entries[index].path, path)) {
+      break;
+    }
+
+    index = (index + 1) & (capacity - 1);
+  }
+
+  return &entries[index];
+}
+
+static bool otter_filesystem_cache_grow(otter_filesystem_cache *cache) {
+  const size_t capacity = cache->capacity * 2;
+  otter_filesystem_cache_entry *entries =
+      otter_malloc(cache->allocator, sizeof(*entries) * capacity);
+  if (entries == NULL) {
+    return false;
+  }
+
+  for (size_t i = 0; i < capacity; i++) {
+    entries[i].path = NULL;
+  }
+
+  for (size_t i = 0; i < cache->capacity; i++) {
+    otter_filesystem_cache_entry *entry = &cache->entries[i];
+    if (entry->path != NULL) {
+      *otter_filesystem_cache_slot(entries, capacity, entry->path,
+                                   entry->hash) = *entry;
+    }
+  }
+
+  otter_free(cache->allocator, cache->entries);
+  cache->entries = entries;
+  cache->capacity = capacity;
+  return true;
+}
+
+static otter_filesystem_cache_entry *
+otter_filesystem_cache_find(otter_filesystem_cache *cache, const char *path) {
+  otter_filesystem_cache_entry *entry = otter_filesystem_cache_slot(
+      cache->entries, cache->capacity, path, otter_filesystem_cache_hash(path));
+  return entry->path != NULL ? entry : NULL;
+}
+
+static void otter_filesystem_cache_store(otter_filesystem_cache *cache,
+                                         const char *path,
+                                         const otter_file_status *status) {
+  /* Keep the load factor below 3/4 */
+  if ((cache->length + 1) * 4 > cache->capacity * 3 &&
+      !otter_filesystem_cache_grow(cache)) {
+    return;
+  }
+
+  const uint64_t hash = otter_filesystem_cache_hash(path);
+  otter_filesystem_cache_entry *entry = otter_filesystem_cache_slot(
+      cache->entries, cache->capacity, path, hash);
+  if (entry->path == NULL) {
+    entry->path = otter_strdup(cache->allocator, path);
+    if (entry->path == NULL) {
+      return;
+    }
+
+    entry->hash = hash;
+    cache->length++;
+  }
+
+  entry->valid = true;
+  entry->status = *status;
+}
+
+static void otter_filesystem_cache_free_impl(otter_filesystem *filesystem) {
+  otter_filesystem_cache *cache = (otter_filesystem_cache *)filesystem;
+  for (size_t i = 0; i < cache->capacity; i++) {
+    otter_free(cache->allocator, cache->entries[i].path);
+  }
+
+  otter_free(cache->allocator, cache->entries);
+  otter_free(cache->allocator, cache);
+}
+
+static void otter_filesystem_cache_invalidate_impl(otter_filesystem *filesystem,
+                                                   const char *path) {
+  otter_filesystem_cache *cache = (otter_filesystem_cache *)filesystem;
+  if (path == NULL) {
+    for (size_t i = 0; i < cache->capacity; i++) {
+      cache->entries[i].valid = false;
+    }
+  } else {
+    otter_filesystem_cache_entry *entry =
+        otter_filesystem_cache_find(cache, path);
+    if (entry != NULL) {
+      entry->valid = false;
+    }
+  }
+
+  otter_filesystem_invalidate(cache->parent, path);
+}
+
+static bool otter_filesystem_cache_stat_many_impl(otter_filesystem *filesystem,
+                                                  const char *const *paths,
+                                                  size_t count,
+                                                  otter_file_status *statuses) {
+  otter_filesystem_cache *cache = (otter_filesystem_cache *)filesystem;
+  if (count == 0) {
+    return true;
+  }
+
+  const char **missed_paths =
+      otter_malloc(cache->allocator, sizeof(*missed_paths) * count);
+  size_t *missed_indices =
+      otter_malloc(cache->allocator, sizeof(*missed_indices) * count);
+  otter_file_status *missed_statuses =
+      otter_malloc(cache->allocator, sizeof(*missed_statuses) * count);
+  bool result = false;
+  if (missed_paths == NULL || missed_indices == NULL ||
+      missed_statuses == NULL) {
+    goto cleanup;
+  }
+
+  size_t missed = 0;
+  for (size_t i = 0; i < count; i++) {
+    const otter_filesystem_cache_entry *entry =
+        otter_filesystem_cache_find(cache, paths[i]);
+    if (entry != NULL && entry->valid) {
+      statuses[i] = entry->status;
+    } else {
+      missed_paths[missed] = paths[i];
+      missed_indices[missed] = i;
+      missed++;
+    }
+  }
+
+  /* Everything that was not cached is queried as a single batch */
+  result = missed == 0 ||
+           otter_filesystem_stat_many(cache->parent, missed_paths, missed,
+                                      missed_statuses);
+  for (size_t i = 0; i < missed; i++) {
+    statuses[missed_indices[i]] = missed_statuses[i];
+    /* A failed batch does not say which path failed, so none are kept */
+    if (result) {
+      otter_filesystem_cache_store(cache, missed_paths[i],
+                                   &missed_statuses[i]);
+    }
+  }
+
+cleanup:
+  otter_free(cache->allocator, missed_paths);
+  otter_free(cache->allocator, missed_indices);
+  otter_free(cache->allocator, missed_statuses);
+  return result;
+}
+
+static bool otter_filesystem_cache_exists_impl(otter_filesystem *filesystem,
+                                               const char *path) {
+  otter_file_status status;
+  if (!otter_filesystem_cache_stat_many_impl(filesystem, &path, 1, &status)) {
+    return false;
+  }
+
+  return status.exists;
+}
+
+static otter_file *otter_filesystem_cache_open_file_impl(
+    otter_filesystem *filesystem, const char *path, const char *mode) {
+  otter_filesystem_cache *cache = (otter_filesystem_cache *)filesystem;
+  if (strpbrk(mode, "wa+") != NULL) {
+    otter_filesystem_cache_invalidate_impl(filesystem, path);
+  }
+
+  return otter_filesystem_open_file(cache->parent, path, mode);
+}
+
+static bool otter_filesystem_cache_copy_impl(otter_filesystem *filesystem,
+                                             const char *from_path,
+                                             const char *to_path) {
+  otter_filesystem_cache *cache = (otter_filesystem_cache *)filesystem;
+  otter_filesystem_cache_invalidate_impl(filesystem, to_path);
+  return otter_filesystem_copy(cache->parent, from_path, to_path);
+}
+
+static bool otter_filesystem_cache_remove_impl(otter_filesystem *filesystem,
+                                               const char *path) {
+  otter_filesystem_cache *cache = (otter_filesystem_cache *)filesystem;
+  otter_filesystem_cache_invalidate_impl(filesystem, path);
+  return otter_filesystem_remove(cache->parent, path);
+}
+
+static bool otter_filesystem_cache_rename_impl(otter_filesystem *filesystem,
+                                               const char *from_path,
+                                               const char *to_path) {
+  otter_filesystem_cache *cache = (otter_filesystem_cache *)filesystem;
+  otter_filesystem_cache_invalidate_impl(filesystem, from_path);
+  otter_filesystem_cache_invalidate_impl(filesystem, to_path);
+  return otter_filesystem_rename(cache->parent, from_path, to_path);
+}
+
+static bool
+otter_filesystem_cache_make_directory_impl(otter_filesystem *filesystem,
+                                           const char *path) {
+  otter_filesystem_cache *cache = (otter_filesystem_cache *)filesystem;
+  otter_filesystem_cache_invalidate_impl(filesystem, path);
+  return otter_filesystem_make_directory(cache->parent, path);
+}
+
+static int otter_filesystem_cache_get_attribute_impl(
+    otter_filesystem *filesystem, const char *path, const char *attribute,
+    unsigned char *value, size_t value_size) {
+  otter_filesystem_cache *cache = (otter_filesystem_cache *)filesystem;
+  return otter_filesystem_get_attribute(cache->parent, path, attribute, value,
+                                        value_size);
+}
+
+static int otter_filesystem_cache_set_attribute_impl(
+    otter_filesystem *filesystem, const char *path, const char *attribute,
+    const unsigned char *value, size_t value_size) {
+  otter_filesystem_cache *cache = (otter_filesystem_cache *)filesystem;
+  return otter_filesystem_set_attribute(cache->parent, path, attribute, value,
+                                        value_size);
+}
+
+static void otter_filesystem_cache_get_attribute_many_impl(
+    otter_filesystem *filesystem, const char *const *paths, size_t count,
+    const char *attribute, unsigned char *values, size_t value_size,
+    int *results) {
+  otter_filesystem_cache *cache = (otter_filesystem_cache *)filesystem;
+  otter_filesystem_get_attribute_many(cache->parent, paths, count, attribute,
+                                      values, value_size, results);
+}
+
+static bool otter_filesystem_cache_map_file_impl(otter_filesystem *filesystem,
+                                                 const char *path,
+                                                 otter_file_view *view) {
+  otter_filesystem_cache *cache = (otter_filesystem_cache *)filesystem;
+  return otter_filesystem_map_file(cache->parent, path, view);
+}
+
+static void
+otter_filesystem_cache_unmap_file_impl(otter_filesystem *filesystem,
+                                       otter_file_view *view) {
+  otter_filesystem_cache *cache = (otter_filesystem_cache *)filesystem;
+  otter_filesystem_unmap_file(cache->parent, view);
+}
+
+otter_filesystem *otter_filesystem_create_cached(otter_allocator *allocator,
+                                                 otter_filesystem *parent) {
+  if (allocator == NULL || parent == NULL) {
+    return NULL;
+  }
+
+  otter_filesystem_cache *cache = otter_malloc(allocator, sizeof(*cache));
+  if (cache == NULL) {
+    return NULL;
+  }
+
+  cache->entries = otter_malloc(
+      allocator,
+      sizeof(*cache->entries) * OTTER_FILESYSTEM_CACHE_INITIAL_CAPACITY);
+  if (cache->entries == NULL) {
+    otter_free(allocator, cache);
+    return NULL;
+  }
+
+  for (size_t i = 0; i < OTTER_FILESYSTEM_CACHE_INITIAL_CAPACITY; i++) {
+    cache->entries[i].path = NULL;
+  }
+
+  static otter_filesystem_vtable vtable = {
+      .free = otter_filesystem_cache_free_impl,
+      .open_file = otter_filesystem_cache_open_file_impl,
+      .copy = otter_filesystem_cache_copy_impl,
+      .remove = otter_filesystem_cache_remove_impl,
+      .rename = otter_filesystem_cache_rename_impl,
+      .make_directory = otter_filesystem_cache_make_directory_impl,
+      .exists = otter_filesystem_cache_exists_impl,
+      .get_attribute = otter_filesystem_cache_get_attribute_impl,
+      .set_attribute = otter_filesystem_cache_set_attribute_impl,
+      .map_file = otter_filesystem_cache_map_file_impl,
+      .unmap_file = otter_filesystem_cache_unmap_file_impl,
+      .stat_many = otter_filesystem_cache_stat_many_impl,
+      .invalidate = otter_filesystem_cache_invalidate_impl,
+      .get_attribute_many = otter_filesystem_cache_get_attribute_many_impl,
+  };
+
+  cache->base.vtable = &vtable;
+  cache->allocator = allocator;
+  cache->parent = parent;
+  cache->capacity = OTTER_FILESYSTEM_CACHE_INITIAL_CAPACITY;
+  cache->length = 0;
+  return (otter_filesystem *)cache;
+}
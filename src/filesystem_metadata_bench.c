@@ -0,0 +1,146 @@
+/*
+  otter Copyright (C) 2026 Nathaniel Wright
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "otter/allocator.h"
+#include "otter/bench.h"
+#include "otter/filesystem.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Sweeps the metadata of a directory of files the way an up-to-date check
+ * does: one stat and one digest attribute per file.  The POSIX filesystem
+ * issues one syscall per query, the io_uring filesystem submits them in
+ * batches (or falls back to POSIX itself).  The files are created below the
+ * directory given as the first argument, which defaults to the current
+ * directory. */
+
+#define OTTER_BENCH_DEFAULT_FILES 10000
+#define OTTER_BENCH_ROUNDS 10
+#define OTTER_BENCH_PATH_SIZE 64
+#define OTTER_BENCH_ATTRIBUTE "user.otter-sha1"
+#define OTTER_BENCH_DIGEST_SIZE 20
+
+typedef struct otter_bench_sweep {
+  char **paths;
+  otter_file_status *statuses;
+  unsigned char *digests;
+  int *results;
+  size_t files;
+} otter_bench_sweep;
+
+static void bench_sweep(otter_filesystem *filesystem, const char *name,
+                        otter_bench_sweep *sweep) {
+  size_t completed = 0;
+  const uint64_t start = otter_bench_now_ns();
+  for (size_t round = 0; round < OTTER_BENCH_ROUNDS; round++) {
+    const char *const *paths = (const char *const *)sweep->paths;
+    if (!otter_filesystem_stat_many(filesystem, paths, sweep->files,
+                                    sweep->statuses)) {
+      break;
+    }
+
+    otter_filesystem_get_attribute_many(
+        filesystem, paths, sweep->files, OTTER_BENCH_ATTRIBUTE, sweep->digests,
+        OTTER_BENCH_DIGEST_SIZE, sweep->results);
+    completed += sweep->files;
+  }
+
+  otter_bench_report(name, completed, otter_bench_now_ns() - start);
+}
+
+int main(int argc, char *argv[]) {
+  const char *directory = ".";
+  if (argc > 1) {
+    directory = argv[1];
+  }
+
+  size_t files = OTTER_BENCH_DEFAULT_FILES;
+  if (argc > 2) {
+    files = strtoul(argv[2], NULL, 10);
+  }
+
+  OTTER_CLEANUP(otter_allocator_free_p)
+  otter_allocator *allocator = otter_allocator_create();
+  if (allocator == NULL) {
+    return EXIT_FAILURE;
+  }
+
+  OTTER_CLEANUP(otter_filesystem_free_p)
+  otter_filesystem *posix = otter_filesystem_create(allocator);
+  OTTER_CLEANUP(otter_filesystem_free_p)
+  otter_filesystem *uring = otter_filesystem_create_uring(allocator);
+  if (posix == NULL || uring == NULL) {
+    return EXIT_FAILURE;
+  }
+
+  char sweep_directory[OTTER_BENCH_PATH_SIZE * 4];
+  snprintf(sweep_directory, sizeof(sweep_directory), "%s/otter_metadata_bench",
+           directory);
+  mkdir(sweep_directory, S_IRWXU);
+
+  otter_bench_sweep sweep = {
+      .paths = otter_malloc(allocator, sizeof(*sweep.paths) * files),
+      .statuses = otter_malloc(allocator, sizeof(*sweep.statuses) * files),
+      .digests = otter_malloc(allocator, OTTER_BENCH_DIGEST_SIZE * files),
+      .results = otter_malloc(allocator, sizeof(*sweep.results) * files),
+      .files = 0,
+  };
+  int result = EXIT_FAILURE;
+  if (sweep.paths == NULL || sweep.statuses == NULL || sweep.digests == NULL ||
+      sweep.results == NULL) {
+    goto cleanup;
+  }
+
+  const unsigned char digest[OTTER_BENCH_DIGEST_SIZE] = {0};
+  for (; sweep.files < files; sweep.files++) {
+    const size_t path_size = sizeof(sweep_directory) + OTTER_BENCH_PATH_SIZE;
+    char *path = otter_malloc(allocator, path_size);
+    if (path == NULL) {
+      goto cleanup;
+    }
+
+    snprintf(path, path_size, "%s/%zu.o", sweep_directory, sweep.files);
+    sweep.paths[sweep.files] = path;
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+      otter_free(allocator, path);
+      goto cleanup;
+    }
+
+    fclose(file);
+    otter_filesystem_set_attribute(posix, path, OTTER_BENCH_ATTRIBUTE, digest,
+                                   sizeof(digest));
+  }
+
+  bench_sweep(posix, "posix stat + getxattr", &sweep);
+  bench_sweep(uring, "io_uring stat + getxattr", &sweep);
+  result = EXIT_SUCCESS;
+
+cleanup:
+  for (size_t i = 0; i < sweep.files; i++) {
+    remove(sweep.paths[i]);
+    otter_free(allocator, sweep.paths[i]);
+  }
+
+  rmdir(sweep_directory);
+  otter_free(allocator, sweep.paths);
+  otter_free(allocator, sweep.statuses);
+  otter_free(allocator, sweep.digests);
+  otter_free(allocator, sweep.results);
+  return result;
+}
@@ -0,0 +1,187 @@
+/*
+  otter Copyright (C) 2026 Nathaniel Wright
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "otter/filesystem.h"
+#include "otter/test.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+OTTER_TEST(filesystem_stat_many_reports_missing_paths) {
+  otter_filesystem *filesystem = NULL;
+
+  filesystem = otter_filesystem_create(OTTER_TEST_ALLOCATOR);
+  OTTER_ASSERT(filesystem != NULL);
+
+  const char *paths[] = {"test_fixtures/test.c", "test_fixtures/missing.c",
+                         "test_fixtures/test.c/missing.c"};
+  otter_file_status statuses[3];
+  OTTER_ASSERT(otter_filesystem_stat_many(filesystem, paths, 3, statuses));
+  OTTER_ASSERT(statuses[0].exists);
+  OTTER_ASSERT(statuses[0].size > 0);
+  OTTER_ASSERT(statuses[0].mtime_ns > 0);
+  OTTER_ASSERT(!statuses[1].exists);
+  OTTER_ASSERT(!statuses[2].exists);
+
+  OTTER_TEST_END(if (filesystem) otter_filesystem_free(filesystem););
+}
+
+typedef struct otter_filesystem_counting {
+  otter_filesystem base;
+  otter_filesystem_vtable counting_vtable;
+  size_t paths_stated;
+} otter_filesystem_counting;
+
+static bool otter_filesystem_counting_stat_many_impl(
+    otter_filesystem *filesystem, const char *const * /*unused*/, size_t count,
+    otter_file_status *statuses) {
+  otter_filesystem_counting *counting = (otter_filesystem_counting *)filesystem;
+  for (size_t i = 0; i < count; i++) {
+    statuses[i] = (otter_file_status){.exists = true, .size = 1};
+  }
+
+  counting->paths_stated += count;
+  return true;
+}
+
+static bool otter_filesystem_counting_remove_impl(otter_filesystem * /*unused*/,
+                                                  const char * /*unused*/) {
+  return true;
+}
+
+static void
+otter_filesystem_counting_invalidate_impl(otter_filesystem * /*unused*/,
+                                          const char * /*unused*/) {}
+
+OTTER_TEST(filesystem_cached_stats_each_path_once) {
+  otter_filesystem *cache = NULL;
+  otter_filesystem_counting counting = {
+      .counting_vtable =
+          {
+              .stat_many = otter_filesystem_counting_stat_many_impl,
+              .remove = otter_filesystem_counting_remove_impl,
+              .invalidate = otter_filesystem_counting_invalidate_impl,
+          },
+      .paths_stated = 0,
+  };
+  counting.base.vtable = &counting.counting_vtable;
+
+  cache = otter_filesystem_create_cached(OTTER_TEST_ALLOCATOR,
+                                         (otter_filesystem *)&counting);
+  OTTER_ASSERT(cache != NULL);
+
+  const char *paths[] = {"a.o", "b.o"};
+  otter_file_status statuses[2];
+  OTTER_ASSERT(otter_filesystem_stat_many(cache, paths, 2, statuses));
+  OTTER_ASSERT(otter_filesystem_stat_many(cache, paths, 2, statuses));
+  OTTER_ASSERT(otter_filesystem_exists(cache, "a.o"));
+  OTTER_ASSERT(counting.paths_stated == 2);
+
+  otter_filesystem_invalidate(cache, "a.o");
+  OTTER_ASSERT(otter_filesystem_stat_many(cache, paths, 2, statuses));
+  OTTER_ASSERT(counting.paths_stated == 3);
+
+  /* Modifying a path through the cache invalidates it */
+  OTTER_ASSERT(otter_filesystem_remove(cache, "b.o"));
+  OTTER_ASSERT(otter_filesystem_exists(cache, "b.o"));
+  OTTER_ASSERT(counting.paths_stated == 4);
+
+  otter_filesystem_invalidate(cache, NULL);
+  OTTER_ASSERT(otter_filesystem_stat_many(cache, paths, 2, statuses));
+  OTTER_ASSERT(counting.paths_stated == 6);
+
+  OTTER_TEST_END(if (cache) otter_filesystem_free(cache););
+}
+
+OTTER_TEST(filesystem_copy_replaces_destination) {
+  otter_filesystem *filesystem = NULL;
+  otter_file_view source = {0};
+  otter_file_view copy = {0};
+
+  filesystem = otter_filesystem_create(OTTER_TEST_ALLOCATOR);
+  OTTER_ASSERT(filesystem != NULL);
+
+  FILE *file = fopen("test_fixtures/copy_destination.c", "w");
+  OTTER_ASSERT(file != NULL);
+  fputs("stale contents", file);
+  fclose(file);
+
+  OTTER_ASSERT(otter_filesystem_copy(filesystem, "test_fixtures/test.c",
+                                     "test_fixtures/copy_destination.c"));
+  OTTER_ASSERT(otter_filesystem_map_file(filesystem, "test_fixtures/test.c",
+                                         &source));
+  OTTER_ASSERT(otter_filesystem_map_file(
+      filesystem, "test_fixtures/copy_destination.c", &copy));
+  OTTER_ASSERT(source.length == copy.length);
+  OTTER_ASSERT(0 == memcmp(source.data, copy.data, source.length));
+
+  char temp_path[256];
+  snprintf(temp_path, sizeof(temp_path),
+           "test_fixtures/copy_destination.c.tmp.%d", (int)getpid());
+  OTTER_ASSERT(!otter_filesystem_exists(filesystem, temp_path));
+
+  OTTER_TEST_END(remove("test_fixtures/copy_destination.c");
+                 if (source.data) otter_filesystem_unmap_file(filesystem,
+                                                              &source);
+                 if (copy.data) otter_filesystem_unmap_file(filesystem, &copy);
+                 if (filesystem) otter_filesystem_free(filesystem););
+}
+
+OTTER_TEST(filesystem_uring_matches_posix) {
+  otter_filesystem *posix = NULL;
+  otter_filesystem *uring = NULL;
+  const char *path = "test_fixtures/uring_attribute.c";
+
+  posix = otter_filesystem_create(OTTER_TEST_ALLOCATOR);
+  OTTER_ASSERT(posix != NULL);
+
+  /* Either an io_uring filesystem or the POSIX fallback */
+  uring = otter_filesystem_create_uring(OTTER_TEST_ALLOCATOR);
+  OTTER_ASSERT(uring != NULL);
+
+  FILE *file = fopen(path, "w");
+  OTTER_ASSERT(file != NULL);
+  fputs("int x;", file);
+  fclose(file);
+
+  const unsigned char digest[4] = {1, 2, 3, 4};
+  OTTER_ASSERT(otter_filesystem_set_attribute(posix, path, "user.otter-test",
+                                              digest, sizeof(digest)) == 0);
+
+  const char *paths[] = {path, "test_fixtures/missing.c",
+                         "test_fixtures/test.c"};
+  otter_file_status expected[3];
+  otter_file_status statuses[3];
+  OTTER_ASSERT(otter_filesystem_stat_many(posix, paths, 3, expected));
+  OTTER_ASSERT(otter_filesystem_stat_many(uring, paths, 3, statuses));
+  for (size_t i = 0; i < 3; i++) {
+    OTTER_ASSERT(statuses[i].exists == expected[i].exists);
+    OTTER_ASSERT(statuses[i].size == expected[i].size);
+    OTTER_ASSERT(statuses[i].mtime_ns == expected[i].mtime_ns);
+  }
+
+  unsigned char values[3 * sizeof(digest)];
+  int results[3];
+  otter_filesystem_get_attribute_many(uring, paths, 3, "user.otter-test",
+                                      values, sizeof(digest), results);
+  OTTER_ASSERT(results[0] == sizeof(digest));
+  OTTER_ASSERT(0 == memcmp(values, digest, sizeof(digest)));
+  OTTER_ASSERT(results[1] < 0);
+  OTTER_ASSERT(results[2] < 0);
+
+  OTTER_TEST_END(remove(path); if (uring) otter_filesystem_free(uring);
+                 if (posix) otter_filesystem_free(posix););
+}
@@ -0,0 +1,475 @@
+/*
+  otter Copyright (C) 2026 Nathaniel Wright
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#define _GNU_SOURCE
+#include "otter/clock.h"
+#include "otter/filesystem.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define OTTER_URING_ENTRIES 256
+#define OTTER_URING_PROBE_OPS 256
+#define OTTER_URING_STATX_MASK                                                 \
+  (STATX_TYPE | STATX_MODE | STATX_SIZE | STATX_MTIME)
+
+/* Operations that are not batched are forwarded to the POSIX filesystem */
+typedef struct otter_filesystem_uring {
+  otter_filesystem base;
+  otter_allocator *allocator;
+  otter_filesystem *posix;
+  int ring_fd;
+  unsigned sq_entries;
+  unsigned *sq_head;
+  unsigned *sq_tail;
+  unsigned *sq_mask;
+  unsigned *sq_array;
+  unsigned *cq_head;
+  unsigned *cq_tail;
+  unsigned *cq_mask;
+  struct io_uring_sqe *sqes;
+  struct io_uring_cqe *cqes;
+  void *sq_ring;
+  size_t sq_ring_size;
+  void *cq_ring;
+  size_t cq_ring_size;
+  size_t sqes_size;
+  bool has_statx;
+  bool has_getxattr;
+} otter_filesystem_uring;
+
+typedef void (*otter_uring_prepare_fn)(struct io_uring_sqe *sqe, size_t index,
+                                       void *context);
+typedef void (*otter_uring_complete_fn)(size_t index, int result,
+                                        void *context);
+
+static int otter_uring_setup(unsigned entries, struct io_uring_params *params) {
+  return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int otter_uring_enter(int ring_fd, unsigned to_submit,
+                             unsigned min_complete, unsigned flags) {
+  return (int)syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete,
+                      flags, NULL, 0);
+}
+
+static int otter_uring_register(int ring_fd, unsigned opcode, void *arg,
+                                unsigned nr_args) {
+  return (int)syscall(__NR_io_uring_register, ring_fd, opcode, arg, nr_args);
+}
+
+static void otter_uring_unmap(otter_filesystem_uring *uring) {
+  if (uring->sqes != NULL) {
+    munmap(uring->sqes, uring->sqes_size);
+  }
+
+  if (uring->cq_ring != NULL && uring->cq_ring != uring->sq_ring) {
+    munmap(uring->cq_ring, uring->cq_ring_size);
+  }
+
+  if (uring->sq_ring != NULL) {
+    munmap(uring->sq_ring, uring->sq_ring_size);
+  }
+}
+
+static bool otter_uring_map(otter_filesystem_uring *uring,
+                            const struct io_uring_params *params) {
+  uring->sq_ring_size =
+      params->sq_off.array + (params->sq_entries * sizeof(unsigned));
+  uring->cq_ring_size = params->cq_off.cqes +
+                        (params->cq_entries * sizeof(struct io_uring_cqe));
+  const bool single_mmap = (params->features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap && uring->cq_ring_size > uring->sq_ring_size) {
+    uring->sq_ring_size = uring->cq_ring_size;
+  }
+
+  void *sq_ring =
+      mmap(NULL, uring->sq_ring_size, PROT_READ | PROT_WRITE,
+           MAP_SHARED | MAP_POPULATE, uring->ring_fd, IORING_OFF_SQ_RING);
+  if (sq_ring == MAP_FAILED) {
+    return false;
+  }
+  uring->sq_ring = sq_ring;
+
+  if (single_mmap) {
+    uring->cq_ring = sq_ring;
+  } else {
+    void *cq_ring =
+        mmap(NULL, uring->cq_ring_size, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_POPULATE, uring->ring_fd, IORING_OFF_CQ_RING);
+    if (cq_ring == MAP_FAILED) {
+      return false;
+    }
+    uring->cq_ring = cq_ring;
+  }
+
+  uring->sqes_size = params->sq_entries * sizeof(struct io_uring_sqe);
+  void *sqes =
+      mmap(NULL, uring->sqes_size, PROT_READ | PROT_WRITE,
+           MAP_SHARED | MAP_POPULATE, uring->ring_fd, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    return false;
+  }
+  uring->sqes = sqes;
+
+  char *sq_base = uring->sq_ring;
+  char *cq_base = uring->cq_ring;
+  uring->sq_entries = params->sq_entries;
+  uring->sq_head = (unsigned *)(sq_base + params->sq_off.head);
+  uring->sq_tail = (unsigned *)(sq_base + params->sq_off.tail);
+  uring->sq_mask = (unsigned *)(sq_base + params->sq_off.ring_mask);
+  uring->sq_array = (unsigned *)(sq_base + params->sq_off.array);
+  uring->cq_head = (unsigned *)(cq_base + params->cq_off.head);
+  uring->cq_tail = (unsigned *)(cq_base + params->cq_off.tail);
+  uring->cq_mask = (unsigned *)(cq_base + params->cq_off.ring_mask);
+  uring->cqes = (struct io_uring_cqe *)(cq_base + params->cq_off.cqes);
+  return true;
+}
+
+static void otter_uring_probe(otter_filesystem_uring *uring) {
+  const size_t probe_size =
+      sizeof(struct io_uring_probe) +
+      (OTTER_URING_PROBE_OPS * sizeof(struct io_uring_probe_op));
+  struct io_uring_probe *probe = otter_malloc(uring->allocator, probe_size);
+  if (probe == NULL) {
+    return;
+  }
+
+  memset(probe, 0, probe_size);
+  if (otter_uring_register(uring->ring_fd, IORING_REGISTER_PROBE, probe,
+                           OTTER_URING_PROBE_OPS) == 0) {
+    uring->has_statx = probe->last_op >= IORING_OP_STATX &&
+                       (probe->ops[IORING_OP_STATX].flags &
+                        IO_URING_OP_SUPPORTED) != 0;
+    uring->has_getxattr = probe->last_op >= IORING_OP_GETXATTR &&
+                          (probe->ops[IORING_OP_GETXATTR].flags &
+                           IO_URING_OP_SUPPORTED) != 0;
+  }
+
+  otter_free(uring->allocator, probe);
+}
+
+/* Keeps at most sq_entries operations in flight, which also bounds the
+ * completion queue, and reaps completions whenever the kernel returns.
+ * Returns false if the ring failed, in which case no operations are left in
+ * flight. */
+static bool otter_uring_run(otter_filesystem_uring *uring, size_t count,
+                            otter_uring_prepare_fn prepare,
+                            otter_uring_complete_fn complete, void *context) {
+  size_t next = 0;
+  size_t completed = 0;
+  while (completed < count) {
+    unsigned tail = *uring->sq_tail;
+    while (next < count && next - completed < uring->sq_entries) {
+      const unsigned index = tail & *uring->sq_mask;
+      struct io_uring_sqe *sqe = &uring->sqes[index];
+      memset(sqe, 0, sizeof(*sqe));
+      prepare(sqe, next, context);
+      sqe->user_data = next;
+      uring->sq_array[index] = index;
+      tail++;
+      next++;
+    }
+
+    __atomic_store_n(uring->sq_tail, tail, __ATOMIC_RELEASE);
+    const unsigned pending =
+        tail - __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE);
+    if (otter_uring_enter(uring->ring_fd, pending, 1,
+                          IORING_ENTER_GETEVENTS) < 0 &&
+        errno != EINTR && pending == next - completed) {
+      /* Nothing is in flight, so the batch can be abandoned.  The entries
+       * that were not submitted must not leak into a later batch. */
+      __atomic_store_n(uring->sq_tail, tail - pending, __ATOMIC_RELEASE);
+      return false;
+    }
+
+    unsigned head = *uring->cq_head;
+    const unsigned cq_tail = __atomic_load_n(uring->cq_tail, __ATOMIC_ACQUIRE);
+    while (head != cq_tail) {
+      const struct io_uring_cqe *cqe = &uring->cqes[head & *uring->cq_mask];
+      complete((size_t)cqe->user_data, cqe->res, context);
+      head++;
+      completed++;
+    }
+
+    __atomic_store_n(uring->cq_head, head, __ATOMIC_RELEASE);
+  }
+
+  return true;
+}
+
+typedef struct otter_uring_stat_batch {
+  const char *const *paths;
+  struct statx *buffers;
+  otter_file_status *statuses;
+  bool result;
+} otter_uring_stat_batch;
+
+static void otter_uring_prepare_statx(struct io_uring_sqe *sqe, size_t index,
+                                      void *context) {
+  otter_uring_stat_batch *batch = context;
+  sqe->opcode = IORING_OP_STATX;
+  sqe->fd = AT_FDCWD;
+  sqe->addr = (uint64_t)(uintptr_t)batch->paths[index];
+  sqe->len = OTTER_URING_STATX_MASK;
+  sqe->off = (uint64_t)(uintptr_t)&batch->buffers[index];
+}
+
+static void otter_uring_complete_statx(size_t index, int result,
+                                       void *context) {
+  otter_uring_stat_batch *batch = context;
+  if (result < 0) {
+    batch->statuses[index] = (otter_file_status){.exists = false};
+    if (result != -ENOENT && result != -ENOTDIR) {
+      batch->result = false;
+    }
+
+    return;
+  }
+
+  const struct statx *statx_info = &batch->buffers[index];
+  batch->statuses[index] = (otter_file_status){
+      .exists = true,
+      .mode = statx_info->stx_mode,
+      .size = statx_info->stx_size,
+      .mtime_ns = (statx_info->stx_mtime.tv_sec *
+                   (int64_t)OTTER_NANOSECONDS_PER_SECOND) +
+                  statx_info->stx_mtime.tv_nsec,
+  };
+}
+
+static bool otter_filesystem_uring_stat_many_impl(otter_filesystem *filesystem,
+                                                  const char *const *paths,
+                                                  size_t count,
+                                                  otter_file_status *statuses) {
+  otter_filesystem_uring *uring = (otter_filesystem_uring *)filesystem;
+  if (!uring->has_statx || count == 0) {
+    return otter_filesystem_stat_many(uring->posix, paths, count, statuses);
+  }
+
+  otter_uring_stat_batch batch = {
+      .paths = paths,
+      .buffers = otter_malloc(uring->allocator, sizeof(struct statx) * count),
+      .statuses = statuses,
+      .result = true,
+  };
+  if (batch.buffers == NULL) {
+    return false;
+  }
+
+  const bool ran = otter_uring_run(uring, count, otter_uring_prepare_statx,
+                                   otter_uring_complete_statx, &batch);
+  otter_free(uring->allocator, batch.buffers);
+  if (!ran) {
+    return otter_filesystem_stat_many(uring->posix, paths, count, statuses);
+  }
+
+  return batch.result;
+}
+
+typedef struct otter_uring_attribute_batch {
+  const char *const *paths;
+  const char *attribute;
+  unsigned char *values;
+  size_t value_size;
+  int *results;
+} otter_uring_attribute_batch;
+
+static void otter_uring_prepare_getxattr(struct io_uring_sqe *sqe,
+                                         size_t index, void *context) {
+  otter_uring_attribute_batch *batch = context;
+  sqe->opcode = IORING_OP_GETXATTR;
+  sqe->addr = (uint64_t)(uintptr_t)batch->attribute;
+  sqe->addr2 = (uint64_t)(uintptr_t)&batch->values[index * batch->value_size];
+  sqe->addr3 = (uint64_t)(uintptr_t)batch->paths[index];
+  sqe->len = (uint32_t)batch->value_size;
+}
+
+static void otter_uring_complete_getxattr(size_t index, int result,
+                                          void *context) {
+  otter_uring_attribute_batch *batch = context;
+  batch->results[index] = result < 0 ? -1 : result;
+}
+
+static void otter_filesystem_uring_get_attribute_many_impl(
+    otter_filesystem *filesystem, const char *const *paths, size_t count,
+    const char *attribute, unsigned char *values, size_t value_size,
+    int *results) {
+  otter_filesystem_uring *uring = (otter_filesystem_uring *)filesystem;
+  otter_uring_attribute_batch batch = {
+      .paths = paths,
+      .attribute = attribute,
+      .values = values,
+      .value_size = value_size,
+      .results = results,
+  };
+  if (!uring->has_getxattr || value_size > UINT32_MAX ||
+      !otter_uring_run(uring, count, otter_uring_prepare_getxattr,
+                       otter_uring_complete_getxattr, &batch)) {
+    otter_filesystem_get_attribute_many(uring->posix, paths, count, attribute,
+                                        values, value_size, results);
+  }
+}
+
+static void otter_filesystem_uring_free_impl(otter_filesystem *filesystem) {
+  otter_filesystem_uring *uring = (otter_filesystem_uring *)filesystem;
+  otter_uring_unmap(uring);
+  close(uring->ring_fd);
+  otter_filesystem_free(uring->posix);
+  otter_free(uring->allocator, uring);
+}
+
+static otter_file *otter_filesystem_uring_open_file_impl(
+    otter_filesystem *filesystem, const char *path, const char *mode) {
+  otter_filesystem_uring *uring = (otter_filesystem_uring *)filesystem;
+  return otter_filesystem_open_file(uring->posix, path, mode);
+}
+
+static bool otter_filesystem_uring_copy_impl(otter_filesystem *filesystem,
+                                             const char *from_path,
+                                             const char *to_path) {
+  otter_filesystem_uring *uring = (otter_filesystem_uring *)filesystem;
+  return otter_filesystem_copy(uring->posix, from_path, to_path);
+}
+
+static bool otter_filesystem_uring_remove_impl(otter_filesystem *filesystem,
+                                               const char *path) {
+  otter_filesystem_uring *uring = (otter_filesystem_uring *)filesystem;
+  return otter_filesystem_remove(uring->posix, path);
+}
+
+static bool
+otter_filesystem_uring_make_directory_impl(otter_filesystem *filesystem,
+                                           const char *path) {
+  otter_filesystem_uring *uring = (otter_filesystem_uring *)filesystem;
+  return otter_filesystem_make_directory(uring->posix, path);
+}
+
+static bool otter_filesystem_uring_rename_impl(otter_filesystem *filesystem,
+                                               const char *from_path,
+                                               const char *to_path) {
+  otter_filesystem_uring *uring = (otter_filesystem_uring *)filesystem;
+  return otter_filesystem_rename(uring->posix, from_path, to_path);
+}
+
+static bool otter_filesystem_uring_exists_impl(otter_filesystem *filesystem,
+                                               const char *path) {
+  otter_filesystem_uring *uring = (otter_filesystem_uring *)filesystem;
+  return otter_filesystem_exists(uring->posix, path);
+}
+
+static int otter_filesystem_uring_get_attribute_impl(
+    otter_filesystem *filesystem, const char *path, const char *attribute,
+    unsigned char *value, size_t value_size) {
+  otter_filesystem_uring *uring = (otter_filesystem_uring *)filesystem;
+  return otter_filesystem_get_attribute(uring->posix, path, attribute, value,
+                                        value_size);
+}
+
+static int otter_filesystem_uring_set_attribute_impl(
+    otter_filesystem *filesystem, const char *path, const char *attribute,
+    const unsigned char *value, size_t value_size) {
+  otter_filesystem_uring *uring = (otter_filesystem_uring *)filesystem;
+  return otter_filesystem_set_attribute(uring->posix, path, attribute, value,
+                                        value_size);
+}
+
+static bool otter_filesystem_uring_map_file_impl(otter_filesystem *filesystem,
+                                                 const char *path,
+                                                 otter_file_view *view) {
+  otter_filesystem_uring *uring = (otter_filesystem_uring *)filesystem;
+  return otter_filesystem_map_file(uring->posix, path, view);
+}
+
+static void
+otter_filesystem_uring_unmap_file_impl(otter_filesystem *filesystem,
+                                       otter_file_view *view) {
+  otter_filesystem_uring *uring = (otter_filesystem_uring *)filesystem;
+  otter_filesystem_unmap_file(uring->posix, view);
+}
+
+static void otter_filesystem_uring_invalidate_impl(otter_filesystem *filesystem,
+                                                   const char *path) {
+  otter_filesystem_uring *uring = (otter_filesystem_uring *)filesystem;
+  otter_filesystem_invalidate(uring->posix, path);
+}
+
+otter_filesystem *otter_filesystem_create_uring(otter_allocator *allocator) {
+  otter_filesystem *posix = otter_filesystem_create(allocator);
+  if (posix == NULL) {
+    return NULL;
+  }
+
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  const int ring_fd = otter_uring_setup(OTTER_URING_ENTRIES, &params);
+  if (ring_fd < 0) {
+    /* Disabled by the kernel, seccomp or io_uring_disabled */
+    return posix;
+  }
+
+  otter_filesystem_uring *uring = otter_malloc(allocator, sizeof(*uring));
+  if (uring == NULL) {
+    close(ring_fd);
+    otter_filesystem_free(posix);
+    return NULL;
+  }
+
+  memset(uring, 0, sizeof(*uring));
+  uring->allocator = allocator;
+  uring->posix = posix;
+  uring->ring_fd = ring_fd;
+  if (!otter_uring_map(uring, &params)) {
+    otter_uring_unmap(uring);
+    close(ring_fd);
+    otter_free(allocator, uring);
+    return posix;
+  }
+
+  otter_uring_probe(uring);
+  if (!uring->has_statx && !uring->has_getxattr) {
+    otter_uring_unmap(uring);
+    close(ring_fd);
+    otter_free(allocator, uring);
+    return posix;
+  }
+
+  static otter_filesystem_vtable vtable = {
+      .free = otter_filesystem_uring_free_impl,
+      .open_file = otter_filesystem_uring_open_file_impl,
+      .copy = otter_filesystem_uring_copy_impl,
+      .remove = otter_filesystem_uring_remove_impl,
+      .rename = otter_filesystem_uring_rename_impl,
+      .make_directory = otter_filesystem_uring_make_directory_impl,
+      .exists = otter_filesystem_uring_exists_impl,
+      .get_attribute = otter_filesystem_uring_get_attribute_impl,
+      .set_attribute = otter_filesystem_uring_set_attribute_impl,
+      .map_file = otter_filesystem_uring_map_file_impl,
+      .unmap_file = otter_filesystem_uring_unmap_file_impl,
+      .stat_many = otter_filesystem_uring_stat_many_impl,
+      .invalidate = otter_filesystem_uring_invalidate_impl,
+      .get_attribute_many = otter_filesystem_uring_get_attribute_many_impl,
+  };
+
+  uring->base.vtable = &vtable;
+  return (otter_filesystem *)uring;
+}
@@ -0,0 +1,210 @@
+/*
+  otter Copyright (C) 2026 Nathaniel Wright
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "otter/intern.h"
+#include "otter/arena.h"
+#include <string.h>
+
+#define OTTER_INTERN_INITIAL_CAPACITY 64
+#define OTTER_INTERN_CHUNK_SIZE ((size_t)4 * 1024)
+#define OTTER_INTERN_FNV_OFFSET 14695981039346656037ULL
+#define OTTER_INTERN_FNV_PRIME 1099511628211ULL
+
+/* Strings are never removed, so the open addressed table does not need
+ * tombstones.  The handles and their characters live in an arena, which
+ * keeps them at a stable address while the slot array grows. */
+struct otter_intern_table {
+  otter_allocator *allocator;
+  otter_allocator *arena;
+  const otter_interned_string **slots; /* NULL marks an empty slot */
+  size_t capacity;                     /* Always a power of two */
+  size_t length;
+};
+
+uint64_t otter_intern_hash(otter_string_view view) {
+  uint64_t hash = OTTER_INTERN_FNV_OFFSET;
+  for (size_t i = 0; i < view.length; i++) {
+    hash ^= (unsigned char)view.data[i];
+    hash *= OTTER_INTERN_FNV_PRIME;
+  }
+
+  return hash;
+}
+
+static const otter_interned_string **
+otter_intern_slot(const otter_interned_string **slots, size_t capacity,
+                  otter_string_view view, uint64_t hash) {
+  size_t index = (size_t)hash & (capacity - 1);
+  while (slots[index] != NULL) {
+    const otter_interned_string *entry = slots[index];
+    if (entry->hash == hash && entry->length == view.length &&
+        0 == memcmp(entry->data, view.data, view.length)) {
+      break;
+    }
+
+    index = (index + 1) & (capacity - 1);
+  }
+
+  return &slots[index];
+}
+
+static const otter_interned_string **
+otter_intern_allocate_slots(otter_allocator *allocator, size_t capacity) {
+  const otter_interned_string **slots =
+      otter_malloc(allocator, sizeof(*slots) * capacity);
+  if (slots == NULL) {
+    return NULL;
+  }
+
+  for (size_t i = 0; i < capacity; i++) {
+    slots[i] = NULL;
+  }
+
+  return slots;
+}
+
+static bool otter_intern_grow(otter_intern_table *table) {
+  const size_t capacity = table->capacity * 2;
+  const otter_interned_string **slots =
+      otter_intern_allocate_slots(table->allocator, capacity);
+  if (slots == NULL) {
+    return false;
+  }
+
+  for (size_t i = 0; i < table->capacity; i++) {
+    const otter_interned_string *entry = table->slots[i];
+    if (entry != NULL) {
+      const otter_string_view view = {.data = entry->data,
+                                      .length = entry->length};
+      *otter_intern_slot(slots, capacity, view, entry->hash) = entry;
+    }
+  }
+
+  otter_free_sized(table->allocator, table->slots,
+                   sizeof(*table->slots) * table->capacity);
+  table->slots = slots;
+  table->capacity = capacity;
+  return true;
+}
+
+otter_intern_table *otter_intern_table_create(otter_allocator *allocator) {
+  if (allocator == NULL) {
+    return NULL;
+  }
+
+  otter_intern_table *table = otter_malloc(allocator, sizeof(*table));
+  if (table == NULL) {
+    return NULL;
+  }
+
+  table->allocator = allocator;
+  table->length = 0;
+  table->capacity = OTTER_INTERN_INITIAL_CAPACITY;
+  table->slots = NULL;
+  table->arena = otter_arena_create(allocator, OTTER_INTERN_CHUNK_SIZE);
+  if (table->arena == NULL) {
+    otter_intern_table_free(table);
+    return NULL;
+  }
+
+  table->slots = otter_intern_allocate_slots(allocator, table->capacity);
+  if (table->slots == NULL) {
+    otter_intern_table_free(table);
+    return NULL;
+  }
+
+  return table;
+}
+
+void otter_intern_table_free(otter_intern_table *table) {
+  if (table == NULL) {
+    return;
+  }
+
+  if (table->slots != NULL) {
+    otter_free_sized(table->allocator, table->slots,
+                     sizeof(*table->slots) * table->capacity);
+  }
+
+  if (table->arena != NULL) {
+    otter_allocator_free(table->arena);
+  }
+
+  otter_free(table->allocator, table);
+}
+
+OTTER_DEFINE_TRIVIAL_CLEANUP_FUNC(otter_intern_table *,
+                                  otter_intern_table_free);
+
+const otter_interned_string *otter_intern(otter_intern_table *table,
+                                          otter_string_view view) {
+  if (table == NULL || view.data == NULL) {
+    return NULL;
+  }
+
+  /* Keep the load factor below 3/4 */
+  if ((table->length + 1) * 4 > table->capacity * 3 &&
+      !otter_intern_grow(table)) {
+    return NULL;
+  }
+
+  const uint64_t hash = otter_intern_hash(view);
+  const otter_interned_string **slot =
+      otter_intern_slot(table->slots, table->capacity, view, hash);
+  if (*slot != NULL) {
+    return *slot;
+  }
+
+  /* The characters follow the handle in the same allocation */
+  otter_interned_string *entry =
+      otter_malloc(table->arena, sizeof(*entry) + view.length + 1);
+  if (entry == NULL) {
+    return NULL;
+  }
+
+  char *data = (char *)(entry + 1);
+  memcpy(data, view.data, view.length);
+  data[view.length] = '\0';
+  entry->data = data;
+  entry->length = view.length;
+  entry->hash = hash;
+
+  *slot = entry;
+  table->length++;
+  return entry;
+}
+
+const otter_interned_string *otter_intern_cstr(otter_intern_table *table,
+                                               const char *str) {
+  return otter_intern(table, otter_string_view_from_cstr(str));
+}
+
+const otter_interned_string *
+otter_intern_find(const otter_intern_table *table, otter_string_view view) {
+  if (table == NULL || view.data == NULL) {
+    return NULL;
+  }
+
+  return *otter_intern_slot(table->slots, table->capacity, view,
+                            otter_intern_hash(view));
+}
+
+size_t otter_intern_table_length(const otter_intern_table *table) {
+  if (table == NULL) {
+    return 0;
+  }
+  return table->length;
+}
@@ -0,0 +1,119 @@
+/*
+  otter Copyright (C) 2026 Nathaniel Wright
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "otter/intern.h"
+#include "otter/test.h"
+#include <stdio.h>
+#include <string.h>
+
+#define MANY_STRINGS 1000
+
+OTTER_TEST(intern_returns_same_handle_for_equal_strings) {
+  OTTER_CLEANUP(otter_intern_table_free_p)
+  otter_intern_table *table = otter_intern_table_create(OTTER_TEST_ALLOCATOR);
+  OTTER_ASSERT(table != NULL);
+
+  /* The second copy lives in a different buffer */
+  char copy[] = "-Wall";
+  const otter_interned_string *first = otter_intern_cstr(table, "-Wall");
+  const otter_interned_string *second = otter_intern_cstr(table, copy);
+  const otter_interned_string *other = otter_intern_cstr(table, "-Wextra");
+
+  OTTER_ASSERT(first != NULL && other != NULL);
+  OTTER_ASSERT(first == second);
+  OTTER_ASSERT(first != other);
+  OTTER_ASSERT(first->data != copy);
+  OTTER_ASSERT(first->length == 5);
+  OTTER_ASSERT(0 == strcmp(first->data, "-Wall"));
+  OTTER_ASSERT(first->hash ==
+               otter_intern_hash(otter_string_view_from_cstr("-Wall")));
+  OTTER_ASSERT(otter_intern_table_length(table) == 2);
+
+  OTTER_TEST_END();
+}
+
+OTTER_TEST(intern_view_is_copied_and_terminated) {
+  OTTER_CLEANUP(otter_intern_table_free_p)
+  otter_intern_table *table = otter_intern_table_create(OTTER_TEST_ALLOCATOR);
+  OTTER_ASSERT(table != NULL);
+
+  const char *buffer = "-I ./include";
+  const otter_interned_string *flag =
+      otter_intern(table, (otter_string_view){.data = buffer, .length = 2});
+  OTTER_ASSERT(flag != NULL);
+  OTTER_ASSERT(0 == strcmp(flag->data, "-I"));
+  OTTER_ASSERT(flag == otter_intern_cstr(table, "-I"));
+
+  const otter_interned_string *empty =
+      otter_intern(table, (otter_string_view){.data = buffer, .length = 0});
+  OTTER_ASSERT(empty != NULL && empty->length == 0);
+  OTTER_ASSERT(empty->data[0] == '\0');
+
+  OTTER_TEST_END();
+}
+
+OTTER_TEST(intern_find_does_not_add) {
+  OTTER_CLEANUP(otter_intern_table_free_p)
+  otter_intern_table *table = otter_intern_table_create(OTTER_TEST_ALLOCATOR);
+  OTTER_ASSERT(table != NULL);
+
+  OTTER_ASSERT(otter_intern_find(table, otter_string_view_from_cstr("cc")) ==
+               NULL);
+  OTTER_ASSERT(otter_intern_table_length(table) == 0);
+
+  const otter_interned_string *cc = otter_intern_cstr(table, "cc");
+  OTTER_ASSERT(otter_intern_find(table, otter_string_view_from_cstr("cc")) ==
+               cc);
+
+  OTTER_TEST_END();
+}
+
+OTTER_TEST(intern_handles_survive_growth) {
+  OTTER_CLEANUP(otter_intern_table_free_p)
+  otter_intern_table *table = otter_intern_table_create(OTTER_TEST_ALLOCATOR);
+  OTTER_ASSERT(table != NULL);
+
+  static const otter_interned_string *handles[MANY_STRINGS];
+  char name[32];
+  for (int i = 0; i < MANY_STRINGS; i++) {
+    snprintf(name, sizeof(name), "./debug/object%d.o", i);
+    handles[i] = otter_intern_cstr(table, name);
+    OTTER_ASSERT(handles[i] != NULL);
+  }
+
+  OTTER_ASSERT(otter_intern_table_length(table) == MANY_STRINGS);
+  for (int i = 0; i < MANY_STRINGS; i++) {
+    snprintf(name, sizeof(name), "./debug/object%d.o", i);
+    OTTER_ASSERT(otter_intern_cstr(table, name) == handles[i]);
+    OTTER_ASSERT(0 == strcmp(handles[i]->data, name));
+  }
+
+  OTTER_TEST_END();
+}
+
+OTTER_TEST(intern_null_arguments) {
+  OTTER_ASSERT(otter_intern_table_create(NULL) == NULL);
+  OTTER_ASSERT(otter_intern_cstr(NULL, "x") == NULL);
+  OTTER_ASSERT(otter_intern_table_length(NULL) == 0);
+  otter_intern_table_free(NULL);
+
+  OTTER_CLEANUP(otter_intern_table_free_p)
+  otter_intern_table *table = otter_intern_table_create(OTTER_TEST_ALLOCATOR);
+  OTTER_ASSERT(table != NULL);
+  OTTER_ASSERT(otter_intern_cstr(table, NULL) == NULL);
+
+  OTTER_TEST_END();
+}
@@ -48,10 +48,52 @@ otter_lexer *otter_lexer_create(otter_allocator *allocator,
   lexer->source = source;
   lexer->line = OTTER_LEXER_LINE_ZERO;
   lexer->column = OTTER_LEXER_COLUMN_ZERO;
+  lexer->strings = NULL;
+  lexer->filesystem = NULL;
+  return lexer;
+}
+
+otter_lexer *otter_lexer_create_from_file(otter_allocator *allocator,
+                                          otter_filesystem *filesystem,
+                                          const char *file) {
+  if (allocator == NULL) {
+    return NULL;
+  }
+
+  if (filesystem == NULL) {
+    return NULL;
+  }
+
+  if (file == NULL) {
+    return NULL;
+  }
+
+  otter_lexer *lexer = otter_malloc(allocator, sizeof(*lexer));
+  if (lexer == NULL) {
+    return NULL;
+  }
+
+  if (!otter_filesystem_map_file(filesystem, file, &lexer->view)) {
+    otter_free(allocator, lexer);
+    return NULL;
+  }
+
+  lexer->allocator = allocator;
+  lexer->index = 0;
+  lexer->source_length = lexer->view.length;
+  lexer->source = lexer->view.data;
+  lexer->line = OTTER_LEXER_LINE_ZERO;
+  lexer->column = OTTER_LEXER_COLUMN_ZERO;
+  lexer->strings = NULL;
+  lexer->filesystem = filesystem;
   return lexer;
 }
 
 void otter_lexer_free(otter_lexer *lexer) {
+  if (lexer->filesystem != NULL) {
+    otter_filesystem_unmap_file(lexer->filesystem, &lexer->view);
+  }
+
   otter_free(lexer->allocator, lexer);
 }
 
@@ -118,11 +160,23 @@ static bool otter_lexer_tokenize_string(otter_lexer *lexer,
     ident->base.type = OTTER_TOKEN_IDENTIFIER;
     ident->base.line = line;
     ident->base.column = column;
-    ident->value =
-        otter_strndup(lexer->allocator, &lexer->source[begin], identifier_len);
-    if (ident->value == NULL) {
-      otter_free(lexer->allocator, ident);
-      return false;
+    ident->value = NULL;
+    ident->interned = NULL;
+    if (lexer->strings != NULL) {
+      ident->interned = otter_intern(
+          lexer->strings, (otter_string_view){.data = &lexer->source[begin],
+                                              .length = identifier_len});
+      if (ident->interned == NULL) {
+        otter_free(lexer->allocator, ident);
+        return false;
+      }
+    } else {
+      ident->value = otter_strndup(lexer->allocator, &lexer->source[begin],
+                                   identifier_len);
+      if (ident->value == NULL) {
+        otter_free(lexer->allocator, ident);
+        return false;
+      }
     }
 
     if (!OTTER_ARRAY_APPEND(tokens, value, lexer->allocator,
@@ -185,9 +239,11 @@ otter_token **otter_lexer_tokenize(otter_lexer *lexer, size_t *tokens_length) {
     return NULL;
   }
 
+  /* Tokens average a few characters including the whitespace around them,
+   * so this usually avoids growing the array more than once or twice */
   otter_token_array tokens;
-  OTTER_ARRAY_INIT(&tokens, value, lexer->allocator);
-  if (tokens.value == NULL) {
+  if (!OTTER_ARRAY_INIT_CAPACITY(&tokens, value, lexer->allocator,
+                                 lexer->source_length / 4 + 1)) {
     return NULL;
   }
 
@@ -14,9 +14,12 @@
   You should have received a copy of the GNU General Public License
   along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
+#include "otter/filesystem.h"
+#include "otter/intern.h"
 #include "otter/lexer.h"
 #include "otter/test.h"
 #include "otter/token.h"
+#include <stdio.h>
 #include <string.h>
 
 OTTER_TEST(lexer_create_null_allocator) {
@@ -401,6 +404,34 @@ OTTER_TEST(lexer_tokenize_identifier) {
   } otter_free(OTTER_TEST_ALLOCATOR, tokens););
 }
 
+OTTER_TEST(lexer_tokenize_identifier_interned) {
+  OTTER_CLEANUP(otter_intern_table_free_p)
+  otter_intern_table *strings = otter_intern_table_create(OTTER_TEST_ALLOCATOR);
+  OTTER_ASSERT(strings != NULL);
+
+  OTTER_CLEANUP(otter_lexer_free_p)
+  otter_lexer *lexer = otter_lexer_create(OTTER_TEST_ALLOCATOR, "foo bar foo");
+  OTTER_ASSERT(lexer != NULL);
+  lexer->strings = strings;
+
+  size_t tokens_length = 0;
+  otter_token **tokens = otter_lexer_tokenize(lexer, &tokens_length);
+  OTTER_ASSERT(tokens_length == 3);
+
+  const otter_token_identifier *first = (otter_token_identifier *)tokens[0];
+  const otter_token_identifier *second = (otter_token_identifier *)tokens[1];
+  const otter_token_identifier *third = (otter_token_identifier *)tokens[2];
+  OTTER_ASSERT(first->interned != NULL && first->value == NULL);
+  OTTER_ASSERT(first->interned == third->interned);
+  OTTER_ASSERT(first->interned != second->interned);
+  OTTER_ASSERT(0 == strcmp(otter_token_identifier_name(second), "bar"));
+  OTTER_ASSERT(otter_intern_table_length(strings) == 2);
+
+  OTTER_TEST_END(for (size_t i = 0; i < tokens_length; i++) {
+    otter_token_free(OTTER_TEST_ALLOCATOR, tokens[i]);
+  } otter_free(OTTER_TEST_ALLOCATOR, tokens););
+}
+
 typedef struct otter_allocator_mock_malloc_failure {
   otter_allocator base;
   otter_allocator *parent;
@@ -422,6 +453,14 @@ otter_allocator_mock_malloc_failure_malloc_impl(otter_allocator *allocator,
   return otter_malloc(mock->parent, size);
 }
 
+static void
+otter_allocator_mock_malloc_failure_free_impl(otter_allocator *allocator,
+                                              void *pointer) {
+  otter_allocator_mock_malloc_failure *mock =
+      (otter_allocator_mock_malloc_failure *)allocator;
+  otter_free(mock->parent, pointer);
+}
+
 static otter_allocator_mock_malloc_failure *
 initialize_mock_allocator(otter_allocator *parent, int start_failing_after) {
   otter_allocator_mock_malloc_failure *mock =
@@ -433,7 +472,7 @@ initialize_mock_allocator(otter_allocator *parent, int start_failing_after) {
   mock->mock_vtable = (otter_allocator_vtable){
       .malloc = otter_allocator_mock_malloc_failure_malloc_impl,
       .realloc = NULL,
-      .free = parent->vtable->free,
+      .free = otter_allocator_mock_malloc_failure_free_impl,
   };
   mock->base.vtable = &mock->mock_vtable;
   mock->parent = parent;
@@ -749,3 +788,122 @@ OTTER_TEST(lexer_tokenize_identifier_malloc_failure2) {
   OTTER_TEST_END(otter_lexer_free(lexer);
                  otter_free(OTTER_TEST_ALLOCATOR, mock_allocator););
 }
+
+typedef struct otter_filesystem_fake {
+  otter_filesystem base;
+  otter_filesystem_vtable fake_vtable;
+  const char *path;
+  const char *contents;
+  int mapped_views;
+} otter_filesystem_fake;
+
+static bool otter_filesystem_fake_map_file_impl(otter_filesystem *filesystem,
+                                                const char *path,
+                                                otter_file_view *view) {
+  otter_filesystem_fake *fake = (otter_filesystem_fake *)filesystem;
+  if (0 != strcmp(path, fake->path)) {
+    return false;
+  }
+
+  view->data = fake->contents;
+  view->length = strlen(fake->contents);
+  view->storage = NULL;
+  view->mapped = false;
+  fake->mapped_views++;
+  return true;
+}
+
+static void otter_filesystem_fake_unmap_file_impl(otter_filesystem *filesystem,
+                                                  otter_file_view *view) {
+  otter_filesystem_fake *fake = (otter_filesystem_fake *)filesystem;
+  view->data = NULL;
+  view->length = 0;
+  fake->mapped_views--;
+}
+
+static void initialize_fake_filesystem(otter_filesystem_fake *fake,
+                                       const char *path,
+                                       const char *contents) {
+  fake->fake_vtable = (otter_filesystem_vtable){
+      .map_file = otter_filesystem_fake_map_file_impl,
+      .unmap_file = otter_filesystem_fake_unmap_file_impl,
+  };
+  fake->base.vtable = &fake->fake_vtable;
+  fake->path = path;
+  fake->contents = contents;
+  fake->mapped_views = 0;
+}
+
+OTTER_TEST(lexer_create_from_file_lexes_view) {
+  otter_filesystem_fake filesystem;
+  otter_token **tokens = NULL;
+  size_t tokens_length = 0;
+  initialize_fake_filesystem(&filesystem, "source.otter", "var x = 1 ;");
+
+  otter_lexer *lexer = otter_lexer_create_from_file(
+      OTTER_TEST_ALLOCATOR, (otter_filesystem *)&filesystem, "source.otter");
+  OTTER_ASSERT(lexer != NULL);
+  OTTER_ASSERT(filesystem.mapped_views == 1);
+
+  tokens = otter_lexer_tokenize(lexer, &tokens_length);
+  OTTER_ASSERT(tokens_length == 5);
+  OTTER_ASSERT(tokens[0]->type == OTTER_TOKEN_VAR);
+  OTTER_ASSERT(tokens[1]->type == OTTER_TOKEN_IDENTIFIER);
+  OTTER_ASSERT(tokens[2]->type == OTTER_TOKEN_ASSIGNMENT);
+  OTTER_ASSERT(tokens[3]->type == OTTER_TOKEN_INTEGER);
+  OTTER_ASSERT(tokens[4]->type == OTTER_TOKEN_SEMICOLON);
+
+  otter_lexer_free(lexer);
+  lexer = NULL;
+  OTTER_ASSERT(filesystem.mapped_views == 0);
+
+  OTTER_TEST_END(if (lexer) otter_lexer_free(lexer);
+                 for (size_t i = 0; i < tokens_length; i++) {
+                   otter_token_free(OTTER_TEST_ALLOCATOR, tokens[i]);
+                 } otter_free(OTTER_TEST_ALLOCATOR, tokens););
+}
+
+OTTER_TEST(lexer_create_from_file_missing_file) {
+  otter_filesystem_fake filesystem;
+  initialize_fake_filesystem(&filesystem, "source.otter", "");
+
+  otter_lexer *lexer = otter_lexer_create_from_file(
+      OTTER_TEST_ALLOCATOR, (otter_filesystem *)&filesystem, "missing.otter");
+  OTTER_ASSERT(lexer == NULL);
+  OTTER_ASSERT(filesystem.mapped_views == 0);
+  OTTER_TEST_END();
+}
+
+OTTER_TEST(lexer_create_from_file_maps_large_file) {
+  const char *path = "test_fixtures/lexer_large.otter";
+  const char *line = "var x = 1 ;\n";
+  const size_t lines = 4096;
+  otter_filesystem *filesystem = NULL;
+  otter_lexer *lexer = NULL;
+  otter_token **tokens = NULL;
+  size_t tokens_length = 0;
+
+  FILE *file = fopen(path, "w");
+  OTTER_ASSERT(file != NULL);
+  for (size_t i = 0; i < lines; i++) {
+    fputs(line, file);
+  }
+  fclose(file);
+
+  filesystem = otter_filesystem_create(OTTER_TEST_ALLOCATOR);
+  OTTER_ASSERT(filesystem != NULL);
+
+  lexer = otter_lexer_create_from_file(OTTER_TEST_ALLOCATOR, filesystem, path);
+  OTTER_ASSERT(lexer != NULL);
+  OTTER_ASSERT(lexer->view.mapped);
+  OTTER_ASSERT(lexer->source_length == lines * strlen(line));
+
+  tokens = otter_lexer_tokenize(lexer, &tokens_length);
+  OTTER_ASSERT(tokens_length == lines * 5);
+
+  OTTER_TEST_END(remove(path); if (lexer) otter_lexer_free(lexer);
+                 if (filesystem) otter_filesystem_free(filesystem);
+                 for (size_t i = 0; i < tokens_length; i++) {
+                   otter_token_free(OTTER_TEST_ALLOCATOR, tokens[i]);
+                 } otter_free(OTTER_TEST_ALLOCATOR, tokens););
+}
@@ -14,78 +14,369 @@
   You should have received a copy of the GNU General Public License
   along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
+#define _GNU_SOURCE
 #include "otter/logger.h"
 #include "otter/array.h"
+#include "otter/clock.h"
 #include "otter/cstring.h"
 #include "otter/term_colors.h"
 #include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
 #include <time.h>
+#include <unistd.h>
+
+/* Keeps a slot at 256 bytes, messages longer than fit are copied to the
+ * heap */
+#define OTTER_LOGGER_ASYNC_MESSAGE_SIZE 200
+#define OTTER_LOGGER_CACHE_LINE 64
+/* While messages keep coming the consumer checks for them this often, so
+ * producers can fill the ring without ever waking it */
+#define OTTER_LOGGER_ASYNC_POLL_NS 1000000
+/* Polls that find nothing before the consumer sleeps until woken */
+#define OTTER_LOGGER_ASYNC_IDLE_POLLS 10
+
+typedef struct otter_logger_slot {
+  /* Equals the position once the slot is free to claim and the position
+   * plus one once the message is published */
+  atomic_size_t sequence;
+  otter_log_level log_level;
+  pid_t thread_id;
+  struct timespec wall_time;
+  uint64_t monotonic_ns;
+  /* A copy of the caller's context, NULL when there was none */
+  otter_log_context *context;
+  char *long_message;
+  char message[OTTER_LOGGER_ASYNC_MESSAGE_SIZE];
+} otter_logger_slot;
+
+/* A bounded multi-producer ring with a single consumer thread.  Producers
+ * claim a position with a compare and swap and publish through the slot's
+ * sequence, so logging never takes a lock. */
+typedef struct otter_logger_async {
+  otter_logger_slot *slots;
+  size_t mask;
+  otter_logger_overflow overflow;
+  pthread_t consumer;
+  /* Held by the consumer while it calls the sinks, so sinks can be added
+   * while it runs */
+  pthread_mutex_t sinks_lock;
+  /* The consumer waits on this between polls and once it is idle.  Producers
+   * only signal it when sleeping is set, so a busy consumer costs them
+   * nothing. */
+  pthread_mutex_t wake_lock;
+  pthread_cond_t wake;
+  atomic_bool sleeping;
+  atomic_bool stopping;
+  /* The process that created the consumer, a forked child has none */
+  pid_t owner;
+  /* Next in the list of loggers that are drained when the program exits */
+  struct otter_logger_impl *live_next;
+  /* Only touched by the consumer */
+  size_t dropped_reported;
+  atomic_size_t dropped;
+  /* Producers and the consumer each write to their own cache line */
+  atomic_size_t enqueue_position;
+  unsigned char enqueue_padding[OTTER_LOGGER_CACHE_LINE -
+                                sizeof(atomic_size_t)];
+  atomic_size_t dequeue_position;
+} otter_logger_async;
+
 typedef struct otter_logger_impl {
   otter_logger base;
   otter_allocator *allocator;
-  otter_log_level log_level;
   OTTER_ARRAY_DECLARE(otter_logger_sink_fn, sinks);
+  OTTER_ARRAY_DECLARE(otter_log_sink *, record_sinks);
+  /* NULL for loggers that call the sinks while logging */
+  otter_logger_async *async;
 } otter_logger_impl;
 
-static inline void otter_log_impl_call_sink(otter_log_level log_level,
-                                            time_t timestamp,
-                                            const char *message,
+static inline void otter_log_impl_call_sink(const otter_log_record *record,
                                             otter_logger_sink_fn sink_fn) {
-  sink_fn(log_level, timestamp, message);
+  sink_fn(record->log_level, record->wall_time.tv_sec, record->message);
+}
+
+static inline void otter_log_impl_call_record_sink(
+    const otter_log_record *record, otter_log_sink *sink) {
+  sink->vtable->write(sink, record);
+}
+
+static inline void otter_log_impl_flush_record_sink(otter_log_sink *sink) {
+  sink->vtable->flush(sink);
+}
+
+static void otter_logger_deliver(otter_logger_impl *logger,
+                                 const otter_log_record *record) {
+  OTTER_ARRAY_FOREACH(logger, sinks, otter_log_impl_call_sink, record);
+  OTTER_ARRAY_FOREACH(logger, record_sinks, otter_log_impl_call_record_sink,
+                      record);
+}
+
+/* The thread id costs a system call, so each thread asks once */
+static _Thread_local pid_t otter_log_thread_id = 0;
+
+static void otter_log_record_stamp(otter_log_record *record,
+                                   otter_log_level log_level) {
+  if (otter_log_thread_id == 0) {
+    otter_log_thread_id = gettid();
+  }
+
+  record->log_level = log_level;
+  record->thread_id = otter_log_thread_id;
+  clock_gettime(CLOCK_REALTIME, &record->wall_time);
+  record->monotonic_ns = otter_clock_now_ns();
+  record->context = NULL;
+  record->message = "";
+  record->message_length = 0;
+}
+
+/* Packs the context, its fields and every string into a single allocation */
+static otter_log_context *
+otter_log_context_copy(otter_allocator *allocator,
+                       const otter_log_context *context) {
+  const size_t target_size =
+      context->target != NULL ? strlen(context->target) + 1 : 0;
+  size_t size = sizeof(otter_log_context) +
+                (sizeof(otter_log_field) * context->fields_length) +
+                target_size;
+  for (size_t i = 0; i < context->fields_length; i++) {
+    size += strlen(context->fields[i].key) + 1;
+    size += strlen(context->fields[i].value) + 1;
+  }
+
+  otter_log_context *copy = otter_malloc(allocator, size);
+  if (copy == NULL) {
+    return NULL;
+  }
+
+  otter_log_field *fields = (otter_log_field *)(copy + 1);
+  char *strings = (char *)(fields + context->fields_length);
+  copy->target = NULL;
+  if (context->target != NULL) {
+    memcpy(strings, context->target, target_size);
+    copy->target = strings;
+    strings += target_size;
+  }
+
+  for (size_t i = 0; i < context->fields_length; i++) {
+    const size_t key_size = strlen(context->fields[i].key) + 1;
+    memcpy(strings, context->fields[i].key, key_size);
+    fields[i].key = strings;
+    strings += key_size;
+
+    const size_t value_size = strlen(context->fields[i].value) + 1;
+    memcpy(strings, context->fields[i].value, value_size);
+    fields[i].value = strings;
+    strings += value_size;
+  }
+
+  copy->fields = fields;
+  copy->fields_length = context->fields_length;
+  return copy;
+}
+
+static bool otter_logger_async_claim(otter_logger_async *async,
+                                     size_t *position) {
+  size_t claimed =
+      atomic_load_explicit(&async->enqueue_position, memory_order_relaxed);
+  while (true) {
+    otter_logger_slot *slot = &async->slots[claimed & async->mask];
+    const size_t sequence =
+        atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    const intptr_t difference = (intptr_t)sequence - (intptr_t)claimed;
+    if (difference == 0) {
+      /* Sequentially consistent so the check of sleeping that follows is
+       * ordered against the consumer's, see otter_logger_async_run */
+      if (atomic_compare_exchange_weak_explicit(
+              &async->enqueue_position, &claimed, claimed + 1,
+              memory_order_seq_cst, memory_order_relaxed)) {
+        *position = claimed;
+        return true;
+      }
+    } else if (difference < 0) {
+      /* The consumer has not freed this slot yet, the ring is full */
+      return false;
+    } else {
+      claimed =
+          atomic_load_explicit(&async->enqueue_position, memory_order_relaxed);
+    }
+  }
+}
+
+static void otter_logger_async_wake(otter_logger_async *async) {
+  pthread_mutex_lock(&async->wake_lock);
+  pthread_cond_signal(&async->wake);
+  pthread_mutex_unlock(&async->wake_lock);
+}
+
+/* Every asynchronous logger that has not been freed, so that calling exit
+ * does not lose what is still queued */
+static pthread_mutex_t otter_logger_live_lock = PTHREAD_MUTEX_INITIALIZER;
+static otter_logger_impl *otter_logger_live = NULL;
+static pthread_once_t otter_logger_live_once = PTHREAD_ONCE_INIT;
+
+static void otter_logger_flush_live(void) {
+  pthread_mutex_lock(&otter_logger_live_lock);
+  for (otter_logger_impl *logger = otter_logger_live; logger != NULL;
+       logger = logger->async->live_next) {
+    /* A sink that calls exit cannot wait for itself */
+    if (logger->async->owner == getpid() &&
+        !pthread_equal(pthread_self(), logger->async->consumer)) {
+      otter_logger_flush((otter_logger *)logger);
+    }
+  }
+  pthread_mutex_unlock(&otter_logger_live_lock);
+}
+
+static void otter_logger_live_init(void) { atexit(otter_logger_flush_live); }
+
+static void otter_logger_live_add(otter_logger_impl *logger) {
+  pthread_once(&otter_logger_live_once, otter_logger_live_init);
+  pthread_mutex_lock(&otter_logger_live_lock);
+  logger->async->live_next = otter_logger_live;
+  otter_logger_live = logger;
+  pthread_mutex_unlock(&otter_logger_live_lock);
+}
+
+static void otter_logger_live_remove(otter_logger_impl *logger) {
+  pthread_mutex_lock(&otter_logger_live_lock);
+  otter_logger_impl **link = &otter_logger_live;
+  while (*link != NULL && *link != logger) {
+    link = &(*link)->async->live_next;
+  }
+
+  if (*link != NULL) {
+    *link = logger->async->live_next;
+  }
+  pthread_mutex_unlock(&otter_logger_live_lock);
+}
+
+static void otter_log_async(otter_logger_impl *logger,
+                            otter_log_level log_level,
+                            const otter_log_context *context, const char *fmt,
+                            va_list args) {
+  otter_logger_async *async = logger->async;
+  const bool must_deliver = async->overflow == OTTER_LOGGER_OVERFLOW_BLOCK ||
+                            log_level <= OTTER_LOG_LEVEL_ERROR;
+  size_t position = 0;
+  while (!otter_logger_async_claim(async, &position)) {
+    if (!must_deliver) {
+      atomic_fetch_add_explicit(&async->dropped, 1, memory_order_relaxed);
+      return;
+    }
+
+    otter_logger_async_wake(async);
+    sched_yield();
+  }
+
+  otter_logger_slot *slot = &async->slots[position & async->mask];
+  otter_log_record record;
+  otter_log_record_stamp(&record, log_level);
+  slot->log_level = log_level;
+  slot->thread_id = record.thread_id;
+  slot->wall_time = record.wall_time;
+  slot->monotonic_ns = record.monotonic_ns;
+  slot->long_message = NULL;
+  /* The message still goes out without its context if this fails */
+  slot->context = context != NULL
+                      ? otter_log_context_copy(logger->allocator, context)
+                      : NULL;
+
+  va_list args_copy;
+  va_copy(args_copy, args);
+  const int length =
+      vsnprintf(slot->message, sizeof(slot->message), fmt, args_copy);
+  va_end(args_copy);
+  if (length < 0) {
+    slot->message[0] = '\0';
+  } else if ((size_t)length >= sizeof(slot->message)) {
+    /* The truncated message is still delivered if this fails */
+    otter_vasprintf(logger->allocator, &slot->long_message, fmt, args);
+  }
+
+  atomic_store_explicit(&slot->sequence, position + 1, memory_order_release);
+  if (atomic_load_explicit(&async->sleeping, memory_order_seq_cst)) {
+    otter_logger_async_wake(async);
+  }
 }
 
 static void otter_log_impl(otter_logger_impl *logger, otter_log_level log_level,
-                           const char *fmt, va_list args) {
-  time_t timestamp = time(NULL);
+                           const otter_log_context *context, const char *fmt,
+                           va_list args) {
+  if (logger->async != NULL) {
+    otter_log_async(logger, log_level, context, fmt, args);
+    return;
+  }
+
+  otter_log_record record;
+  otter_log_record_stamp(&record, log_level);
   char *message = NULL;
   bool formatted = otter_vasprintf(logger->allocator, &message, fmt, args);
   if (!formatted) {
     return;
   }
 
-  OTTER_ARRAY_FOREACH(logger, sinks, otter_log_impl_call_sink, log_level,
-                      timestamp, message);
+  record.context = context;
+  record.message = message;
+  record.message_length = strlen(message);
+  otter_logger_deliver(logger, &record);
   otter_free(logger->allocator, message);
 }
 
 static void otter_log_debug_impl(otter_logger *logger_, const char *fmt,
                                  va_list args) {
   otter_logger_impl *logger = (otter_logger_impl *)logger_;
-  if (logger->log_level >= OTTER_LOG_LEVEL_DEBUG) {
-    otter_log_impl(logger, OTTER_LOG_LEVEL_DEBUG, fmt, args);
+  if (logger->base.log_level >= OTTER_LOG_LEVEL_DEBUG) {
+    otter_log_impl(logger, OTTER_LOG_LEVEL_DEBUG, NULL, fmt, args);
   }
 }
 
 static void otter_log_info_impl(otter_logger *logger_, const char *fmt,
                                 va_list args) {
   otter_logger_impl *logger = (otter_logger_impl *)logger_;
-  if (logger->log_level >= OTTER_LOG_LEVEL_INFO) {
-    otter_log_impl(logger, OTTER_LOG_LEVEL_INFO, fmt, args);
+  if (logger->base.log_level >= OTTER_LOG_LEVEL_INFO) {
+    otter_log_impl(logger, OTTER_LOG_LEVEL_INFO, NULL, fmt, args);
   }
 }
 
 static void otter_log_warning_impl(otter_logger *logger_, const char *fmt,
                                    va_list args) {
   otter_logger_impl *logger = (otter_logger_impl *)logger_;
-  if (logger->log_level >= OTTER_LOG_LEVEL_WARNING) {
-    otter_log_impl(logger, OTTER_LOG_LEVEL_WARNING, fmt, args);
+  if (logger->base.log_level >= OTTER_LOG_LEVEL_WARNING) {
+    otter_log_impl(logger, OTTER_LOG_LEVEL_WARNING, NULL, fmt, args);
   }
 }
 
 static void otter_log_error_impl(otter_logger *logger_, const char *fmt,
                                  va_list args) {
   otter_logger_impl *logger = (otter_logger_impl *)logger_;
-  if (logger->log_level >= OTTER_LOG_LEVEL_ERROR) {
-    otter_log_impl(logger, OTTER_LOG_LEVEL_ERROR, fmt, args);
+  if (logger->base.log_level >= OTTER_LOG_LEVEL_ERROR) {
+    otter_log_impl(logger, OTTER_LOG_LEVEL_ERROR, NULL, fmt, args);
   }
 }
 
 static void otter_log_critical_impl(otter_logger *logger_, const char *fmt,
                                     va_list args) {
   otter_logger_impl *logger = (otter_logger_impl *)logger_;
-  if (logger->log_level >= OTTER_LOG_LEVEL_CRITICAL) {
-    otter_log_impl(logger, OTTER_LOG_LEVEL_CRITICAL, fmt, args);
+  if (logger->base.log_level >= OTTER_LOG_LEVEL_CRITICAL) {
+    otter_log_impl(logger, OTTER_LOG_LEVEL_CRITICAL, NULL, fmt, args);
+  }
+}
+
+static void otter_log_with_impl(otter_logger *logger_,
+                                otter_log_level log_level,
+                                const otter_log_context *context,
+                                const char *fmt, va_list args) {
+  otter_logger_impl *logger = (otter_logger_impl *)logger_;
+  if (logger->base.log_level >= log_level) {
+    otter_log_impl(logger, log_level, context, fmt, args);
   }
 }
 
@@ -95,6 +386,7 @@ static otter_logger_vtable vtable = {
     .log_warning = otter_log_warning_impl,
     .log_error = otter_log_error_impl,
     .log_critical = otter_log_critical_impl,
+    .log_with = otter_log_with_impl,
 };
 
 static const char *otter_log_level_to_console_string(otter_log_level level) {
@@ -133,6 +425,136 @@ const char *otter_log_level_to_string(otter_log_level level) {
   return "";
 }
 
+/* Hands every published message to the sinks, returns how many there were */
+static size_t otter_logger_async_drain(otter_logger_impl *logger) {
+  otter_logger_async *async = logger->async;
+  size_t drained = 0;
+  pthread_mutex_lock(&async->sinks_lock);
+  size_t position =
+      atomic_load_explicit(&async->dequeue_position, memory_order_relaxed);
+  /* At most one lap per batch, so flushing callers see progress while
+   * producers keep the ring busy */
+  while (drained <= async->mask) {
+    otter_logger_slot *slot = &async->slots[position & async->mask];
+    if (atomic_load_explicit(&slot->sequence, memory_order_acquire) !=
+        position + 1) {
+      break;
+    }
+
+    otter_log_record record = {
+        .log_level = slot->log_level,
+        .thread_id = slot->thread_id,
+        .wall_time = slot->wall_time,
+        .monotonic_ns = slot->monotonic_ns,
+        .context = slot->context,
+        .message =
+            slot->long_message != NULL ? slot->long_message : slot->message,
+    };
+    record.message_length = strlen(record.message);
+    otter_logger_deliver(logger, &record);
+    otter_free(logger->allocator, slot->long_message);
+    slot->long_message = NULL;
+    otter_free(logger->allocator, slot->context);
+    slot->context = NULL;
+
+    /* Hand the slot back to the producers for the next lap */
+    atomic_store_explicit(&slot->sequence, position + async->mask + 1,
+                          memory_order_release);
+    position++;
+    drained++;
+  }
+
+  const size_t dropped =
+      atomic_load_explicit(&async->dropped, memory_order_relaxed);
+  if (dropped > async->dropped_reported) {
+    char message[OTTER_LOGGER_ASYNC_MESSAGE_SIZE];
+    otter_log_record record;
+    otter_log_record_stamp(&record, OTTER_LOG_LEVEL_WARNING);
+    const int length = snprintf(message, sizeof(message),
+                                "Dropped %zu log messages",
+                                dropped - async->dropped_reported);
+    record.message = message;
+    record.message_length = length > 0 ? (size_t)length : 0;
+    otter_logger_deliver(logger, &record);
+    async->dropped_reported = dropped;
+  }
+
+  /* Only once the batch, and any drops before it, reached the sinks */
+  atomic_store_explicit(&async->dequeue_position, position,
+                        memory_order_release);
+  pthread_mutex_unlock(&async->sinks_lock);
+  return drained;
+}
+
+/* Whether the consumer has anything to do, including messages that are
+ * claimed but not published yet */
+static bool otter_logger_async_ready(otter_logger_async *async) {
+  return atomic_load_explicit(&async->enqueue_position, memory_order_seq_cst) !=
+             atomic_load_explicit(&async->dequeue_position,
+                                  memory_order_relaxed) ||
+         atomic_load_explicit(&async->stopping, memory_order_acquire);
+}
+
+static void *otter_logger_async_run(void *logger_) {
+  otter_logger_impl *logger = logger_;
+  otter_logger_async *async = logger->async;
+  size_t idle_polls = 0;
+  while (true) {
+    /* Read before draining so nothing published before the stop is lost */
+    const bool stopping =
+        atomic_load_explicit(&logger->async->stopping, memory_order_acquire);
+    if (otter_logger_async_drain(logger) > 0) {
+      idle_polls = 0;
+      continue;
+    }
+
+    if (stopping) {
+      break;
+    }
+
+    /* Buffered records go out as soon as there is nothing else to do */
+    pthread_mutex_lock(&async->sinks_lock);
+    OTTER_ARRAY_FOREACH(logger, record_sinks,
+                        otter_log_impl_flush_record_sink);
+    pthread_mutex_unlock(&async->sinks_lock);
+
+    if (idle_polls < OTTER_LOGGER_ASYNC_IDLE_POLLS) {
+      /* A wake up that comes in before the wait only costs one poll */
+      struct timespec deadline;
+      clock_gettime(CLOCK_MONOTONIC, &deadline);
+      deadline.tv_nsec += OTTER_LOGGER_ASYNC_POLL_NS;
+      if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+      }
+
+      pthread_mutex_lock(&async->wake_lock);
+      pthread_cond_timedwait(&async->wake, &async->wake_lock, &deadline);
+      pthread_mutex_unlock(&async->wake_lock);
+      idle_polls++;
+      continue;
+    }
+
+    /* Sleep until there is something to do.  Either a producer's claim is
+     * seen here or the producer sees sleeping and signals, and the check
+     * happens under the lock every waker takes, so no wake up is lost. */
+    pthread_mutex_lock(&async->wake_lock);
+    atomic_store_explicit(&async->sleeping, true, memory_order_seq_cst);
+    const bool ready = otter_logger_async_ready(async);
+    if (!ready) {
+      pthread_cond_wait(&async->wake, &async->wake_lock);
+    }
+    atomic_store_explicit(&async->sleeping, false, memory_order_relaxed);
+    pthread_mutex_unlock(&async->wake_lock);
+    if (ready) {
+      /* A producer is still writing its message */
+      sched_yield();
+    }
+  }
+
+  return NULL;
+}
+
 otter_logger *otter_logger_create(otter_allocator *allocator,
                                   otter_log_level log_level) {
   otter_logger_impl *logger = otter_malloc(allocator, sizeof(*logger));
@@ -141,15 +563,89 @@ otter_logger *otter_logger_create(otter_allocator *allocator,
   }
 
   logger->base.vtable = &vtable;
+  logger->base.log_level = log_level;
   logger->allocator = allocator;
-  logger->log_level = log_level;
   OTTER_ARRAY_INIT(logger, sinks, allocator);
-  if (logger->sinks == NULL) {
-    otter_free(allocator, logger);
+  OTTER_ARRAY_INIT(logger, record_sinks, allocator);
+  logger->async = NULL;
+
+  return (otter_logger *)logger;
+}
+
+otter_logger *otter_logger_create_async(otter_allocator *allocator,
+                                        otter_log_level log_level,
+                                        size_t capacity,
+                                        otter_logger_overflow overflow) {
+  if (allocator == NULL || !otter_allocator_thread_safe(allocator)) {
     return NULL;
   }
 
+  size_t slots_length = 2;
+  while (slots_length < capacity) {
+    if (slots_length > SIZE_MAX / 2 / sizeof(otter_logger_slot)) {
+      return NULL;
+    }
+    slots_length *= 2;
+  }
+
+  otter_logger_impl *logger =
+      (otter_logger_impl *)otter_logger_create(allocator, log_level);
+  if (logger == NULL) {
+    return NULL;
+  }
+
+  otter_logger_async *async = otter_malloc(allocator, sizeof(*async));
+  if (async == NULL) {
+    goto failure;
+  }
+
+  async->slots =
+      otter_malloc(allocator, sizeof(otter_logger_slot) * slots_length);
+  if (async->slots == NULL) {
+    otter_free(allocator, async);
+    goto failure;
+  }
+
+  for (size_t i = 0; i < slots_length; i++) {
+    atomic_init(&async->slots[i].sequence, i);
+    async->slots[i].long_message = NULL;
+    async->slots[i].context = NULL;
+  }
+
+  async->mask = slots_length - 1;
+  async->overflow = overflow;
+  async->dropped_reported = 0;
+  atomic_init(&async->dropped, 0);
+  atomic_init(&async->sleeping, false);
+  atomic_init(&async->stopping, false);
+  async->owner = getpid();
+  async->live_next = NULL;
+  atomic_init(&async->enqueue_position, 0);
+  atomic_init(&async->dequeue_position, 0);
+  pthread_mutex_init(&async->sinks_lock, NULL);
+  pthread_mutex_init(&async->wake_lock, NULL);
+  pthread_condattr_t wake_attributes;
+  pthread_condattr_init(&wake_attributes);
+  pthread_condattr_setclock(&wake_attributes, CLOCK_MONOTONIC);
+  pthread_cond_init(&async->wake, &wake_attributes);
+  pthread_condattr_destroy(&wake_attributes);
+  logger->async = async;
+  if (pthread_create(&async->consumer, NULL, otter_logger_async_run, logger) !=
+      0) {
+    pthread_cond_destroy(&async->wake);
+    pthread_mutex_destroy(&async->wake_lock);
+    pthread_mutex_destroy(&async->sinks_lock);
+    otter_free(allocator, async->slots);
+    otter_free(allocator, async);
+    logger->async = NULL;
+    goto failure;
+  }
+
+  otter_logger_live_add(logger);
   return (otter_logger *)logger;
+failure:
+  otter_logger_free((otter_logger *)logger);
+  return NULL;
 }
 
 void otter_logger_free(otter_logger *logger_) {
@@ -158,17 +654,98 @@ void otter_logger_free(otter_logger *logger_) {
   }
 
   otter_logger_impl *logger = (otter_logger_impl *)logger_;
-  otter_free(logger->allocator, logger->sinks);
+  if (logger->async != NULL) {
+    otter_logger_live_remove(logger);
+    /* The consumer drains the ring before it exits */
+    atomic_store_explicit(&logger->async->stopping, true,
+                          memory_order_release);
+    otter_logger_async_wake(logger->async);
+    pthread_join(logger->async->consumer, NULL);
+    pthread_cond_destroy(&logger->async->wake);
+    pthread_mutex_destroy(&logger->async->wake_lock);
+    pthread_mutex_destroy(&logger->async->sinks_lock);
+    otter_free(logger->allocator, logger->async->slots);
+    otter_free(logger->allocator, logger->async);
+  }
+
+  OTTER_ARRAY_FOREACH(logger, record_sinks, otter_log_sink_free);
+  OTTER_ARRAY_FREE(logger, record_sinks, logger->allocator);
+  OTTER_ARRAY_FREE(logger, sinks, logger->allocator);
   otter_free(logger->allocator, logger);
 }
 
 OTTER_DEFINE_TRIVIAL_CLEANUP_FUNC(otter_logger *, otter_logger_free);
 void otter_logger_add_sink(otter_logger *logger_, otter_logger_sink_fn sink) {
   otter_logger_impl *logger = (otter_logger_impl *)logger_;
+  if (logger->async != NULL) {
+    pthread_mutex_lock(&logger->async->sinks_lock);
+  }
+
   OTTER_ARRAY_APPEND(logger, sinks, logger->allocator, sink);
+  if (logger->async != NULL) {
+    pthread_mutex_unlock(&logger->async->sinks_lock);
+  }
 }
 
-void otter_log_debug(otter_logger *logger, const char *fmt, ...) {
+void otter_logger_flush(otter_logger *logger_) {
+  if (logger_ == NULL) {
+    return;
+  }
+
+  otter_logger_impl *logger = (otter_logger_impl *)logger_;
+  if (logger->async == NULL) {
+    OTTER_ARRAY_FOREACH(logger, record_sinks,
+                        otter_log_impl_flush_record_sink);
+    return;
+  }
+
+  const size_t position = atomic_load_explicit(
+      &logger->async->enqueue_position, memory_order_acquire);
+  while (atomic_load_explicit(&logger->async->dequeue_position,
+                              memory_order_acquire) < position) {
+    otter_logger_async_wake(logger->async);
+    sched_yield();
+  }
+
+  pthread_mutex_lock(&logger->async->sinks_lock);
+  OTTER_ARRAY_FOREACH(logger, record_sinks, otter_log_impl_flush_record_sink);
+  pthread_mutex_unlock(&logger->async->sinks_lock);
+}
+
+bool otter_logger_add_record_sink(otter_logger *logger_,
+                                  otter_log_sink *sink) {
+  otter_logger_impl *logger = (otter_logger_impl *)logger_;
+  if (logger->async != NULL) {
+    pthread_mutex_lock(&logger->async->sinks_lock);
+  }
+
+  const bool added =
+      OTTER_ARRAY_APPEND(logger, record_sinks, logger->allocator, sink);
+  if (logger->async != NULL) {
+    pthread_mutex_unlock(&logger->async->sinks_lock);
+  }
+
+  if (!added) {
+    otter_log_sink_free(sink);
+  }
+
+  return added;
+}
+
+size_t otter_logger_dropped(otter_logger *logger_) {
+  if (logger_ == NULL) {
+    return 0;
+  }
+
+  otter_logger_impl *logger = (otter_logger_impl *)logger_;
+  if (logger->async == NULL) {
+    return 0;
+  }
+
+  return atomic_load_explicit(&logger->async->dropped, memory_order_relaxed);
+}
+
+void(otter_log_debug)(otter_logger *logger, const char *fmt, ...) {
   if (logger == NULL) {
     return;
   }
@@ -179,7 +756,7 @@ void otter_log_debug(otter_logger *logger, const char *fmt, ...) {
   va_end(args);
 }
 
-void otter_log_info(otter_logger *logger, const char *fmt, ...) {
+void(otter_log_info)(otter_logger *logger, const char *fmt, ...) {
   if (logger == NULL) {
     return;
   }
@@ -190,7 +767,7 @@ void otter_log_info(otter_logger *logger, const char *fmt, ...) {
   va_end(args);
 }
 
-void otter_log_warning(otter_logger *logger, const char *fmt, ...) {
+void(otter_log_warning)(otter_logger *logger, const char *fmt, ...) {
   if (logger == NULL) {
     return;
   }
@@ -201,7 +778,7 @@ void otter_log_warning(otter_logger *logger, const char *fmt, ...) {
   va_end(args);
 }
 
-void otter_log_error(otter_logger *logger, const char *fmt, ...) {
+void(otter_log_error)(otter_logger *logger, const char *fmt, ...) {
   if (logger == NULL) {
     return;
   }
@@ -212,7 +789,7 @@ void otter_log_error(otter_logger *logger, const char *fmt, ...) {
   va_end(args);
 }
 
-void otter_log_critical(otter_logger *logger, const char *fmt, ...) {
+void(otter_log_critical)(otter_logger *logger, const char *fmt, ...) {
   if (logger == NULL) {
     return;
   }
@@ -223,14 +800,399 @@ void otter_log_critical(otter_logger *logger, const char *fmt, ...) {
   va_end(args);
 }
 
+void(otter_log_with)(otter_logger *logger, otter_log_level log_level,
+                     const otter_log_context *context, const char *fmt, ...) {
+  if (logger == NULL) {
+    return;
+  }
+
+  va_list args;
+  va_start(args, fmt);
+  logger->vtable->log_with(logger, log_level, context, fmt, args);
+  va_end(args);
+}
+
+/* Formatting a timestamp is only worth doing once per second */
+typedef struct otter_log_timestamp_cache {
+  time_t second;
+  size_t length;
+  char string[64];
+} otter_log_timestamp_cache;
+
+/* The ISO 8601 form leaves the fraction of the second to the caller */
+static const char *otter_log_timestamp(otter_log_timestamp_cache *cache,
+                                       time_t second, bool iso8601) {
+  if (cache->length == 0 || cache->second != second) {
+    struct tm time_info;
+    gmtime_r(&second, &time_info);
+    cache->length = strftime(cache->string, sizeof(cache->string),
+                             iso8601 ? "%Y-%m-%dT%H:%M:%S."
+                                     : "%Y-%m-%d %H:%M:%S UTC",
+                             &time_info);
+    cache->second = second;
+  }
+
+  return cache->string;
+}
+
 void otter_logger_console_sink(otter_log_level log_level, time_t timestamp,
                                const char *message) {
-#define TIMESTAMP_STRING_SIZE 84
-  char timestamp_string[TIMESTAMP_STRING_SIZE];
-  struct tm time_info;
-  gmtime_r(&timestamp, &time_info);
-  strftime(timestamp_string, sizeof(timestamp_string), "%Y-%m-%d %H:%M:%S UTC",
-           &time_info);
-  printf("[%s] - %s - %s\n", timestamp_string,
+  /* Sinks have no context of their own, every thread keeps its own cache */
+  static _Thread_local otter_log_timestamp_cache cache = {.length = 0};
+  printf("[%s] - %s - %s\n",
+         otter_log_timestamp(&cache, timestamp, false),
          otter_log_level_to_console_string(log_level), message);
 }
+
+void otter_log_sink_free(otter_log_sink *sink) {
+  if (sink == NULL) {
+    return;
+  }
+
+  sink->vtable->free(sink);
+}
+
+#define OTTER_LOG_WRITER_BUFFER_SIZE 16384
+#define OTTER_LOG_WRITER_IOV_SIZE 16
+/* Pieces at least this long are written straight from the record instead of
+ * being copied into the buffer */
+#define OTTER_LOG_WRITER_BORROW_SIZE 1024
+
+/* Collects records in a buffer and hands it to writev together with any
+ * long strings it borrowed from the record being written */
+typedef struct otter_log_writer {
+  int fd;
+  size_t length;
+  /* Start of the buffered bytes that are not in iov yet */
+  size_t pending;
+  int iov_length;
+  bool borrowed;
+  struct iovec iov[OTTER_LOG_WRITER_IOV_SIZE];
+  char buffer[OTTER_LOG_WRITER_BUFFER_SIZE];
+} otter_log_writer;
+
+static void otter_log_writer_init(otter_log_writer *writer, int fd) {
+  writer->fd = fd;
+  writer->length = 0;
+  writer->pending = 0;
+  writer->iov_length = 0;
+  writer->borrowed = false;
+}
+
+static void otter_log_writer_close_pending(otter_log_writer *writer) {
+  if (writer->length > writer->pending) {
+    writer->iov[writer->iov_length++] = (struct iovec){
+        .iov_base = &writer->buffer[writer->pending],
+        .iov_len = writer->length - writer->pending,
+    };
+    writer->pending = writer->length;
+  }
+}
+
+static void otter_log_writer_flush(otter_log_writer *writer) {
+  otter_log_writer_close_pending(writer);
+  struct iovec *iov = writer->iov;
+  int iov_length = writer->iov_length;
+  while (iov_length > 0) {
+    const ssize_t written = writev(writer->fd, iov, iov_length);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      /* There is nowhere left to report this, the records are lost */
+      break;
+    }
+
+    size_t remaining = (size_t)written;
+    while (iov_length > 0 && remaining >= iov->iov_len) {
+      remaining -= iov->iov_len;
+      iov++;
+      iov_length--;
+    }
+
+    if (iov_length > 0) {
+      iov->iov_base = (char *)iov->iov_base + remaining;
+      iov->iov_len -= remaining;
+    }
+  }
+
+  writer->length = 0;
+  writer->pending = 0;
+  writer->iov_length = 0;
+  writer->borrowed = false;
+}
+
+static void otter_log_writer_append(otter_log_writer *writer,
+                                    const void *data, size_t length) {
+  if (length >= OTTER_LOG_WRITER_BORROW_SIZE) {
+    /* Room for the pending bytes and the borrowed ones */
+    if (writer->iov_length + 2 > OTTER_LOG_WRITER_IOV_SIZE) {
+      otter_log_writer_flush(writer);
+    }
+
+    otter_log_writer_close_pending(writer);
+    /* NOLINTBEGIN(performance-no-int-to-ptr) */
+    writer->iov[writer->iov_length++] = (struct iovec){
+        .iov_base = (void *)(uintptr_t)data,
+        .iov_len = length,
+    };
+    /* NOLINTEND(performance-no-int-to-ptr) */
+    writer->borrowed = true;
+    return;
+  }
+
+  if (length > sizeof(writer->buffer) - writer->length ||
+      writer->iov_length + 1 >= OTTER_LOG_WRITER_IOV_SIZE) {
+    otter_log_writer_flush(writer);
+  }
+
+  memcpy(&writer->buffer[writer->length], data, length);
+  writer->length += length;
+}
+
+static void otter_log_writer_append_cstr(otter_log_writer *writer,
+                                         const char *value) {
+  otter_log_writer_append(writer, value, strlen(value));
+}
+
+/* Borrowed strings belong to the record, so they are written before the
+ * record goes away */
+static void otter_log_writer_end_record(otter_log_writer *writer) {
+  if (writer->borrowed) {
+    otter_log_writer_flush(writer);
+  }
+}
+
+/* Formats value in decimal, zero padded to at least width digits */
+static void otter_log_writer_append_decimal(otter_log_writer *writer,
+                                            uint64_t value, size_t width) {
+  char digits[24];
+  size_t start = sizeof(digits);
+  do {
+    digits[--start] = (char)('0' + (value % 10));
+    value /= 10;
+  } while (value != 0 || sizeof(digits) - start < width);
+
+  otter_log_writer_append(writer, &digits[start], sizeof(digits) - start);
+}
+
+typedef struct otter_log_sink_jsonl {
+  otter_log_sink base;
+  otter_allocator *allocator;
+  otter_log_timestamp_cache timestamp;
+  otter_log_writer writer;
+} otter_log_sink_jsonl;
+
+static void otter_log_sink_jsonl_append_string(otter_log_writer *writer,
+                                               const char *value,
+                                               size_t length) {
+  otter_log_writer_append(writer, "\"", 1);
+  size_t start = 0;
+  for (size_t i = 0; i < length; i++) {
+    const unsigned char character = (unsigned char)value[i];
+    if (character >= 0x20 && character != '"' && character != '\\') {
+      continue;
+    }
+
+    otter_log_writer_append(writer, &value[start], i - start);
+    start = i + 1;
+    switch (character) {
+    case '"':
+      otter_log_writer_append(writer, "\\\"", 2);
+      break;
+    case '\\':
+      otter_log_writer_append(writer, "\\\\", 2);
+      break;
+    case '\n':
+      otter_log_writer_append(writer, "\\n", 2);
+      break;
+    case '\r':
+      otter_log_writer_append(writer, "\\r", 2);
+      break;
+    case '\t':
+      otter_log_writer_append(writer, "\\t", 2);
+      break;
+    default: {
+      static const char hex[] = "0123456789abcdef";
+      const char escaped[] = {'\\', 'u', '0', '0', hex[character >> 4],
+                              hex[character & 0xf]};
+      otter_log_writer_append(writer, escaped, sizeof(escaped));
+    } break;
+    }
+  }
+
+  otter_log_writer_append(writer, &value[start], length - start);
+  otter_log_writer_append(writer, "\"", 1);
+}
+
+static void otter_log_sink_jsonl_write(otter_log_sink *sink_,
+                                       const otter_log_record *record) {
+  otter_log_sink_jsonl *sink = (otter_log_sink_jsonl *)sink_;
+  otter_log_writer *writer = &sink->writer;
+  const char *timestamp =
+      otter_log_timestamp(&sink->timestamp, record->wall_time.tv_sec, true);
+  otter_log_writer_append_cstr(writer, "{\"time\":\"");
+  otter_log_writer_append(writer, timestamp, sink->timestamp.length);
+  otter_log_writer_append_decimal(writer, (uint64_t)record->wall_time.tv_nsec,
+                                  9);
+  otter_log_writer_append_cstr(writer, "Z\",\"monotonic_ns\":");
+  otter_log_writer_append_decimal(writer, record->monotonic_ns, 1);
+  otter_log_writer_append_cstr(writer, ",\"level\":\"");
+  otter_log_writer_append_cstr(writer,
+                               otter_log_level_to_string(record->log_level));
+  otter_log_writer_append_cstr(writer, "\",\"thread\":");
+  otter_log_writer_append_decimal(writer, (uint64_t)record->thread_id, 1);
+  if (record->context != NULL && record->context->target != NULL) {
+    otter_log_writer_append_cstr(writer, ",\"target\":");
+    otter_log_sink_jsonl_append_string(writer, record->context->target,
+                                       strlen(record->context->target));
+  }
+
+  otter_log_writer_append_cstr(writer, ",\"message\":");
+  otter_log_sink_jsonl_append_string(writer, record->message,
+                                     record->message_length);
+  if (record->context != NULL && record->context->fields_length > 0) {
+    otter_log_writer_append_cstr(writer, ",\"fields\":{");
+    for (size_t i = 0; i < record->context->fields_length; i++) {
+      const otter_log_field *field = &record->context->fields[i];
+      if (i > 0) {
+        otter_log_writer_append(writer, ",", 1);
+      }
+
+      otter_log_sink_jsonl_append_string(writer, field->key,
+                                         strlen(field->key));
+      otter_log_writer_append(writer, ":", 1);
+      otter_log_sink_jsonl_append_string(writer, field->value,
+                                         strlen(field->value));
+    }
+    otter_log_writer_append(writer, "}", 1);
+  }
+
+  otter_log_writer_append(writer, "}\n", 2);
+  otter_log_writer_end_record(writer);
+}
+
+static void otter_log_sink_jsonl_flush(otter_log_sink *sink_) {
+  otter_log_sink_jsonl *sink = (otter_log_sink_jsonl *)sink_;
+  otter_log_writer_flush(&sink->writer);
+}
+
+static void otter_log_sink_jsonl_free(otter_log_sink *sink_) {
+  otter_log_sink_jsonl *sink = (otter_log_sink_jsonl *)sink_;
+  otter_log_writer_flush(&sink->writer);
+  close(sink->writer.fd);
+  otter_free(sink->allocator, sink);
+}
+
+static otter_log_sink_vtable jsonl_vtable = {
+    .write = otter_log_sink_jsonl_write,
+    .flush = otter_log_sink_jsonl_flush,
+    .free = otter_log_sink_jsonl_free,
+};
+
+otter_log_sink *otter_log_sink_jsonl_create(otter_allocator *allocator,
+                                            int fd) {
+  otter_log_sink_jsonl *sink = otter_malloc(allocator, sizeof(*sink));
+  if (sink == NULL) {
+    close(fd);
+    return NULL;
+  }
+
+  sink->base.vtable = &jsonl_vtable;
+  sink->allocator = allocator;
+  sink->timestamp.length = 0;
+  otter_log_writer_init(&sink->writer, fd);
+  return (otter_log_sink *)sink;
+}
+
+typedef struct otter_log_sink_binary {
+  otter_log_sink base;
+  otter_allocator *allocator;
+  otter_log_writer writer;
+} otter_log_sink_binary;
+
+static void otter_log_sink_binary_write(otter_log_sink *sink_,
+                                        const otter_log_record *record) {
+  otter_log_sink_binary *sink = (otter_log_sink_binary *)sink_;
+  const otter_log_context *context = record->context;
+  const char *target =
+      context != NULL && context->target != NULL ? context->target : "";
+  const size_t fields_length = context != NULL ? context->fields_length : 0;
+  const size_t target_length = strlen(target);
+  size_t record_length =
+      sizeof(otter_log_binary_header) + target_length + record->message_length;
+  for (size_t i = 0; i < fields_length; i++) {
+    record_length += sizeof(otter_log_binary_field) +
+                     strlen(context->fields[i].key) +
+                     strlen(context->fields[i].value);
+  }
+
+  if (record_length > UINT32_MAX) {
+    return;
+  }
+
+  const otter_log_binary_header header = {
+      .record_length = (uint32_t)record_length,
+      .log_level = (uint32_t)record->log_level,
+      .wall_time_ns =
+          ((int64_t)record->wall_time.tv_sec *
+           (int64_t)OTTER_NANOSECONDS_PER_SECOND) +
+          record->wall_time.tv_nsec,
+      .monotonic_ns = record->monotonic_ns,
+      .thread_id = (int32_t)record->thread_id,
+      .target_length = (uint32_t)target_length,
+      .message_length = (uint32_t)record->message_length,
+      .fields_length = (uint32_t)fields_length,
+  };
+  otter_log_writer *writer = &sink->writer;
+  otter_log_writer_append(writer, &header, sizeof(header));
+  otter_log_writer_append(writer, target, target_length);
+  otter_log_writer_append(writer, record->message, record->message_length);
+  for (size_t i = 0; i < fields_length; i++) {
+    const otter_log_field *field = &context->fields[i];
+    const otter_log_binary_field field_header = {
+        .key_length = (uint32_t)strlen(field->key),
+        .value_length = (uint32_t)strlen(field->value),
+    };
+    otter_log_writer_append(writer, &field_header, sizeof(field_header));
+    otter_log_writer_append(writer, field->key, field_header.key_length);
+    otter_log_writer_append(writer, field->value, field_header.value_length);
+  }
+
+  otter_log_writer_end_record(writer);
+}
+
+static void otter_log_sink_binary_flush(otter_log_sink *sink_) {
+  otter_log_sink_binary *sink = (otter_log_sink_binary *)sink_;
+  otter_log_writer_flush(&sink->writer);
+}
+
+static void otter_log_sink_binary_free(otter_log_sink *sink_) {
+  otter_log_sink_binary *sink = (otter_log_sink_binary *)sink_;
+  otter_log_writer_flush(&sink->writer);
+  close(sink->writer.fd);
+  otter_free(sink->allocator, sink);
+}
+
+static otter_log_sink_vtable binary_vtable = {
+    .write = otter_log_sink_binary_write,
+    .flush = otter_log_sink_binary_flush,
+    .free = otter_log_sink_binary_free,
+};
+
+otter_log_sink *otter_log_sink_binary_create(otter_allocator *allocator,
+                                             int fd) {
+  otter_log_sink_binary *sink = otter_malloc(allocator, sizeof(*sink));
+  if (sink == NULL) {
+    close(fd);
+    return NULL;
+  }
+
+  sink->base.vtable = &binary_vtable;
+  sink->allocator = allocator;
+  otter_log_writer_init(&sink->writer, fd);
+  otter_log_writer_append(&sink->writer, OTTER_LOG_BINARY_MAGIC,
+                          OTTER_LOG_BINARY_MAGIC_SIZE);
+  return (otter_log_sink *)sink;
+}
@@ -0,0 +1,232 @@
+/*
+  otter Copyright (C) 2026 Nathaniel Wright
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "otter/allocator.h"
+#include "otter/bench.h"
+#include "otter/logger.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Logs the kind of line a build prints per target to a sink that formats the
+ * timestamp and writes to /dev/null, the way the console sink does.  The
+ * asynchronous logger is timed on the calling threads and again once it has
+ * been flushed.  Bursts that fit into the ring show what a caller pays when
+ * the consumer keeps up. */
+
+#define OTTER_BENCH_MESSAGES_PER_THREAD 25000
+#define OTTER_BENCH_THREADS 4
+#define OTTER_BENCH_BURSTS 100
+#define OTTER_BENCH_BURST_SIZE 512
+#define OTTER_BENCH_DISABLED_MESSAGES 10000000
+
+static FILE *bench_output = NULL;
+
+static void bench_sink(otter_log_level log_level, time_t timestamp,
+                       const char *message) {
+  char timestamp_string[64];
+  struct tm time_info;
+  gmtime_r(&timestamp, &time_info);
+  strftime(timestamp_string, sizeof(timestamp_string), "%Y-%m-%d %H:%M:%S UTC",
+           &time_info);
+  fprintf(bench_output, "[%s] - %s - %s\n", timestamp_string,
+          otter_log_level_to_string(log_level), message);
+}
+
+static void *bench_log(void *logger) {
+  for (size_t i = 0; i < OTTER_BENCH_MESSAGES_PER_THREAD; i++) {
+    otter_log_info(logger, "Executing target './debug/module_%05zu.o'", i);
+  }
+
+  return NULL;
+}
+
+static void bench_run(const char *name, otter_logger *logger, size_t threads) {
+  otter_logger_add_sink(logger, bench_sink);
+  pthread_t workers[OTTER_BENCH_THREADS];
+  const uint64_t start = otter_bench_now_ns();
+  size_t started = 0;
+  for (; started < threads; started++) {
+    if (pthread_create(&workers[started], NULL, bench_log, logger) != 0) {
+      break;
+    }
+  }
+  for (size_t i = 0; i < started; i++) {
+    pthread_join(workers[i], NULL);
+  }
+
+  const uint64_t logged = otter_bench_now_ns();
+  otter_logger_flush(logger);
+  const uint64_t flushed = otter_bench_now_ns();
+
+  const size_t messages = started * OTTER_BENCH_MESSAGES_PER_THREAD;
+  char label[128];
+  snprintf(label, sizeof(label), "%s, %zu thread(s), caller", name, threads);
+  otter_bench_report(label, messages, logged - start);
+  snprintf(label, sizeof(label), "%s, %zu thread(s), flushed", name, threads);
+  otter_bench_report(label, messages, flushed - start);
+  otter_logger_free(logger);
+}
+
+static void bench_burst(const char *name, otter_logger *logger) {
+  otter_logger_add_sink(logger, bench_sink);
+  uint64_t elapsed = 0;
+  for (size_t burst = 0; burst < OTTER_BENCH_BURSTS; burst++) {
+    const uint64_t start = otter_bench_now_ns();
+    for (size_t i = 0; i < OTTER_BENCH_BURST_SIZE; i++) {
+      otter_log_info(logger, "Executing target './debug/module_%05zu.o'", i);
+    }
+    elapsed += otter_bench_now_ns() - start;
+    otter_logger_flush(logger);
+  }
+
+  char label[128];
+  snprintf(label, sizeof(label), "%s, bursts of %d, caller", name,
+           OTTER_BENCH_BURST_SIZE);
+  otter_bench_report(label, OTTER_BENCH_BURSTS * OTTER_BENCH_BURST_SIZE,
+                     elapsed);
+  otter_logger_free(logger);
+}
+
+/* Stands in for the argument a debug line usually carries, e.g. a path that
+ * has to be put together first */
+__attribute__((noinline)) static const char *bench_describe(size_t i) {
+  static char description[64];
+  snprintf(description, sizeof(description), "./debug/module_%05zu.o", i);
+  return description;
+}
+
+/* Debug lines against an info logger: the plain function call evaluates the
+ * arguments before the level is checked, the macro checks first and a release
+ * build drops the statement altogether */
+static void bench_disabled(otter_logger *logger) {
+  uint64_t start = otter_bench_now_ns();
+  for (size_t i = 0; i < OTTER_BENCH_DISABLED_MESSAGES; i++) {
+    (otter_log_debug)(logger, "Executing target '%s'", bench_describe(i));
+  }
+  otter_bench_report("disabled debug, function call",
+                     OTTER_BENCH_DISABLED_MESSAGES,
+                     otter_bench_now_ns() - start);
+
+  start = otter_bench_now_ns();
+  for (size_t i = 0; i < OTTER_BENCH_DISABLED_MESSAGES; i++) {
+    otter_log_debug(logger, "Executing target '%s'", bench_describe(i));
+  }
+  otter_bench_report("disabled debug, level check",
+                     OTTER_BENCH_DISABLED_MESSAGES,
+                     otter_bench_now_ns() - start);
+
+#pragma push_macro("OTTER_LOG_MIN_LEVEL")
+#undef OTTER_LOG_MIN_LEVEL
+#define OTTER_LOG_MIN_LEVEL OTTER_LOG_LEVEL_INFO
+  start = otter_bench_now_ns();
+  for (size_t i = 0; i < OTTER_BENCH_DISABLED_MESSAGES; i++) {
+    otter_log_debug(logger, "Executing target '%s'", bench_describe(i));
+  }
+  otter_bench_report("disabled debug, compiled out",
+                     OTTER_BENCH_DISABLED_MESSAGES,
+                     otter_bench_now_ns() - start);
+#pragma pop_macro("OTTER_LOG_MIN_LEVEL")
+  otter_logger_free(logger);
+}
+
+/* The same lines with the target and command attached, written by a
+ * structured sink instead of the text sink */
+static void bench_structured(const char *name, otter_logger *logger,
+                             otter_log_sink *sink) {
+  if (sink == NULL || !otter_logger_add_record_sink(logger, sink)) {
+    otter_logger_free(logger);
+    return;
+  }
+
+  const otter_log_field fields[] = {
+      {.key = "command", .value = "cc -c ./src/module.c -o ./debug/module.o"}};
+  const otter_log_context context = {
+      .target = "./debug/module.o", .fields = fields, .fields_length = 1};
+  const uint64_t start = otter_bench_now_ns();
+  for (size_t i = 0; i < OTTER_BENCH_MESSAGES_PER_THREAD; i++) {
+    otter_log_with(logger, OTTER_LOG_LEVEL_INFO, &context,
+                   "Executing target './debug/module_%05zu.o'", i);
+  }
+  otter_logger_flush(logger);
+
+  otter_bench_report(name, OTTER_BENCH_MESSAGES_PER_THREAD,
+                     otter_bench_now_ns() - start);
+  otter_logger_free(logger);
+}
+
+int main(void) {
+  OTTER_CLEANUP(otter_allocator_free_p)
+  otter_allocator *allocator = otter_allocator_create();
+  if (allocator == NULL) {
+    return EXIT_FAILURE;
+  }
+
+  bench_output = fopen("/dev/null", "w");
+  if (bench_output == NULL) {
+    return EXIT_FAILURE;
+  }
+
+  /* The synchronous logger is only safe to use from one thread */
+  otter_logger *logger = otter_logger_create(allocator, OTTER_LOG_LEVEL_INFO);
+  if (logger != NULL) {
+    bench_run("synchronous", logger, 1);
+  }
+
+  logger = otter_logger_create(allocator, OTTER_LOG_LEVEL_INFO);
+  if (logger != NULL) {
+    bench_burst("synchronous", logger);
+  }
+
+  logger = otter_logger_create(allocator, OTTER_LOG_LEVEL_INFO);
+  if (logger != NULL) {
+    bench_disabled(logger);
+  }
+
+  logger = otter_logger_create(allocator, OTTER_LOG_LEVEL_INFO);
+  if (logger != NULL) {
+    bench_structured(
+        "synchronous, jsonl sink", logger,
+        otter_log_sink_jsonl_create(allocator, open("/dev/null", O_WRONLY)));
+  }
+
+  logger = otter_logger_create(allocator, OTTER_LOG_LEVEL_INFO);
+  if (logger != NULL) {
+    bench_structured(
+        "synchronous, binary sink", logger,
+        otter_log_sink_binary_create(allocator, open("/dev/null", O_WRONLY)));
+  }
+
+  logger = otter_logger_create_async(allocator, OTTER_LOG_LEVEL_INFO,
+                                     OTTER_LOGGER_ASYNC_DEFAULT_CAPACITY,
+                                     OTTER_LOGGER_OVERFLOW_BLOCK);
+  if (logger != NULL) {
+    bench_burst("asynchronous", logger);
+  }
+
+  for (size_t threads = 1; threads <= OTTER_BENCH_THREADS; threads *= 2) {
+    logger = otter_logger_create_async(allocator, OTTER_LOG_LEVEL_INFO,
+                                       OTTER_LOGGER_ASYNC_DEFAULT_CAPACITY,
+                                       OTTER_LOGGER_OVERFLOW_BLOCK);
+    if (logger != NULL) {
+      bench_run("asynchronous", logger, threads);
+    }
+  }
+
+  fclose(bench_output);
+  return EXIT_SUCCESS;
+}
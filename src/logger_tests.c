@@ -0,0 +1,453 @@
+/*
+  otter Copyright (C) 2026 Nathaniel Wright
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "otter/logger.h"
+#include "otter/test.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/* Sinks have no context, so the messages they see are kept here.  They are
+ * only written from the consumer thread and only read after a flush. */
+#define CAPTURED_MESSAGES_SIZE 4096
+static int captured_values[CAPTURED_MESSAGES_SIZE];
+static size_t captured_length = 0;
+static size_t captured_longest = 0;
+static size_t captured_warnings = 0;
+static atomic_bool sink_released = true;
+
+static void capture_sink(otter_log_level log_level, time_t /* unused */,
+                         const char *message) {
+  if (log_level == OTTER_LOG_LEVEL_WARNING) {
+    captured_warnings++;
+    return;
+  }
+
+  const size_t length = strlen(message);
+  if (length > captured_longest) {
+    captured_longest = length;
+  }
+
+  if (captured_length < CAPTURED_MESSAGES_SIZE) {
+    captured_values[captured_length++] = atoi(message);
+  }
+}
+
+/* Holds the consumer inside the sink until the test lets it go */
+static void blocking_sink(otter_log_level /* unused */, time_t /* unused */,
+                          const char * /* unused */) {
+  while (!atomic_load(&sink_released)) {
+    sched_yield();
+  }
+}
+
+static void reset_captured(void) {
+  captured_length = 0;
+  captured_longest = 0;
+  captured_warnings = 0;
+  atomic_store(&sink_released, true);
+}
+
+OTTER_TEST(logger_async_delivers_messages_in_order) {
+  reset_captured();
+  otter_logger *logger = NULL;
+  otter_allocator *libc = otter_allocator_create();
+  OTTER_ASSERT(libc != NULL);
+  logger = otter_logger_create_async(libc, OTTER_LOG_LEVEL_INFO, 16,
+                                     OTTER_LOGGER_OVERFLOW_BLOCK);
+  OTTER_ASSERT(logger != NULL);
+  otter_logger_add_sink(logger, capture_sink);
+
+  /* More messages than slots, so the ring wraps several times */
+  for (int i = 0; i < 100; i++) {
+    otter_log_info(logger, "%d", i);
+  }
+  otter_log_debug(logger, "%d", 100);
+
+  otter_logger_flush(logger);
+  OTTER_ASSERT(captured_length == 100);
+  for (size_t i = 0; i < captured_length; i++) {
+    OTTER_ASSERT(captured_values[i] == (int)i);
+  }
+  OTTER_ASSERT(otter_logger_dropped(logger) == 0);
+
+  OTTER_TEST_END(if (logger) otter_logger_free(logger);
+                 if (libc) otter_allocator_free(libc););
+}
+
+OTTER_TEST(logger_async_copies_long_messages) {
+  reset_captured();
+  otter_logger *logger = NULL;
+  otter_allocator *libc = otter_allocator_create();
+  OTTER_ASSERT(libc != NULL);
+  logger = otter_logger_create_async(libc, OTTER_LOG_LEVEL_INFO, 4,
+                                     OTTER_LOGGER_OVERFLOW_BLOCK);
+  OTTER_ASSERT(logger != NULL);
+  otter_logger_add_sink(logger, capture_sink);
+
+  char long_message[1024];
+  memset(long_message, 'x', sizeof(long_message) - 1);
+  long_message[sizeof(long_message) - 1] = '\0';
+  otter_log_info(logger, "%s", long_message);
+
+  otter_logger_flush(logger);
+  OTTER_ASSERT(captured_length == 1);
+  OTTER_ASSERT(captured_longest == sizeof(long_message) - 1);
+
+  OTTER_TEST_END(if (logger) otter_logger_free(logger);
+                 if (libc) otter_allocator_free(libc););
+}
+
+OTTER_TEST(logger_async_drops_when_full) {
+  reset_captured();
+  otter_logger *logger = NULL;
+  otter_allocator *libc = otter_allocator_create();
+  OTTER_ASSERT(libc != NULL);
+  logger = otter_logger_create_async(libc, OTTER_LOG_LEVEL_INFO, 2,
+                                     OTTER_LOGGER_OVERFLOW_DROP);
+  OTTER_ASSERT(logger != NULL);
+  otter_logger_add_sink(logger, blocking_sink);
+  otter_logger_add_sink(logger, capture_sink);
+
+  /* With the consumer stuck in a sink only the two slots of the ring fill up,
+   * a slot is handed back once the sinks return */
+  atomic_store(&sink_released, false);
+  for (int i = 0; i < 10; i++) {
+    otter_log_info(logger, "%d", i);
+  }
+  OTTER_ASSERT(otter_logger_dropped(logger) >= 8);
+
+  atomic_store(&sink_released, true);
+  otter_logger_flush(logger);
+  OTTER_ASSERT(captured_length + otter_logger_dropped(logger) == 10);
+
+  /* Errors are never dropped */
+  atomic_store(&sink_released, false);
+  for (int i = 0; i < 10; i++) {
+    otter_log_info(logger, "%d", i);
+  }
+  atomic_store(&sink_released, true);
+  otter_log_error(logger, "%d", 10);
+  otter_logger_flush(logger);
+  OTTER_ASSERT(captured_values[captured_length - 1] == 10);
+  OTTER_ASSERT(captured_warnings > 0);
+
+  OTTER_TEST_END(atomic_store(&sink_released, true);
+                 if (logger) otter_logger_free(logger);
+                 if (libc) otter_allocator_free(libc););
+}
+
+OTTER_TEST(logger_async_free_flushes) {
+  reset_captured();
+  otter_logger *logger = NULL;
+  otter_allocator *libc = otter_allocator_create();
+  OTTER_ASSERT(libc != NULL);
+  logger = otter_logger_create_async(libc, OTTER_LOG_LEVEL_INFO,
+                                     OTTER_LOGGER_ASYNC_DEFAULT_CAPACITY,
+                                     OTTER_LOGGER_OVERFLOW_BLOCK);
+  OTTER_ASSERT(logger != NULL);
+  otter_logger_add_sink(logger, capture_sink);
+
+  for (int i = 0; i < 10; i++) {
+    otter_log_info(logger, "%d", i);
+  }
+
+  otter_logger_free(logger);
+  logger = NULL;
+  OTTER_ASSERT(captured_length == 10);
+
+  OTTER_TEST_END(if (logger) otter_logger_free(logger);
+                 if (libc) otter_allocator_free(libc););
+}
+
+OTTER_TEST(logger_async_requires_thread_safe_allocator) {
+  /* Producers allocate messages that the consumer frees */
+  otter_allocator_vtable vtable = {
+      .malloc = NULL,
+      .realloc = NULL,
+      .free = NULL,
+      .capabilities = 0,
+  };
+  otter_allocator allocator = {
+      .vtable = &vtable,
+  };
+  OTTER_ASSERT(otter_logger_create_async(&allocator, OTTER_LOG_LEVEL_INFO, 4,
+                                         OTTER_LOGGER_OVERFLOW_BLOCK) == NULL);
+
+  OTTER_TEST_END();
+}
+
+/* Where exit_pipe_sink writes, the sink runs in a forked child */
+static int exit_pipe_fd = -1;
+
+/* Slow enough that the child reaches exit with most messages still queued */
+static void exit_pipe_sink(otter_log_level /* unused */, time_t /* unused */,
+                           const char *message) {
+  usleep(1000);
+  dprintf(exit_pipe_fd, "%s\n", message);
+}
+
+#define EXIT_MESSAGES 100
+OTTER_TEST(logger_async_exit_flushes) {
+  int fds[2] = {-1, -1};
+  FILE *output = NULL;
+  OTTER_ASSERT(pipe(fds) == 0);
+
+  /* Otherwise the child's exit writes out the driver's buffered output too */
+  fflush(stdout);
+  fflush(stderr);
+  const pid_t child = fork();
+  OTTER_ASSERT(child >= 0);
+  if (child == 0) {
+    /* Never freed, exit has to drain it */
+    close(fds[0]);
+    exit_pipe_fd = fds[1];
+    otter_logger *logger = otter_logger_create_async(
+        otter_allocator_create(), OTTER_LOG_LEVEL_INFO,
+        OTTER_LOGGER_ASYNC_DEFAULT_CAPACITY, OTTER_LOGGER_OVERFLOW_BLOCK);
+    if (logger == NULL) {
+      exit(1);
+    }
+
+    otter_logger_add_sink(logger, exit_pipe_sink);
+    for (int i = 0; i < EXIT_MESSAGES; i++) {
+      otter_log_info(logger, "%d", i);
+    }
+    exit(0);
+  }
+
+  close(fds[1]);
+  fds[1] = -1;
+  output = fdopen(fds[0], "r");
+  OTTER_ASSERT(output != NULL);
+  fds[0] = -1;
+
+  int received = 0;
+  char line[32];
+  while (fgets(line, sizeof(line), output) != NULL) {
+    OTTER_ASSERT(atoi(line) == received);
+    received++;
+  }
+
+  int status = 0;
+  OTTER_ASSERT(waitpid(child, &status, 0) == child);
+  OTTER_ASSERT(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  OTTER_ASSERT(received == EXIT_MESSAGES);
+
+  OTTER_TEST_END(if (output) fclose(output); if (fds[0] >= 0) close(fds[0]);
+                 if (fds[1] >= 0) close(fds[1]););
+}
+
+#define PRODUCER_THREADS 4
+#define PRODUCER_MESSAGES 1000
+typedef struct producer {
+  pthread_t thread;
+  otter_logger *logger;
+  int index;
+} producer;
+
+static void *produce_messages(void *producer_) {
+  producer *self = producer_;
+  for (int i = 0; i < PRODUCER_MESSAGES; i++) {
+    otter_log_info(self->logger, "%d", self->index * PRODUCER_MESSAGES + i);
+  }
+
+  return NULL;
+}
+
+OTTER_TEST(logger_async_concurrent_producers) {
+  reset_captured();
+  otter_logger *logger = NULL;
+  otter_allocator *libc = otter_allocator_create();
+  OTTER_ASSERT(libc != NULL);
+  logger = otter_logger_create_async(libc, OTTER_LOG_LEVEL_INFO, 64,
+                                     OTTER_LOGGER_OVERFLOW_BLOCK);
+  OTTER_ASSERT(logger != NULL);
+  otter_logger_add_sink(logger, capture_sink);
+
+  producer producers[PRODUCER_THREADS];
+  for (int i = 0; i < PRODUCER_THREADS; i++) {
+    producers[i].logger = logger;
+    producers[i].index = i;
+    OTTER_ASSERT(pthread_create(&producers[i].thread, NULL, produce_messages,
+                                &producers[i]) == 0);
+  }
+  for (size_t i = 0; i < PRODUCER_THREADS; i++) {
+    pthread_join(producers[i].thread, NULL);
+  }
+
+  otter_logger_flush(logger);
+  OTTER_ASSERT(captured_length == PRODUCER_THREADS * PRODUCER_MESSAGES);
+  OTTER_ASSERT(otter_logger_dropped(logger) == 0);
+
+  /* Each thread's messages arrive in the order it logged them */
+  int next[PRODUCER_THREADS] = {0};
+  for (size_t i = 0; i < captured_length; i++) {
+    const int index = captured_values[i] / PRODUCER_MESSAGES;
+    OTTER_ASSERT(captured_values[i] % PRODUCER_MESSAGES == next[index]);
+    next[index]++;
+  }
+
+  OTTER_TEST_END(if (logger) otter_logger_free(logger);
+                 if (libc) otter_allocator_free(libc););
+}
+
+OTTER_TEST(logger_disabled_level_skips_arguments) {
+  reset_captured();
+  otter_logger *logger =
+      otter_logger_create(OTTER_TEST_ALLOCATOR, OTTER_LOG_LEVEL_INFO);
+  OTTER_ASSERT(logger != NULL);
+  otter_logger_add_sink(logger, capture_sink);
+
+  int evaluated = 0;
+  otter_log_debug(logger, "%d", evaluated++);
+  OTTER_ASSERT(evaluated == 0);
+  OTTER_ASSERT(captured_length == 0);
+
+  otter_log_info(logger, "%d", evaluated++);
+  OTTER_ASSERT(evaluated == 1);
+  OTTER_ASSERT(captured_length == 1);
+
+  otter_logger *no_logger = NULL;
+  otter_log_error(no_logger, "%d", evaluated++);
+  OTTER_ASSERT(evaluated == 1);
+
+  OTTER_TEST_END(if (logger) otter_logger_free(logger););
+}
+
+/* Reads back everything the sink wrote to file */
+static size_t read_written(FILE *file, char *contents, size_t size) {
+  const ssize_t length = pread(fileno(file), contents, size - 1, 0);
+  if (length < 0) {
+    contents[0] = '\0';
+    return 0;
+  }
+
+  contents[length] = '\0';
+  return (size_t)length;
+}
+
+OTTER_TEST(logger_jsonl_sink_writes_context) {
+  otter_logger *logger = NULL;
+  FILE *file = tmpfile();
+  OTTER_ASSERT(file != NULL);
+  logger = otter_logger_create(OTTER_TEST_ALLOCATOR, OTTER_LOG_LEVEL_INFO);
+  OTTER_ASSERT(logger != NULL);
+  OTTER_ASSERT(otter_logger_add_record_sink(
+      logger, otter_log_sink_jsonl_create(OTTER_TEST_ALLOCATOR,
+                                          dup(fileno(file)))));
+
+  const otter_log_field fields[] = {{.key = "command", .value = "cc \"a.c\""}};
+  const otter_log_context context = {
+      .target = "module.o", .fields = fields, .fields_length = 1};
+  otter_log_with(logger, OTTER_LOG_LEVEL_INFO, &context, "Executing\n%s",
+                 "now");
+  otter_log_info(logger, "Done");
+  otter_log_with(logger, OTTER_LOG_LEVEL_DEBUG, &context, "Skipped");
+
+  /* Nothing is written until the buffer is flushed */
+  char contents[1024];
+  OTTER_ASSERT(read_written(file, contents, sizeof(contents)) == 0);
+  otter_logger_flush(logger);
+  OTTER_ASSERT(read_written(file, contents, sizeof(contents)) > 0);
+
+  /* e.g. {"time":"2026-01-02T03:04:05.123456789Z" */
+  OTTER_ASSERT(strncmp(contents, "{\"time\":\"", 9) == 0);
+  const char *time = &contents[9];
+  OTTER_ASSERT(time[4] == '-' && time[10] == 'T' && time[19] == '.');
+  OTTER_ASSERT(strncmp(&time[29], "Z\",\"monotonic_ns\":", 17) == 0);
+  OTTER_ASSERT(strstr(contents,
+                      "\"level\":\"INFO\",\"thread\":") != NULL);
+  OTTER_ASSERT(strstr(contents, ",\"target\":\"module.o\","
+                                "\"message\":\"Executing\\nnow\","
+                                "\"fields\":{\"command\":"
+                                "\"cc \\\"a.c\\\"\"}}\n") != NULL);
+  OTTER_ASSERT(strstr(contents, ",\"message\":\"Done\"}\n") != NULL);
+  OTTER_ASSERT(strstr(contents, "Skipped") == NULL);
+
+  OTTER_TEST_END(if (logger) otter_logger_free(logger);
+                 if (file) fclose(file););
+}
+
+OTTER_TEST(logger_binary_sink_copies_context) {
+  otter_logger *logger = NULL;
+  otter_allocator *libc = NULL;
+  FILE *file = tmpfile();
+  OTTER_ASSERT(file != NULL);
+  libc = otter_allocator_create();
+  OTTER_ASSERT(libc != NULL);
+  logger = otter_logger_create_async(libc, OTTER_LOG_LEVEL_INFO, 4,
+                                     OTTER_LOGGER_OVERFLOW_BLOCK);
+  OTTER_ASSERT(logger != NULL);
+  OTTER_ASSERT(otter_logger_add_record_sink(
+      logger, otter_log_sink_binary_create(OTTER_TEST_ALLOCATOR,
+                                           dup(fileno(file)))));
+
+  /* Long enough to be written from the record instead of the buffer */
+  char long_message[2000];
+  memset(long_message, 'x', sizeof(long_message) - 1);
+  long_message[sizeof(long_message) - 1] = '\0';
+  char target[] = "module.o";
+  const otter_log_field fields[] = {{.key = "k", .value = "value"}};
+  const otter_log_context context = {
+      .target = target, .fields = fields, .fields_length = 1};
+  otter_log_with(logger, OTTER_LOG_LEVEL_WARNING, &context, "%s",
+                 long_message);
+  /* The consumer has to see the copy */
+  memset(target, 'y', sizeof(target) - 1);
+  otter_logger_flush(logger);
+
+  char contents[4096];
+  const size_t length = read_written(file, contents, sizeof(contents));
+  const size_t message_length = sizeof(long_message) - 1;
+  const size_t record_length =
+      sizeof(otter_log_binary_header) + strlen("module.o") + message_length +
+      sizeof(otter_log_binary_field) + strlen("k") + strlen("value");
+  OTTER_ASSERT(length == OTTER_LOG_BINARY_MAGIC_SIZE + record_length);
+  OTTER_ASSERT(memcmp(contents, OTTER_LOG_BINARY_MAGIC,
+                      OTTER_LOG_BINARY_MAGIC_SIZE) == 0);
+
+  const char *cursor = &contents[OTTER_LOG_BINARY_MAGIC_SIZE];
+  otter_log_binary_header header;
+  memcpy(&header, cursor, sizeof(header));
+  cursor += sizeof(header);
+  OTTER_ASSERT(header.record_length == record_length);
+  OTTER_ASSERT(header.log_level == OTTER_LOG_LEVEL_WARNING);
+  OTTER_ASSERT(header.thread_id > 0);
+  OTTER_ASSERT(header.wall_time_ns > 0 && header.monotonic_ns > 0);
+  OTTER_ASSERT(header.target_length == strlen("module.o"));
+  OTTER_ASSERT(memcmp(cursor, "module.o", header.target_length) == 0);
+  cursor += header.target_length;
+  OTTER_ASSERT(header.message_length == message_length);
+  OTTER_ASSERT(memcmp(cursor, long_message, message_length) == 0);
+  cursor += header.message_length;
+
+  OTTER_ASSERT(header.fields_length == 1);
+  otter_log_binary_field field;
+  memcpy(&field, cursor, sizeof(field));
+  cursor += sizeof(field);
+  OTTER_ASSERT(field.key_length == 1 && field.value_length == 5);
+  OTTER_ASSERT(memcmp(cursor, "kvalue", 6) == 0);
+
+  OTTER_TEST_END(if (logger) otter_logger_free(logger);
+                 if (file) fclose(file);
+                 if (libc) otter_allocator_free(libc););
+}
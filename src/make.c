@@ -43,7 +43,9 @@
 #define CC_FLAGS_DEBUG                                                         \
   CC_FLAGS_COMMON "-O0 -g -fsanitize=address,undefined,leak "
 
-#define CC_FLAGS_RELEASE CC_FLAGS_COMMON "-O3 -D_FORTIFY_SOURCE=3 "
+#define CC_FLAGS_RELEASE                                                       \
+  CC_FLAGS_COMMON "-O3 -D_FORTIFY_SOURCE=3 "                                   \
+                  "-DOTTER_LOG_MIN_LEVEL=OTTER_LOG_LEVEL_INFO "
 #define LL_FLAGS_RELEASE LL_FLAGS_COMMON "-flto "
 
 #define CC_FLAGS_COVERAGE CC_FLAGS_DEBUG "-fprofile-arcs -ftest-coverage "
@@ -55,31 +57,50 @@
 
 /* Main build target dependencies */
 static const char *allocator_deps[] = {NULL};
+static const char *allocator_stats_deps[] = {"allocator", NULL};
+static const char *arena_deps[] = {"allocator", NULL};
+static const char *pool_deps[] = {"allocator", NULL};
+static const char *thread_cache_deps[] = {"allocator", NULL};
 static const char *string_deps[] = {"allocator", NULL};
+static const char *intern_deps[] = {"allocator", "arena", "string", NULL};
 static const char *array_deps[] = {"allocator", NULL};
+static const char *map_deps[] = {"allocator", NULL};
 static const char *cstring_deps[] = {"allocator", NULL};
 static const char *logger_deps[] = {"cstring", "array", "allocator", NULL};
-static const char *process_manager_deps[] = {"allocator", "logger", "string",
-                                             NULL};
+static const char *process_manager_deps[] = {"allocator", "array", "cstring",
+                                             "logger", "string", NULL};
 static const char *file_deps[] = {NULL};
 static const char *filesystem_deps[] = {"file", "allocator", NULL};
+static const char *filesystem_cache_deps[] = {"filesystem", "cstring", NULL};
+static const char *filesystem_uring_deps[] = {"filesystem", NULL};
 static const char *target_deps[] = {"allocator", "array",  "filesystem",
-                                    "logger",    "string", NULL};
+                                    "intern",    "logger", "map",
+                                    "string",    NULL};
 static const char *token_deps[] = {"allocator", NULL};
 static const char *node_deps[] = {"allocator", "array", NULL};
-static const char *lexer_deps[] = {"array", "cstring", NULL};
+static const char *lexer_deps[] = {"array", "cstring", "filesystem",
+                                   "intern", NULL};
 static const char *parser_deps[] = {"allocator", "logger", "node",
                                     "cstring",   "token",  NULL};
 static const char *bytecode_deps[] = {NULL};
-static const char *vm_deps[] = {"allocator", "logger", "bytecode", NULL};
+static const char *vm_deps[] = {"allocator", "pool", "logger", "bytecode",
+                                NULL};
 static const char *test_deps[] = {"allocator", NULL};
+static const char *bench_deps[] = {NULL};
 static const char *build_deps[] = {
-    "allocator", "filesystem", "logger", "process_manager",
-    "target",    "string",     NULL};
+    "allocator", "filesystem",      "filesystem_cache", "intern",
+    "logger",    "map",             "process_manager",  "target",
+    "string",    NULL};
+static const char *allocator_tests_deps[] = {
+    "test", "allocator_stats", "arena", "pool", "thread_cache", NULL};
 static const char *cstring_tests_deps[] = {"test", "cstring", NULL};
 static const char *string_tests_deps[] = {"test", "string", NULL};
+static const char *intern_tests_deps[] = {"test", "intern", NULL};
 static const char *array_tests_deps[] = {"test", "array", NULL};
-static const char *lexer_tests_deps[] = {"test", "lexer", "token", NULL};
+static const char *map_tests_deps[] = {"test", "map", NULL};
+static const char *logger_tests_deps[] = {"test", "logger", NULL};
+static const char *lexer_tests_deps[] = {"test", "lexer", "token",
+                                         "filesystem", NULL};
 static const char *parser_tests_deps[] = {"test", "cstring", "node", "parser",
                                           NULL};
 static const char *parser_integration_tests_deps[] = {"test", "lexer", "node",
@@ -96,21 +117,51 @@ static const char *target_tests_deps[] = {
 static const char *target_integration_tests_deps[] = {
     "test",   "target", "filesystem", "logger", "process_manager",
     "string", NULL};
+static const char *filesystem_tests_deps[] = {
+    "test", "filesystem", "filesystem_cache", "filesystem_uring", NULL};
+static const char *process_manager_tests_deps[] = {
+    "test", "process_manager", "logger", "string", NULL};
 /* All VM test files share the same dependencies */
 static const char *vm_tests_deps[] = {"test", "vm", "bytecode", "logger", NULL};
 static const char *otter_exe_deps[] = {"vm", NULL};
-static const char *test_driver_deps[] = {"allocator", NULL};
+static const char *test_driver_deps[] = {"allocator", "allocator_stats",
+                                         NULL};
+static const char *process_manager_bench_deps[] = {
+    "bench", "allocator", "logger", "process_manager", "string", NULL};
+static const char *filesystem_bench_deps[] = {"bench", "allocator",
+                                              "filesystem", "file", NULL};
+static const char *filesystem_metadata_bench_deps[] = {
+    "bench", "allocator", "filesystem", "filesystem_uring", "file", NULL};
+static const char *allocator_bench_deps[] = {"bench", "allocator", "arena",
+                                             "lexer", "token", NULL};
+static const char *allocator_thread_bench_deps[] = {"bench", "allocator",
+                                                    "thread_cache", NULL};
+static const char *string_bench_deps[] = {"bench", "allocator", "string",
+                                          NULL};
+static const char *map_bench_deps[] = {"bench", "allocator", "map", NULL};
+static const char *logger_bench_deps[] = {"bench", "allocator", "logger",
+                                          NULL};
 
 /* Target definitions for main build */
 static const otter_target_definition targets[] = {
     {"allocator", NULL, allocator_deps, NULL, OTTER_TARGET_OBJECT},
+    {"allocator_stats", NULL, allocator_stats_deps, NULL, OTTER_TARGET_OBJECT},
+    {"arena", NULL, arena_deps, NULL, OTTER_TARGET_OBJECT},
+    {"pool", NULL, pool_deps, NULL, OTTER_TARGET_OBJECT},
+    {"thread_cache", NULL, thread_cache_deps, NULL, OTTER_TARGET_OBJECT},
     {"string", NULL, string_deps, NULL, OTTER_TARGET_OBJECT},
+    {"intern", NULL, intern_deps, NULL, OTTER_TARGET_OBJECT},
     {"array", NULL, array_deps, NULL, OTTER_TARGET_OBJECT},
+    {"map", NULL, map_deps, NULL, OTTER_TARGET_OBJECT},
     {"cstring", NULL, cstring_deps, NULL, OTTER_TARGET_OBJECT},
     {"logger", NULL, logger_deps, NULL, OTTER_TARGET_OBJECT},
     {"process_manager", NULL, process_manager_deps, NULL, OTTER_TARGET_OBJECT},
     {"file", NULL, file_deps, NULL, OTTER_TARGET_OBJECT},
     {"filesystem", NULL, filesystem_deps, NULL, OTTER_TARGET_OBJECT},
+    {"filesystem_cache", NULL, filesystem_cache_deps, NULL,
+     OTTER_TARGET_OBJECT},
+    {"filesystem_uring", NULL, filesystem_uring_deps, NULL,
+     OTTER_TARGET_OBJECT},
     {"target", NULL, target_deps, NULL, OTTER_TARGET_OBJECT},
     {"build", NULL, build_deps, NULL, OTTER_TARGET_OBJECT},
     {"token", NULL, token_deps, NULL, OTTER_TARGET_OBJECT},
@@ -120,12 +171,31 @@ static const otter_target_definition targets[] = {
     {"bytecode", NULL, bytecode_deps, NULL, OTTER_TARGET_OBJECT},
     {"vm", NULL, vm_deps, NULL, OTTER_TARGET_OBJECT},
     {"test", NULL, test_deps, NULL, OTTER_TARGET_OBJECT},
+    {"bench", NULL, bench_deps, NULL, OTTER_TARGET_OBJECT},
     {"otter", NULL, otter_exe_deps, NULL, OTTER_TARGET_EXECUTABLE},
     {"test_driver", NULL, test_driver_deps, NULL, OTTER_TARGET_EXECUTABLE},
+    {"process_manager_bench", NULL, process_manager_bench_deps, NULL,
+     OTTER_TARGET_EXECUTABLE},
+    {"filesystem_bench", NULL, filesystem_bench_deps, NULL,
+     OTTER_TARGET_EXECUTABLE},
+    {"filesystem_metadata_bench", NULL, filesystem_metadata_bench_deps, NULL,
+     OTTER_TARGET_EXECUTABLE},
+    {"allocator_bench", NULL, allocator_bench_deps, NULL,
+     OTTER_TARGET_EXECUTABLE},
+    {"allocator_thread_bench", NULL, allocator_thread_bench_deps, NULL,
+     OTTER_TARGET_EXECUTABLE},
+    {"string_bench", NULL, string_bench_deps, NULL, OTTER_TARGET_EXECUTABLE},
+    {"map_bench", NULL, map_bench_deps, NULL, OTTER_TARGET_EXECUTABLE},
+    {"logger_bench", NULL, logger_bench_deps, NULL, OTTER_TARGET_EXECUTABLE},
+    {"allocator_tests", NULL, allocator_tests_deps, NULL,
+     OTTER_TARGET_SHARED_OBJECT},
     {"cstring_tests", NULL, cstring_tests_deps, NULL,
      OTTER_TARGET_SHARED_OBJECT},
     {"string_tests", NULL, string_tests_deps, NULL, OTTER_TARGET_SHARED_OBJECT},
+    {"intern_tests", NULL, intern_tests_deps, NULL, OTTER_TARGET_SHARED_OBJECT},
     {"array_tests", NULL, array_tests_deps, NULL, OTTER_TARGET_SHARED_OBJECT},
+    {"map_tests", NULL, map_tests_deps, NULL, OTTER_TARGET_SHARED_OBJECT},
+    {"logger_tests", NULL, logger_tests_deps, NULL, OTTER_TARGET_SHARED_OBJECT},
     {"lexer_tests", NULL, lexer_tests_deps, NULL, OTTER_TARGET_SHARED_OBJECT},
     {"parser_tests", NULL, parser_tests_deps, NULL, OTTER_TARGET_SHARED_OBJECT},
     {"parser_integration_tests", NULL, parser_integration_tests_deps, NULL,
@@ -140,6 +210,10 @@ static const otter_target_definition targets[] = {
      OTTER_TARGET_SHARED_OBJECT},
     {"target_integration_tests", NULL, target_integration_tests_deps,
      "-lgnutls", OTTER_TARGET_SHARED_OBJECT},
+    {"filesystem_tests", NULL, filesystem_tests_deps, NULL,
+     OTTER_TARGET_SHARED_OBJECT},
+    {"process_manager_tests", NULL, process_manager_tests_deps, NULL,
+     OTTER_TARGET_SHARED_OBJECT},
     {"vm_tests", NULL, vm_tests_deps, NULL, OTTER_TARGET_SHARED_OBJECT},
     {"vm_arithmetic_tests", NULL, vm_tests_deps, NULL,
      OTTER_TARGET_SHARED_OBJECT},
@@ -158,19 +232,26 @@ static bool build_bootstrap_make(otter_allocator *allocator,
   /* Bootstrap uses a subset of the main targets - just the dependencies
    * needed for otter_make itself */
   static const char *otter_make_deps[] = {
-      "allocator", "cstring",         "string", "array", "file", "filesystem",
-      "logger",    "process_manager", "target", "build", NULL};
+      "allocator",  "arena",           "cstring",          "string",
+      "intern",     "array",           "map",              "file",
+      "filesystem", "logger",          "process_manager",  "filesystem_cache",
+      "target",     "build",           NULL};
 
   static const otter_target_definition bootstrap_targets[] = {
       {"allocator", NULL, allocator_deps, NULL, OTTER_TARGET_OBJECT},
+      {"arena", NULL, arena_deps, NULL, OTTER_TARGET_OBJECT},
       {"string", NULL, string_deps, NULL, OTTER_TARGET_OBJECT},
+      {"intern", NULL, intern_deps, NULL, OTTER_TARGET_OBJECT},
       {"array", NULL, array_deps, NULL, OTTER_TARGET_OBJECT},
+      {"map", NULL, map_deps, NULL, OTTER_TARGET_OBJECT},
       {"cstring", NULL, cstring_deps, NULL, OTTER_TARGET_OBJECT},
       {"logger", NULL, logger_deps, NULL, OTTER_TARGET_OBJECT},
       {"process_manager", NULL, process_manager_deps, NULL,
        OTTER_TARGET_OBJECT},
       {"file", NULL, file_deps, NULL, OTTER_TARGET_OBJECT},
       {"filesystem", NULL, filesystem_deps, NULL, OTTER_TARGET_OBJECT},
+      {"filesystem_cache", NULL, filesystem_cache_deps, NULL,
+       OTTER_TARGET_OBJECT},
       {"target", NULL, target_deps, NULL, OTTER_TARGET_OBJECT},
       {"build", NULL, build_deps, NULL, OTTER_TARGET_OBJECT},
       {"otter_make", "make", otter_make_deps, "-lgnutls",
@@ -206,12 +287,7 @@ static bool build_bootstrap_make(otter_allocator *allocator,
     return false;
   }
 
-  if (otter_filesystem_exists(filesystem, "./otter_make")) {
-    if (!otter_filesystem_remove(filesystem, "./otter_make")) {
-      otter_log_error(logger, "Failed to delete otter_make");
-    }
-  }
-
+  /* The copy is renamed into place, so the running binary can be replaced */
   if (!otter_filesystem_copy(filesystem, "./release/otter_make",
                              "./otter_make")) {
     otter_log_error(logger, "Failed to copy otter_make to root directory");
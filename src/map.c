@@ -0,0 +1,94 @@
+/*
+  otter Copyright (C) 2026 Nathaniel Wright
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "otter/map.h"
+
+uint64_t otter_map_hash_cstr(const void *key) {
+  const char *str;
+  memcpy(&str, key, sizeof(str));
+
+  /* FNV-1a, mixed since its top bits alone make a poor tag */
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (const char *character = str; *character != '\0'; character++) {
+    hash ^= (unsigned char)*character;
+    hash *= 0x100000001b3ULL;
+  }
+  return otter_map_mix(hash);
+}
+
+bool otter_map_equal_cstr(const void *key1, const void *key2) {
+  const char *str1;
+  const char *str2;
+  memcpy(&str1, key1, sizeof(str1));
+  memcpy(&str2, key2, sizeof(str2));
+  return strcmp(str1, str2) == 0;
+}
+
+size_t otter_map_capacity_for(size_t length) {
+  size_t capacity = OTTER_MAP_MIN_CAPACITY;
+  while (length > capacity - capacity / 8) {
+    if (capacity > SIZE_MAX / 2) {
+      return SIZE_MAX;
+    }
+    capacity *= 2;
+  }
+  return capacity;
+}
+
+bool otter_map_rehash(otter_allocator *allocator, void **entries,
+                      uint8_t **control, size_t *capacity, size_t *tombstones,
+                      size_t entry_size, size_t new_capacity,
+                      otter_map_hash_fn hash) {
+  if (new_capacity < OTTER_MAP_MIN_CAPACITY ||
+      (new_capacity & (new_capacity - 1)) != 0 ||
+      new_capacity > SIZE_MAX / (entry_size + 1)) {
+    return false;
+  }
+
+  /* The control bytes follow the entries in the same allocation */
+  unsigned char *new_entries =
+      otter_malloc(allocator, (entry_size + 1) * new_capacity);
+  if (new_entries == NULL) {
+    return false;
+  }
+
+  uint8_t *new_control = new_entries + entry_size * new_capacity;
+  memset(new_control, OTTER_MAP_CONTROL_EMPTY, new_capacity);
+
+  const unsigned char *old_entries = *entries;
+  for (size_t i = 0; i < *capacity; i++) {
+    if (((*control)[i] & OTTER_MAP_CONTROL_FULL) == 0) {
+      continue;
+    }
+
+    const unsigned char *entry = &old_entries[i * entry_size];
+    const uint64_t entry_hash = hash(entry);
+    const size_t slot = otter_map_free_slot(new_control, new_capacity,
+                                            entry_hash);
+    new_control[slot] = otter_map_tag(entry_hash);
+    memcpy(&new_entries[slot * entry_size], entry, entry_size);
+  }
+
+  if (*entries != NULL) {
+    otter_free_sized(allocator, *entries, (entry_size + 1) * *capacity);
+  }
+
+  *entries = new_entries;
+  *control = new_control;
+  *capacity = new_capacity;
+  *tombstones = 0;
+  return true;
+}
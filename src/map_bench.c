@@ -0,0 +1,132 @@
+/*
+  otter Copyright (C) 2026 Nathaniel Wright
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "otter/allocator.h"
+#include "otter/bench.h"
+#include "otter/map.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Looks up every key of tables of 10, 100 and 10k target names, once by
+ * scanning an array with strcmp and once in an OTTER_MAP, and the same for
+ * pointer keys the way interned handles are compared. */
+
+#define OTTER_BENCH_LOOKUPS 2000000
+#define OTTER_BENCH_NAME_SIZE 48
+
+typedef struct {
+  OTTER_MAP_DECLARE(const char *, size_t, names);
+  OTTER_MAP_DECLARE(const void *, size_t, pointers);
+} bench_maps;
+
+static volatile size_t bench_sink;
+
+static void bench_size(otter_allocator *allocator, size_t count) {
+  char(*names)[OTTER_BENCH_NAME_SIZE] =
+      otter_malloc(allocator, sizeof(*names) * count);
+  const char **keys = otter_malloc(allocator, sizeof(*keys) * count);
+  if (names == NULL || keys == NULL) {
+    otter_free(allocator, (void *)names);
+    otter_free(allocator, (void *)keys);
+    return;
+  }
+
+  bench_maps maps;
+  OTTER_MAP_INIT(&maps, names);
+  OTTER_MAP_INIT(&maps, pointers);
+  for (size_t i = 0; i < count; i++) {
+    snprintf(names[i], sizeof(names[i]), "./debug/target_%zu.o", i);
+    keys[i] = names[i];
+    OTTER_MAP_INSERT(&maps, names, allocator, keys[i], i, otter_map_hash_cstr,
+                     otter_map_equal_cstr);
+    OTTER_MAP_INSERT(&maps, pointers, allocator, (const void *)keys[i], i,
+                     otter_map_hash_pointer, otter_map_equal_pointer);
+  }
+
+  /* Large tables are sampled, a full scan per lookup would take minutes */
+  const size_t lookups = count > 1000 ? OTTER_BENCH_LOOKUPS / 100
+                                      : OTTER_BENCH_LOOKUPS;
+  char label[64];
+
+  uint64_t start = otter_bench_now_ns();
+  for (size_t i = 0; i < lookups; i++) {
+    const char *key = keys[(i * 7919) % count];
+    for (size_t j = 0; j < count; j++) {
+      if (strcmp(names[j], key) == 0) {
+        bench_sink = j;
+        break;
+      }
+    }
+  }
+  snprintf(label, sizeof(label), "%zu names, linear strcmp scan", count);
+  otter_bench_report(label, lookups, otter_bench_now_ns() - start);
+
+  start = otter_bench_now_ns();
+  for (size_t i = 0; i < lookups; i++) {
+    const char *key = keys[(i * 7919) % count];
+    const size_t *index = OTTER_MAP_FIND(&maps, names, key,
+                                         otter_map_hash_cstr,
+                                         otter_map_equal_cstr);
+    bench_sink = index != NULL ? *index : 0;
+  }
+  snprintf(label, sizeof(label), "%zu names, OTTER_MAP", count);
+  otter_bench_report(label, lookups, otter_bench_now_ns() - start);
+
+  start = otter_bench_now_ns();
+  for (size_t i = 0; i < lookups; i++) {
+    const char *key = keys[(i * 7919) % count];
+    for (size_t j = 0; j < count; j++) {
+      if (keys[j] == key) {
+        bench_sink = j;
+        break;
+      }
+    }
+  }
+  snprintf(label, sizeof(label), "%zu handles, linear scan", count);
+  otter_bench_report(label, lookups, otter_bench_now_ns() - start);
+
+  start = otter_bench_now_ns();
+  for (size_t i = 0; i < lookups; i++) {
+    const void *key = keys[(i * 7919) % count];
+    const size_t *index = OTTER_MAP_FIND(&maps, pointers, key,
+                                         otter_map_hash_pointer,
+                                         otter_map_equal_pointer);
+    bench_sink = index != NULL ? *index : 0;
+  }
+  snprintf(label, sizeof(label), "%zu handles, OTTER_MAP", count);
+  otter_bench_report(label, lookups, otter_bench_now_ns() - start);
+
+  OTTER_MAP_FREE(&maps, names, allocator);
+  OTTER_MAP_FREE(&maps, pointers, allocator);
+  otter_free(allocator, (void *)keys);
+  otter_free(allocator, (void *)names);
+}
+
+int main(void) {
+  OTTER_CLEANUP(otter_allocator_free_p)
+  otter_allocator *allocator = otter_allocator_create();
+  if (allocator == NULL) {
+    return EXIT_FAILURE;
+  }
+
+  const size_t sizes[] = {10, 100, 10000};
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    bench_size(allocator, sizes[i]);
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,206 @@
+/*
+  otter Copyright (C) 2026 Nathaniel Wright
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "otter/map.h"
+#include "otter/test.h"
+#include <stdio.h>
+
+typedef struct {
+  OTTER_MAP_DECLARE(uint64_t, int, values);
+} integer_map;
+
+typedef struct {
+  OTTER_MAP_DECLARE(const char *, size_t, values);
+} name_map;
+
+typedef struct {
+  OTTER_SET_DECLARE(const void *, pointers);
+} pointer_set;
+
+OTTER_TEST(map_init_does_not_allocate) {
+  integer_map map;
+  OTTER_MAP_INIT(&map, values);
+
+  OTTER_ASSERT(OTTER_MAP_LENGTH(&map, values) == 0);
+  OTTER_ASSERT(OTTER_MAP_CAPACITY(&map, values) == 0);
+  OTTER_ASSERT(map.values == NULL);
+  OTTER_ASSERT(OTTER_MAP_FIND(&map, values, 1, otter_map_hash_u64,
+                              otter_map_equal_u64) == NULL);
+
+  OTTER_TEST_END(OTTER_MAP_FREE(&map, values, OTTER_TEST_ALLOCATOR););
+}
+
+OTTER_TEST(map_insert_grows_and_finds_every_key) {
+  integer_map map;
+  OTTER_MAP_INIT(&map, values);
+
+  const int count = 1000;
+  for (int i = 0; i < count; i++) {
+    OTTER_ASSERT(OTTER_MAP_INSERT(&map, values, OTTER_TEST_ALLOCATOR,
+                                  (uint64_t)i, i * 2, otter_map_hash_u64,
+                                  otter_map_equal_u64));
+    OTTER_ASSERT(OTTER_MAP_LENGTH(&map, values) == (size_t)(i + 1));
+  }
+
+  /* The maximum load is 7/8 */
+  OTTER_ASSERT(OTTER_MAP_CAPACITY(&map, values) == 2048);
+  for (int i = 0; i < count; i++) {
+    int *value = OTTER_MAP_FIND(&map, values, (uint64_t)i, otter_map_hash_u64,
+                                otter_map_equal_u64);
+    OTTER_ASSERT(value != NULL);
+    OTTER_ASSERT(*value == i * 2);
+  }
+
+  OTTER_ASSERT(!OTTER_MAP_CONTAINS(&map, values, (uint64_t)count,
+                                   otter_map_hash_u64, otter_map_equal_u64));
+
+  OTTER_TEST_END(OTTER_MAP_FREE(&map, values, OTTER_TEST_ALLOCATOR););
+}
+
+OTTER_TEST(map_insert_replaces_value) {
+  integer_map map;
+  OTTER_MAP_INIT(&map, values);
+
+  OTTER_ASSERT(OTTER_MAP_INSERT(&map, values, OTTER_TEST_ALLOCATOR, 7, 1,
+                                otter_map_hash_u64, otter_map_equal_u64));
+  OTTER_ASSERT(OTTER_MAP_INSERT(&map, values, OTTER_TEST_ALLOCATOR, 7, 2,
+                                otter_map_hash_u64, otter_map_equal_u64));
+  OTTER_ASSERT(OTTER_MAP_LENGTH(&map, values) == 1);
+  OTTER_ASSERT(*OTTER_MAP_FIND(&map, values, 7, otter_map_hash_u64,
+                               otter_map_equal_u64) == 2);
+
+  OTTER_TEST_END(OTTER_MAP_FREE(&map, values, OTTER_TEST_ALLOCATOR););
+}
+
+OTTER_TEST(map_remove_keeps_other_keys_reachable) {
+  integer_map map;
+  OTTER_MAP_INIT(&map, values);
+
+  const int count = 200;
+  for (int i = 0; i < count; i++) {
+    OTTER_ASSERT(OTTER_MAP_INSERT(&map, values, OTTER_TEST_ALLOCATOR,
+                                  (uint64_t)i, i, otter_map_hash_u64,
+                                  otter_map_equal_u64));
+  }
+
+  for (int i = 0; i < count; i += 2) {
+    OTTER_ASSERT(OTTER_MAP_REMOVE(&map, values, (uint64_t)i,
+                                  otter_map_hash_u64, otter_map_equal_u64));
+  }
+
+  OTTER_ASSERT(!OTTER_MAP_REMOVE(&map, values, (uint64_t)0,
+                                 otter_map_hash_u64, otter_map_equal_u64));
+  OTTER_ASSERT(OTTER_MAP_LENGTH(&map, values) == (size_t)count / 2);
+  for (int i = 0; i < count; i++) {
+    OTTER_ASSERT(OTTER_MAP_CONTAINS(&map, values, (uint64_t)i,
+                                    otter_map_hash_u64,
+                                    otter_map_equal_u64) == (i % 2 == 1));
+  }
+
+  /* Reinserting reuses the tombstones instead of growing */
+  const size_t capacity = OTTER_MAP_CAPACITY(&map, values);
+  for (int i = 0; i < count; i += 2) {
+    OTTER_ASSERT(OTTER_MAP_INSERT(&map, values, OTTER_TEST_ALLOCATOR,
+                                  (uint64_t)i, -i, otter_map_hash_u64,
+                                  otter_map_equal_u64));
+  }
+
+  OTTER_ASSERT(OTTER_MAP_LENGTH(&map, values) == (size_t)count);
+  OTTER_ASSERT(OTTER_MAP_CAPACITY(&map, values) == capacity);
+  OTTER_ASSERT(*OTTER_MAP_FIND(&map, values, (uint64_t)4, otter_map_hash_u64,
+                               otter_map_equal_u64) == -4);
+
+  OTTER_TEST_END(OTTER_MAP_FREE(&map, values, OTTER_TEST_ALLOCATOR););
+}
+
+OTTER_TEST(map_cstr_keys_compare_by_content) {
+  name_map map;
+  OTTER_MAP_INIT(&map, values);
+
+  char names[64][16];
+  for (size_t i = 0; i < 64; i++) {
+    snprintf(names[i], sizeof(names[i]), "target_%zu", i);
+    OTTER_ASSERT(OTTER_MAP_INSERT(&map, values, OTTER_TEST_ALLOCATOR,
+                                  names[i], i, otter_map_hash_cstr,
+                                  otter_map_equal_cstr));
+  }
+
+  char lookup[16];
+  snprintf(lookup, sizeof(lookup), "target_%d", 42);
+  size_t *value = OTTER_MAP_FIND(&map, values, lookup, otter_map_hash_cstr,
+                                 otter_map_equal_cstr);
+  OTTER_ASSERT(value != NULL);
+  OTTER_ASSERT(*value == 42);
+  OTTER_ASSERT(OTTER_MAP_FIND(&map, values, "target_64", otter_map_hash_cstr,
+                              otter_map_equal_cstr) == NULL);
+
+  OTTER_TEST_END(OTTER_MAP_FREE(&map, values, OTTER_TEST_ALLOCATOR););
+}
+
+static void count_entry(size_t *count, const void *entry) {
+  (void)entry;
+  (*count)++;
+}
+
+OTTER_TEST(set_insert_is_idempotent) {
+  pointer_set set;
+  OTTER_MAP_INIT(&set, pointers);
+
+  int objects[3];
+  for (size_t i = 0; i < 3; i++) {
+    OTTER_ASSERT(OTTER_SET_INSERT(&set, pointers, OTTER_TEST_ALLOCATOR,
+                                  &objects[i], otter_map_hash_pointer,
+                                  otter_map_equal_pointer));
+    OTTER_ASSERT(OTTER_SET_INSERT(&set, pointers, OTTER_TEST_ALLOCATOR,
+                                  &objects[i], otter_map_hash_pointer,
+                                  otter_map_equal_pointer));
+  }
+
+  OTTER_ASSERT(OTTER_MAP_LENGTH(&set, pointers) == 3);
+  OTTER_ASSERT(OTTER_MAP_CONTAINS(&set, pointers, &objects[1],
+                                  otter_map_hash_pointer,
+                                  otter_map_equal_pointer));
+
+  size_t visited = 0;
+  OTTER_MAP_FOREACH(&set, pointers, count_entry, &visited);
+  OTTER_ASSERT(visited == 3);
+
+  OTTER_TEST_END(OTTER_MAP_FREE(&set, pointers, OTTER_TEST_ALLOCATOR););
+}
+
+static void *malloc_mock(otter_allocator * /* unused */, size_t /*unused */) {
+  return NULL;
+}
+
+OTTER_TEST(map_insert_malloc_fails) {
+  otter_allocator_vtable vtable = {
+      .malloc = malloc_mock,
+      .realloc = NULL,
+      .free = NULL,
+  };
+  otter_allocator allocator = {
+      .vtable = &vtable,
+  };
+
+  integer_map map;
+  OTTER_MAP_INIT(&map, values);
+  OTTER_ASSERT(!OTTER_MAP_INSERT(&map, values, &allocator, 1, 1,
+                                 otter_map_hash_u64, otter_map_equal_u64));
+  OTTER_ASSERT(OTTER_MAP_LENGTH(&map, values) == 0);
+  OTTER_ASSERT(map.values == NULL);
+
+  OTTER_TEST_END();
+}
@@ -35,6 +35,7 @@ void otter_node_free(otter_allocator *allocator, otter_node *node) {
     otter_node_free(allocator, for_loop->condition);
     otter_node_free(allocator, for_loop->iteration);
     OTTER_ARRAY_FOREACH(for_loop, statements, otter_node_free, allocator);
+    OTTER_ARRAY_FREE(for_loop, statements, allocator);
   } break;
   case OTTER_NODE_EXPRESSION_MULTIPLY:
   case OTTER_NODE_EXPRESSION_ADD: {
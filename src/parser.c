@@ -306,8 +306,20 @@ static otter_node *otter_parser_parse_identifier(otter_parser *parser,
     return NULL;
   }
 
+  /* Interned names are shared with the token, the table outlives both */
   ident_node->base.type = OTTER_NODE_IDENTIFIER;
-  ident_node->value = otter_strdup(parser->allocator, ident->value);
+  ident_node->value = NULL;
+  ident_node->interned = ident->interned;
+  if (ident->interned == NULL) {
+    ident_node->value = otter_strdup(parser->allocator, ident->value);
+    if (ident_node->value == NULL) {
+      otter_log_critical(parser->logger, "Unable to copy identifier '%s'",
+                         ident->value);
+      otter_free(parser->allocator, ident_node);
+      return NULL;
+    }
+  }
+
   parser->tokens_index++;
   return (otter_node *)ident_node;
 }
@@ -816,6 +828,10 @@ static otter_node_for *otter_parser_parse_for_statement(otter_parser *parser) {
   }
 
   for_loop->base.type = OTTER_NODE_STATEMENT_FOR;
+  for_loop->assignment = NULL;
+  for_loop->condition = NULL;
+  for_loop->iteration = NULL;
+  OTTER_ARRAY_INIT(for_loop, statements, parser->allocator);
   otter_token *token = NEXT_TOKEN_OR_RETURN_NULL(parser);
   parser->tokens_index++;
   if (token->type != OTTER_TOKEN_FOR) {
@@ -936,9 +952,18 @@ otter_node **otter_parser_parse(otter_parser *parser, size_t *nodes_length) {
   }
 
   OTTER_RETURN_IF_NULL(parser->logger, nodes_length, NULL);
+  /* Top level statements end in a semicolon or a block, so the semicolons
+   * bound their number for all but block-only sources */
+  size_t statements = 1;
+  for (size_t i = 0; i < parser->tokens_length; i++) {
+    if (parser->tokens[i]->type == OTTER_TOKEN_SEMICOLON) {
+      statements++;
+    }
+  }
+
   otter_node_array result;
-  OTTER_ARRAY_INIT(&result, nodes, parser->allocator);
-  if (result.nodes == NULL) {
+  if (!OTTER_ARRAY_INIT_CAPACITY(&result, nodes, parser->allocator,
+                                 statements)) {
     return NULL;
   }
 
@@ -958,6 +983,6 @@ otter_node **otter_parser_parse(otter_parser *parser, size_t *nodes_length) {
 
 failure:
   OTTER_ARRAY_FOREACH(&result, nodes, otter_node_free, parser->allocator);
-  otter_free(parser->allocator, result.nodes);
+  OTTER_ARRAY_FREE(&result, nodes, parser->allocator);
   return NULL;
 }
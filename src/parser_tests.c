@@ -39,6 +39,7 @@ typedef struct token_array {
     OTTER_ASSERT(token != NULL);                                               \
     token->base.type = OTTER_TOKEN_IDENTIFIER;                                 \
     token->value = otter_strdup(allocator, ident);                             \
+    token->interned = NULL;                                                    \
     OTTER_ASSERT(token->value != NULL);                                        \
     (otter_token *)token;                                                      \
   })
@@ -427,7 +428,8 @@ OTTER_TEST(parse_assignment) {
   OTTER_ASSERT(statements_length == 1);
   OTTER_ASSERT(statements[0]->type == OTTER_NODE_STATEMENT_ASSIGNMENT);
   otter_node_assignment *assignment = (otter_node_assignment *)statements[0];
-  OTTER_ASSERT(0 == strcmp(assignment->variable->value, "foobar"));
+  OTTER_ASSERT(
+      0 == strcmp(otter_node_identifier_name(assignment->variable), "foobar"));
   OTTER_ASSERT(assignment->value_expr->type == OTTER_NODE_INTEGER);
   otter_node_integer *value = (otter_node_integer *)assignment->value_expr;
   OTTER_ASSERT(value->value == 2);
@@ -437,3 +439,47 @@ OTTER_TEST(parse_assignment) {
     otter_free(OTTER_TEST_ALLOCATOR, statements);
   });
 }
+
+OTTER_TEST(parse_assignment_keeps_interned_identifier) {
+  token_array tokens = {};
+  otter_node **statements = NULL;
+  OTTER_CLEANUP(otter_logger_free_p) otter_logger *logger = NULL;
+  OTTER_CLEANUP(otter_parser_free_p) otter_parser *parser = NULL;
+  static const otter_interned_string foobar = {.data = "foobar",
+                                               .length = 6};
+
+  OTTER_ARRAY_INIT(&tokens, value, OTTER_TEST_ALLOCATOR);
+  APPEND_BASIC_TOKEN(&tokens, OTTER_TOKEN_VAR);
+  otter_token_identifier *ident =
+      otter_malloc(OTTER_TEST_ALLOCATOR, sizeof(*ident));
+  OTTER_ASSERT(ident != NULL);
+  ident->base.type = OTTER_TOKEN_IDENTIFIER;
+  ident->value = NULL;
+  ident->interned = &foobar;
+  OTTER_ARRAY_APPEND(&tokens, value, OTTER_TEST_ALLOCATOR,
+                     (otter_token *)ident);
+  APPEND_BASIC_TOKEN(&tokens, OTTER_TOKEN_ASSIGNMENT);
+  APPEND_INTEGER(&tokens, 2);
+  APPEND_BASIC_TOKEN(&tokens, OTTER_TOKEN_SEMICOLON);
+
+  logger = create_logger(OTTER_TEST_ALLOCATOR);
+  parser = otter_parser_create(OTTER_TEST_ALLOCATOR, tokens.value,
+                               tokens.value_length, logger);
+
+  /* The node shares the token's handle instead of copying the name */
+  size_t statements_length = 0;
+  statements = otter_parser_parse(parser, &statements_length);
+  OTTER_ASSERT(statements != NULL);
+  OTTER_ASSERT(statements_length == 1);
+  OTTER_ASSERT(statements[0]->type == OTTER_NODE_STATEMENT_ASSIGNMENT);
+  otter_node_assignment *assignment = (otter_node_assignment *)statements[0];
+  OTTER_ASSERT(assignment->variable->interned == &foobar);
+  OTTER_ASSERT(assignment->variable->value == NULL);
+  OTTER_ASSERT(
+      0 == strcmp(otter_node_identifier_name(assignment->variable), "foobar"));
+
+  OTTER_TEST_END(if (statements != NULL) {
+    otter_node_free(OTTER_TEST_ALLOCATOR, statements[0]);
+    otter_free(OTTER_TEST_ALLOCATOR, statements);
+  });
+}
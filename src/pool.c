@@ -0,0 +1,343 @@
+/*
+  otter Copyright (C) 2026 Nathaniel Wright
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "otter/pool.h"
+#include <stdalign.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define OTTER_POOL_SLAB_SIZE ((size_t)64 * 1024)
+#define OTTER_POOL_GRANULARITY alignof(max_align_t)
+#define OTTER_POOL_CLASSES_LENGTH                                              \
+  (OTTER_POOL_MAX_BLOCK_SIZE / OTTER_POOL_GRANULARITY)
+
+typedef struct otter_pool_block otter_pool_block;
+struct otter_pool_block {
+  otter_pool_block *next;
+};
+
+typedef struct otter_pool_class {
+  otter_pool_block *free_list;
+  /* Unused tail of the newest slab of this class */
+  unsigned char *bump;
+  unsigned char *bump_end;
+} otter_pool_class;
+
+/* Requests too big for any class come from the parent with this in front,
+ * so the pool can release them along with its slabs */
+typedef struct otter_pool_large otter_pool_large;
+struct otter_pool_large {
+  otter_pool_large *previous;
+  otter_pool_large *next;
+  alignas(max_align_t) unsigned char data[];
+};
+
+typedef struct otter_pool_slab {
+  unsigned char *start;
+  size_t block_size;
+} otter_pool_slab;
+
+typedef struct otter_pool {
+  otter_allocator base;
+  otter_allocator *parent;
+  otter_pool_class classes[OTTER_POOL_CLASSES_LENGTH];
+  /* Sorted by start address so a pointer can be mapped back to its slab */
+  otter_pool_slab *slabs;
+  size_t slabs_length;
+  size_t slabs_capacity;
+  /* Every live allocation forwarded to the parent */
+  otter_pool_large *large;
+} otter_pool;
+
+static size_t otter_pool_class_index(size_t size) {
+  if (size == 0) {
+    size = 1;
+  }
+
+  return (size - 1) / OTTER_POOL_GRANULARITY;
+}
+
+static size_t otter_pool_class_size(size_t index) {
+  return (index + 1) * OTTER_POOL_GRANULARITY;
+}
+
+/* Returns the slab containing pointer or NULL if it came from the parent */
+static otter_pool_slab *otter_pool_find_slab(otter_pool *pool,
+                                             const void *pointer) {
+  const uintptr_t address = (uintptr_t)pointer;
+  size_t low = 0;
+  size_t high = pool->slabs_length;
+  while (low < high) {
+    const size_t middle = low + ((high - low) / 2);
+    if ((uintptr_t)pool->slabs[middle].start <= address) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+
+  if (low == 0) {
+    return NULL;
+  }
+
+  otter_pool_slab *slab = &pool->slabs[low - 1];
+  if (address - (uintptr_t)slab->start >= OTTER_POOL_SLAB_SIZE) {
+    return NULL;
+  }
+
+  return slab;
+}
+
+static otter_pool_large *otter_pool_large_from(void *pointer) {
+  void *large = (unsigned char *)pointer - offsetof(otter_pool_large, data);
+  return large;
+}
+
+static void otter_pool_large_link(otter_pool *pool, otter_pool_large *large) {
+  large->previous = NULL;
+  large->next = pool->large;
+  if (pool->large != NULL) {
+    pool->large->previous = large;
+  }
+  pool->large = large;
+}
+
+static void otter_pool_large_unlink(otter_pool *pool,
+                                    otter_pool_large *large) {
+  if (large->previous != NULL) {
+    large->previous->next = large->next;
+  } else {
+    pool->large = large->next;
+  }
+
+  if (large->next != NULL) {
+    large->next->previous = large->previous;
+  }
+}
+
+static void *otter_pool_large_malloc(otter_pool *pool, size_t size) {
+  if (size > SIZE_MAX - sizeof(otter_pool_large)) {
+    return NULL;
+  }
+
+  otter_pool_large *large =
+      otter_malloc(pool->parent, sizeof(otter_pool_large) + size);
+  if (large == NULL) {
+    return NULL;
+  }
+
+  otter_pool_large_link(pool, large);
+  return large->data;
+}
+
+static void *otter_pool_large_realloc(otter_pool *pool, void *pointer,
+                                      size_t size) {
+  if (size > SIZE_MAX - sizeof(otter_pool_large)) {
+    return NULL;
+  }
+
+  otter_pool_large *large = otter_pool_large_from(pointer);
+  otter_pool_large_unlink(pool, large);
+  otter_pool_large *resized =
+      otter_realloc(pool->parent, large, sizeof(otter_pool_large) + size);
+  if (resized == NULL) {
+    otter_pool_large_link(pool, large);
+    return NULL;
+  }
+
+  otter_pool_large_link(pool, resized);
+  return resized->data;
+}
+
+static bool otter_pool_add_slab(otter_pool *pool, size_t index) {
+  if (pool->slabs_length == pool->slabs_capacity) {
+    const size_t capacity =
+        pool->slabs_capacity == 0 ? 16 : pool->slabs_capacity * 2;
+    otter_pool_slab *slabs = otter_realloc(pool->parent, pool->slabs,
+                                           capacity * sizeof(*slabs));
+    if (slabs == NULL) {
+      return false;
+    }
+
+    pool->slabs = slabs;
+    pool->slabs_capacity = capacity;
+  }
+
+  unsigned char *start = otter_malloc(pool->parent, OTTER_POOL_SLAB_SIZE);
+  if (start == NULL) {
+    return false;
+  }
+
+  size_t position = pool->slabs_length;
+  while (position > 0 &&
+         (uintptr_t)pool->slabs[position - 1].start > (uintptr_t)start) {
+    pool->slabs[position] = pool->slabs[position - 1];
+    position--;
+  }
+
+  const size_t block_size = otter_pool_class_size(index);
+  pool->slabs[position] = (otter_pool_slab){
+      .start = start,
+      .block_size = block_size,
+  };
+  pool->slabs_length++;
+
+  otter_pool_class *size_class = &pool->classes[index];
+  size_class->bump = start;
+  size_class->bump_end =
+      start + (OTTER_POOL_SLAB_SIZE - (OTTER_POOL_SLAB_SIZE % block_size));
+  return true;
+}
+
+static void *otter_pool_malloc_impl(otter_allocator *allocator, size_t size) {
+  otter_pool *pool = (otter_pool *)allocator;
+  if (size > OTTER_POOL_MAX_BLOCK_SIZE) {
+    return otter_pool_large_malloc(pool, size);
+  }
+
+  const size_t index = otter_pool_class_index(size);
+  otter_pool_class *size_class = &pool->classes[index];
+  otter_pool_block *block = size_class->free_list;
+  if (block != NULL) {
+    size_class->free_list = block->next;
+    return block;
+  }
+
+  if (size_class->bump == size_class->bump_end &&
+      !otter_pool_add_slab(pool, index)) {
+    return NULL;
+  }
+
+  void *pointer = size_class->bump;
+  size_class->bump += otter_pool_class_size(index);
+  return pointer;
+}
+
+static void otter_pool_free_impl(otter_allocator *allocator, void *pointer) {
+  otter_pool *pool = (otter_pool *)allocator;
+  if (pointer == NULL) {
+    return;
+  }
+
+  otter_pool_slab *slab = otter_pool_find_slab(pool, pointer);
+  if (slab == NULL) {
+    otter_pool_large *large = otter_pool_large_from(pointer);
+    otter_pool_large_unlink(pool, large);
+    otter_free(pool->parent, large);
+    return;
+  }
+
+  otter_pool_class *size_class =
+      &pool->classes[otter_pool_class_index(slab->block_size)];
+  otter_pool_block *block = pointer;
+  block->next = size_class->free_list;
+  size_class->free_list = block;
+}
+
+static void otter_pool_free_sized_impl(otter_allocator *allocator,
+                                       void *pointer, size_t size) {
+  otter_pool *pool = (otter_pool *)allocator;
+  if (pointer == NULL) {
+    return;
+  }
+
+  if (size > OTTER_POOL_MAX_BLOCK_SIZE) {
+    otter_pool_large *large = otter_pool_large_from(pointer);
+    otter_pool_large_unlink(pool, large);
+    otter_free_sized(pool->parent, large, sizeof(otter_pool_large) + size);
+    return;
+  }
+
+  /* The size identifies the class, so there is no slab to look up */
+  otter_pool_class *size_class = &pool->classes[otter_pool_class_index(size)];
+  otter_pool_block *block = pointer;
+  block->next = size_class->free_list;
+  size_class->free_list = block;
+}
+
+static void *otter_pool_realloc_impl(otter_allocator *allocator, void *pointer,
+                                     size_t size) {
+  otter_pool *pool = (otter_pool *)allocator;
+  if (pointer == NULL) {
+    return otter_pool_malloc_impl(allocator, size);
+  }
+
+  otter_pool_slab *slab = otter_pool_find_slab(pool, pointer);
+  if (slab == NULL && size > OTTER_POOL_MAX_BLOCK_SIZE) {
+    return otter_pool_large_realloc(pool, pointer, size);
+  }
+
+  /* A parent allocation is larger than any class, so shrinking it into one
+   * copies the new size.  A block only stays put while the new size maps to
+   * the same class because sized frees derive the class from the size. */
+  const size_t old_size =
+      slab != NULL ? slab->block_size : OTTER_POOL_MAX_BLOCK_SIZE + 1;
+  if (slab != NULL && size != 0 &&
+      otter_pool_class_index(size) == otter_pool_class_index(old_size)) {
+    return pointer;
+  }
+
+  void *resized = otter_pool_malloc_impl(allocator, size);
+  if (resized == NULL) {
+    return NULL;
+  }
+
+  memcpy(resized, pointer, size < old_size ? size : old_size);
+  otter_pool_free_impl(allocator, pointer);
+  return resized;
+}
+
+static void otter_pool_free_allocator_impl(otter_allocator *allocator) {
+  otter_pool *pool = (otter_pool *)allocator;
+  for (size_t i = 0; i < pool->slabs_length; i++) {
+    otter_free(pool->parent, pool->slabs[i].start);
+  }
+
+  while (pool->large != NULL) {
+    otter_pool_large *next = pool->large->next;
+    otter_free(pool->parent, pool->large);
+    pool->large = next;
+  }
+
+  otter_free(pool->parent, pool->slabs);
+  otter_free(pool->parent, pool);
+}
+
+otter_allocator *otter_pool_create(otter_allocator *parent) {
+  if (parent == NULL) {
+    return NULL;
+  }
+
+  otter_pool *pool = otter_malloc(parent, sizeof(*pool));
+  if (pool == NULL) {
+    return NULL;
+  }
+
+  static otter_allocator_vtable vtable = {
+      .free_allocator = otter_pool_free_allocator_impl,
+      .malloc = otter_pool_malloc_impl,
+      .realloc = otter_pool_realloc_impl,
+      .free = otter_pool_free_impl,
+      .free_sized = otter_pool_free_sized_impl,
+  };
+
+  memset(pool, 0, sizeof(*pool));
+  pool->base.vtable = &vtable;
+  pool->parent = parent;
+  return (otter_allocator *)pool;
+}
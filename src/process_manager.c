@@ -16,23 +16,345 @@
  */
 
 #include "otter/process_manager.h"
+#include "otter/array.h"
+#include "otter/clock.h"
 #include "otter/cstring.h"
 
 #include <assert.h>
 #include <errno.h>
 #include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <unistd.h>
 
 extern char **environ;
 
+#define OTTER_MEBIBYTE ((size_t)1024 * 1024)
+#define OTTER_DEFAULT_COMPILE_WEIGHT (256 * OTTER_MEBIBYTE)
+#define OTTER_DEFAULT_LINK_WEIGHT (1024 * OTTER_MEBIBYTE)
+#define OTTER_RUSAGE_MAXRSS_UNIT 1024 /* ru_maxrss is reported in KiB */
+#define OTTER_DEFAULT_SEARCH_PATH "/bin:/usr/bin"
+
+typedef struct otter_process_job {
+  pid_t pid;
+  otter_process_job_class job_class;
+  size_t reserved_bytes;
+  otter_process_stats stats;
+  int status;
+  bool running;
+} otter_process_job;
+
+typedef struct otter_process_tool {
+  char *name;
+  char *path; /* NULL when the program could not be found */
+} otter_process_tool;
+
 typedef struct otter_process_manager_impl {
   otter_process_manager base;
   otter_allocator *allocator;
   otter_logger *logger;
+  otter_process_admission admission;
+  size_t reserved_bytes;
+  size_t running_count;
+  /* Only jobs that are running or have not been waited for, oldest first */
+  OTTER_ARRAY_DECLARE(otter_process_job, jobs);
+  /* A ring of the jobs waited for last, so their statistics can still be
+   * read without the table growing with every spawn */
+  otter_process_job finished[OTTER_PROCESS_MANAGER_FINISHED_JOBS];
+  size_t finished_count;
+  OTTER_ARRAY_DECLARE(otter_process_tool, tools);
 } otter_process_manager_impl;
 
+/* Reads the memory.max of the cgroup v2 hierarchy that this process belongs
+ * to.  Returns false when there is no limit or it cannot be determined. */
+static bool otter_process_manager_read_cgroup_memory_max(size_t *bytes) {
+  FILE *cgroup_file = fopen("/proc/self/cgroup", "r");
+  if (cgroup_file == NULL) {
+    return false;
+  }
+
+  char line[512];
+  char cgroup_path[512] = {0};
+  while (fgets(line, sizeof(line), cgroup_file) != NULL) {
+    /* The cgroup v2 entry always has the form "0::<path>" */
+    if (strncmp(line, "0::", 3) == 0) {
+      snprintf(cgroup_path, sizeof(cgroup_path), "%s", &line[3]);
+      cgroup_path[strcspn(cgroup_path, "\n")] = '\0';
+      break;
+    }
+  }
+  fclose(cgroup_file);
+
+  char memory_max_path[1024];
+  snprintf(memory_max_path, sizeof(memory_max_path),
+           "/sys/fs/cgroup%s/memory.max",
+           strcmp(cgroup_path, "/") == 0 ? "" : cgroup_path);
+  FILE *memory_max_file = fopen(memory_max_path, "r");
+  if (memory_max_file == NULL) {
+    return false;
+  }
+
+  char value[64] = {0};
+  const bool read = fgets(value, sizeof(value), memory_max_file) != NULL;
+  fclose(memory_max_file);
+  if (!read || strncmp(value, "max", 3) == 0) {
+    return false;
+  }
+
+  char *end = NULL;
+  const unsigned long long limit = strtoull(value, &end, 10);
+  if (end == value || limit == 0) {
+    return false;
+  }
+
+  *bytes = (size_t)limit;
+  return true;
+}
+
+static bool otter_process_manager_is_executable(const char *path) {
+  struct stat path_stat;
+  return access(path, X_OK) == 0 && stat(path, &path_stat) == 0 &&
+         S_ISREG(path_stat.st_mode);
+}
+
+/* Performs the same lookup as execvp would, but only once per program */
+static char *
+otter_process_manager_search_path(otter_process_manager_impl *process_manager,
+                                  const char *program) {
+  if (strchr(program, '/') != NULL) {
+    if (!otter_process_manager_is_executable(program)) {
+      return NULL;
+    }
+
+    return otter_strdup(process_manager->allocator, program);
+  }
+
+  const char *search_path = getenv("PATH");
+  if (search_path == NULL) {
+    search_path = OTTER_DEFAULT_SEARCH_PATH;
+  }
+
+  const size_t program_length = strlen(program);
+  const char *directory = search_path;
+  while (true) {
+    const char *separator = strchr(directory, ':');
+    const size_t directory_length = separator != NULL
+                                        ? (size_t)(separator - directory)
+                                        : strlen(directory);
+    /* An empty entry refers to the current working directory */
+    const char *prefix = directory_length == 0 ? "." : directory;
+    const size_t prefix_length = directory_length == 0 ? 1 : directory_length;
+
+    char *candidate = otter_malloc(process_manager->allocator,
+                                   prefix_length + 1 + program_length + 1);
+    if (candidate == NULL) {
+      otter_log_critical(process_manager->logger,
+                         "Failed to allocate path for '%s'", program);
+      return NULL;
+    }
+
+    memcpy(candidate, prefix, prefix_length);
+    candidate[prefix_length] = '/';
+    memcpy(&candidate[prefix_length + 1], program, program_length + 1);
+    if (otter_process_manager_is_executable(candidate)) {
+      return candidate;
+    }
+
+    otter_free(process_manager->allocator, candidate);
+    if (separator == NULL) {
+      return NULL;
+    }
+
+    directory = separator + 1;
+  }
+}
+
+static const char *
+otter_process_manager_resolve_impl(otter_process_manager *process_manager_,
+                                   const char *program) {
+  otter_process_manager_impl *process_manager =
+      (otter_process_manager_impl *)process_manager_;
+  for (size_t i = 0; i < OTTER_ARRAY_LENGTH(process_manager, tools); i++) {
+    otter_process_tool *tool =
+        &OTTER_ARRAY_AT_UNSAFE(process_manager, tools, i);
+    if (strcmp(tool->name, program) == 0) {
+      return tool->path;
+    }
+  }
+
+  otter_process_tool tool = {
+      .name = otter_strdup(process_manager->allocator, program),
+      .path = otter_process_manager_search_path(process_manager, program),
+  };
+  if (tool.name == NULL ||
+      !OTTER_ARRAY_APPEND(process_manager, tools, process_manager->allocator,
+                          tool)) {
+    otter_log_critical(process_manager->logger,
+                       "Failed to cache path for '%s'", program);
+    otter_free(process_manager->allocator, tool.name);
+    otter_free(process_manager->allocator, tool.path);
+    return NULL;
+  }
+
+  /* Logged once here, later lookups answer from the cache quietly */
+  if (tool.path != NULL) {
+    otter_log_debug(process_manager->logger, "Resolved '%s' to '%s'", program,
+                    tool.path);
+  } else {
+    otter_log_error(process_manager->logger,
+                    "%s is not installed or not in PATH", program);
+  }
+
+  return tool.path;
+}
+
+static otter_process_job *
+otter_process_manager_find_job(otter_process_manager_impl *process_manager,
+                               pid_t pid) {
+  /* Search newest first so that a recycled pid resolves to its latest job */
+  for (size_t i = OTTER_ARRAY_LENGTH(process_manager, jobs); i > 0; i--) {
+    otter_process_job *job =
+        &OTTER_ARRAY_AT_UNSAFE(process_manager, jobs, i - 1);
+    if (job->pid == pid) {
+      return job;
+    }
+  }
+
+  const size_t finished_length =
+      process_manager->finished_count < OTTER_PROCESS_MANAGER_FINISHED_JOBS
+          ? process_manager->finished_count
+          : OTTER_PROCESS_MANAGER_FINISHED_JOBS;
+  for (size_t i = 0; i < finished_length; i++) {
+    otter_process_job *job =
+        &process_manager->finished[(process_manager->finished_count - 1 - i) %
+                                   OTTER_PROCESS_MANAGER_FINISHED_JOBS];
+    if (job->pid == pid) {
+      return job;
+    }
+  }
+
+  return NULL;
+}
+
+/* Moves a job whose status was handed out from the table to the ring of
+ * finished jobs */
+static void
+otter_process_manager_retire_job(otter_process_manager_impl *process_manager,
+                                 otter_process_job *job) {
+  const size_t length = OTTER_ARRAY_LENGTH(process_manager, jobs);
+  if (job < process_manager->jobs || job >= process_manager->jobs + length) {
+    /* Already retired, the same id was waited for twice */
+    return;
+  }
+
+  process_manager->finished[process_manager->finished_count++ %
+                            OTTER_PROCESS_MANAGER_FINISHED_JOBS] = *job;
+  const size_t index = (size_t)(job - process_manager->jobs);
+  memmove(job, job + 1, sizeof(*job) * (length - index - 1));
+  OTTER_ARRAY_LENGTH(process_manager, jobs)--;
+}
+
+/* Blocks until the given job exits and records its status and peak RSS.  The
+ * observed peak is folded into the weight of the job's class so that later
+ * admission decisions use realistic numbers. */
+static bool
+otter_process_manager_reap_job(otter_process_manager_impl *process_manager,
+                               otter_process_job *job) {
+  struct rusage usage;
+  int status;
+  if (wait4(job->pid, &status, 0, &usage) == -1) {
+    otter_log_error(process_manager->logger,
+                    "Failed to wait for process %d: %s", job->pid,
+                    strerror(errno));
+    job->status = -1;
+  } else {
+    job->status = status;
+    job->stats.user_ns = otter_clock_timeval_ns(&usage.ru_utime);
+    job->stats.system_ns = otter_clock_timeval_ns(&usage.ru_stime);
+    job->stats.peak_rss = (size_t)usage.ru_maxrss * OTTER_RUSAGE_MAXRSS_UNIT;
+  }
+
+  job->stats.finished_ns = otter_clock_now_ns();
+
+  job->running = false;
+  process_manager->running_count--;
+  process_manager->reserved_bytes -= job->reserved_bytes;
+
+  const size_t peak_rss = job->stats.peak_rss;
+  if (peak_rss > 0) {
+    size_t *weight = &process_manager->admission.weights[job->job_class];
+    if (peak_rss > *weight) {
+      *weight = peak_rss;
+    } else {
+      *weight = ((*weight * 3) + peak_rss) / 4;
+    }
+
+    otter_log_debug(process_manager->logger,
+                    "Process %d peaked at %zu bytes, class estimate is now %zu",
+                    job->pid, peak_rss, *weight);
+  }
+
+  return job->status != -1;
+}
+
+static bool
+otter_process_manager_can_admit(otter_process_manager_impl *process_manager,
+                                size_t reserve_bytes) {
+  /* Something has to make progress, so an idle manager always admits */
+  if (process_manager->running_count == 0) {
+    return true;
+  }
+
+  const otter_process_admission *admission = &process_manager->admission;
+  if (admission->memory_budget != 0 &&
+      process_manager->reserved_bytes + reserve_bytes >
+          admission->memory_budget) {
+    otter_log_debug(process_manager->logger,
+                    "Deferring spawn: %zu bytes reserved, %zu requested, "
+                    "budget is %zu",
+                    process_manager->reserved_bytes, reserve_bytes,
+                    admission->memory_budget);
+    return false;
+  }
+
+  if (admission->max_load_average > 0) {
+    double load;
+    if (getloadavg(&load, 1) == 1 && load > admission->max_load_average) {
+      otter_log_debug(process_manager->logger,
+                      "Deferring spawn: load average %.2f exceeds %.2f", load,
+                      admission->max_load_average);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/* Waits for the oldest running jobs until a job of the given size fits */
+static void
+otter_process_manager_admit(otter_process_manager_impl *process_manager,
+                            size_t reserve_bytes) {
+  size_t next = 0;
+  while (!otter_process_manager_can_admit(process_manager, reserve_bytes)) {
+    while (next < OTTER_ARRAY_LENGTH(process_manager, jobs) &&
+           !OTTER_ARRAY_AT_UNSAFE(process_manager, jobs, next).running) {
+      next++;
+    }
+
+    if (next >= OTTER_ARRAY_LENGTH(process_manager, jobs)) {
+      return;
+    }
+
+    otter_process_manager_reap_job(
+        process_manager, &OTTER_ARRAY_AT_UNSAFE(process_manager, jobs, next));
+  }
+}
+
 static void
 otter_process_manager_free_impl(otter_process_manager *process_manager_) {
   if (process_manager_ == NULL) {
@@ -41,12 +363,29 @@ otter_process_manager_free_impl(otter_process_manager *process_manager_) {
 
   otter_process_manager_impl *process_manager =
       (otter_process_manager_impl *)process_manager_;
+  for (size_t i = 0; i < OTTER_ARRAY_LENGTH(process_manager, jobs); i++) {
+    otter_process_job *job = &OTTER_ARRAY_AT_UNSAFE(process_manager, jobs, i);
+    if (job->running) {
+      otter_process_manager_reap_job(process_manager, job);
+    }
+  }
+
+  for (size_t i = 0; i < OTTER_ARRAY_LENGTH(process_manager, tools); i++) {
+    otter_process_tool *tool =
+        &OTTER_ARRAY_AT_UNSAFE(process_manager, tools, i);
+    otter_free(process_manager->allocator, tool->name);
+    otter_free(process_manager->allocator, tool->path);
+  }
+
+  OTTER_ARRAY_FREE(process_manager, tools, process_manager->allocator);
+  OTTER_ARRAY_FREE(process_manager, jobs, process_manager->allocator);
   otter_free(process_manager->allocator, process_manager);
 }
 
 static otter_process_id
 otter_process_manager_queue_impl(otter_process_manager *process_manager_,
-                                 otter_string *command) {
+                                 otter_string *command,
+                                 otter_process_job_class job_class) {
   otter_process_manager_impl *process_manager =
       (otter_process_manager_impl *)process_manager_;
   otter_process_id error_id = {.value = -1};
@@ -58,27 +397,52 @@ otter_process_manager_queue_impl(otter_process_manager *process_manager_,
     goto cleanup;
   }
 
+  const uint64_t queued_ns = otter_clock_now_ns();
   const char *delims = " \t\n";
-  argv = otter_string_split_cstr(process_manager->allocator, command, delims);
+  /* A single allocation holds argv and the characters it points to */
+  size_t argc = 0;
+  argv = otter_string_split_packed(process_manager->allocator,
+                                   otter_string_view_of(command), delims,
+                                   &argc);
   if (argv == NULL) {
     otter_log_error(process_manager->logger, "Failed to split command: '%s'",
                     otter_string_cstr(command));
     goto cleanup;
   }
 
-  size_t argc = 0;
-  while (argv[argc] != NULL) {
-    argc++;
-  }
-
   if (argc == 0) {
     otter_log_error(process_manager->logger, "Command is empty: '%s'",
                     otter_string_cstr(command));
     goto cleanup;
   }
 
+  if (job_class >= OTTER_PROCESS_JOB_CLASS_COUNT_) {
+    otter_log_error(process_manager->logger, "Invalid job class %d",
+                    (int)job_class);
+    goto cleanup;
+  }
+
+  const char *program_path =
+      otter_process_manager_resolve_impl(process_manager_, argv[0]);
+  if (program_path == NULL) {
+    otter_log_error(process_manager->logger,
+                    "Failed to spawn process for command '%s': '%s' was not "
+                    "found in PATH",
+                    otter_string_cstr(command), argv[0]);
+    goto cleanup;
+  }
+
+  const size_t reserve_bytes = process_manager->admission.weights[job_class];
+  otter_process_manager_admit(process_manager, reserve_bytes);
+
+  /* posix_spawn with an already resolved path avoids the PATH walk that
+   * posix_spawnp repeats for every job.  glibc implements it with
+   * clone(CLONE_VM | CLONE_VFORK), so the page tables are not copied. */
   pid_t pid;
-  int spawn_result = posix_spawnp(&pid, argv[0], NULL, NULL, argv, environ);
+  const uint64_t spawn_start_ns = otter_clock_now_ns();
+  int spawn_result =
+      posix_spawn(&pid, program_path, NULL, NULL, argv, environ);
+  const uint64_t started_ns = otter_clock_now_ns();
 
   if (spawn_result != 0) {
     otter_log_error(process_manager->logger,
@@ -87,6 +451,35 @@ otter_process_manager_queue_impl(otter_process_manager *process_manager_,
     goto cleanup;
   }
 
+  otter_process_job job = {
+      .pid = pid,
+      .job_class = job_class,
+      .reserved_bytes = reserve_bytes,
+      .stats =
+          {
+              .queued_ns = queued_ns,
+              .started_ns = started_ns,
+              .finished_ns = 0,
+              .queue_wait_ns = spawn_start_ns - queued_ns,
+              .spawn_ns = started_ns - spawn_start_ns,
+              .user_ns = 0,
+              .system_ns = 0,
+              .peak_rss = 0,
+          },
+      .status = -1,
+      .running = true,
+  };
+  if (!OTTER_ARRAY_APPEND(process_manager, jobs, process_manager->allocator,
+                          job)) {
+    otter_log_critical(process_manager->logger,
+                       "Failed to track process %d, waiting for it now", pid);
+    int status;
+    waitpid(pid, &status, 0);
+    goto cleanup;
+  }
+
+  process_manager->running_count++;
+  process_manager->reserved_bytes += reserve_bytes;
   otter_log_debug(process_manager->logger,
                   "Queued process %d for command: '%s'", pid,
                   otter_string_cstr(command));
@@ -96,10 +489,7 @@ otter_process_manager_queue_impl(otter_process_manager *process_manager_,
 
 cleanup:
   if (argv != NULL) {
-    for (size_t i = 0; argv[i] != NULL; i++) {
-      otter_free(process_manager->allocator, argv[i]);
-    }
-    otter_free(process_manager->allocator, argv);
+    otter_free(process_manager->allocator, (void *)argv);
   }
 
   return result;
@@ -130,19 +520,29 @@ otter_process_manager_wait_impl(otter_process_manager *process_manager_,
     pid_t pid;
     memcpy(&pid, &ids[i].value, sizeof(pid));
 
-    int status;
     otter_log_debug(process_manager->logger, "Waiting for process %d", pid);
-
-    if (waitpid(pid, &status, 0) == -1) {
+    otter_process_job *job =
+        otter_process_manager_find_job(process_manager, pid);
+    if (job == NULL) {
       otter_log_error(process_manager->logger,
-                      "Failed to wait for process %d: %s", pid,
-                      strerror(errno));
+                      "Process %d was not queued by this process manager",
+                      pid);
       if (exit_statuses != NULL) {
         exit_statuses[i] = -1;
       }
       continue;
     }
 
+    if (job->running &&
+        !otter_process_manager_reap_job(process_manager, job)) {
+      if (exit_statuses != NULL) {
+        exit_statuses[i] = -1;
+      }
+      otter_process_manager_retire_job(process_manager, job);
+      continue;
+    }
+
+    const int status = job->status;
     /* Store the full wait status if array provided */
     if (exit_statuses != NULL) {
       exit_statuses[i] = status;
@@ -165,13 +565,70 @@ otter_process_manager_wait_impl(otter_process_manager *process_manager_,
       otter_log_error(process_manager->logger, "Process %d exited abnormally",
                       pid);
     }
+
+    otter_process_manager_retire_job(process_manager, job);
+  }
+}
+
+static void otter_process_manager_set_admission_impl(
+    otter_process_manager *process_manager_,
+    const otter_process_admission *admission) {
+  otter_process_manager_impl *process_manager =
+      (otter_process_manager_impl *)process_manager_;
+  process_manager->admission = *admission;
+}
+
+static void otter_process_manager_get_admission_impl(
+    otter_process_manager *process_manager_,
+    otter_process_admission *admission) {
+  otter_process_manager_impl *process_manager =
+      (otter_process_manager_impl *)process_manager_;
+  *admission = process_manager->admission;
+}
+
+static size_t
+otter_process_manager_peak_rss_impl(otter_process_manager *process_manager_,
+                                    otter_process_id id) {
+  otter_process_manager_impl *process_manager =
+      (otter_process_manager_impl *)process_manager_;
+  pid_t pid;
+  memcpy(&pid, &id.value, sizeof(pid));
+  otter_process_job *job =
+      otter_process_manager_find_job(process_manager, pid);
+  if (job == NULL) {
+    return 0;
   }
+
+  return job->stats.peak_rss;
+}
+
+static bool
+otter_process_manager_stats_impl(otter_process_manager *process_manager_,
+                                 otter_process_id id,
+                                 otter_process_stats *stats) {
+  otter_process_manager_impl *process_manager =
+      (otter_process_manager_impl *)process_manager_;
+  pid_t pid;
+  memcpy(&pid, &id.value, sizeof(pid));
+  otter_process_job *job =
+      otter_process_manager_find_job(process_manager, pid);
+  if (job == NULL || job->running) {
+    return false;
+  }
+
+  *stats = job->stats;
+  return true;
 }
 
 static otter_process_manager_vtable vtable = {
     .process_manager_free = otter_process_manager_free_impl,
     .process_manager_queue = otter_process_manager_queue_impl,
     .process_manager_wait = otter_process_manager_wait_impl,
+    .process_manager_set_admission = otter_process_manager_set_admission_impl,
+    .process_manager_get_admission = otter_process_manager_get_admission_impl,
+    .process_manager_peak_rss = otter_process_manager_peak_rss_impl,
+    .process_manager_resolve = otter_process_manager_resolve_impl,
+    .process_manager_stats = otter_process_manager_stats_impl,
 };
 
 otter_process_manager *otter_process_manager_create(otter_allocator *allocator,
@@ -190,6 +647,23 @@ otter_process_manager *otter_process_manager_create(otter_allocator *allocator,
   process_manager->base.vtable = &vtable;
   process_manager->allocator = allocator;
   process_manager->logger = logger;
+  process_manager->reserved_bytes = 0;
+  process_manager->running_count = 0;
+  process_manager->admission.weights[OTTER_PROCESS_JOB_CLASS_COMPILE] =
+      OTTER_DEFAULT_COMPILE_WEIGHT;
+  process_manager->admission.weights[OTTER_PROCESS_JOB_CLASS_LINK] =
+      OTTER_DEFAULT_LINK_WEIGHT;
+  process_manager->admission.memory_budget = 0;
+  process_manager->admission.max_load_average = 0;
+  if (otter_process_manager_read_cgroup_memory_max(
+          &process_manager->admission.memory_budget)) {
+    otter_log_debug(logger, "Using cgroup memory budget of %zu bytes",
+                    process_manager->admission.memory_budget);
+  }
+
+  OTTER_ARRAY_INIT(process_manager, jobs, allocator);
+  process_manager->finished_count = 0;
+  OTTER_ARRAY_INIT(process_manager, tools, allocator);
 
   return (otter_process_manager *)process_manager;
 }
@@ -214,8 +688,22 @@ otter_process_manager_queue(otter_process_manager *process_manager,
     return error_id;
   }
 
+  return process_manager->vtable->process_manager_queue(
+      process_manager, command, OTTER_PROCESS_JOB_CLASS_COMPILE);
+}
+
+otter_process_id
+otter_process_manager_queue_job(otter_process_manager *process_manager,
+                                otter_string *command,
+                                otter_process_job_class job_class) {
+  otter_process_id error_id = {.value = -1};
+
+  if (process_manager == NULL || process_manager->vtable == NULL) {
+    return error_id;
+  }
+
   return process_manager->vtable->process_manager_queue(process_manager,
-                                                        command);
+                                                        command, job_class);
 }
 
 void otter_process_manager_wait(otter_process_manager *process_manager,
@@ -228,3 +716,61 @@ void otter_process_manager_wait(otter_process_manager *process_manager,
   process_manager->vtable->process_manager_wait(process_manager, ids,
                                                 ids_length, exit_statuses);
 }
+
+void otter_process_manager_set_admission(
+    otter_process_manager *process_manager,
+    const otter_process_admission *admission) {
+  if (process_manager == NULL || process_manager->vtable == NULL ||
+      admission == NULL) {
+    return;
+  }
+
+  process_manager->vtable->process_manager_set_admission(process_manager,
+                                                         admission);
+}
+
+void otter_process_manager_get_admission(
+    otter_process_manager *process_manager,
+    otter_process_admission *admission) {
+  if (process_manager == NULL || process_manager->vtable == NULL ||
+      admission == NULL) {
+    return;
+  }
+
+  process_manager->vtable->process_manager_get_admission(process_manager,
+                                                         admission);
+}
+
+size_t otter_process_manager_peak_rss(otter_process_manager *process_manager,
+                                      otter_process_id id) {
+  if (process_manager == NULL || process_manager->vtable == NULL) {
+    return 0;
+  }
+
+  return process_manager->vtable->process_manager_peak_rss(process_manager,
+                                                           id);
+}
+
+bool otter_process_manager_stats(otter_process_manager *process_manager,
+                                 otter_process_id id,
+                                 otter_process_stats *stats) {
+  if (process_manager == NULL || process_manager->vtable == NULL ||
+      stats == NULL) {
+    return false;
+  }
+
+  return process_manager->vtable->process_manager_stats(process_manager, id,
+                                                        stats);
+}
+
+const char *
+otter_process_manager_resolve(otter_process_manager *process_manager,
+                              const char *program) {
+  if (process_manager == NULL || process_manager->vtable == NULL ||
+      program == NULL) {
+    return NULL;
+  }
+
+  return process_manager->vtable->process_manager_resolve(process_manager,
+                                                          program);
+}
@@ -0,0 +1,142 @@
+/*
+  otter Copyright (C) 2026 Nathaniel Wright
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "otter/allocator.h"
+#include "otter/bench.h"
+#include "otter/logger.h"
+#include "otter/process_manager.h"
+#include "otter/string.h"
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+
+/* Measures how many /bin/true processes can be spawned and reaped per second.
+ * The raw posix_spawnp loop is the baseline the process manager is compared
+ * against. */
+
+extern char **environ;
+
+#define OTTER_BENCH_DEFAULT_SPAWNS 1000
+#define OTTER_BENCH_BATCH_SIZE 16
+
+static void bench_posix_spawnp(size_t spawns) {
+  char *const argv[] = {"true", NULL};
+  size_t completed = 0;
+  const uint64_t start = otter_bench_now_ns();
+  for (size_t i = 0; i < spawns; i++) {
+    pid_t pid;
+    if (posix_spawnp(&pid, "true", NULL, NULL, argv, environ) != 0) {
+      break;
+    }
+
+    int status;
+    waitpid(pid, &status, 0);
+    completed++;
+  }
+
+  otter_bench_report("posix_spawnp true", completed,
+                     otter_bench_now_ns() - start);
+}
+
+static void bench_process_manager(otter_process_manager *process_manager,
+                                  otter_string *command, size_t spawns) {
+  size_t completed = 0;
+  const uint64_t start = otter_bench_now_ns();
+  for (size_t i = 0; i < spawns; i++) {
+    otter_process_id id = otter_process_manager_queue(process_manager, command);
+    if (id.value < 0) {
+      break;
+    }
+
+    otter_process_manager_wait(process_manager, &id, 1, NULL);
+    completed++;
+  }
+
+  otter_bench_report("process manager true", completed,
+                     otter_bench_now_ns() - start);
+}
+
+static void
+bench_process_manager_batched(otter_process_manager *process_manager,
+                              otter_string *command, size_t spawns) {
+  otter_process_id ids[OTTER_BENCH_BATCH_SIZE];
+  size_t completed = 0;
+  const uint64_t start = otter_bench_now_ns();
+  while (completed < spawns) {
+    size_t queued = 0;
+    while (queued < OTTER_BENCH_BATCH_SIZE && completed + queued < spawns) {
+      ids[queued] = otter_process_manager_queue(process_manager, command);
+      if (ids[queued].value < 0) {
+        break;
+      }
+      queued++;
+    }
+
+    otter_process_manager_wait(process_manager, ids, queued, NULL);
+    completed += queued;
+    if (queued < OTTER_BENCH_BATCH_SIZE && completed < spawns) {
+      break;
+    }
+  }
+
+  otter_bench_report("process manager true (batches of 16)", completed,
+                     otter_bench_now_ns() - start);
+}
+
+int main(int argc, char *argv[]) {
+  size_t spawns = OTTER_BENCH_DEFAULT_SPAWNS;
+  if (argc > 1) {
+    spawns = strtoul(argv[1], NULL, 10);
+  }
+
+  OTTER_CLEANUP(otter_allocator_free_p)
+  otter_allocator *allocator = otter_allocator_create();
+  if (allocator == NULL) {
+    return EXIT_FAILURE;
+  }
+
+  OTTER_CLEANUP(otter_logger_free_p)
+  otter_logger *logger = otter_logger_create(allocator, OTTER_LOG_LEVEL_ERROR);
+  if (logger == NULL) {
+    return EXIT_FAILURE;
+  }
+
+  OTTER_CLEANUP(otter_process_manager_free_p)
+  otter_process_manager *process_manager =
+      otter_process_manager_create(allocator, logger);
+  if (process_manager == NULL) {
+    return EXIT_FAILURE;
+  }
+
+  /* Admission would otherwise serialize the batches on small machines */
+  otter_process_admission admission;
+  otter_process_manager_get_admission(process_manager, &admission);
+  admission.memory_budget = 0;
+  admission.max_load_average = 0;
+  otter_process_manager_set_admission(process_manager, &admission);
+
+  OTTER_CLEANUP(otter_string_free_p)
+  otter_string *command = otter_string_from_cstr(allocator, "true");
+  if (command == NULL) {
+    return EXIT_FAILURE;
+  }
+
+  bench_posix_spawnp(spawns);
+  bench_process_manager(process_manager, command, spawns);
+  bench_process_manager_batched(process_manager, command, spawns);
+  return EXIT_SUCCESS;
+}
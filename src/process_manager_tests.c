@@ -0,0 +1,239 @@
+/*
+  otter Copyright (C) 2026 Nathaniel Wright
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "otter/logger.h"
+#include "otter/process_manager.h"
+#include "otter/string.h"
+#include "otter/test.h"
+#include <string.h>
+#include <sys/wait.h>
+
+OTTER_TEST(process_manager_queue_and_wait_reports_exit_status) {
+  otter_logger *logger = NULL;
+  otter_process_manager *proc_mgr = NULL;
+  otter_string *command = NULL;
+
+  logger = otter_logger_create(OTTER_TEST_ALLOCATOR, OTTER_LOG_LEVEL_ERROR);
+  OTTER_ASSERT(logger != NULL);
+
+  proc_mgr = otter_process_manager_create(OTTER_TEST_ALLOCATOR, logger);
+  OTTER_ASSERT(proc_mgr != NULL);
+
+  command = otter_string_from_cstr(OTTER_TEST_ALLOCATOR, "false");
+  OTTER_ASSERT(command != NULL);
+
+  otter_process_id id = otter_process_manager_queue(proc_mgr, command);
+  OTTER_ASSERT(id.value > 0);
+
+  int status = 0;
+  otter_process_manager_wait(proc_mgr, &id, 1, &status);
+  OTTER_ASSERT(WIFEXITED(status));
+  OTTER_ASSERT(WEXITSTATUS(status) == 1);
+
+  OTTER_TEST_END(if (command) otter_string_free(command);
+                 if (proc_mgr) otter_process_manager_free(proc_mgr);
+                 if (logger) otter_logger_free(logger););
+}
+
+OTTER_TEST(process_manager_records_peak_rss) {
+  otter_logger *logger = NULL;
+  otter_process_manager *proc_mgr = NULL;
+  otter_string *command = NULL;
+
+  logger = otter_logger_create(OTTER_TEST_ALLOCATOR, OTTER_LOG_LEVEL_ERROR);
+  OTTER_ASSERT(logger != NULL);
+
+  proc_mgr = otter_process_manager_create(OTTER_TEST_ALLOCATOR, logger);
+  OTTER_ASSERT(proc_mgr != NULL);
+
+  command = otter_string_from_cstr(OTTER_TEST_ALLOCATOR, "true");
+  OTTER_ASSERT(command != NULL);
+
+  otter_process_id id = otter_process_manager_queue_job(
+      proc_mgr, command, OTTER_PROCESS_JOB_CLASS_LINK);
+  OTTER_ASSERT(id.value > 0);
+  OTTER_ASSERT(otter_process_manager_peak_rss(proc_mgr, id) == 0);
+
+  int status = -1;
+  otter_process_manager_wait(proc_mgr, &id, 1, &status);
+  OTTER_ASSERT(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  OTTER_ASSERT(otter_process_manager_peak_rss(proc_mgr, id) > 0);
+
+  OTTER_TEST_END(if (command) otter_string_free(command);
+                 if (proc_mgr) otter_process_manager_free(proc_mgr);
+                 if (logger) otter_logger_free(logger););
+}
+
+OTTER_TEST(process_manager_defers_spawn_over_memory_budget) {
+  otter_logger *logger = NULL;
+  otter_process_manager *proc_mgr = NULL;
+  otter_string *command = NULL;
+
+  logger = otter_logger_create(OTTER_TEST_ALLOCATOR, OTTER_LOG_LEVEL_ERROR);
+  OTTER_ASSERT(logger != NULL);
+
+  proc_mgr = otter_process_manager_create(OTTER_TEST_ALLOCATOR, logger);
+  OTTER_ASSERT(proc_mgr != NULL);
+
+  /* Only one compile fits into the budget at a time */
+  otter_process_admission admission = {
+      .weights = {[OTTER_PROCESS_JOB_CLASS_COMPILE] = 100,
+                  [OTTER_PROCESS_JOB_CLASS_LINK] = 100},
+      .memory_budget = 150,
+      .max_load_average = 0,
+  };
+  otter_process_manager_set_admission(proc_mgr, &admission);
+
+  command = otter_string_from_cstr(OTTER_TEST_ALLOCATOR, "true");
+  OTTER_ASSERT(command != NULL);
+
+  otter_process_id ids[2];
+  ids[0] = otter_process_manager_queue(proc_mgr, command);
+  OTTER_ASSERT(ids[0].value > 0);
+
+  /* The first job has to be reaped before the second is admitted */
+  ids[1] = otter_process_manager_queue(proc_mgr, command);
+  OTTER_ASSERT(ids[1].value > 0);
+  OTTER_ASSERT(otter_process_manager_peak_rss(proc_mgr, ids[0]) > 0);
+
+  int statuses[2] = {-1, -1};
+  otter_process_manager_wait(proc_mgr, ids, 2, statuses);
+  OTTER_ASSERT(WIFEXITED(statuses[0]) && WEXITSTATUS(statuses[0]) == 0);
+  OTTER_ASSERT(WIFEXITED(statuses[1]) && WEXITSTATUS(statuses[1]) == 0);
+
+  OTTER_TEST_END(if (command) otter_string_free(command);
+                 if (proc_mgr) otter_process_manager_free(proc_mgr);
+                 if (logger) otter_logger_free(logger););
+}
+
+OTTER_TEST(process_manager_updates_class_weight_from_peak_rss) {
+  otter_logger *logger = NULL;
+  otter_process_manager *proc_mgr = NULL;
+  otter_string *command = NULL;
+
+  logger = otter_logger_create(OTTER_TEST_ALLOCATOR, OTTER_LOG_LEVEL_ERROR);
+  OTTER_ASSERT(logger != NULL);
+
+  proc_mgr = otter_process_manager_create(OTTER_TEST_ALLOCATOR, logger);
+  OTTER_ASSERT(proc_mgr != NULL);
+
+  otter_process_admission admission;
+  otter_process_manager_get_admission(proc_mgr, &admission);
+  admission.weights[OTTER_PROCESS_JOB_CLASS_LINK] = 1;
+  const size_t compile_weight =
+      admission.weights[OTTER_PROCESS_JOB_CLASS_COMPILE];
+  otter_process_manager_set_admission(proc_mgr, &admission);
+
+  command = otter_string_from_cstr(OTTER_TEST_ALLOCATOR, "true");
+  OTTER_ASSERT(command != NULL);
+
+  otter_process_id id = otter_process_manager_queue_job(
+      proc_mgr, command, OTTER_PROCESS_JOB_CLASS_LINK);
+  OTTER_ASSERT(id.value > 0);
+  otter_process_manager_wait(proc_mgr, &id, 1, NULL);
+
+  otter_process_manager_get_admission(proc_mgr, &admission);
+  OTTER_ASSERT(admission.weights[OTTER_PROCESS_JOB_CLASS_LINK] ==
+               otter_process_manager_peak_rss(proc_mgr, id));
+  OTTER_ASSERT(admission.weights[OTTER_PROCESS_JOB_CLASS_COMPILE] ==
+               compile_weight);
+
+  OTTER_TEST_END(if (command) otter_string_free(command);
+                 if (proc_mgr) otter_process_manager_free(proc_mgr);
+                 if (logger) otter_logger_free(logger););
+}
+
+static int missing_tool_errors = 0;
+static void count_missing_tool_errors(otter_log_level /* unused */,
+                                      time_t /* unused */,
+                                      const char *message) {
+  if (strstr(message, "not installed") != NULL) {
+    missing_tool_errors++;
+  }
+}
+
+OTTER_TEST(process_manager_resolve_caches_absolute_path) {
+  otter_logger *logger = NULL;
+  otter_process_manager *proc_mgr = NULL;
+
+  logger = otter_logger_create(OTTER_TEST_ALLOCATOR, OTTER_LOG_LEVEL_ERROR);
+  OTTER_ASSERT(logger != NULL);
+  missing_tool_errors = 0;
+  otter_logger_add_sink(logger, count_missing_tool_errors);
+
+  proc_mgr = otter_process_manager_create(OTTER_TEST_ALLOCATOR, logger);
+  OTTER_ASSERT(proc_mgr != NULL);
+
+  const char *path = otter_process_manager_resolve(proc_mgr, "true");
+  OTTER_ASSERT(path != NULL);
+  OTTER_ASSERT(path[0] == '/');
+  OTTER_ASSERT(otter_process_manager_resolve(proc_mgr, "true") == path);
+
+  /* A missing program is reported once and then cached */
+  OTTER_ASSERT(otter_process_manager_resolve(
+                   proc_mgr, "otter-program-that-does-not-exist") == NULL);
+  OTTER_ASSERT(otter_process_manager_resolve(
+                   proc_mgr, "otter-program-that-does-not-exist") == NULL);
+  OTTER_ASSERT(missing_tool_errors == 1);
+
+  otter_string *command = otter_string_from_cstr(
+      OTTER_TEST_ALLOCATOR, "otter-program-that-does-not-exist");
+  OTTER_ASSERT(command != NULL);
+  otter_process_id id = otter_process_manager_queue(proc_mgr, command);
+  otter_string_free(command);
+  OTTER_ASSERT(id.value < 0);
+
+  OTTER_TEST_END(if (proc_mgr) otter_process_manager_free(proc_mgr);
+                 if (logger) otter_logger_free(logger););
+}
+
+OTTER_TEST(process_manager_forgets_old_waited_jobs) {
+  otter_logger *logger = NULL;
+  otter_process_manager *proc_mgr = NULL;
+  otter_string *command = NULL;
+
+  logger = otter_logger_create(OTTER_TEST_ALLOCATOR, OTTER_LOG_LEVEL_ERROR);
+  OTTER_ASSERT(logger != NULL);
+
+  proc_mgr = otter_process_manager_create(OTTER_TEST_ALLOCATOR, logger);
+  OTTER_ASSERT(proc_mgr != NULL);
+
+  command = otter_string_from_cstr(OTTER_TEST_ALLOCATOR, "true");
+  OTTER_ASSERT(command != NULL);
+
+  otter_process_id first = {.value = -1};
+  otter_process_id last = {.value = -1};
+  for (size_t i = 0; i <= OTTER_PROCESS_MANAGER_FINISHED_JOBS; i++) {
+    last = otter_process_manager_queue(proc_mgr, command);
+    OTTER_ASSERT(last.value > 0);
+    if (i == 0) {
+      first = last;
+    }
+
+    int status = -1;
+    otter_process_manager_wait(proc_mgr, &last, 1, &status);
+    OTTER_ASSERT(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  }
+
+  otter_process_stats stats;
+  OTTER_ASSERT(otter_process_manager_stats(proc_mgr, last, &stats));
+  OTTER_ASSERT(stats.finished_ns >= stats.started_ns);
+  OTTER_ASSERT(!otter_process_manager_stats(proc_mgr, first, &stats));
+
+  OTTER_TEST_END(if (command) otter_string_free(command);
+                 if (proc_mgr) otter_process_manager_free(proc_mgr);
+                 if (logger) otter_logger_free(logger););
+}
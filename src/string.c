@@ -17,6 +17,7 @@
 #include "otter/string.h"
 #include <assert.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -29,11 +30,18 @@ typedef struct otter_string {
 
 #define FUDGE_FACTOR 16
 static otter_string *otter_string_expand(otter_string *str, size_t capacity) {
-  if (capacity < str->size) {
+  if (capacity < str->size ||
+      capacity > SIZE_MAX - sizeof(*str) - FUDGE_FACTOR) {
     return NULL;
   }
 
+  /* Grow at least geometrically, so repeated appends are amortized O(1)
+   * instead of reallocating for almost every one of them */
   size_t new_capacity = capacity + FUDGE_FACTOR;
+  if (str->capacity <= (SIZE_MAX - sizeof(*str)) / 2 &&
+      new_capacity < str->capacity * 2) {
+    new_capacity = str->capacity * 2;
+  }
 
   void *result =
       otter_realloc(str->allocator, str, sizeof(*str) + new_capacity);
@@ -96,7 +104,7 @@ otter_string *otter_string_format(otter_allocator *allocator,
   const int result = vsnprintf(str->data, size_needed, format, args_copy);
   va_end(args_copy);
   if (result < 0) {
-    otter_free(allocator, str);
+    otter_free_sized(allocator, str, sizeof(*str) + size_needed);
     return NULL;
   }
 
@@ -126,7 +134,7 @@ void otter_string_free(otter_string *str) {
   if (str == NULL) {
     return;
   }
-  otter_free(str->allocator, str);
+  otter_free_sized(str->allocator, str, sizeof(*str) + str->capacity);
 }
 OTTER_DEFINE_TRIVIAL_CLEANUP_FUNC(otter_string *, otter_string_free);
 size_t otter_string_capacity(const otter_string *str) { return str->capacity; }
@@ -224,6 +232,76 @@ int otter_string_compare_cstr(const otter_string *str, const char *cstr) {
   return strcmp(str->data, cstr);
 }
 
+static void otter_string_delimiters_init(otter_string_delimiters *set,
+                                         const char *delimiters) {
+  for (size_t i = 0; i < sizeof(set->bits) / sizeof(set->bits[0]); i++) {
+    set->bits[i] = 0;
+  }
+
+  for (const char *delimiter = delimiters; *delimiter != '\0'; delimiter++) {
+    const unsigned char byte = (unsigned char)*delimiter;
+    set->bits[byte >> 6] |= (uint64_t)1 << (byte & 63);
+  }
+}
+
+static inline bool
+otter_string_is_delimiter(const otter_string_delimiters *set, char character) {
+  const unsigned char byte = (unsigned char)character;
+  return (set->bits[byte >> 6] >> (byte & 63)) & 1;
+}
+
+void otter_string_split_iterator_init(otter_string_split_iterator *iterator,
+                                      otter_string_view str,
+                                      const char *delimiters) {
+  iterator->position = str.data;
+  iterator->end = str.data != NULL ? str.data + str.length : NULL;
+  otter_string_delimiters_init(&iterator->delimiters,
+                               delimiters != NULL ? delimiters : "");
+}
+
+bool otter_string_split_next(otter_string_split_iterator *iterator,
+                             otter_string_view *token) {
+  const char *position = iterator->position;
+  const char *end = iterator->end;
+  while (position < end &&
+         otter_string_is_delimiter(&iterator->delimiters, *position)) {
+    position++;
+  }
+
+  if (position == end) {
+    iterator->position = position;
+    return false;
+  }
+
+  const char *begin = position;
+  while (position < end &&
+         !otter_string_is_delimiter(&iterator->delimiters, *position)) {
+    position++;
+  }
+
+  iterator->position = position;
+  token->data = begin;
+  token->length = (size_t)(position - begin);
+  return true;
+}
+
+/* Counts the tokens and the bytes they need including their terminators */
+static size_t otter_string_split_count(otter_string_view str,
+                                       const char *delimiters,
+                                       size_t *bytes) {
+  otter_string_split_iterator iterator;
+  otter_string_split_iterator_init(&iterator, str, delimiters);
+  otter_string_view token;
+  size_t count = 0;
+  *bytes = 0;
+  while (otter_string_split_next(&iterator, &token)) {
+    count++;
+    *bytes += token.length + 1;
+  }
+
+  return count;
+}
+
 otter_string **otter_string_split(otter_allocator *allocator,
                                   const otter_string *str,
                                   const char *delimiters) {
@@ -231,51 +309,35 @@ otter_string **otter_string_split(otter_allocator *allocator,
     return NULL;
   }
 
-  /* Create a working copy for tokenization */
-  const char *cstr = otter_string_cstr(str);
-  char *working_copy = otter_malloc(allocator, str->size);
-  if (working_copy == NULL) {
-    return NULL;
-  }
-  memcpy(working_copy, cstr, str->size);
-
-  /* Count tokens first */
-  size_t token_count = 0;
-  char *token = strtok(working_copy, delimiters);
-  while (token != NULL) {
-    token_count++;
-    token = strtok(NULL, delimiters);
-  }
+  size_t bytes;
+  const otter_string_view view = otter_string_view_of(str);
+  const size_t token_count = otter_string_split_count(view, delimiters, &bytes);
 
   /* Allocate result array (NULL-terminated) */
   otter_string **result =
       otter_malloc(allocator, (token_count + 1) * sizeof(otter_string *));
   if (result == NULL) {
-    otter_free(allocator, working_copy);
     return NULL;
   }
 
-  /* Reset working copy and tokenize again */
-  memcpy(working_copy, cstr, str->size);
+  otter_string_split_iterator iterator;
+  otter_string_split_iterator_init(&iterator, view, delimiters);
+  otter_string_view token;
   size_t index = 0;
-  token = strtok(working_copy, delimiters);
-  while (token != NULL) {
-    result[index] = otter_string_from_cstr(allocator, token);
+  while (otter_string_split_next(&iterator, &token)) {
+    result[index] = otter_string_from_view(allocator, token);
     if (result[index] == NULL) {
       /* Cleanup on failure */
       for (size_t i = 0; i < index; i++) {
         otter_string_free(result[i]);
       }
       otter_free(allocator, result);
-      otter_free(allocator, working_copy);
       return NULL;
     }
     index++;
-    token = strtok(NULL, delimiters);
   }
   result[token_count] = NULL;
 
-  otter_free(allocator, working_copy);
   return result;
 }
 
@@ -286,51 +348,306 @@ char **otter_string_split_cstr(otter_allocator *allocator,
     return NULL;
   }
 
-  /* Create a working copy for tokenization */
-  const char *cstr = otter_string_cstr(str);
-  char *working_copy = otter_malloc(allocator, str->size);
-  if (working_copy == NULL) {
-    return NULL;
-  }
-  memcpy(working_copy, cstr, str->size);
-
-  /* Count tokens first */
-  size_t token_count = 0;
-  char *token = strtok(working_copy, delimiters);
-  while (token != NULL) {
-    token_count++;
-    token = strtok(NULL, delimiters);
-  }
+  size_t bytes;
+  const otter_string_view view = otter_string_view_of(str);
+  const size_t token_count = otter_string_split_count(view, delimiters, &bytes);
 
   /* Allocate result array (NULL-terminated) */
   char **result = otter_malloc(allocator, (token_count + 1) * sizeof(char *));
   if (result == NULL) {
-    otter_free(allocator, working_copy);
     return NULL;
   }
 
-  /* Reset working copy and tokenize again */
-  memcpy(working_copy, cstr, str->size);
+  otter_string_split_iterator iterator;
+  otter_string_split_iterator_init(&iterator, view, delimiters);
+  otter_string_view token;
   size_t index = 0;
-  token = strtok(working_copy, delimiters);
-  while (token != NULL) {
-    size_t token_len = strlen(token);
-    result[index] = otter_malloc(allocator, token_len + 1);
+  while (otter_string_split_next(&iterator, &token)) {
+    result[index] = otter_malloc(allocator, token.length + 1);
     if (result[index] == NULL) {
       /* Cleanup on failure */
       for (size_t i = 0; i < index; i++) {
         otter_free(allocator, result[i]);
       }
       otter_free(allocator, result);
-      otter_free(allocator, working_copy);
       return NULL;
     }
-    memcpy(result[index], token, token_len + 1);
+    memcpy(result[index], token.data, token.length);
+    result[index][token.length] = '\0';
     index++;
-    token = strtok(NULL, delimiters);
   }
   result[token_count] = NULL;
 
-  otter_free(allocator, working_copy);
   return result;
 }
+
+char **otter_string_split_packed(otter_allocator *allocator,
+                                 otter_string_view str, const char *delimiters,
+                                 size_t *count) {
+  if (allocator == NULL || str.data == NULL || delimiters == NULL) {
+    return NULL;
+  }
+
+  size_t bytes;
+  const size_t token_count = otter_string_split_count(str, delimiters, &bytes);
+
+  /* The pointers come first so they stay aligned, the characters follow */
+  const size_t pointers_size = (token_count + 1) * sizeof(char *);
+  char **result = otter_malloc(allocator, pointers_size + bytes);
+  if (result == NULL) {
+    return NULL;
+  }
+
+  char *characters = (char *)&result[token_count + 1];
+  otter_string_split_iterator iterator;
+  otter_string_split_iterator_init(&iterator, str, delimiters);
+  otter_string_view token;
+  size_t index = 0;
+  while (otter_string_split_next(&iterator, &token)) {
+    memcpy(characters, token.data, token.length);
+    characters[token.length] = '\0';
+    result[index++] = characters;
+    characters += token.length + 1;
+  }
+  result[token_count] = NULL;
+
+  if (count != NULL) {
+    *count = token_count;
+  }
+  return result;
+}
+
+otter_string_view otter_string_view_from_cstr(const char *str) {
+  if (str == NULL) {
+    return (otter_string_view){.data = NULL, .length = 0};
+  }
+  return (otter_string_view){.data = str, .length = strlen(str)};
+}
+
+otter_string_view otter_string_view_of(const otter_string *str) {
+  if (str == NULL) {
+    return (otter_string_view){.data = NULL, .length = 0};
+  }
+  return (otter_string_view){.data = str->data,
+                             .length = otter_string_length(str)};
+}
+
+otter_string *otter_string_from_view(otter_allocator *allocator,
+                                     otter_string_view view) {
+  if (allocator == NULL || view.data == NULL) {
+    return NULL;
+  }
+
+  /* Views may point into the middle of a larger buffer so the length can't
+   * be checked against strlen like otter_string_create does */
+  otter_string *str = otter_malloc(allocator, sizeof(*str) + view.length + 1);
+  if (str == NULL) {
+    return NULL;
+  }
+
+  str->allocator = allocator;
+  str->size = view.length + 1;
+  str->capacity = view.length + 1;
+  memcpy(str->data, view.data, view.length);
+  str->data[view.length] = '\0';
+  return str;
+}
+
+int otter_string_compare_view(const otter_string *str,
+                              otter_string_view view) {
+  if (str == NULL && view.data == NULL) {
+    return 0;
+  }
+  if (str == NULL) {
+    return -1;
+  }
+  if (view.data == NULL) {
+    return 1;
+  }
+
+  const size_t length = otter_string_length(str);
+  const int result =
+      memcmp(str->data, view.data, length < view.length ? length : view.length);
+  if (result != 0 || length == view.length) {
+    return result;
+  }
+  return length < view.length ? -1 : 1;
+}
+
+#define OTTER_STRING_BUILDER_MIN_CAPACITY 64
+void otter_string_builder_init(otter_string_builder *builder,
+                               otter_allocator *allocator) {
+  builder->allocator = allocator;
+  builder->str = NULL;
+  builder->failed = allocator == NULL;
+}
+
+bool otter_string_builder_reserve(otter_string_builder *builder,
+                                  size_t length) {
+  if (builder == NULL || builder->failed) {
+    return false;
+  }
+
+  otter_string *str = builder->str;
+  if (str == NULL) {
+    if (length > SIZE_MAX - sizeof(*str) - 1) {
+      builder->failed = true;
+      return false;
+    }
+
+    size_t capacity = length + 1;
+    if (capacity < OTTER_STRING_BUILDER_MIN_CAPACITY) {
+      capacity = OTTER_STRING_BUILDER_MIN_CAPACITY;
+    }
+
+    str = otter_malloc(builder->allocator, sizeof(*str) + capacity);
+    if (str == NULL) {
+      builder->failed = true;
+      return false;
+    }
+
+    str->allocator = builder->allocator;
+    str->size = 1;
+    str->capacity = capacity;
+    str->data[0] = '\0';
+    builder->str = str;
+    return true;
+  }
+
+  if (length > SIZE_MAX - str->size) {
+    builder->failed = true;
+    return false;
+  }
+
+  if (str->size + length <= str->capacity) {
+    return true;
+  }
+
+  otter_string *expanded = otter_string_expand(str, str->size + length);
+  if (expanded == NULL) {
+    builder->failed = true;
+    return false;
+  }
+
+  builder->str = expanded;
+  return true;
+}
+
+bool otter_string_builder_append(otter_string_builder *builder,
+                                 const char *append, size_t length) {
+  if (builder == NULL) {
+    return false;
+  }
+
+  if (append == NULL) {
+    builder->failed = true;
+    return false;
+  }
+
+  if (!otter_string_builder_reserve(builder, length)) {
+    return false;
+  }
+
+  otter_string *str = builder->str;
+  const size_t offset = str->size - 1;
+  str->size += length;
+  memcpy(&str->data[offset], append, length);
+  str->data[str->size - 1] = '\0';
+  return true;
+}
+
+bool otter_string_builder_append_cstr(otter_string_builder *builder,
+                                      const char *append) {
+  if (append == NULL) {
+    return otter_string_builder_append(builder, NULL, 0);
+  }
+  return otter_string_builder_append(builder, append, strlen(append));
+}
+
+bool otter_string_builder_append_view(otter_string_builder *builder,
+                                      otter_string_view append) {
+  return otter_string_builder_append(builder, append.data, append.length);
+}
+
+bool otter_string_builder_append_fmt(otter_string_builder *builder,
+                                     const char *format, ...) {
+  if (builder == NULL) {
+    return false;
+  }
+
+  if (format == NULL) {
+    builder->failed = true;
+    return false;
+  }
+
+  if (!otter_string_builder_reserve(builder, 0)) {
+    return false;
+  }
+
+  /* Try the spare capacity first and only format a second time, after
+   * growing, when the result did not fit */
+  va_list args;
+  va_list args_copy;
+  va_start(args, format);
+  va_copy(args_copy, args);
+  otter_string *str = builder->str;
+  const size_t offset = str->size - 1;
+  const size_t spare = str->capacity - offset;
+  const int needed = vsnprintf(&str->data[offset], spare, format, args);
+  va_end(args);
+  if (needed < 0) {
+    va_end(args_copy);
+    str->data[offset] = '\0';
+    builder->failed = true;
+    return false;
+  }
+
+  if ((size_t)needed >= spare) {
+    if (!otter_string_builder_reserve(builder, (size_t)needed)) {
+      va_end(args_copy);
+      builder->str->data[offset] = '\0';
+      return false;
+    }
+
+    str = builder->str;
+    vsnprintf(&str->data[offset], (size_t)needed + 1, format, args_copy);
+  }
+
+  va_end(args_copy);
+  str->size += (size_t)needed;
+  return true;
+}
+
+size_t otter_string_builder_length(const otter_string_builder *builder) {
+  if (builder == NULL) {
+    return 0;
+  }
+  return otter_string_length(builder->str);
+}
+
+otter_string *otter_string_builder_finish(otter_string_builder *builder) {
+  if (builder == NULL) {
+    return NULL;
+  }
+
+  /* An empty builder still produces an empty string */
+  otter_string_builder_reserve(builder, 0);
+  if (builder->failed) {
+    otter_string_builder_free(builder);
+    return NULL;
+  }
+
+  otter_string *str = builder->str;
+  builder->str = NULL;
+  return str;
+}
+
+void otter_string_builder_free(otter_string_builder *builder) {
+  if (builder == NULL) {
+    return;
+  }
+
+  otter_string_free(builder->str);
+  builder->str = NULL;
+  builder->failed = builder->allocator == NULL;
+}
@@ -0,0 +1,155 @@
+/*
+  otter Copyright (C) 2026 Nathaniel Wright
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "otter/allocator.h"
+#include "otter/bench.h"
+#include "otter/string.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Builds a link line with 10k object files the way generated commands are
+ * built: one append per argument.  The first run grows a buffer to exactly
+ * the length needed, as otter_string_append used to, for comparison. */
+
+#define OTTER_BENCH_ITERATIONS 50
+#define OTTER_BENCH_ARGUMENTS 10000
+#define OTTER_BENCH_ARGUMENT_SIZE 32
+
+static char bench_arguments[OTTER_BENCH_ARGUMENTS][OTTER_BENCH_ARGUMENT_SIZE];
+
+static bool bench_exact_growth(otter_allocator *allocator) {
+  char *line = NULL;
+  size_t length = 0;
+  for (size_t i = 0; i < OTTER_BENCH_ARGUMENTS; i++) {
+    const size_t argument_length = strlen(bench_arguments[i]);
+    char *grown = otter_realloc(allocator, line, length + argument_length + 2);
+    if (grown == NULL) {
+      otter_free(allocator, line);
+      return false;
+    }
+
+    line = grown;
+    line[length++] = ' ';
+    memcpy(&line[length], bench_arguments[i], argument_length + 1);
+    length += argument_length;
+  }
+
+  otter_free(allocator, line);
+  return true;
+}
+
+static bool bench_string_append(otter_allocator *allocator) {
+  otter_string *line = otter_string_from_cstr(allocator, "cc -o otter");
+  if (line == NULL) {
+    return false;
+  }
+
+  for (size_t i = 0; i < OTTER_BENCH_ARGUMENTS; i++) {
+    otter_string_append(&line, " ", 1);
+    otter_string_append_cstr(&line, bench_arguments[i]);
+  }
+
+  otter_string_free(line);
+  return true;
+}
+
+static bool bench_builder(otter_allocator *allocator, bool reserve) {
+  otter_string_builder builder;
+  otter_string_builder_init(&builder, allocator);
+  if (reserve) {
+    otter_string_builder_reserve(&builder, OTTER_BENCH_ARGUMENTS *
+                                               OTTER_BENCH_ARGUMENT_SIZE);
+  }
+
+  otter_string_builder_append_cstr(&builder, "cc -o otter");
+  for (size_t i = 0; i < OTTER_BENCH_ARGUMENTS; i++) {
+    otter_string_builder_append(&builder, " ", 1);
+    otter_string_builder_append_cstr(&builder, bench_arguments[i]);
+  }
+
+  otter_string *line = otter_string_builder_finish(&builder);
+  otter_string_free(line);
+  return line != NULL;
+}
+
+static bool bench_builder_fmt(otter_allocator *allocator) {
+  otter_string_builder builder;
+  otter_string_builder_init(&builder, allocator);
+  otter_string_builder_append_cstr(&builder, "cc -o otter");
+  for (size_t i = 0; i < OTTER_BENCH_ARGUMENTS; i++) {
+    otter_string_builder_append_fmt(&builder, " ./debug/module_%05zu.o", i);
+  }
+
+  otter_string *line = otter_string_builder_finish(&builder);
+  otter_string_free(line);
+  return line != NULL;
+}
+
+int main(void) {
+  OTTER_CLEANUP(otter_allocator_free_p)
+  otter_allocator *allocator = otter_allocator_create();
+  if (allocator == NULL) {
+    return EXIT_FAILURE;
+  }
+
+  for (size_t i = 0; i < OTTER_BENCH_ARGUMENTS; i++) {
+    snprintf(bench_arguments[i], sizeof(bench_arguments[i]),
+             "./debug/module_%05zu.o", i);
+  }
+
+  size_t completed = 0;
+  uint64_t start = otter_bench_now_ns();
+  while (completed < OTTER_BENCH_ITERATIONS && bench_exact_growth(allocator)) {
+    completed++;
+  }
+  otter_bench_report("10k argument link line, exact growth", completed,
+                     otter_bench_now_ns() - start);
+
+  completed = 0;
+  start = otter_bench_now_ns();
+  while (completed < OTTER_BENCH_ITERATIONS && bench_string_append(allocator)) {
+    completed++;
+  }
+  otter_bench_report("10k argument link line, otter_string_append",
+                     completed, otter_bench_now_ns() - start);
+
+  completed = 0;
+  start = otter_bench_now_ns();
+  while (completed < OTTER_BENCH_ITERATIONS &&
+         bench_builder(allocator, false)) {
+    completed++;
+  }
+  otter_bench_report("10k argument link line, builder", completed,
+                     otter_bench_now_ns() - start);
+
+  completed = 0;
+  start = otter_bench_now_ns();
+  while (completed < OTTER_BENCH_ITERATIONS && bench_builder(allocator, true)) {
+    completed++;
+  }
+  otter_bench_report("10k argument link line, builder reserved", completed,
+                     otter_bench_now_ns() - start);
+
+  completed = 0;
+  start = otter_bench_now_ns();
+  while (completed < OTTER_BENCH_ITERATIONS && bench_builder_fmt(allocator)) {
+    completed++;
+  }
+  otter_bench_report("10k argument link line, builder append_fmt", completed,
+                     otter_bench_now_ns() - start);
+  return EXIT_SUCCESS;
+}
@@ -367,6 +367,190 @@ OTTER_TEST(string_compare_cstr_cstr_null) {
   OTTER_TEST_END(otter_string_free(str););
 }
 
+OTTER_TEST(string_from_view) {
+  const char *buffer = "hello world";
+  otter_string_view view = {.data = buffer, .length = 5};
+  otter_string *str = otter_string_from_view(OTTER_TEST_ALLOCATOR, view);
+
+  OTTER_ASSERT(str != NULL);
+  OTTER_ASSERT(otter_string_length(str) == 5);
+  OTTER_ASSERT(strcmp(otter_string_cstr(str), "hello") == 0);
+
+  OTTER_TEST_END(otter_string_free(str););
+}
+
+OTTER_TEST(string_from_view_null) {
+  otter_string_view view = otter_string_view_from_cstr(NULL);
+  OTTER_ASSERT(view.data == NULL && view.length == 0);
+  OTTER_ASSERT(otter_string_from_view(OTTER_TEST_ALLOCATOR, view) == NULL);
+
+  OTTER_TEST_END();
+}
+
+OTTER_TEST(string_view_of) {
+  otter_string *str = otter_string_from_cstr(OTTER_TEST_ALLOCATOR, "hello");
+  otter_string_view view = otter_string_view_of(str);
+
+  OTTER_ASSERT(view.data == otter_string_cstr(str));
+  OTTER_ASSERT(view.length == 5);
+
+  OTTER_TEST_END(otter_string_free(str););
+}
+
+OTTER_TEST(string_compare_view) {
+  otter_string *str = otter_string_from_cstr(OTTER_TEST_ALLOCATOR, "hello");
+  const char *buffer = "hello world";
+
+  OTTER_ASSERT(otter_string_compare_view(
+                   str, (otter_string_view){.data = buffer, .length = 5}) ==
+               0);
+  OTTER_ASSERT(otter_string_compare_view(
+                   str, otter_string_view_from_cstr(buffer)) < 0);
+  OTTER_ASSERT(otter_string_compare_view(
+                   str, (otter_string_view){.data = buffer, .length = 4}) > 0);
+  OTTER_ASSERT(otter_string_compare_view(
+                   str, otter_string_view_from_cstr("help")) < 0);
+  OTTER_ASSERT(otter_string_compare_view(
+                   str, otter_string_view_from_cstr(NULL)) > 0);
+  OTTER_ASSERT(otter_string_compare_view(
+                   NULL, otter_string_view_from_cstr(NULL)) == 0);
+
+  OTTER_TEST_END(otter_string_free(str););
+}
+
+OTTER_TEST(string_split_iterator) {
+  const char *buffer = "  cc\t-c  main.c\n";
+  otter_string_split_iterator it;
+  otter_string_split_iterator_init(&it, otter_string_view_from_cstr(buffer),
+                                   " \t\n");
+
+  otter_string_view token;
+  OTTER_ASSERT(otter_string_split_next(&it, &token));
+  OTTER_ASSERT(token.data == buffer + 2);
+  OTTER_ASSERT(token.length == 2);
+  OTTER_ASSERT(otter_string_split_next(&it, &token));
+  OTTER_ASSERT(token.data == buffer + 5);
+  OTTER_ASSERT(token.length == 2);
+  OTTER_ASSERT(otter_string_split_next(&it, &token));
+  OTTER_ASSERT(strncmp(token.data, "main.c", token.length) == 0);
+  OTTER_ASSERT(token.length == 6);
+  OTTER_ASSERT(!otter_string_split_next(&it, &token));
+  OTTER_ASSERT(!otter_string_split_next(&it, &token));
+
+  otter_string_split_iterator_init(&it, otter_string_view_from_cstr(" \t "),
+                                   " \t\n");
+  OTTER_ASSERT(!otter_string_split_next(&it, &token));
+
+  OTTER_TEST_END();
+}
+
+OTTER_TEST(string_split_packed) {
+  size_t count = 0;
+  char **tokens = otter_string_split_packed(
+      OTTER_TEST_ALLOCATOR, otter_string_view_from_cstr("-I include  -I src "),
+      " ", &count);
+  OTTER_ASSERT(tokens != NULL);
+  OTTER_ASSERT(count == 4);
+  OTTER_ASSERT(strcmp(tokens[0], "-I") == 0);
+  OTTER_ASSERT(strcmp(tokens[1], "include") == 0);
+  OTTER_ASSERT(strcmp(tokens[2], "-I") == 0);
+  OTTER_ASSERT(strcmp(tokens[3], "src") == 0);
+  OTTER_ASSERT(tokens[4] == NULL);
+
+  OTTER_TEST_END(if (tokens) otter_free(OTTER_TEST_ALLOCATOR, (void *)tokens););
+}
+
+OTTER_TEST(string_split_cstr) {
+  otter_string *str = otter_string_from_cstr(OTTER_TEST_ALLOCATOR, "a,,bc,d,");
+  char **tokens = otter_string_split_cstr(OTTER_TEST_ALLOCATOR, str, ",");
+  OTTER_ASSERT(tokens != NULL);
+  OTTER_ASSERT(strcmp(tokens[0], "a") == 0);
+  OTTER_ASSERT(strcmp(tokens[1], "bc") == 0);
+  OTTER_ASSERT(strcmp(tokens[2], "d") == 0);
+  OTTER_ASSERT(tokens[3] == NULL);
+
+  OTTER_TEST_END(if (tokens) {
+    for (size_t i = 0; tokens[i] != NULL; i++) {
+      otter_free(OTTER_TEST_ALLOCATOR, tokens[i]);
+    }
+    otter_free(OTTER_TEST_ALLOCATOR, (void *)tokens);
+  } otter_string_free(str););
+}
+
+OTTER_TEST(string_append_grows_geometrically) {
+  otter_string *str = otter_string_from_cstr(OTTER_TEST_ALLOCATOR, "a");
+  OTTER_ASSERT(str != NULL);
+
+  size_t reallocations = 0;
+  size_t capacity = otter_string_capacity(str);
+  for (size_t i = 0; i < LARGE_BUFFER_SIZE; i++) {
+    otter_string_append(&str, "b", 1);
+    if (otter_string_capacity(str) != capacity) {
+      OTTER_ASSERT(otter_string_capacity(str) >= capacity * 2);
+      capacity = otter_string_capacity(str);
+      reallocations++;
+    }
+  }
+
+  OTTER_ASSERT(otter_string_length(str) == LARGE_BUFFER_SIZE + 1);
+  OTTER_ASSERT(reallocations < 16);
+
+  OTTER_TEST_END(otter_string_free(str););
+}
+
+OTTER_TEST(string_builder_append) {
+  otter_string_builder builder;
+  otter_string_builder_init(&builder, OTTER_TEST_ALLOCATOR);
+  OTTER_ASSERT(otter_string_builder_length(&builder) == 0);
+
+  OTTER_ASSERT(otter_string_builder_append(&builder, "cc", 2));
+  OTTER_ASSERT(otter_string_builder_append_cstr(&builder, " -c"));
+  OTTER_ASSERT(otter_string_builder_append_view(
+      &builder, (otter_string_view){.data = " main.c.o", .length = 7}));
+  OTTER_ASSERT(otter_string_builder_length(&builder) == 12);
+
+  otter_string *str = otter_string_builder_finish(&builder);
+  OTTER_ASSERT(str != NULL);
+  OTTER_ASSERT(strcmp(otter_string_cstr(str), "cc -c main.c") == 0);
+  OTTER_ASSERT(builder.str == NULL);
+
+  OTTER_TEST_END(otter_string_free(str););
+}
+
+OTTER_TEST(string_builder_finish_empty) {
+  otter_string_builder builder;
+  otter_string_builder_init(&builder, OTTER_TEST_ALLOCATOR);
+
+  otter_string *str = otter_string_builder_finish(&builder);
+  OTTER_ASSERT(str != NULL);
+  OTTER_ASSERT(otter_string_length(str) == 0);
+  OTTER_ASSERT(strcmp(otter_string_cstr(str), "") == 0);
+
+  OTTER_TEST_END(otter_string_free(str););
+}
+
+OTTER_TEST(string_builder_append_fmt) {
+  otter_string_builder builder;
+  otter_string_builder_init(&builder, OTTER_TEST_ALLOCATOR);
+
+  OTTER_ASSERT(otter_string_builder_append_fmt(&builder, "%s=%d", "jobs", 8));
+
+  /* Longer than the spare capacity, so it is formatted a second time */
+  char large[LARGE_BUFFER_SIZE];
+  memset(large, 'x', sizeof(large) - 1);
+  large[sizeof(large) - 1] = '\0';
+  OTTER_ASSERT(otter_string_builder_append_fmt(&builder, " %s;", large));
+  OTTER_ASSERT(otter_string_builder_length(&builder) ==
+               strlen("jobs=8 ;") + sizeof(large) - 1);
+
+  otter_string *str = otter_string_builder_finish(&builder);
+  OTTER_ASSERT(str != NULL);
+  OTTER_ASSERT(strncmp(otter_string_cstr(str), "jobs=8 xxx", 10) == 0);
+  OTTER_ASSERT(otter_string_cstr(str)[otter_string_length(str) - 1] == ';');
+
+  OTTER_TEST_END(otter_string_free(str););
+}
+
 OTTER_TEST(string_free_null) {
   otter_string_free(NULL);
 
@@ -417,17 +601,39 @@ static void *realloc_mock(otter_allocator * /*unused */, void * /*unused */,
   return NULL;
 }
 
+/* Hands whatever a test does not mock on to the test allocator */
+typedef struct otter_allocator_mock_forwarding {
+  otter_allocator base;
+  otter_allocator *parent;
+} otter_allocator_mock_forwarding;
+
+static void *otter_allocator_mock_forwarding_malloc_impl(
+    otter_allocator *allocator, size_t size) {
+  otter_allocator_mock_forwarding *mock =
+      (otter_allocator_mock_forwarding *)allocator;
+  return otter_malloc(mock->parent, size);
+}
+
+static void
+otter_allocator_mock_forwarding_free_impl(otter_allocator *allocator,
+                                          void *pointer) {
+  otter_allocator_mock_forwarding *mock =
+      (otter_allocator_mock_forwarding *)allocator;
+  otter_free(mock->parent, pointer);
+}
+
 OTTER_TEST(string_append_realloc_fails) {
   otter_allocator_vtable vtable = {
-      .malloc = OTTER_TEST_ALLOCATOR->vtable->malloc,
+      .malloc = otter_allocator_mock_forwarding_malloc_impl,
       .realloc = realloc_mock,
-      .free = OTTER_TEST_ALLOCATOR->vtable->free,
+      .free = otter_allocator_mock_forwarding_free_impl,
   };
-  otter_allocator allocator = {
-      .vtable = &vtable,
+  otter_allocator_mock_forwarding allocator = {
+      .base = {.vtable = &vtable},
+      .parent = OTTER_TEST_ALLOCATOR,
   };
 
-  otter_string *str = otter_string_create(&allocator, "a", 1);
+  otter_string *str = otter_string_create(&allocator.base, "a", 1);
   OTTER_ASSERT(str != NULL);
 
   size_t original_capacity = otter_string_capacity(str);
@@ -446,3 +652,48 @@ OTTER_TEST(string_append_realloc_fails) {
 
   OTTER_TEST_END(otter_free(OTTER_TEST_ALLOCATOR, str););
 }
+
+OTTER_TEST(string_builder_reserve_avoids_realloc) {
+  otter_allocator_vtable vtable = {
+      .malloc = otter_allocator_mock_forwarding_malloc_impl,
+      .realloc = realloc_mock,
+      .free = otter_allocator_mock_forwarding_free_impl,
+  };
+  otter_allocator_mock_forwarding allocator = {
+      .base = {.vtable = &vtable},
+      .parent = OTTER_TEST_ALLOCATOR,
+  };
+
+  otter_string_builder builder;
+  otter_string_builder_init(&builder, &allocator.base);
+  OTTER_ASSERT(otter_string_builder_reserve(&builder, LARGE_BUFFER_SIZE));
+  for (size_t i = 0; i < LARGE_BUFFER_SIZE; i++) {
+    OTTER_ASSERT(otter_string_builder_append(&builder, "a", 1));
+  }
+
+  /* Growing past the reservation fails and the failure is sticky */
+  OTTER_ASSERT(!otter_string_builder_append(&builder, "b", 1));
+  OTTER_ASSERT(!otter_string_builder_append(&builder, "", 0));
+  OTTER_ASSERT(otter_string_builder_finish(&builder) == NULL);
+  OTTER_ASSERT(builder.str == NULL);
+
+  OTTER_TEST_END(otter_string_builder_free(&builder););
+}
+
+OTTER_TEST(string_builder_malloc_fails) {
+  otter_allocator_vtable vtable = {
+      .malloc = malloc_mock,
+      .realloc = NULL,
+      .free = NULL,
+  };
+  otter_allocator allocator = {
+      .vtable = &vtable,
+  };
+
+  otter_string_builder builder;
+  otter_string_builder_init(&builder, &allocator);
+  OTTER_ASSERT(!otter_string_builder_append_fmt(&builder, "%d", 1));
+  OTTER_ASSERT(otter_string_builder_finish(&builder) == NULL);
+
+  OTTER_TEST_END();
+}
@@ -15,16 +15,20 @@
   along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 #include "otter/target.h"
+#include "otter/clock.h"
 #include "otter/cstring.h"
 #include "otter/process_manager.h"
 
 #include <assert.h>
+#include <dirent.h>
 #include <errno.h>
 #include <gnutls/crypto.h>
 #include <gnutls/gnutls.h>
+#include <signal.h>
 #include <spawn.h>
 #include <stdarg.h>
 #include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/wait.h>
 #include <sys/xattr.h>
@@ -38,8 +42,11 @@ static int otter_target_run_clang_tidy(otter_target *target);
 /* Helper to execute command using process manager */
 static int otter_target_execute_command(otter_target *target,
                                         otter_string *command) {
-  otter_process_id proc_id =
-      otter_process_manager_queue(target->process_manager, command);
+  const otter_process_job_class job_class =
+      target->type == OTTER_TARGET_OBJECT ? OTTER_PROCESS_JOB_CLASS_COMPILE
+                                          : OTTER_PROCESS_JOB_CLASS_LINK;
+  otter_process_id proc_id = otter_process_manager_queue_job(
+      target->process_manager, command, job_class);
   if (proc_id.value < 0) {
     otter_log_error(target->logger, "Failed to queue command: '%s'",
                     otter_string_cstr(command));
@@ -49,6 +56,8 @@ static int otter_target_execute_command(otter_target *target,
   int exit_status;
   otter_process_manager_wait(target->process_manager, &proc_id, 1,
                              &exit_status);
+  target->has_process_stats = otter_process_manager_stats(
+      target->process_manager, proc_id, &target->process_stats);
   return exit_status;
 }
 
@@ -70,7 +79,40 @@ static void otter_target_was_executed(bool *executed, otter_target *target) {
                       executed);
 }
 
-static bool otter_target_needs_execute(otter_target *target) {
+/* Digest of the command line, so that changing flags forces a rebuild even
+ * though the preprocessed sources are identical */
+static bool otter_target_command_digest(otter_target *target,
+                                        unsigned char *digest) {
+  if (target->command == NULL) {
+    return false;
+  }
+
+  return gnutls_hash_fast(GNUTLS_DIG_SHA1, otter_string_cstr(target->command),
+                          otter_string_length(target->command), digest) == 0;
+}
+
+static bool otter_target_attribute_matches(otter_target *target,
+                                           const char *attribute,
+                                           const unsigned char *expected,
+                                           unsigned int expected_size) {
+  unsigned char *stored = otter_malloc(target->allocator, expected_size);
+  if (stored == NULL) {
+    otter_log_critical(target->logger,
+                       "Unable to allocate space for sha1 digest");
+    return false;
+  }
+
+  const int stored_size = otter_filesystem_get_attribute(
+      target->filesystem, otter_string_cstr(target->name), attribute, stored,
+      expected_size);
+  const bool matches = stored_size >= 0 &&
+                       (unsigned int)stored_size == expected_size &&
+                       memcmp(expected, stored, expected_size) == 0;
+  otter_free(target->allocator, stored);
+  return matches;
+}
+
+otter_target_stale_reason otter_target_check_stale(otter_target *target) {
   otter_log_debug(target->logger, "Checking if '%s' needs to be executed",
                   otter_string_cstr(target->name));
   bool any_dependency_executed = false;
@@ -82,7 +124,7 @@ static bool otter_target_needs_execute(otter_target *target) {
                       "'%s' target needs to execute because one or more of its "
                       "dependencies was exectued",
                       otter_string_cstr(target->name));
-      return true;
+      return OTTER_TARGET_STALE_DEPENDENCY_REBUILT;
     }
     otter_log_debug(target->logger,
                     "One or more of %s's dependencies was executed.  This "
@@ -91,6 +133,14 @@ static bool otter_target_needs_execute(otter_target *target) {
                     otter_string_cstr(target->name));
   }
 
+  if (!otter_filesystem_exists(target->filesystem,
+                               otter_string_cstr(target->name))) {
+    otter_log_debug(target->logger,
+                    "'%s' does not exist.  It needs to be executed.",
+                    otter_string_cstr(target->name));
+    return OTTER_TARGET_STALE_MISSING_OUTPUT;
+  }
+
   /* Retrieve stored digest */
   unsigned int expected_hash_size = gnutls_hash_get_len(GNUTLS_DIG_SHA1);
   unsigned char *stored_hash =
@@ -98,7 +148,7 @@ static bool otter_target_needs_execute(otter_target *target) {
   if (stored_hash == NULL) {
     otter_log_critical(target->logger,
                        "Unable to allocate space for sha1 digest");
-    return true;
+    return OTTER_TARGET_STALE_NO_DIGEST;
   }
 
   int stored_hash_size = otter_filesystem_get_attribute(
@@ -106,107 +156,399 @@ static bool otter_target_needs_execute(otter_target *target) {
       stored_hash, expected_hash_size);
   if (stored_hash_size < 0) {
     otter_free(target->allocator, stored_hash);
-    return true;
+    return OTTER_TARGET_STALE_NO_DIGEST;
   }
 
-  if ((unsigned int)stored_hash_size != target->hash_size) {
+  if ((unsigned int)stored_hash_size != target->hash_size ||
+      memcmp(target->hash, stored_hash, target->hash_size) != 0) {
     otter_log_debug(
         target->logger,
         "Hashes do not match for target '%s'.  It needs to be executed.",
         otter_string_cstr(target->name));
     otter_free(target->allocator, stored_hash);
-    return true;
+    return OTTER_TARGET_STALE_DIGEST_MISMATCH;
   }
+  otter_free(target->allocator, stored_hash);
 
-  if (memcmp(target->hash, stored_hash, target->hash_size) == 0) {
+  unsigned char command_digest[OTTER_SHA1_DIGEST_SIZE];
+  if (!otter_target_command_digest(target, command_digest) ||
+      !otter_target_attribute_matches(target, OTTER_XATTR_COMMAND_NAME,
+                                      command_digest,
+                                      sizeof(command_digest))) {
     otter_log_debug(
         target->logger,
-        "Hashes match for target '%s'.  It does not need to be executed.",
+        "Command changed for target '%s'.  It needs to be executed.",
         otter_string_cstr(target->name));
-    otter_free(target->allocator, stored_hash);
-    return false;
+    return OTTER_TARGET_STALE_FLAGS_CHANGED;
   }
+
   otter_log_debug(
       target->logger,
-      "Hashes do not match for target '%s'.  It needs to be executed.",
+      "Hashes match for target '%s'.  It does not need to be executed.",
       otter_string_cstr(target->name));
-  otter_free(target->allocator, stored_hash);
-  return true;
+  return OTTER_TARGET_UP_TO_DATE;
+}
+
+static bool otter_target_needs_execute(otter_target *target) {
+  target->stale_reason = otter_target_check_stale(target);
+  return target->stale_reason != OTTER_TARGET_UP_TO_DATE;
+}
+
+const char *otter_target_stale_reason_str(otter_target_stale_reason reason) {
+  switch (reason) {
+  case OTTER_TARGET_UP_TO_DATE:
+    return "up to date";
+  case OTTER_TARGET_STALE_MISSING_OUTPUT:
+    return "missing output";
+  case OTTER_TARGET_STALE_NO_DIGEST:
+    return "no stored digest";
+  case OTTER_TARGET_STALE_DIGEST_MISMATCH:
+    return "digest mismatch";
+  case OTTER_TARGET_STALE_DEPENDENCY_REBUILT:
+    return "dependency rebuilt";
+  case OTTER_TARGET_STALE_FLAGS_CHANGED:
+    return "flags changed";
+  default:
+    return "unknown";
+  }
 }
 
-static void otter_target_store_hash(otter_target *target) {
+uint64_t otter_target_historical_cost_ns(const otter_target *target) {
+  if (target == NULL) {
+    return 0;
+  }
+
+  uint64_t cost_ns = 0;
+  if (otter_filesystem_get_attribute(
+          target->filesystem, otter_string_cstr(target->name),
+          OTTER_XATTR_COST_NAME, (unsigned char *)&cost_ns,
+          sizeof(cost_ns)) != (int)sizeof(cost_ns)) {
+    return 0;
+  }
+
+  return cost_ns;
+}
+
+static void otter_target_store_hash(otter_target *target, const char *path) {
   // Store raw digest in xattr
   assert(target->hash != NULL);
   assert(target->hash_size != 0);
-  if (otter_filesystem_set_attribute(
-          target->filesystem, otter_string_cstr(target->name), OTTER_XATTR_NAME,
-          target->hash, target->hash_size) < 0) {
-    otter_log_error(
-        target->logger, "Failed to set %s attribute on file '%s': '%s'\n",
-        OTTER_XATTR_NAME, otter_string_cstr(target->name), strerror(errno));
+  if (otter_filesystem_set_attribute(target->filesystem, path,
+                                     OTTER_XATTR_NAME, target->hash,
+                                     target->hash_size) < 0) {
+    otter_log_error(target->logger,
+                    "Failed to set %s attribute on file '%s': '%s'\n",
+                    OTTER_XATTR_NAME, path, strerror(errno));
 
     return;
   }
+
+  unsigned char command_digest[OTTER_SHA1_DIGEST_SIZE];
+  if (otter_target_command_digest(target, command_digest) &&
+      otter_filesystem_set_attribute(target->filesystem, path,
+                                     OTTER_XATTR_COMMAND_NAME, command_digest,
+                                     sizeof(command_digest)) < 0) {
+    otter_log_error(target->logger,
+                    "Failed to set %s attribute on file '%s': '%s'\n",
+                    OTTER_XATTR_COMMAND_NAME, path, strerror(errno));
+  }
+
+  /* Remember how long the job took for build graph reports */
+  if (target->has_process_stats) {
+    const uint64_t cost_ns = target->process_stats.finished_ns -
+                             target->process_stats.started_ns;
+    otter_filesystem_set_attribute(target->filesystem, path,
+                                   OTTER_XATTR_COST_NAME,
+                                   (const unsigned char *)&cost_ns,
+                                   sizeof(cost_ns));
+  }
 }
 
-static int otter_cc_check_available(otter_logger *logger) {
-  static int cached_result =
-      -1; /* -1 = unchecked, 0 = available, 1 = unavailable */
+/* Reads the digest the output had after its previous successful execution.
+ * This has to happen before executing, as tools may replace the file. */
+static bool otter_target_previous_output_digest(otter_target *target,
+                                                unsigned char *digest) {
+  return otter_filesystem_get_attribute(
+             target->filesystem, otter_string_cstr(target->name),
+             OTTER_XATTR_OUTPUT_NAME, digest, OTTER_SHA1_DIGEST_SIZE) ==
+         OTTER_SHA1_DIGEST_SIZE;
+}
 
-  if (cached_result != -1) {
-    return cached_result;
+static bool otter_target_hash_output(otter_target *target, const char *path,
+                                     unsigned char *digest) {
+  otter_file_view view;
+  if (!otter_filesystem_map_file(target->filesystem, path, &view)) {
+    return false;
   }
 
-  pid_t pid;
-  char *const argv[] = {"cc", "--version", NULL};
-  const int spawn_result = posix_spawnp(&pid, "cc", NULL, NULL, argv, environ);
+  const bool result =
+      gnutls_hash_fast(GNUTLS_DIG_SHA1, view.data, view.length, digest) == 0;
+  otter_filesystem_unmap_file(target->filesystem, &view);
+  return result;
+}
 
-  if (spawn_result != 0) {
-    otter_log_error(logger, "C compiler (cc) is not installed or not in PATH");
-    cached_result = 1;
-    return cached_result;
+/* Early cutoff: when a successful execution reproduced the previous output
+ * byte for byte, dependents do not have to be executed because of it. */
+static void otter_target_restat(otter_target *target, const char *path,
+                                const unsigned char *previous_digest,
+                                bool has_previous_digest) {
+  unsigned char digest[OTTER_SHA1_DIGEST_SIZE];
+  if (!otter_target_hash_output(target, path, digest)) {
+    otter_log_warning(target->logger, "Unable to hash output of '%s'",
+                      otter_string_cstr(target->name));
+    return;
   }
 
-  int status;
-  if (waitpid(pid, &status, 0) > 0 && WIFEXITED(status)) {
-    cached_result = 0;
-  } else {
-    otter_log_error(logger, "C compiler (cc) is not installed or not in PATH");
-    cached_result = 1;
+  if (has_previous_digest &&
+      memcmp(previous_digest, digest, sizeof(digest)) == 0) {
+    otter_log_info(target->logger,
+                   "Output of '%s' is unchanged, dependents are not affected",
+                   otter_string_cstr(target->name));
+    target->executed = false;
   }
 
-  return cached_result;
+  if (otter_filesystem_set_attribute(target->filesystem, path,
+                                     OTTER_XATTR_OUTPUT_NAME, digest,
+                                     sizeof(digest)) < 0) {
+    otter_log_error(target->logger,
+                    "Failed to set %s attribute on file '%s': '%s'",
+                    OTTER_XATTR_OUTPUT_NAME, path, strerror(errno));
+  }
+}
+
+/* Length of the argv joined with single spaces */
+static size_t otter_target_command_length(const otter_target *target) {
+  size_t length = 0;
+  for (size_t i = 0; i < OTTER_ARRAY_LENGTH(target, argv); i++) {
+    length += OTTER_ARRAY_AT_UNSAFE(target, argv, i)->length + 1;
+  }
+  return length;
 }
 
-static int otter_clang_tidy_check_available(otter_logger *logger) {
-  static int cached_result =
-      -1; /* -1 = unchecked, 0 = available, 1 = unavailable */
+/* Builds the command with the output argument following "-o" replaced by
+ * output_path.  Auxiliary outputs such as coverage notes are named after
+ * dump_dir, so they land where they would without the replacement.  Returns
+ * NULL when the command does not name the output. */
+static otter_string *otter_target_command_with_output(otter_target *target,
+                                                      const char *output_path,
+                                                      const char *dump_dir) {
+  bool replaced = false;
+  otter_string_builder command;
+  otter_string_builder_init(&command, target->allocator);
+  otter_string_builder_reserve(&command,
+                               otter_target_command_length(target) +
+                                   strlen(output_path) +
+                                   strlen(" -dumpdir ") + strlen(dump_dir));
+
+  for (size_t i = 0; i < OTTER_ARRAY_LENGTH(target, argv); i++) {
+    const otter_interned_string *arg = OTTER_ARRAY_AT_UNSAFE(target, argv, i);
+    if (i > 0) {
+      otter_string_builder_append(&command, " ", 1);
+    }
+
+    if (!replaced && i > 0 &&
+        0 == strcmp(OTTER_ARRAY_AT_UNSAFE(target, argv, i - 1)->data,
+                    "-o") &&
+        0 == otter_string_compare_view(
+                 target->name,
+                 (otter_string_view){.data = arg->data,
+                                     .length = arg->length})) {
+      otter_string_builder_append_cstr(&command, output_path);
+      otter_string_builder_append_cstr(&command, " -dumpdir ");
+      otter_string_builder_append_cstr(&command, dump_dir);
+      replaced = true;
+    } else {
+      otter_string_builder_append(&command, arg->data, arg->length);
+    }
+  }
 
-  if (cached_result != -1) {
-    return cached_result;
+  if (!replaced) {
+    otter_string_builder_free(&command);
+    return NULL;
   }
 
-  pid_t pid;
-  char *const argv[] = {"clang-tidy", "--version", NULL};
-  const int spawn_result =
-      posix_spawnp(&pid, "clang-tidy", NULL, NULL, argv, environ);
+  return otter_string_builder_finish(&command);
+}
 
-  if (spawn_result != 0) {
-    otter_log_error(logger, "clang-tidy is not installed or not in PATH");
-    cached_result = 1;
-    return cached_result;
+/* Removes the directories in temp_root left behind by builds that were killed
+ * before they could rename their outputs.  Directories of processes that are
+ * still running belong to concurrent builds and are left alone. */
+static void otter_target_remove_stale_temp_dirs(otter_target *target,
+                                                const char *temp_root) {
+  DIR *root = opendir(temp_root);
+  if (root == NULL) {
+    return;
   }
 
-  int status;
-  if (waitpid(pid, &status, 0) > 0 && WIFEXITED(status) &&
-      WEXITSTATUS(status) == 0) {
-    cached_result = 0;
-  } else {
-    otter_log_error(logger, "clang-tidy is not installed or not in PATH");
-    cached_result = 1;
+  const struct dirent *entry = NULL;
+  while ((entry = readdir(root)) != NULL) {
+    char *end = NULL;
+    const long pid = strtol(entry->d_name, &end, 10);
+    if (end == entry->d_name || *end != '\0' || pid <= 0 ||
+        pid == (long)getpid()) {
+      continue;
+    }
+
+    if (kill((pid_t)pid, 0) == 0 || errno != ESRCH) {
+      continue;
+    }
+
+    OTTER_CLEANUP(otter_string_free_p)
+    otter_string *stale_dir = otter_string_format(target->allocator, "%s/%s",
+                                                  temp_root, entry->d_name);
+    if (stale_dir == NULL) {
+      break;
+    }
+
+    otter_log_debug(target->logger, "Removing stale temporary directory '%s'",
+                    otter_string_cstr(stale_dir));
+    DIR *directory = opendir(otter_string_cstr(stale_dir));
+    if (directory != NULL) {
+      const struct dirent *stale = NULL;
+      while ((stale = readdir(directory)) != NULL) {
+        if (strcmp(stale->d_name, ".") == 0 ||
+            strcmp(stale->d_name, "..") == 0) {
+          continue;
+        }
+
+        OTTER_CLEANUP(otter_string_free_p)
+        otter_string *stale_path =
+            otter_string_format(target->allocator, "%s/%s",
+                                otter_string_cstr(stale_dir), stale->d_name);
+        if (stale_path != NULL) {
+          otter_filesystem_remove(target->filesystem,
+                                  otter_string_cstr(stale_path));
+        }
+      }
+
+      closedir(directory);
+    }
+
+    otter_filesystem_remove(target->filesystem, otter_string_cstr(stale_dir));
   }
 
-  return cached_result;
+  closedir(root);
+}
+
+/* Generated commands write to a file of the same name in a directory of
+ * their own process in OTTER_TARGET_TEMP_DIR next to the output, so
+ * concurrent builds of the same target never share a temporary file.  Keeping
+ * the name keeps the names compilers derive from it, e.g. gcov's .gcno and
+ * .gcda files.  command is left NULL if the command does not name its output
+ * and runs as it is. */
+static bool otter_target_temp_command(otter_target *target,
+                                      otter_string **command,
+                                      otter_string **temp_path) {
+  const char *name = otter_string_cstr(target->name);
+  const char *base = strrchr(name, '/');
+  const int directory_length = base != NULL ? (int)(base - name) + 1 : 0;
+  base = base != NULL ? base + 1 : name;
+
+  OTTER_CLEANUP(otter_string_free_p)
+  otter_string *temp_root =
+      otter_string_format(target->allocator, "%.*s" OTTER_TARGET_TEMP_DIR,
+                          directory_length, name);
+  OTTER_CLEANUP(otter_string_free_p)
+  otter_string *temp_dir =
+      temp_root != NULL
+          ? otter_string_format(target->allocator, "%s/%ld",
+                                otter_string_cstr(temp_root), (long)getpid())
+          : NULL;
+  /* Where the compiler would put auxiliary outputs for name: next to an
+   * object, or prefixed with the name of a linked output */
+  OTTER_CLEANUP(otter_string_free_p)
+  otter_string *dump_dir =
+      target->type == OTTER_TARGET_OBJECT
+          ? otter_string_format(target->allocator, "%.*s",
+                                directory_length > 0 ? directory_length : 2,
+                                directory_length > 0 ? name : "./")
+          : otter_string_format(target->allocator, "%s-", name);
+  if (temp_dir == NULL || dump_dir == NULL) {
+    otter_log_critical(target->logger, "Failed to create string %s",
+                       OTTER_NAMEOF(temp_dir));
+    return false;
+  }
+
+  if (!otter_filesystem_make_directory(target->filesystem,
+                                       otter_string_cstr(temp_root))) {
+    otter_log_error(target->logger, "Failed to create directory '%s': '%s'",
+                    otter_string_cstr(temp_root), strerror(errno));
+    return false;
+  }
+
+  otter_target_remove_stale_temp_dirs(target, otter_string_cstr(temp_root));
+  if (!otter_filesystem_make_directory(target->filesystem,
+                                       otter_string_cstr(temp_dir))) {
+    otter_log_error(target->logger, "Failed to create directory '%s': '%s'",
+                    otter_string_cstr(temp_dir), strerror(errno));
+    return false;
+  }
+
+  *temp_path = otter_string_format(target->allocator, "%s/%s",
+                                   otter_string_cstr(temp_dir), base);
+  if (*temp_path == NULL) {
+    otter_log_critical(target->logger, "Failed to create string %s",
+                       OTTER_NAMEOF(temp_path));
+    return false;
+  }
+
+  *command = otter_target_command_with_output(
+      target, otter_string_cstr(*temp_path), otter_string_cstr(dump_dir));
+  if (*command == NULL) {
+    otter_string_free(*temp_path);
+    *temp_path = NULL;
+  }
+
+  return true;
+}
+
+/* Executes the target's command and records its digests.  Generated commands
+ * write to a temporary file which is renamed over the output only once the
+ * digests are stored, so an interrupted or failed job never leaves a
+ * truncated output behind that looks up to date. */
+static int otter_target_run(otter_target *target) {
+  unsigned char previous_digest[OTTER_SHA1_DIGEST_SIZE];
+  const bool has_previous_digest =
+      otter_target_previous_output_digest(target, previous_digest);
+
+  OTTER_CLEANUP(otter_string_free_p) otter_string *temp_path = NULL;
+  OTTER_CLEANUP(otter_string_free_p) otter_string *command = NULL;
+  if (target->atomic_output &&
+      !otter_target_temp_command(target, &command, &temp_path)) {
+    return -1;
+  }
+
+  const char *output_path = temp_path != NULL ? otter_string_cstr(temp_path)
+                                              : otter_string_cstr(target->name);
+  int status = otter_target_execute_command(
+      target, command != NULL ? command : target->command);
+  /* The command wrote the output behind the filesystem's back */
+  otter_filesystem_invalidate(target->filesystem, output_path);
+  if (status < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    if (temp_path != NULL &&
+        otter_filesystem_exists(target->filesystem, output_path)) {
+      otter_filesystem_remove(target->filesystem, output_path);
+    }
+
+    return status < 0 ? -1 : status;
+  }
+
+  otter_target_store_hash(target, output_path); /* Only update hash on
+                                                   success.  Allows for the
+                                                   target to be re-executed. */
+  otter_target_restat(target, output_path, previous_digest,
+                      has_previous_digest);
+  if (temp_path != NULL &&
+      !otter_filesystem_rename(target->filesystem, output_path,
+                               otter_string_cstr(target->name))) {
+    otter_log_error(target->logger, "Failed to rename '%s' to '%s': '%s'",
+                    output_path, otter_string_cstr(target->name),
+                    strerror(errno));
+    otter_filesystem_remove(target->filesystem, output_path);
+    return -1;
+  }
+
+  return status;
 }
 
 static int otter_target_run_clang_tidy(otter_target *target) {
@@ -220,7 +562,9 @@ static int otter_target_run_clang_tidy(otter_target *target) {
   }
 
   /* Check if clang-tidy is available before proceeding */
-  if (otter_clang_tidy_check_available(target->logger) != 0) {
+  const char *clang_tidy_path =
+      otter_process_manager_resolve(target->process_manager, "clang-tidy");
+  if (clang_tidy_path == NULL) {
     return -1;
   }
 
@@ -229,33 +573,29 @@ static int otter_target_run_clang_tidy(otter_target *target) {
   char **include_flag_tokens = NULL;
   size_t arg_count = 0;
 
-  /* Split include flags */
+  /* Split include flags, argv points into the packed tokens */
   size_t flag_count = 0;
   if (target->include_flags != NULL) {
-    include_flag_tokens = otter_string_split_cstr(
-        target->allocator, target->include_flags, " \t\n");
+    include_flag_tokens = otter_string_split_packed(
+        target->allocator, otter_string_view_of(target->include_flags),
+        " \t\n", &flag_count);
     if (include_flag_tokens == NULL) {
       otter_log_error(target->logger, "Failed to split include flags");
       return -1;
     }
-    /* Count tokens */
-    for (size_t i = 0; include_flag_tokens[i] != NULL; i++) {
-      flag_count++;
-    }
   }
 
   /* Build argv: clang-tidy <files...> -- <include_flags> NULL */
   const size_t file_count = OTTER_ARRAY_LENGTH(target, files);
   const size_t argc = 1 + file_count + 1 + flag_count +
                       1; /* clang-tidy + files + "--" + include flags + NULL */
+  /* Only clang-tidy, the files and "--" are duplicated */
+  const size_t owned_count = 1 + file_count + 1;
   argv = (char **)otter_malloc(target->allocator, argc * sizeof(char *));
   if (argv == NULL) {
     otter_log_error(target->logger, "Failed to allocate argv for clang-tidy");
     if (include_flag_tokens != NULL) {
-      for (size_t i = 0; include_flag_tokens[i] != NULL; i++) {
-        otter_free(target->allocator, include_flag_tokens[i]);
-      }
-      otter_free(target->allocator, include_flag_tokens);
+      otter_free(target->allocator, (void *)include_flag_tokens);
     }
     return -1;
   }
@@ -288,14 +628,8 @@ static int otter_target_run_clang_tidy(otter_target *target) {
   arg_count++;
 
   /* Add include flags after -- */
-  if (include_flag_tokens != NULL) {
-    for (size_t i = 0; include_flag_tokens[i] != NULL; i++) {
-      argv[arg_count] = otter_strdup(target->allocator, include_flag_tokens[i]);
-      if (argv[arg_count] == NULL) {
-        goto cleanup;
-      }
-      arg_count++;
-    }
+  for (size_t i = 0; i < flag_count; i++) {
+    argv[arg_count++] = include_flag_tokens[i];
   }
 
   otter_log_info(target->logger, "Running clang-tidy on target '%s'",
@@ -303,7 +637,7 @@ static int otter_target_run_clang_tidy(otter_target *target) {
 
   pid_t pid;
   const int posix_spawn_result =
-      posix_spawnp(&pid, "clang-tidy", NULL, NULL, argv, environ);
+      posix_spawn(&pid, clang_tidy_path, NULL, NULL, argv, environ);
 
   if (posix_spawn_result != 0) {
     otter_log_error(
@@ -324,21 +658,33 @@ static int otter_target_run_clang_tidy(otter_target *target) {
 
 cleanup:
   if (argv != NULL) {
-    for (size_t i = 0; i < argc; i++) {
+    /* The include flags belong to include_flag_tokens */
+    for (size_t i = 0; i < owned_count; i++) {
       otter_free(target->allocator, argv[i]);
     }
     otter_free(target->allocator, (void *)argv);
   }
   if (include_flag_tokens != NULL) {
-    for (size_t i = 0; include_flag_tokens[i] != NULL; i++) {
-      otter_free(target->allocator, include_flag_tokens[i]);
-    }
-    otter_free(target->allocator, include_flag_tokens);
+    otter_free(target->allocator, (void *)include_flag_tokens);
   }
 
   return result;
 }
 
+/* Lets structured log sinks tell which target a message is about */
+static otter_log_context otter_target_log_context(const otter_target *target,
+                                                  otter_log_field *command) {
+  *command = (otter_log_field){
+      .key = "command",
+      .value = otter_string_cstr(target->command),
+  };
+  return (otter_log_context){
+      .target = otter_string_cstr(target->name),
+      .fields = command,
+      .fields_length = command->value != NULL ? 1 : 0,
+  };
+}
+
 static void otter_target_execute_dependency_helper(int *return_code,
                                                    otter_target *dependency) {
 
@@ -354,7 +700,7 @@ static int otter_target_execute_dependency(otter_target *target) {
     return -1;
   }
 
-  if (otter_cc_check_available(target->logger) != 0) {
+  if (otter_process_manager_resolve(target->process_manager, "cc") == NULL) {
     return -1;
   }
 
@@ -367,30 +713,24 @@ static int otter_target_execute_dependency(otter_target *target) {
     return return_code;
   }
 
+  otter_log_field command;
+  const otter_log_context context = otter_target_log_context(target, &command);
   if (otter_target_needs_execute(target)) {
     target->executed = true;
-    otter_log_info(target->logger, "Executing target '%s'\nCommand: '%s'",
+    otter_log_with(target->logger, OTTER_LOG_LEVEL_INFO, &context,
+                   "Executing target '%s'\nCommand: '%s'",
                    otter_string_cstr(target->name),
                    otter_string_cstr(target->command));
 
     int clang_tidy_result = otter_target_run_clang_tidy(target);
     if (clang_tidy_result != 0) {
-      otter_log_error(target->logger, "clang-tidy failed for target '%s'",
-                      otter_string_cstr(target->name));
+      otter_log_with(target->logger, OTTER_LOG_LEVEL_ERROR, &context,
+                     "clang-tidy failed for target '%s'",
+                     otter_string_cstr(target->name));
       return clang_tidy_result;
     }
 
-    int status = otter_target_execute_command(target, target->command);
-    if (status < 0) {
-      return -1;
-    }
-
-    if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
-      otter_target_store_hash(target); /* Only update hash on success.  Allows
-                                          for the target to be re-executed. */
-    }
-
-    return status;
+    return otter_target_run(target);
   }
 
   return 0;
@@ -401,7 +741,7 @@ int otter_target_execute(otter_target *target) {
     return -1;
   }
 
-  if (otter_cc_check_available(target->logger) != 0) {
+  if (otter_process_manager_resolve(target->process_manager, "cc") == NULL) {
     return -1;
   }
 
@@ -412,33 +752,28 @@ int otter_target_execute(otter_target *target) {
     return return_code;
   }
 
+  otter_log_field command;
+  const otter_log_context context = otter_target_log_context(target, &command);
   if (otter_target_needs_execute(target)) {
     int clang_tidy_result = otter_target_run_clang_tidy(target);
     if (clang_tidy_result != 0) {
-      otter_log_error(target->logger, "clang-tidy failed for target '%s'",
-                      otter_string_cstr(target->name));
+      otter_log_with(target->logger, OTTER_LOG_LEVEL_ERROR, &context,
+                     "clang-tidy failed for target '%s'",
+                     otter_string_cstr(target->name));
       return clang_tidy_result;
     }
 
     target->executed = true;
-    otter_log_info(target->logger, "Executing target '%s'\nCommand: '%s'",
+    otter_log_with(target->logger, OTTER_LOG_LEVEL_INFO, &context,
+                   "Executing target '%s'\nCommand: '%s'",
                    otter_string_cstr(target->name),
                    otter_string_cstr(target->command));
 
-    int status = otter_target_execute_command(target, target->command);
-    if (status < 0) {
-      return -1;
-    }
-
-    if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
-      otter_target_store_hash(target); /* Only update hash on success.  Allows
-                                          for the target to be re-executed. */
-    }
-    return status;
+    return otter_target_run(target);
   }
 
-  otter_log_info(target->logger, "Target '%s' up-to-date",
-                 otter_string_cstr(target->name));
+  otter_log_with(target->logger, OTTER_LOG_LEVEL_INFO, &context,
+                 "Target '%s' up-to-date", otter_string_cstr(target->name));
   return 0;
 }
 
@@ -451,15 +786,16 @@ void otter_target_free(otter_target *target) {
   if (target->files != NULL) {
     OTTER_ARRAY_FOREACH(target, files, otter_string_free);
   }
-  otter_free(target->allocator, target->files);
+  OTTER_ARRAY_FREE(target, files, target->allocator);
   otter_string_free(target->command);
   otter_string_free(target->cc_flags);
   otter_string_free(target->include_flags);
-  if (target->argv != NULL) {
-    OTTER_ARRAY_FOREACH(target, argv, otter_string_free);
+  OTTER_ARRAY_FREE(target, argv, target->allocator);
+  OTTER_MAP_FREE(target, argv_set, target->allocator);
+  if (target->owns_strings) {
+    otter_intern_table_free(target->strings);
   }
-  otter_free(target->allocator, target->argv);
-  otter_free(target->allocator, target->dependencies);
+  OTTER_ARRAY_FREE(target, dependencies, target->allocator);
   otter_free(target->allocator, target->hash);
   otter_free(target->allocator, target);
 }
@@ -467,92 +803,169 @@ void otter_target_free(otter_target *target) {
 OTTER_DEFINE_TRIVIAL_CLEANUP_FUNC(otter_target *, otter_target_free);
 
 static bool otter_target_generate_command_from_argv(otter_target *target) {
-  target->command = otter_string_create(target->allocator, "", 0);
-  if (target->command == NULL) {
-    return false;
-  }
-
+  /* The length is known up front, so the command is allocated once */
+  otter_string_builder command;
+  otter_string_builder_init(&command, target->allocator);
+  otter_string_builder_reserve(&command, otter_target_command_length(target));
   for (size_t i = 0; i < OTTER_ARRAY_LENGTH(target, argv); i++) {
-    otter_string *arg = OTTER_ARRAY_AT_UNSAFE(target, argv, i);
+    const otter_interned_string *arg = OTTER_ARRAY_AT_UNSAFE(target, argv, i);
     if (i > 0) {
-      otter_string_append_cstr(&target->command, " ");
+      otter_string_builder_append(&command, " ", 1);
     }
-    otter_string_append(&target->command, otter_string_cstr(arg),
-                        otter_string_length(arg));
+    otter_string_builder_append(&command, arg->data, arg->length);
+  }
+
+  target->command = otter_string_builder_finish(&command);
+  if (target->command == NULL) {
+    return false;
   }
 
+  /* Generated commands name their output after "-o" */
+  target->atomic_output = true;
   return true;
 }
 
-static bool otter_target_append_arg_to_argv(otter_target *target,
-                                            const char *arg_) {
-  if (target == NULL || arg_ == NULL) {
+/* Targets that were not given a shared table intern into one of their own */
+static bool otter_target_ensure_strings(otter_target *target) {
+  if (target->strings != NULL) {
+    return true;
+  }
+
+  target->strings = otter_intern_table_create(target->allocator);
+  if (target->strings == NULL) {
+    otter_log_critical(target->logger, "Failed to create %s",
+                       OTTER_NAMEOF(target->strings));
     return false;
   }
 
+  target->owns_strings = true;
+  return true;
+}
+
+/* Interned arguments carry their hash */
+static uint64_t otter_target_hash_arg(const void *key) {
+  const otter_interned_string *arg;
+  memcpy(&arg, key, sizeof(arg));
+  return otter_map_mix(arg->hash);
+}
+
+/* Below this many arguments scanning argv beats hashing */
+#define OTTER_TARGET_ARGV_SET_THRESHOLD 32
+static bool otter_target_argv_contains(otter_target *target,
+                                       const otter_interned_string *arg) {
+  if (OTTER_MAP_LENGTH(target, argv_set) == 0 &&
+      OTTER_ARRAY_LENGTH(target, argv) >= OTTER_TARGET_ARGV_SET_THRESHOLD) {
+    for (size_t i = 0; i < OTTER_ARRAY_LENGTH(target, argv); i++) {
+      if (!OTTER_SET_INSERT(target, argv_set, target->allocator,
+                            OTTER_ARRAY_AT_UNSAFE(target, argv, i),
+                            otter_target_hash_arg, otter_map_equal_pointer)) {
+        OTTER_MAP_FREE(target, argv_set, target->allocator);
+        break;
+      }
+    }
+  }
+
+  if (OTTER_MAP_LENGTH(target, argv_set) > 0) {
+    return OTTER_MAP_CONTAINS(target, argv_set, arg, otter_target_hash_arg,
+                              otter_map_equal_pointer);
+  }
+
   for (size_t i = 0; i < OTTER_ARRAY_LENGTH(target, argv); i++) {
-    otter_string *existing_arg = OTTER_ARRAY_AT_UNSAFE(target, argv, i);
-    if (0 == otter_string_compare_cstr(existing_arg, arg_)) {
-      otter_log_debug(
-          target->logger,
-          "Skipping adding argument '%s' to argv since it already exists",
-          arg_);
+    if (OTTER_ARRAY_AT_UNSAFE(target, argv, i) == arg) {
       return true;
     }
   }
+  return false;
+}
+
+static bool otter_target_append_view_to_argv(otter_target *target,
+                                             otter_string_view arg_) {
+  if (target == NULL || arg_.data == NULL) {
+    return false;
+  }
 
-  otter_string *arg = otter_string_from_cstr(target->allocator, arg_);
+  const otter_interned_string *arg = otter_intern(target->strings, arg_);
   if (arg == NULL) {
     otter_log_critical(target->logger,
-                       "Failed to create string for argument '%s'", arg_);
+                       "Failed to intern string for argument '%.*s'",
+                       OTTER_STRING_VIEW_ARG(arg_));
     return false;
   }
 
+  if (otter_target_argv_contains(target, arg)) {
+    otter_log_debug(
+        target->logger,
+        "Skipping adding argument '%s' to argv since it already exists",
+        arg->data);
+    return true;
+  }
+
   if (!OTTER_ARRAY_APPEND(target, argv, target->allocator, arg)) {
     otter_log_critical(target->logger,
-                       "Failed to append argument '%s' to array %s", arg_,
-                       OTTER_NAMEOF(target->argv));
-    otter_string_free(arg);
+                       "Failed to append argument '%s' to array %s",
+                       arg->data, OTTER_NAMEOF(target->argv));
     return false;
   }
 
+  if (OTTER_MAP_LENGTH(target, argv_set) > 0 &&
+      !OTTER_SET_INSERT(target, argv_set, target->allocator, arg,
+                        otter_target_hash_arg, otter_map_equal_pointer)) {
+    /* The index is only an accelerator, fall back to scanning */
+    OTTER_MAP_FREE(target, argv_set, target->allocator);
+  }
+
   return true;
 }
 
-static bool otter_target_append_args_to_argv(otter_target *target,
-                                             const char *args_) {
-  const char *delims = " \t\n";
+static bool otter_target_append_arg_to_argv(otter_target *target,
+                                            const char *arg) {
+  return otter_target_append_view_to_argv(target,
+                                          otter_string_view_from_cstr(arg));
+}
 
-  /* Create temporary otter_string for splitting */
-  otter_string *args_str = otter_string_from_cstr(target->allocator, args_);
-  if (args_str == NULL) {
-    otter_log_critical(target->logger,
-                       "Failed to create string from arguments '%s'", args_);
+/* Makes room in argv for every token of args, counting them is cheaper than
+ * growing argv several times */
+static bool otter_target_reserve_argv(otter_target *target,
+                                      otter_string_view args) {
+  size_t count = 0;
+  otter_string_split_iterator iterator;
+  otter_string_split_iterator_init(&iterator, args, " \t\n");
+  otter_string_view token;
+  while (otter_string_split_next(&iterator, &token)) {
+    count++;
+  }
+
+  if (!OTTER_ARRAY_RESERVE(target, argv, target->allocator,
+                           OTTER_ARRAY_LENGTH(target, argv) + count)) {
+    otter_log_critical(target->logger, "Failed to reserve %zu arguments",
+                       count);
     return false;
   }
 
-  char **tokens = otter_string_split_cstr(target->allocator, args_str, delims);
-  otter_string_free(args_str);
+  return true;
+}
+
+static bool otter_target_append_args_to_argv(otter_target *target,
+                                             const char *args) {
+  if (args == NULL) {
+    return false;
+  }
 
-  if (tokens == NULL) {
-    otter_log_critical(target->logger, "Failed to split arguments '%s'", args_);
+  if (!otter_target_reserve_argv(target, otter_string_view_from_cstr(args))) {
     return false;
   }
 
-  for (size_t i = 0; tokens[i] != NULL; i++) {
-    if (!otter_target_append_arg_to_argv(target, tokens[i])) {
-      for (size_t j = 0; tokens[j] != NULL; j++) {
-        otter_free(target->allocator, tokens[j]);
-      }
-      otter_free(target->allocator, tokens);
+  /* The tokens are views into args, only the interned copies are kept */
+  otter_string_split_iterator iterator;
+  otter_string_split_iterator_init(
+      &iterator, otter_string_view_from_cstr(args), " \t\n");
+  otter_string_view token;
+  while (otter_string_split_next(&iterator, &token)) {
+    if (!otter_target_append_view_to_argv(target, token)) {
       return false;
     }
   }
 
-  for (size_t i = 0; tokens[i] != NULL; i++) {
-    otter_free(target->allocator, tokens[i]);
-  }
-  otter_free(target->allocator, tokens);
   return true;
 }
 
@@ -707,10 +1120,11 @@ otter_target_generate_c_shared_object_argv(otter_target *target,
 }
 
 static otter_target *otter_target_create_and_initialize(
-    const otter_string *name, otter_allocator *allocator,
+    otter_string_view name, otter_string_view cc_flags,
+    otter_string_view include_flags, otter_allocator *allocator,
     otter_filesystem *filesystem, otter_logger *logger,
     otter_process_manager *process_manager, otter_target_type type) {
-  OTTER_RETURN_IF_NULL(logger, name, NULL);
+  OTTER_RETURN_IF_NULL(logger, name.data, NULL);
   OTTER_RETURN_IF_NULL(logger, allocator, NULL);
   OTTER_RETURN_IF_NULL(logger, filesystem, NULL);
   OTTER_RETURN_IF_NULL(logger, logger, NULL);
@@ -731,38 +1145,43 @@ static otter_target *otter_target_create_and_initialize(
   target->command = NULL;
   target->cc_flags = NULL;
   target->include_flags = NULL;
+  target->strings = NULL;
+  target->owns_strings = false;
   target->argv = NULL;
+  OTTER_MAP_INIT(target, argv_set);
   target->dependencies = NULL;
   target->hash = NULL;
   target->hash_size = 0;
   target->executed = false;
+  target->stale_reason = OTTER_TARGET_UP_TO_DATE;
+  target->hash_start_ns = 0;
+  target->hash_ns = 0;
+  target->has_process_stats = false;
+  target->atomic_output = false;
   target->type = type;
 
-  target->name = otter_string_copy(name);
+  target->name = otter_string_from_view(allocator, name);
   if (target->name == NULL) {
     otter_log_critical(target->logger, "Failed to create string %s",
                        OTTER_NAMEOF(target->name));
     goto failure;
   }
 
+  /* Nothing is allocated until the arrays are filled, most targets have no
+   * dependencies at all */
   OTTER_ARRAY_INIT(target, dependencies, target->allocator);
-  if (target->dependencies == NULL) {
-    otter_log_critical(target->logger, "Failed to allocate array of %s",
-                       OTTER_NAMEOF(target->dependencies));
-    goto failure;
-  }
-
   OTTER_ARRAY_INIT(target, files, target->allocator);
-  if (target->files == NULL) {
-    otter_log_critical(target->logger, "Failed to allocate array of %s",
-                       OTTER_NAMEOF(target->files));
+  OTTER_ARRAY_INIT(target, argv, target->allocator);
+
+  target->cc_flags = otter_string_from_view(allocator, cc_flags);
+  if (target->cc_flags == NULL) {
+    otter_log_critical(logger, "Failed to create cc_flags string");
     goto failure;
   }
 
-  OTTER_ARRAY_INIT(target, argv, target->allocator);
-  if (target->argv == NULL) {
-    otter_log_critical(target->logger, "Failed to allocate array of %s",
-                       OTTER_NAMEOF(target->argv));
+  target->include_flags = otter_string_from_view(allocator, include_flags);
+  if (target->include_flags == NULL) {
+    otter_log_critical(logger, "Failed to create include_flags string");
     goto failure;
   }
 
@@ -772,213 +1191,202 @@ failure:
   return NULL;
 }
 
-otter_target *otter_target_create_c_object(
-    const otter_string *name, const otter_string *cc_flags,
-    const otter_string *include_flags, otter_allocator *allocator,
-    otter_filesystem *filesystem, otter_logger *logger,
-    otter_process_manager *process_manager, ...) {
-  OTTER_RETURN_IF_NULL(logger, name, NULL);
-  OTTER_RETURN_IF_NULL(logger, allocator, NULL);
-  OTTER_RETURN_IF_NULL(logger, filesystem, NULL);
-  OTTER_RETURN_IF_NULL(logger, logger, NULL);
-  OTTER_RETURN_IF_NULL(logger, process_manager, NULL);
-
-  otter_target *target =
-      otter_target_create_and_initialize(name, allocator, filesystem, logger,
-                                         process_manager, OTTER_TARGET_OBJECT);
-  if (target == NULL) {
-    return NULL;
+static bool otter_target_append_file(otter_target *target,
+                                     otter_string_view file) {
+  otter_string *duplicated_file =
+      otter_string_from_view(target->allocator, file);
+  if (duplicated_file == NULL) {
+    otter_log_critical(target->logger,
+                       "Failed to create string for file: '%.*s'",
+                       OTTER_STRING_VIEW_ARG(file));
+    return false;
   }
 
-  target->cc_flags = otter_string_copy(cc_flags);
-  if (target->cc_flags == NULL) {
-    otter_log_critical(logger, "Failed to create cc_flags string");
-    goto failure;
+  if (!OTTER_ARRAY_APPEND(target, files, target->allocator,
+                          duplicated_file)) {
+    otter_log_critical(target->logger,
+                       "Failed to insert file string '%.*s' into %s",
+                       OTTER_STRING_VIEW_ARG(file),
+                       OTTER_NAMEOF(target->files));
+    otter_string_free(duplicated_file);
+    return false;
   }
 
-  target->include_flags = otter_string_copy(include_flags);
-  if (target->include_flags == NULL) {
-    otter_log_critical(logger, "Failed to create include_flags string");
-    goto failure;
-  }
+  return true;
+}
 
-  va_list args;
-  va_start(args, process_manager);
-  otter_string *file = va_arg(args, otter_string *);
-  while (file != NULL) {
-    otter_string *duplicated_file = otter_string_copy(file);
-    if (duplicated_file == NULL) {
-      otter_log_critical(target->logger,
-                         "Failed to create string for file: '%s'",
-                         otter_string_cstr(file));
-      va_end(args);
-      goto failure;
+static bool otter_target_append_dependencies(otter_target *target,
+                                             otter_target **dependencies) {
+  for (otter_target **dependency = dependencies;
+       dependency != NULL && *dependency != NULL; dependency++) {
+    if (!OTTER_ARRAY_APPEND(target, dependencies, target->allocator,
+                            *dependency)) {
+      otter_log_critical(target->logger, "Failed to append target to %s",
+                         OTTER_NAMEOF(target->dependencies));
+      return false;
     }
+  }
 
-    if (!OTTER_ARRAY_APPEND(target, files, target->allocator,
-                            duplicated_file)) {
-      otter_log_critical(target->logger,
-                         "Failed to insert file string '%s' into %s",
-                         otter_string_cstr(file), OTTER_NAMEOF(target->files));
-      otter_string_free(duplicated_file);
-      va_end(args);
-      goto failure;
-    }
+  return true;
+}
 
-    file = va_arg(args, otter_string *);
+/* Generates the command line and the digest once the files and dependencies
+ * are in place */
+static bool otter_target_finalize(otter_target *target) {
+  if (!otter_target_ensure_strings(target)) {
+    return false;
   }
 
-  va_end(args);
-  otter_target_generate_c_object_argv(target, cc_flags);
-  if (!otter_target_generate_hash_c(target)) {
-    goto failure;
+  bool generated = false;
+  switch (target->type) {
+  case OTTER_TARGET_OBJECT:
+    generated = otter_target_generate_c_object_argv(target, target->cc_flags);
+    break;
+  case OTTER_TARGET_EXECUTABLE:
+    generated =
+        otter_target_generate_c_executable_argv(target, target->cc_flags);
+    break;
+  case OTTER_TARGET_SHARED_OBJECT:
+    generated =
+        otter_target_generate_c_shared_object_argv(target, target->cc_flags);
+    break;
+  }
+
+  if (!generated) {
+    otter_log_critical(target->logger, "Failed to generate command for '%s'",
+                       otter_string_cstr(target->name));
+    return false;
   }
 
-  return target;
-failure:
-  otter_target_free(target);
-  return NULL;
+  return otter_target_generate_hash_c(target);
 }
 
-otter_target *otter_target_create_c_executable(
-    const otter_string *name, const otter_string *flags,
-    const otter_string *include_flags, otter_allocator *allocator,
-    otter_filesystem *filesystem, otter_logger *logger,
-    otter_process_manager *process_manager, const otter_string **files,
-    otter_target **dependencies) {
-  OTTER_RETURN_IF_NULL(logger, name, NULL);
-  OTTER_RETURN_IF_NULL(logger, allocator, NULL);
-  OTTER_RETURN_IF_NULL(logger, filesystem, NULL);
-  OTTER_RETURN_IF_NULL(logger, logger, NULL);
-  OTTER_RETURN_IF_NULL(logger, process_manager, NULL);
-  OTTER_RETURN_IF_NULL(logger, files, NULL);
+otter_target *otter_target_create(const otter_target_spec *spec,
+                                  otter_allocator *allocator,
+                                  otter_filesystem *filesystem,
+                                  otter_logger *logger,
+                                  otter_process_manager *process_manager) {
+  OTTER_RETURN_IF_NULL(logger, spec, NULL);
+  OTTER_RETURN_IF_NULL(logger, spec->flags.data, NULL);
+  OTTER_RETURN_IF_NULL(logger, spec->include_flags.data, NULL);
+  if (spec->files_length > 0) {
+    OTTER_RETURN_IF_NULL(logger, spec->files, NULL);
+  }
 
   otter_target *target = otter_target_create_and_initialize(
-      name, allocator, filesystem, logger, process_manager,
-      OTTER_TARGET_EXECUTABLE);
+      spec->name, spec->flags, spec->include_flags, allocator, filesystem,
+      logger, process_manager, spec->type);
   if (target == NULL) {
     return NULL;
   }
 
-  target->cc_flags = otter_string_copy(flags);
-  if (target->cc_flags == NULL) {
-    otter_log_critical(logger, "Failed to create cc_flags string");
-    goto failure;
+  target->strings = spec->strings;
+  size_t dependencies_length = 0;
+  while (spec->dependencies != NULL &&
+         spec->dependencies[dependencies_length] != NULL) {
+    dependencies_length++;
   }
 
-  target->include_flags = otter_string_copy(include_flags);
-  if (target->include_flags == NULL) {
-    otter_log_critical(logger, "Failed to create include_flags string");
+  if (!OTTER_ARRAY_RESERVE(target, files, allocator, spec->files_length) ||
+      !OTTER_ARRAY_RESERVE(target, dependencies, allocator,
+                           dependencies_length)) {
+    otter_log_critical(logger, "Failed to allocate arrays of %s and %s",
+                       OTTER_NAMEOF(target->files),
+                       OTTER_NAMEOF(target->dependencies));
     goto failure;
   }
 
-  const otter_string **file = files;
-  while (*file != NULL) {
-    otter_string *duplicated_file = otter_string_copy(*file);
-    if (duplicated_file == NULL) {
-      otter_log_critical(target->logger, "Unable to create string for '%s'",
-                         otter_string_cstr(*file));
+  for (size_t i = 0; i < spec->files_length; i++) {
+    if (!otter_target_append_file(target, spec->files[i])) {
       goto failure;
     }
-
-    if (!OTTER_ARRAY_APPEND(target, files, target->allocator,
-                            duplicated_file)) {
-      otter_string_free(duplicated_file);
-      goto failure;
-    }
-
-    file++;
   }
 
-  otter_target **dependency = dependencies;
-  while (*dependency != NULL) {
-    if (!OTTER_ARRAY_APPEND(target, dependencies, target->allocator,
-                            *dependency)) {
-      otter_log_critical(target->logger, "Failed to append target to %s",
-                         OTTER_NAMEOF(target->dependencies));
-      goto failure;
-    }
-
-    dependency++;
+  if (!otter_target_append_dependencies(target, spec->dependencies)) {
+    goto failure;
   }
 
-  otter_target_generate_c_executable_argv(target, flags);
-  if (!otter_target_generate_hash_c(target)) {
+  if (!otter_target_finalize(target)) {
     goto failure;
   }
 
   return target;
-
 failure:
   otter_target_free(target);
   return NULL;
 }
 
-otter_target *otter_target_create_c_shared_object(
-    const otter_string *name, const otter_string *flags,
+otter_target *otter_target_create_c_object(
+    const otter_string *name, const otter_string *cc_flags,
     const otter_string *include_flags, otter_allocator *allocator,
     otter_filesystem *filesystem, otter_logger *logger,
-    otter_process_manager *process_manager, const otter_string **files,
-    otter_target **dependencies) {
+    otter_process_manager *process_manager, ...) {
   OTTER_RETURN_IF_NULL(logger, name, NULL);
-  OTTER_RETURN_IF_NULL(logger, allocator, NULL);
-  OTTER_RETURN_IF_NULL(logger, filesystem, NULL);
-  OTTER_RETURN_IF_NULL(logger, logger, NULL);
-  OTTER_RETURN_IF_NULL(logger, process_manager, NULL);
-  OTTER_RETURN_IF_NULL(logger, files, NULL);
-  OTTER_RETURN_IF_NULL(logger, dependencies, NULL);
+  OTTER_RETURN_IF_NULL(logger, cc_flags, NULL);
+  OTTER_RETURN_IF_NULL(logger, include_flags, NULL);
 
   otter_target *target = otter_target_create_and_initialize(
-      name, allocator, filesystem, logger, process_manager,
-      OTTER_TARGET_SHARED_OBJECT);
+      otter_string_view_of(name), otter_string_view_of(cc_flags),
+      otter_string_view_of(include_flags), allocator, filesystem, logger,
+      process_manager, OTTER_TARGET_OBJECT);
   if (target == NULL) {
     return NULL;
   }
 
-  target->cc_flags = otter_string_copy(flags);
-  if (target->cc_flags == NULL) {
-    otter_log_critical(logger, "Failed to create cc_flags string");
-    goto failure;
+  va_list args;
+  va_start(args, process_manager);
+  const otter_string *file = va_arg(args, const otter_string *);
+  while (file != NULL) {
+    if (!otter_target_append_file(target, otter_string_view_of(file))) {
+      va_end(args);
+      goto failure;
+    }
+
+    file = va_arg(args, const otter_string *);
   }
 
-  target->include_flags = otter_string_copy(include_flags);
-  if (target->include_flags == NULL) {
-    otter_log_critical(logger, "Failed to create include_flags string");
+  va_end(args);
+  if (!otter_target_finalize(target)) {
     goto failure;
   }
 
-  const otter_string **file = files;
-  while (*file != NULL) {
-    otter_string *duplicated_file = otter_string_copy(*file);
-    if (duplicated_file == NULL) {
-      otter_log_critical(target->logger, "Unable to create string for '%s'",
-                         otter_string_cstr(*file));
-      goto failure;
-    }
+  return target;
+failure:
+  otter_target_free(target);
+  return NULL;
+}
 
-    if (!OTTER_ARRAY_APPEND(target, files, target->allocator,
-                            duplicated_file)) {
-      otter_string_free(duplicated_file);
-      goto failure;
-    }
+static otter_target *otter_target_create_c_linked(
+    otter_target_type type, const otter_string *name,
+    const otter_string *flags, const otter_string *include_flags,
+    otter_allocator *allocator, otter_filesystem *filesystem,
+    otter_logger *logger, otter_process_manager *process_manager,
+    const otter_string **files, otter_target **dependencies) {
+  OTTER_RETURN_IF_NULL(logger, name, NULL);
+  OTTER_RETURN_IF_NULL(logger, flags, NULL);
+  OTTER_RETURN_IF_NULL(logger, include_flags, NULL);
+  OTTER_RETURN_IF_NULL(logger, files, NULL);
+  OTTER_RETURN_IF_NULL(logger, dependencies, NULL);
 
-    file++;
+  otter_target *target = otter_target_create_and_initialize(
+      otter_string_view_of(name), otter_string_view_of(flags),
+      otter_string_view_of(include_flags), allocator, filesystem, logger,
+      process_manager, type);
+  if (target == NULL) {
+    return NULL;
   }
 
-  otter_target **dependency = dependencies;
-  while (*dependency != NULL) {
-    if (!OTTER_ARRAY_APPEND(target, dependencies, target->allocator,
-                            *dependency)) {
-      otter_log_critical(target->logger, "Failed to append target to %s",
-                         OTTER_NAMEOF(target->dependencies));
+  for (const otter_string **file = files; *file != NULL; file++) {
+    if (!otter_target_append_file(target, otter_string_view_of(*file))) {
       goto failure;
     }
+  }
 
-    dependency++;
+  if (!otter_target_append_dependencies(target, dependencies)) {
+    goto failure;
   }
 
-  otter_target_generate_c_shared_object_argv(target, flags);
-  if (!otter_target_generate_hash_c(target)) {
+  if (!otter_target_finalize(target)) {
     goto failure;
   }
 
@@ -989,6 +1397,28 @@ failure:
   return NULL;
 }
 
+otter_target *otter_target_create_c_executable(
+    const otter_string *name, const otter_string *flags,
+    const otter_string *include_flags, otter_allocator *allocator,
+    otter_filesystem *filesystem, otter_logger *logger,
+    otter_process_manager *process_manager, const otter_string **files,
+    otter_target **dependencies) {
+  return otter_target_create_c_linked(
+      OTTER_TARGET_EXECUTABLE, name, flags, include_flags, allocator,
+      filesystem, logger, process_manager, files, dependencies);
+}
+
+otter_target *otter_target_create_c_shared_object(
+    const otter_string *name, const otter_string *flags,
+    const otter_string *include_flags, otter_allocator *allocator,
+    otter_filesystem *filesystem, otter_logger *logger,
+    otter_process_manager *process_manager, const otter_string **files,
+    otter_target **dependencies) {
+  return otter_target_create_c_linked(
+      OTTER_TARGET_SHARED_OBJECT, name, flags, include_flags, allocator,
+      filesystem, logger, process_manager, files, dependencies);
+}
+
 void otter_target_add_command(otter_target *target,
                               const otter_string *command_) {
   if (target == NULL) {
@@ -1005,37 +1435,47 @@ void otter_target_add_command(otter_target *target,
   }
 
   target->command = otter_string_copy(command_);
-  const char *delims = " \t\n";
+  target->atomic_output = false;
+  if (!otter_target_ensure_strings(target)) {
+    return;
+  }
 
-  otter_string **tokens =
-      otter_string_split(target->allocator, command_, delims);
-  if (tokens == NULL) {
+  /* Arguments appended here bypass the index, it is rebuilt on demand */
+  OTTER_MAP_FREE(target, argv_set, target->allocator);
+  if (!otter_target_reserve_argv(target, otter_string_view_of(command_))) {
     return;
   }
 
-  for (size_t i = 0; tokens[i] != NULL; i++) {
-    if (!OTTER_ARRAY_APPEND(target, argv, target->allocator, tokens[i])) {
-      /* On failure, free remaining tokens and clear argv */
-      for (size_t j = i; tokens[j] != NULL; j++) {
-        otter_string_free(tokens[j]);
-      }
-      otter_free(target->allocator, tokens);
-      OTTER_ARRAY_FOREACH(target, argv, otter_string_free);
+  /* The argv entries are handles into the intern table, so the command is
+   * split in place rather than into temporary strings */
+  otter_string_split_iterator iterator;
+  otter_string_split_iterator_init(&iterator, otter_string_view_of(command_),
+                                   " \t\n");
+  otter_string_view token;
+  while (otter_string_split_next(&iterator, &token)) {
+    const otter_interned_string *arg = otter_intern(target->strings, token);
+    if (arg == NULL ||
+        !OTTER_ARRAY_APPEND(target, argv, target->allocator, arg)) {
+      otter_log_critical(target->logger, "Failed to append argument '%.*s'",
+                         OTTER_STRING_VIEW_ARG(token));
+      OTTER_ARRAY_LENGTH(target, argv) = 0;
       return;
     }
   }
-
-  /* Free the tokens array (but not the strings themselves - they're now in
-   * argv) */
-  otter_free(target->allocator, tokens);
 }
 
 void otter_target_add_dependency(otter_target *target, otter_target *dep) {
   OTTER_ARRAY_APPEND(target, dependencies, target->allocator, dep);
 }
 
-static bool otter_preprocess_and_hash_file_posix_spawnp(
+static bool otter_preprocess_and_hash_file_spawn(
     otter_target *target, gnutls_hash_hd_t hash_hd, const char *src_path) {
+  const char *cc_path =
+      otter_process_manager_resolve(target->process_manager, "cc");
+  if (cc_path == NULL) {
+    return false;
+  }
+
   int pipefd[2];
   if (pipe(pipefd) == -1) {
     otter_log_error(target->logger,
@@ -1079,14 +1519,9 @@ static bool otter_preprocess_and_hash_file_posix_spawnp(
   char **include_flag_tokens = NULL;
   size_t flag_count = 0;
   if (target->include_flags != NULL) {
-    include_flag_tokens = otter_string_split_cstr(
-        target->allocator, target->include_flags, " \t\n");
-    if (include_flag_tokens != NULL) {
-      /* Count tokens */
-      for (size_t i = 0; include_flag_tokens[i] != NULL; i++) {
-        flag_count++;
-      }
-    }
+    include_flag_tokens = otter_string_split_packed(
+        target->allocator, otter_string_view_of(target->include_flags),
+        " \t\n", &flag_count);
   }
 
   /* Allocate argv: cc + -E + -P + flags + path + NULL */
@@ -1095,10 +1530,7 @@ static bool otter_preprocess_and_hash_file_posix_spawnp(
   if (argv == NULL) {
     otter_free(target->allocator, path);
     if (include_flag_tokens != NULL) {
-      for (size_t i = 0; include_flag_tokens[i] != NULL; i++) {
-        otter_free(target->allocator, include_flag_tokens[i]);
-      }
-      otter_free(target->allocator, include_flag_tokens);
+      otter_free(target->allocator, (void *)include_flag_tokens);
     }
     return false;
   }
@@ -1113,43 +1545,35 @@ static bool otter_preprocess_and_hash_file_posix_spawnp(
   argv[arg_idx++] = otter_strdup(target->allocator, "-E");
   argv[arg_idx++] = otter_strdup(target->allocator, "-P");
 
-  /* Add include flags */
-  if (include_flag_tokens != NULL) {
-    for (size_t i = 0; include_flag_tokens[i] != NULL && arg_idx < argc - 2;
-         i++) {
-      argv[arg_idx++] = otter_strdup(target->allocator, include_flag_tokens[i]);
-    }
+  /* Add include flags, they point into the packed tokens */
+  const size_t first_flag = arg_idx;
+  for (size_t i = 0; i < flag_count; i++) {
+    argv[arg_idx++] = include_flag_tokens[i];
   }
 
   argv[arg_idx++] = path; /* Use path directly, don't dup again */
   argv[arg_idx] = NULL;
 
-  /* Free the token array (tokens were duplicated into argv) */
-  if (include_flag_tokens != NULL) {
-    for (size_t i = 0; include_flag_tokens[i] != NULL; i++) {
-      otter_free(target->allocator, include_flag_tokens[i]);
-    }
-    otter_free(target->allocator, include_flag_tokens);
-  }
-
   pid_t pid;
-  int spawn_err = posix_spawnp(&pid, "cc", &actions, NULL, argv, environ);
+  int spawn_err = posix_spawn(&pid, cc_path, &actions, NULL, argv, environ);
 
   /* actions may be destroyed regardless of spawn success */
   posix_spawn_file_actions_destroy(&actions);
 
-  /* Free argv array and all duplicated strings except path (freed below) */
-  for (size_t i = 0; i < arg_idx; i++) {
-    if (argv[i] != path) {
-      otter_free(target->allocator, argv[i]);
-    }
+  /* Free argv array and the duplicated "cc -E -P", the include flags and path
+   * are freed separately */
+  for (size_t i = 0; i < first_flag; i++) {
+    otter_free(target->allocator, argv[i]);
+  }
+  otter_free(target->allocator, (void *)argv);
+  if (include_flag_tokens != NULL) {
+    otter_free(target->allocator, (void *)include_flag_tokens);
   }
-  otter_free(target->allocator, argv);
   otter_free(target->allocator, path);
   if (spawn_err != 0) {
     otter_log_error(target->logger,
-                    "posix_spawnp failed to run gcc for '%s': '%s'", src_path,
-                    strerror(spawn_err));
+                    "posix_spawn failed to run '%s' for '%s': '%s'", cc_path,
+                    src_path, strerror(spawn_err));
     close(pipefd[0]);
     close(pipefd[1]);
     return false;
@@ -1197,8 +1621,9 @@ static bool otter_preprocess_and_hash_file_posix_spawnp(
 
   if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
     otter_log_error(target->logger,
-                    "Preprocessor (gcc -E) failed for '%s' with status %d",
-                    src_path, WIFEXITED(status) ? WEXITSTATUS(status) : status);
+                    "Preprocessor ('%s' -E) failed for '%s' with status %d",
+                    cc_path, src_path,
+                    WIFEXITED(status) ? WEXITSTATUS(status) : status);
     return false;
   }
 
@@ -1206,6 +1631,7 @@ static bool otter_preprocess_and_hash_file_posix_spawnp(
 }
 
 static bool otter_target_generate_hash_c(otter_target *target) {
+  target->hash_start_ns = otter_clock_now_ns();
   gnutls_hash_hd_t hash_hd;
   if (gnutls_hash_init(&hash_hd, GNUTLS_DIG_SHA1) < 0) {
     otter_log_critical(target->logger,
@@ -1220,7 +1646,7 @@ static bool otter_target_generate_hash_c(otter_target *target) {
   for (size_t i = 0; i < target->files_length; i++) {
     const char *src = otter_string_cstr(target->files[i]);
     otter_log_debug(target->logger, "Hashing file '%s'", src);
-    if (!otter_preprocess_and_hash_file_posix_spawnp(target, hash_hd, src)) {
+    if (!otter_preprocess_and_hash_file_spawn(target, hash_hd, src)) {
       otter_log_error(target->logger,
                       "Failed preprocessing+hashing of '%s' for target '%s'",
                       src, otter_string_cstr(target->name));
@@ -1239,6 +1665,7 @@ static bool otter_target_generate_hash_c(otter_target *target) {
   }
 
   gnutls_hash_deinit(hash_hd, target->hash);
+  target->hash_ns = otter_clock_now_ns() - target->hash_start_ns;
   return true;
 
 failure:
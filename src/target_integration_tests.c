@@ -20,6 +20,10 @@
 #include "otter/string.h"
 #include "otter/target.h"
 #include "otter/test.h"
+#include <stdio.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 OTTER_TEST(target_create_c_object_basic) {
   otter_filesystem *filesystem = NULL;
@@ -942,3 +946,418 @@ OTTER_TEST(target_create_shared_object_null_files) {
                  if (flags) otter_string_free(flags);
                  if (include_flags) otter_string_free(include_flags););
 }
+
+OTTER_TEST(target_check_stale_reports_reason) {
+  otter_filesystem *filesystem = NULL;
+  otter_logger *logger = NULL;
+  otter_process_manager *proc_mgr = NULL;
+  otter_target *target = NULL;
+  otter_string *name = NULL;
+  otter_string *flags = NULL;
+  otter_string *other_flags = NULL;
+  otter_string *include_flags = NULL;
+  otter_string *file = NULL;
+
+  filesystem = otter_filesystem_create(OTTER_TEST_ALLOCATOR);
+  OTTER_ASSERT(filesystem != NULL);
+
+  logger = otter_logger_create(OTTER_TEST_ALLOCATOR, OTTER_LOG_LEVEL_ERROR);
+  OTTER_ASSERT(logger != NULL);
+
+  proc_mgr = otter_process_manager_create(OTTER_TEST_ALLOCATOR, logger);
+  OTTER_ASSERT(proc_mgr != NULL);
+
+  name = otter_string_from_cstr(OTTER_TEST_ALLOCATOR,
+                                "test_fixtures/test_stale.o");
+  OTTER_ASSERT(name != NULL);
+
+  flags = otter_string_from_cstr(OTTER_TEST_ALLOCATOR, "-Wall");
+  OTTER_ASSERT(flags != NULL);
+
+  other_flags = otter_string_from_cstr(OTTER_TEST_ALLOCATOR, "-Wall -O1");
+  OTTER_ASSERT(other_flags != NULL);
+
+  include_flags = otter_string_from_cstr(OTTER_TEST_ALLOCATOR, "-Iinclude");
+  OTTER_ASSERT(include_flags != NULL);
+
+  file = otter_string_from_cstr(OTTER_TEST_ALLOCATOR, "test_fixtures/test.c");
+  OTTER_ASSERT(file != NULL);
+
+  remove("test_fixtures/test_stale.o");
+  target = otter_target_create_c_object(name, flags, include_flags,
+                                        OTTER_TEST_ALLOCATOR, filesystem,
+                                        logger, proc_mgr, file, NULL);
+  OTTER_ASSERT(target != NULL);
+  OTTER_ASSERT(otter_target_check_stale(target) ==
+               OTTER_TARGET_STALE_MISSING_OUTPUT);
+
+  OTTER_ASSERT(otter_target_execute(target) == 0);
+  OTTER_ASSERT(otter_target_check_stale(target) == OTTER_TARGET_UP_TO_DATE);
+  OTTER_ASSERT(otter_target_historical_cost_ns(target) > 0);
+
+  /* Same sources, different flags */
+  otter_target_free(target);
+  target = otter_target_create_c_object(name, other_flags, include_flags,
+                                        OTTER_TEST_ALLOCATOR, filesystem,
+                                        logger, proc_mgr, file, NULL);
+  OTTER_ASSERT(target != NULL);
+  OTTER_ASSERT(otter_target_check_stale(target) ==
+               OTTER_TARGET_STALE_FLAGS_CHANGED);
+
+  OTTER_TEST_END(remove("test_fixtures/test_stale.o");
+                 if (target) otter_target_free(target);
+                 if (proc_mgr) otter_process_manager_free(proc_mgr);
+                 if (logger) otter_logger_free(logger);
+                 if (filesystem) otter_filesystem_free(filesystem);
+                 if (name) otter_string_free(name);
+                 if (flags) otter_string_free(flags);
+                 if (other_flags) otter_string_free(other_flags);
+                 if (include_flags) otter_string_free(include_flags);
+                 if (file) otter_string_free(file););
+}
+
+OTTER_TEST(target_identical_output_does_not_relink_dependents) {
+  otter_filesystem *filesystem = NULL;
+  otter_logger *logger = NULL;
+  otter_process_manager *proc_mgr = NULL;
+  otter_target *obj_target = NULL;
+  otter_target *exe_target = NULL;
+  otter_string *obj_name = NULL;
+  otter_string *exe_name = NULL;
+  otter_string *flags = NULL;
+  otter_string *warning_flags = NULL;
+  otter_string *include_flags = NULL;
+  otter_string *obj_file = NULL;
+  otter_string *exe_file = NULL;
+
+  filesystem = otter_filesystem_create(OTTER_TEST_ALLOCATOR);
+  OTTER_ASSERT(filesystem != NULL);
+
+  logger = otter_logger_create(OTTER_TEST_ALLOCATOR, OTTER_LOG_LEVEL_ERROR);
+  OTTER_ASSERT(logger != NULL);
+
+  proc_mgr = otter_process_manager_create(OTTER_TEST_ALLOCATOR, logger);
+  OTTER_ASSERT(proc_mgr != NULL);
+
+  obj_name = otter_string_from_cstr(OTTER_TEST_ALLOCATOR,
+                                    "test_fixtures/lib_restat.o");
+  OTTER_ASSERT(obj_name != NULL);
+
+  exe_name =
+      otter_string_from_cstr(OTTER_TEST_ALLOCATOR, "test_fixtures/main_restat");
+  OTTER_ASSERT(exe_name != NULL);
+
+  flags = otter_string_from_cstr(OTTER_TEST_ALLOCATOR, "-Wall");
+  OTTER_ASSERT(flags != NULL);
+
+  /* Only changes diagnostics, so the object file stays the same */
+  warning_flags =
+      otter_string_from_cstr(OTTER_TEST_ALLOCATOR, "-Wall -Wextra");
+  OTTER_ASSERT(warning_flags != NULL);
+
+  include_flags = otter_string_from_cstr(OTTER_TEST_ALLOCATOR, "-Iinclude");
+  OTTER_ASSERT(include_flags != NULL);
+
+  obj_file =
+      otter_string_from_cstr(OTTER_TEST_ALLOCATOR, "test_fixtures/lib.c");
+  OTTER_ASSERT(obj_file != NULL);
+
+  exe_file =
+      otter_string_from_cstr(OTTER_TEST_ALLOCATOR, "test_fixtures/main.c");
+  OTTER_ASSERT(exe_file != NULL);
+
+  remove("test_fixtures/lib_restat.o");
+  remove("test_fixtures/main_restat");
+
+  const otter_string *exe_files[] = {exe_file, NULL};
+  obj_target = otter_target_create_c_object(obj_name, flags, include_flags,
+                                            OTTER_TEST_ALLOCATOR, filesystem,
+                                            logger, proc_mgr, obj_file, NULL);
+  OTTER_ASSERT(obj_target != NULL);
+  otter_target *deps[] = {obj_target, NULL};
+  exe_target = otter_target_create_c_executable(
+      exe_name, flags, include_flags, OTTER_TEST_ALLOCATOR, filesystem, logger,
+      proc_mgr, exe_files, deps);
+  OTTER_ASSERT(exe_target != NULL);
+  OTTER_ASSERT(otter_target_execute(exe_target) == 0);
+  OTTER_ASSERT(exe_target->executed == true);
+  OTTER_ASSERT(obj_target->executed == true);
+
+  otter_target_free(exe_target);
+  exe_target = NULL;
+  otter_target_free(obj_target);
+  obj_target = NULL;
+
+  /* The object is recompiled because its flags changed, but its output is
+   * byte-identical so the executable is not relinked */
+  obj_target = otter_target_create_c_object(obj_name, warning_flags,
+                                            include_flags, OTTER_TEST_ALLOCATOR,
+                                            filesystem, logger, proc_mgr,
+                                            obj_file, NULL);
+  OTTER_ASSERT(obj_target != NULL);
+  deps[0] = obj_target;
+  exe_target = otter_target_create_c_executable(
+      exe_name, flags, include_flags, OTTER_TEST_ALLOCATOR, filesystem, logger,
+      proc_mgr, exe_files, deps);
+  OTTER_ASSERT(exe_target != NULL);
+  OTTER_ASSERT(otter_target_execute(exe_target) == 0);
+  OTTER_ASSERT(obj_target->stale_reason == OTTER_TARGET_STALE_FLAGS_CHANGED);
+  OTTER_ASSERT(obj_target->executed == false);
+  OTTER_ASSERT(exe_target->executed == false);
+
+  OTTER_TEST_END(remove("test_fixtures/lib_restat.o");
+                 remove("test_fixtures/main_restat");
+                 if (exe_target) otter_target_free(exe_target);
+                 if (obj_target) otter_target_free(obj_target);
+                 if (proc_mgr) otter_process_manager_free(proc_mgr);
+                 if (logger) otter_logger_free(logger);
+                 if (filesystem) otter_filesystem_free(filesystem);
+                 if (obj_name) otter_string_free(obj_name);
+                 if (exe_name) otter_string_free(exe_name);
+                 if (flags) otter_string_free(flags);
+                 if (warning_flags) otter_string_free(warning_flags);
+                 if (include_flags) otter_string_free(include_flags);
+                 if (obj_file) otter_string_free(obj_file);
+                 if (exe_file) otter_string_free(exe_file););
+}
+
+OTTER_TEST(target_execute_publishes_output_atomically) {
+  otter_filesystem *filesystem = NULL;
+  otter_logger *logger = NULL;
+  otter_process_manager *proc_mgr = NULL;
+  otter_target *target = NULL;
+  otter_string *name = NULL;
+  otter_string *flags = NULL;
+  otter_string *include_flags = NULL;
+  otter_string *file = NULL;
+
+  filesystem = otter_filesystem_create(OTTER_TEST_ALLOCATOR);
+  OTTER_ASSERT(filesystem != NULL);
+
+  logger = otter_logger_create(OTTER_TEST_ALLOCATOR, OTTER_LOG_LEVEL_ERROR);
+  OTTER_ASSERT(logger != NULL);
+
+  proc_mgr = otter_process_manager_create(OTTER_TEST_ALLOCATOR, logger);
+  OTTER_ASSERT(proc_mgr != NULL);
+
+  name = otter_string_from_cstr(OTTER_TEST_ALLOCATOR,
+                                "test_fixtures/test_atomic.o");
+  OTTER_ASSERT(name != NULL);
+
+  flags = otter_string_from_cstr(OTTER_TEST_ALLOCATOR, "-Wall");
+  OTTER_ASSERT(flags != NULL);
+
+  include_flags = otter_string_from_cstr(OTTER_TEST_ALLOCATOR, "-Iinclude");
+  OTTER_ASSERT(include_flags != NULL);
+
+  file = otter_string_from_cstr(OTTER_TEST_ALLOCATOR, "test_fixtures/test.c");
+  OTTER_ASSERT(file != NULL);
+
+  remove("test_fixtures/test_atomic.o");
+  target = otter_target_create_c_object(name, flags, include_flags,
+                                        OTTER_TEST_ALLOCATOR, filesystem,
+                                        logger, proc_mgr, file, NULL);
+  OTTER_ASSERT(target != NULL);
+  OTTER_ASSERT(target->atomic_output == true);
+  OTTER_ASSERT(otter_target_execute(target) == 0);
+
+  /* The temporary file was renamed over the output together with its
+   * attributes, and the command digest does not include its name */
+  char temp_path[256];
+  snprintf(temp_path, sizeof(temp_path),
+           "test_fixtures/" OTTER_TARGET_TEMP_DIR "/%ld/test_atomic.o",
+           (long)getpid());
+  OTTER_ASSERT(!otter_filesystem_exists(filesystem, temp_path));
+  OTTER_ASSERT(
+      otter_filesystem_exists(filesystem, "test_fixtures/test_atomic.o"));
+  OTTER_ASSERT(strstr(otter_string_cstr(target->command),
+                      OTTER_TARGET_TEMP_DIR) == NULL);
+  OTTER_ASSERT(otter_target_check_stale(target) == OTTER_TARGET_UP_TO_DATE);
+
+  OTTER_TEST_END(remove("test_fixtures/test_atomic.o");
+                 if (target) otter_target_free(target);
+                 if (proc_mgr) otter_process_manager_free(proc_mgr);
+                 if (logger) otter_logger_free(logger);
+                 if (filesystem) otter_filesystem_free(filesystem);
+                 if (name) otter_string_free(name);
+                 if (flags) otter_string_free(flags);
+                 if (include_flags) otter_string_free(include_flags);
+                 if (file) otter_string_free(file););
+}
+
+OTTER_TEST(target_execute_keeps_coverage_names) {
+  otter_filesystem *filesystem = NULL;
+  otter_logger *logger = NULL;
+  otter_process_manager *proc_mgr = NULL;
+  otter_target *target = NULL;
+  FILE *stale = NULL;
+
+  filesystem = otter_filesystem_create(OTTER_TEST_ALLOCATOR);
+  OTTER_ASSERT(filesystem != NULL);
+
+  logger = otter_logger_create(OTTER_TEST_ALLOCATOR, OTTER_LOG_LEVEL_ERROR);
+  OTTER_ASSERT(logger != NULL);
+
+  proc_mgr = otter_process_manager_create(OTTER_TEST_ALLOCATOR, logger);
+  OTTER_ASSERT(proc_mgr != NULL);
+
+  /* A temporary output left behind by a build that was killed */
+  fflush(stdout);
+  fflush(stderr);
+  const pid_t killed = fork();
+  OTTER_ASSERT(killed >= 0);
+  if (killed == 0) {
+    _exit(0);
+  }
+
+  OTTER_ASSERT(waitpid(killed, NULL, 0) == killed);
+  char stale_dir[256];
+  snprintf(stale_dir, sizeof(stale_dir),
+           "test_fixtures/" OTTER_TARGET_TEMP_DIR "/%ld", (long)killed);
+  char stale_path[300];
+  snprintf(stale_path, sizeof(stale_path), "%s/test_coverage.o", stale_dir);
+  OTTER_ASSERT(otter_filesystem_make_directory(
+      filesystem, "test_fixtures/" OTTER_TARGET_TEMP_DIR));
+  OTTER_ASSERT(otter_filesystem_make_directory(filesystem, stale_dir));
+  stale = fopen(stale_path, "w");
+  OTTER_ASSERT(stale != NULL);
+  fputs("truncated", stale);
+  fclose(stale);
+  stale = NULL;
+
+  remove("test_fixtures/test_coverage.o");
+  remove("test_fixtures/test_coverage.gcno");
+  const otter_string_view file =
+      otter_string_view_from_cstr("test_fixtures/test.c");
+  const otter_target_spec spec = {
+      .type = OTTER_TARGET_OBJECT,
+      .name = otter_string_view_from_cstr("test_fixtures/test_coverage.o"),
+      .flags = otter_string_view_from_cstr("--coverage"),
+      .include_flags = otter_string_view_from_cstr("-Iinclude"),
+      .files = &file,
+      .files_length = 1,
+      .dependencies = NULL,
+  };
+  target = otter_target_create(&spec, OTTER_TEST_ALLOCATOR, filesystem,
+                               logger, proc_mgr);
+  OTTER_ASSERT(target != NULL);
+  OTTER_ASSERT(otter_target_execute(target) == 0);
+
+  /* The notes are named after the output, not the temporary file, and the
+   * killed build's directory is gone */
+  char temp_dir[256];
+  snprintf(temp_dir, sizeof(temp_dir),
+           "test_fixtures/" OTTER_TARGET_TEMP_DIR "/%ld", (long)getpid());
+  char temp_notes[300];
+  snprintf(temp_notes, sizeof(temp_notes), "%s/test_coverage.gcno", temp_dir);
+  OTTER_ASSERT(
+      otter_filesystem_exists(filesystem, "test_fixtures/test_coverage.gcno"));
+  OTTER_ASSERT(!otter_filesystem_exists(filesystem, temp_notes));
+  OTTER_ASSERT(!otter_filesystem_exists(filesystem, stale_path));
+  OTTER_ASSERT(!otter_filesystem_exists(filesystem, stale_dir));
+  OTTER_ASSERT(otter_target_check_stale(target) == OTTER_TARGET_UP_TO_DATE);
+
+  OTTER_TEST_END(if (stale) fclose(stale);
+                 remove("test_fixtures/test_coverage.o");
+                 remove("test_fixtures/test_coverage.gcno");
+                 if (target) otter_target_free(target);
+                 if (proc_mgr) otter_process_manager_free(proc_mgr);
+                 if (logger) otter_logger_free(logger);
+                 if (filesystem) otter_filesystem_free(filesystem););
+}
+
+#define CONCURRENT_BUILDS 2
+#define CONCURRENT_ROUNDS 5
+
+/* Builds name from scratch a few times over in a child process, which exits
+ * with a failure as soon as one of the builds does */
+static pid_t build_concurrently(const otter_target_spec *spec) {
+  fflush(stdout);
+  fflush(stderr);
+  const pid_t pid = fork();
+  if (pid != 0) {
+    return pid;
+  }
+
+  otter_allocator *allocator = otter_allocator_create();
+  otter_filesystem *filesystem = otter_filesystem_create(allocator);
+  otter_logger *logger = otter_logger_create(allocator, OTTER_LOG_LEVEL_ERROR);
+  otter_process_manager *proc_mgr =
+      otter_process_manager_create(allocator, logger);
+  otter_target *target =
+      otter_target_create(spec, allocator, filesystem, logger, proc_mgr);
+  if (target == NULL) {
+    _exit(1);
+  }
+
+  for (int i = 0; i < CONCURRENT_ROUNDS; i++) {
+    if (otter_target_execute(target) != 0) {
+      _exit(1);
+    }
+  }
+
+  _exit(0);
+}
+
+static void wait_for_builds(const pid_t *builds) {
+  for (int i = 0; i < CONCURRENT_BUILDS; i++) {
+    if (builds[i] > 0) {
+      waitpid(builds[i], NULL, 0);
+    }
+  }
+}
+
+OTTER_TEST(target_execute_concurrent_builds) {
+  otter_filesystem *filesystem = NULL;
+  otter_logger *logger = NULL;
+  otter_process_manager *proc_mgr = NULL;
+  otter_target *target = NULL;
+  pid_t builds[CONCURRENT_BUILDS] = {0};
+
+  remove("test_fixtures/test_concurrent.o");
+  const otter_string_view file =
+      otter_string_view_from_cstr("test_fixtures/test.c");
+  const otter_target_spec spec = {
+      .type = OTTER_TARGET_OBJECT,
+      .name = otter_string_view_from_cstr("test_fixtures/test_concurrent.o"),
+      .flags = otter_string_view_from_cstr("-Wall"),
+      .include_flags = otter_string_view_from_cstr("-Iinclude"),
+      .files = &file,
+      .files_length = 1,
+      .dependencies = NULL,
+  };
+  for (int i = 0; i < CONCURRENT_BUILDS; i++) {
+    builds[i] = build_concurrently(&spec);
+    OTTER_ASSERT(builds[i] > 0);
+  }
+
+  /* Neither build saw its temporary file taken over by the other */
+  for (int i = 0; i < CONCURRENT_BUILDS; i++) {
+    int status = 0;
+    OTTER_ASSERT(waitpid(builds[i], &status, 0) == builds[i]);
+    builds[i] = 0;
+    OTTER_ASSERT(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  }
+
+  filesystem = otter_filesystem_create(OTTER_TEST_ALLOCATOR);
+  OTTER_ASSERT(filesystem != NULL);
+
+  logger = otter_logger_create(OTTER_TEST_ALLOCATOR, OTTER_LOG_LEVEL_ERROR);
+  OTTER_ASSERT(logger != NULL);
+
+  proc_mgr = otter_process_manager_create(OTTER_TEST_ALLOCATOR, logger);
+  OTTER_ASSERT(proc_mgr != NULL);
+
+  /* The published object matches the digest stored on it */
+  target = otter_target_create(&spec, OTTER_TEST_ALLOCATOR, filesystem,
+                               logger, proc_mgr);
+  OTTER_ASSERT(target != NULL);
+  OTTER_ASSERT(otter_target_check_stale(target) == OTTER_TARGET_UP_TO_DATE);
+
+  OTTER_TEST_END(wait_for_builds(builds);
+                 remove("test_fixtures/test_concurrent.o");
+                 if (target) otter_target_free(target);
+                 if (proc_mgr) otter_process_manager_free(proc_mgr);
+                 if (logger) otter_logger_free(logger);
+                 if (filesystem) otter_filesystem_free(filesystem););
+}
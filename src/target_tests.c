@@ -20,12 +20,41 @@
 #include "otter/string.h"
 #include "otter/target.h"
 #include "otter/test.h"
+#include <string.h>
 
 static void *malloc_mock_fail(otter_allocator * /* unused */,
                               size_t /*unused */) {
   return NULL;
 }
 
+/* Hands whatever a test does not mock on to the test allocator */
+typedef struct otter_allocator_mock_forwarding {
+  otter_allocator base;
+  otter_allocator *parent;
+} otter_allocator_mock_forwarding;
+
+static void *otter_allocator_mock_forwarding_malloc_impl(
+    otter_allocator *allocator, size_t size) {
+  otter_allocator_mock_forwarding *mock =
+      (otter_allocator_mock_forwarding *)allocator;
+  return otter_malloc(mock->parent, size);
+}
+
+static void *otter_allocator_mock_forwarding_realloc_impl(
+    otter_allocator *allocator, void *pointer, size_t size) {
+  otter_allocator_mock_forwarding *mock =
+      (otter_allocator_mock_forwarding *)allocator;
+  return otter_realloc(mock->parent, pointer, size);
+}
+
+static void
+otter_allocator_mock_forwarding_free_impl(otter_allocator *allocator,
+                                          void *pointer) {
+  otter_allocator_mock_forwarding *mock =
+      (otter_allocator_mock_forwarding *)allocator;
+  otter_free(mock->parent, pointer);
+}
+
 OTTER_TEST(target_create_c_object_malloc_fails) {
   otter_filesystem *filesystem = NULL;
   otter_logger *logger = NULL;
@@ -60,17 +89,19 @@ OTTER_TEST(target_create_c_object_malloc_fails) {
   /* Create failing allocator */
   otter_allocator_vtable vtable = {
       .malloc = malloc_mock_fail,
-      .realloc = OTTER_TEST_ALLOCATOR->vtable->realloc,
-      .free = OTTER_TEST_ALLOCATOR->vtable->free,
+      .realloc = otter_allocator_mock_forwarding_realloc_impl,
+      .free = otter_allocator_mock_forwarding_free_impl,
   };
-  otter_allocator allocator = {
-      .vtable = &vtable,
+  otter_allocator_mock_forwarding allocator = {
+      .base = {.vtable = &vtable},
+      .parent = OTTER_TEST_ALLOCATOR,
   };
 
   /* Target creation should fail due to malloc failure */
   target =
-      otter_target_create_c_object(name, flags, include_flags, &allocator,
-                                   filesystem, logger, proc_mgr, file, NULL);
+      otter_target_create_c_object(name, flags, include_flags,
+                                   &allocator.base, filesystem, logger,
+                                   proc_mgr, file, NULL);
   OTTER_ASSERT(target == NULL);
 
   OTTER_TEST_END(if (proc_mgr) otter_process_manager_free(proc_mgr);
@@ -116,11 +147,12 @@ OTTER_TEST(target_create_executable_malloc_fails) {
   /* Create failing allocator */
   otter_allocator_vtable vtable = {
       .malloc = malloc_mock_fail,
-      .realloc = OTTER_TEST_ALLOCATOR->vtable->realloc,
-      .free = OTTER_TEST_ALLOCATOR->vtable->free,
+      .realloc = otter_allocator_mock_forwarding_realloc_impl,
+      .free = otter_allocator_mock_forwarding_free_impl,
   };
-  otter_allocator allocator = {
-      .vtable = &vtable,
+  otter_allocator_mock_forwarding allocator = {
+      .base = {.vtable = &vtable},
+      .parent = OTTER_TEST_ALLOCATOR,
   };
 
   const otter_string *files[] = {file, NULL};
@@ -128,8 +160,8 @@ OTTER_TEST(target_create_executable_malloc_fails) {
 
   /* Target creation should fail due to malloc failure */
   target = otter_target_create_c_executable(name, flags, include_flags,
-                                            &allocator, filesystem, logger,
-                                            proc_mgr, files, deps);
+                                            &allocator.base, filesystem,
+                                            logger, proc_mgr, files, deps);
   OTTER_ASSERT(target == NULL);
 
   OTTER_TEST_END(if (proc_mgr) otter_process_manager_free(proc_mgr);
@@ -175,11 +207,12 @@ OTTER_TEST(target_create_shared_object_malloc_fails) {
   /* Create failing allocator */
   otter_allocator_vtable vtable = {
       .malloc = malloc_mock_fail,
-      .realloc = OTTER_TEST_ALLOCATOR->vtable->realloc,
-      .free = OTTER_TEST_ALLOCATOR->vtable->free,
+      .realloc = otter_allocator_mock_forwarding_realloc_impl,
+      .free = otter_allocator_mock_forwarding_free_impl,
   };
-  otter_allocator allocator = {
-      .vtable = &vtable,
+  otter_allocator_mock_forwarding allocator = {
+      .base = {.vtable = &vtable},
+      .parent = OTTER_TEST_ALLOCATOR,
   };
 
   const otter_string *files[] = {file, NULL};
@@ -187,8 +220,8 @@ OTTER_TEST(target_create_shared_object_malloc_fails) {
 
   /* Target creation should fail due to malloc failure */
   target = otter_target_create_c_shared_object(name, flags, include_flags,
-                                               &allocator, filesystem, logger,
-                                               proc_mgr, files, deps);
+                                               &allocator.base, filesystem,
+                                               logger, proc_mgr, files, deps);
   OTTER_ASSERT(target == NULL);
 
   OTTER_TEST_END(if (proc_mgr) otter_process_manager_free(proc_mgr);
@@ -203,22 +236,26 @@ OTTER_TEST(target_create_shared_object_malloc_fails) {
 /* Counter for selective malloc failures */
 static int malloc_call_count = 0;
 static int malloc_fail_at = -1;
-static otter_allocator *saved_allocator = NULL;
 
-/* Named constants for malloc call positions */
+/* Named constants for malloc call positions. The arrays are only allocated
+ * once they outgrow their inline items, so they come after the strings are
+ * copied */
 #define NAME_COPY_MALLOC_COUNT 2
-#define DEPENDENCIES_ARRAY_MALLOC_COUNT 3
-#define FILES_ARRAY_MALLOC_COUNT 4
-#define CC_FLAGS_COPY_MALLOC_COUNT 5
-#define INCLUDE_FLAGS_COPY_MALLOC_COUNT 7
-#define FILE_COPY_MALLOC_COUNT 9
+#define CC_FLAGS_COPY_MALLOC_COUNT 3
+#define INCLUDE_FLAGS_COPY_MALLOC_COUNT 4
+#define FILE_COPY_MALLOC_COUNT 5
+/* After copying one more file than fits inline */
+#define FILES_ARRAY_MALLOC_COUNT                                               \
+  (FILE_COPY_MALLOC_COUNT + OTTER_TARGET_INLINE_FILES + 1)
+/* otter_target_create reserves the dependencies before copying any files */
+#define DEPENDENCIES_ARRAY_MALLOC_COUNT 5
 
 static void *malloc_mock_selective(otter_allocator *allocator, size_t size) {
   malloc_call_count++;
   if (malloc_call_count == malloc_fail_at) {
     return NULL;
   }
-  return saved_allocator->vtable->malloc(allocator, size);
+  return otter_allocator_mock_forwarding_malloc_impl(allocator, size);
 }
 
 OTTER_TEST(target_create_name_copy_fails) {
@@ -255,21 +292,22 @@ OTTER_TEST(target_create_name_copy_fails) {
   /* Create allocator that fails on 2nd malloc (name copy) */
   malloc_call_count = 0;
   malloc_fail_at = NAME_COPY_MALLOC_COUNT;
-  saved_allocator = OTTER_TEST_ALLOCATOR;
 
   otter_allocator_vtable vtable = {
       .malloc = malloc_mock_selective,
-      .realloc = OTTER_TEST_ALLOCATOR->vtable->realloc,
-      .free = OTTER_TEST_ALLOCATOR->vtable->free,
+      .realloc = otter_allocator_mock_forwarding_realloc_impl,
+      .free = otter_allocator_mock_forwarding_free_impl,
   };
-  otter_allocator allocator = {
-      .vtable = &vtable,
+  otter_allocator_mock_forwarding allocator = {
+      .base = {.vtable = &vtable},
+      .parent = OTTER_TEST_ALLOCATOR,
   };
 
   /* Target creation should fail when name copy fails */
   target =
-      otter_target_create_c_object(name, flags, include_flags, &allocator,
-                                   filesystem, logger, proc_mgr, file, NULL);
+      otter_target_create_c_object(name, flags, include_flags,
+                                   &allocator.base, filesystem, logger,
+                                   proc_mgr, file, NULL);
   OTTER_ASSERT(target == NULL);
 
   OTTER_TEST_END(if (proc_mgr) otter_process_manager_free(proc_mgr);
@@ -285,11 +323,8 @@ OTTER_TEST(target_create_dependencies_array_fails) {
   otter_filesystem *filesystem = NULL;
   otter_logger *logger = NULL;
   otter_process_manager *proc_mgr = NULL;
+  otter_target *dependency = NULL;
   otter_target *target = NULL;
-  otter_string *name = NULL;
-  otter_string *flags = NULL;
-  otter_string *include_flags = NULL;
-  otter_string *file = NULL;
 
   filesystem = otter_filesystem_create(OTTER_TEST_ALLOCATOR);
   OTTER_ASSERT(filesystem != NULL);
@@ -300,45 +335,51 @@ OTTER_TEST(target_create_dependencies_array_fails) {
   proc_mgr = otter_process_manager_create(OTTER_TEST_ALLOCATOR, logger);
   OTTER_ASSERT(proc_mgr != NULL);
 
-  name = otter_string_from_cstr(OTTER_TEST_ALLOCATOR, "test.o");
-  OTTER_ASSERT(name != NULL);
-
-  flags = otter_string_from_cstr(OTTER_TEST_ALLOCATOR, "-Wall");
-  OTTER_ASSERT(flags != NULL);
-
-  include_flags = otter_string_from_cstr(OTTER_TEST_ALLOCATOR, "-Iinclude");
-  OTTER_ASSERT(include_flags != NULL);
-
-  file = otter_string_from_cstr(OTTER_TEST_ALLOCATOR, "test_fixtures/test.c");
-  OTTER_ASSERT(file != NULL);
+  const otter_string_view file =
+      otter_string_view_from_cstr("test_fixtures/test.c");
+  otter_target_spec spec = {
+      .type = OTTER_TARGET_OBJECT,
+      .name = otter_string_view_from_cstr("dependency.o"),
+      .flags = otter_string_view_from_cstr("-Wall"),
+      .include_flags = otter_string_view_from_cstr("-Iinclude"),
+      .files = &file,
+      .files_length = 1,
+      .dependencies = NULL,
+  };
+  dependency = otter_target_create(&spec, OTTER_TEST_ALLOCATOR, filesystem,
+                                   logger, proc_mgr);
+  OTTER_ASSERT(dependency != NULL);
 
-  /* Create allocator that fails on 3rd malloc (dependencies array) */
+  /* Create allocator that fails on 5th malloc (dependencies array) */
   malloc_call_count = 0;
   malloc_fail_at = DEPENDENCIES_ARRAY_MALLOC_COUNT;
-  saved_allocator = OTTER_TEST_ALLOCATOR;
 
   otter_allocator_vtable vtable = {
       .malloc = malloc_mock_selective,
-      .realloc = OTTER_TEST_ALLOCATOR->vtable->realloc,
-      .free = OTTER_TEST_ALLOCATOR->vtable->free,
+      .realloc = otter_allocator_mock_forwarding_realloc_impl,
+      .free = otter_allocator_mock_forwarding_free_impl,
   };
-  otter_allocator allocator = {
-      .vtable = &vtable,
+  otter_allocator_mock_forwarding allocator = {
+      .base = {.vtable = &vtable},
+      .parent = OTTER_TEST_ALLOCATOR,
   };
 
   /* Target creation should fail when dependencies array allocation fails */
-  target =
-      otter_target_create_c_object(name, flags, include_flags, &allocator,
-                                   filesystem, logger, proc_mgr, file, NULL);
+  otter_target *dependencies[OTTER_TARGET_INLINE_DEPENDENCIES + 2] = {0};
+  for (size_t i = 0; i < OTTER_TARGET_INLINE_DEPENDENCIES + 1; i++) {
+    dependencies[i] = dependency;
+  }
+  spec.name = otter_string_view_from_cstr("test.o");
+  spec.dependencies = dependencies;
+  target = otter_target_create(&spec, &allocator.base, filesystem, logger,
+                               proc_mgr);
   OTTER_ASSERT(target == NULL);
+  OTTER_ASSERT(malloc_call_count == DEPENDENCIES_ARRAY_MALLOC_COUNT);
 
-  OTTER_TEST_END(if (proc_mgr) otter_process_manager_free(proc_mgr);
+  OTTER_TEST_END(if (dependency) otter_target_free(dependency);
+                 if (proc_mgr) otter_process_manager_free(proc_mgr);
                  if (logger) otter_logger_free(logger);
-                 if (filesystem) otter_filesystem_free(filesystem);
-                 if (name) otter_string_free(name);
-                 if (flags) otter_string_free(flags);
-                 if (include_flags) otter_string_free(include_flags);
-                 if (file) otter_string_free(file););
+                 if (filesystem) otter_filesystem_free(filesystem););
 }
 
 OTTER_TEST(target_create_files_array_fails) {
@@ -372,25 +413,27 @@ OTTER_TEST(target_create_files_array_fails) {
   file = otter_string_from_cstr(OTTER_TEST_ALLOCATOR, "test_fixtures/test.c");
   OTTER_ASSERT(file != NULL);
 
-  /* Create allocator that fails on 4th malloc (files array) */
+  /* Create allocator that fails once the files no longer fit inline */
   malloc_call_count = 0;
   malloc_fail_at = FILES_ARRAY_MALLOC_COUNT;
-  saved_allocator = OTTER_TEST_ALLOCATOR;
 
   otter_allocator_vtable vtable = {
       .malloc = malloc_mock_selective,
-      .realloc = OTTER_TEST_ALLOCATOR->vtable->realloc,
-      .free = OTTER_TEST_ALLOCATOR->vtable->free,
+      .realloc = otter_allocator_mock_forwarding_realloc_impl,
+      .free = otter_allocator_mock_forwarding_free_impl,
   };
-  otter_allocator allocator = {
-      .vtable = &vtable,
+  otter_allocator_mock_forwarding allocator = {
+      .base = {.vtable = &vtable},
+      .parent = OTTER_TEST_ALLOCATOR,
   };
 
-  /* Target creation should fail when files array allocation fails */
-  target =
-      otter_target_create_c_object(name, flags, include_flags, &allocator,
-                                   filesystem, logger, proc_mgr, file, NULL);
+  /* Target creation should fail when files array allocation fails, three
+   * files are one more than fit inline */
+  target = otter_target_create_c_object(name, flags, include_flags,
+                                        &allocator.base, filesystem, logger,
+                                        proc_mgr, file, file, file, NULL);
   OTTER_ASSERT(target == NULL);
+  OTTER_ASSERT(malloc_call_count == FILES_ARRAY_MALLOC_COUNT);
 
   OTTER_TEST_END(if (proc_mgr) otter_process_manager_free(proc_mgr);
                  if (logger) otter_logger_free(logger);
@@ -400,3 +443,108 @@ OTTER_TEST(target_create_files_array_fails) {
                  if (include_flags) otter_string_free(include_flags);
                  if (file) otter_string_free(file););
 }
+
+OTTER_TEST(target_create_copies_views) {
+  otter_filesystem *filesystem = NULL;
+  otter_logger *logger = NULL;
+  otter_process_manager *proc_mgr = NULL;
+  otter_target *target = NULL;
+
+  filesystem = otter_filesystem_create(OTTER_TEST_ALLOCATOR);
+  OTTER_ASSERT(filesystem != NULL);
+
+  logger = otter_logger_create(OTTER_TEST_ALLOCATOR, OTTER_LOG_LEVEL_ERROR);
+  OTTER_ASSERT(logger != NULL);
+
+  proc_mgr = otter_process_manager_create(OTTER_TEST_ALLOCATOR, logger);
+  OTTER_ASSERT(proc_mgr != NULL);
+
+  /* None of the views are NUL terminated where they end */
+  char buffer[] = "test.o test_fixtures/test.c -Wall -Iinclude";
+  const otter_string_view file = {.data = &buffer[7], .length = 20};
+  const otter_target_spec spec = {
+      .type = OTTER_TARGET_OBJECT,
+      .name = {.data = buffer, .length = 6},
+      .flags = {.data = &buffer[28], .length = 5},
+      .include_flags = {.data = &buffer[34], .length = 9},
+      .files = &file,
+      .files_length = 1,
+      .dependencies = NULL,
+  };
+
+  target = otter_target_create(&spec, OTTER_TEST_ALLOCATOR, filesystem,
+                               logger, proc_mgr);
+  OTTER_ASSERT(target != NULL);
+
+  /* The target must not keep pointing at the caller's buffer */
+  memset(buffer, 'x', sizeof(buffer) - 1);
+  OTTER_ASSERT(otter_string_compare_cstr(target->name, "test.o") == 0);
+  OTTER_ASSERT(OTTER_ARRAY_LENGTH(target, files) == 1);
+  OTTER_ASSERT(otter_string_compare_cstr(
+                   OTTER_ARRAY_AT_UNSAFE(target, files, 0),
+                   "test_fixtures/test.c") == 0);
+  OTTER_ASSERT(otter_string_compare_cstr(
+                   target->command, "cc -fPIC -c test_fixtures/test.c -o "
+                                    "test.o -Iinclude -Wall") == 0);
+
+  OTTER_TEST_END(if (target) otter_target_free(target);
+                 if (proc_mgr) otter_process_manager_free(proc_mgr);
+                 if (logger) otter_logger_free(logger);
+                 if (filesystem) otter_filesystem_free(filesystem););
+}
+
+OTTER_TEST(target_argv_skips_duplicates_past_set_threshold) {
+  otter_filesystem *filesystem = NULL;
+  otter_logger *logger = NULL;
+  otter_process_manager *proc_mgr = NULL;
+  otter_target *target = NULL;
+  otter_string *flags = NULL;
+
+  filesystem = otter_filesystem_create(OTTER_TEST_ALLOCATOR);
+  OTTER_ASSERT(filesystem != NULL);
+
+  logger = otter_logger_create(OTTER_TEST_ALLOCATOR, OTTER_LOG_LEVEL_ERROR);
+  OTTER_ASSERT(logger != NULL);
+
+  proc_mgr = otter_process_manager_create(OTTER_TEST_ALLOCATOR, logger);
+  OTTER_ASSERT(proc_mgr != NULL);
+
+  /* Every define is passed twice, the second round is looked up in the set */
+  const size_t define_count = 64;
+  otter_string_builder builder;
+  otter_string_builder_init(&builder, OTTER_TEST_ALLOCATOR);
+  for (size_t round = 0; round < 2; round++) {
+    for (size_t i = 0; i < define_count; i++) {
+      otter_string_builder_append_fmt(&builder, " -DFLAG_%zu", i);
+    }
+  }
+  flags = otter_string_builder_finish(&builder);
+  OTTER_ASSERT(flags != NULL);
+
+  const otter_string_view file =
+      otter_string_view_from_cstr("test_fixtures/test.c");
+  const otter_target_spec spec = {
+      .type = OTTER_TARGET_OBJECT,
+      .name = otter_string_view_from_cstr("test.o"),
+      .flags = otter_string_view_of(flags),
+      .include_flags = otter_string_view_from_cstr(""),
+      .files = &file,
+      .files_length = 1,
+      .dependencies = NULL,
+  };
+
+  target = otter_target_create(&spec, OTTER_TEST_ALLOCATOR, filesystem,
+                               logger, proc_mgr);
+  OTTER_ASSERT(target != NULL);
+
+  /* cc -fPIC -c test_fixtures/test.c -o test.o then each define once */
+  OTTER_ASSERT(OTTER_ARRAY_LENGTH(target, argv) == 6 + define_count);
+  OTTER_ASSERT(OTTER_MAP_LENGTH(target, argv_set) ==
+               OTTER_ARRAY_LENGTH(target, argv));
+
+  OTTER_TEST_END(if (target) otter_target_free(target);
+                 if (flags) otter_string_free(flags);
+                 if (proc_mgr) otter_process_manager_free(proc_mgr);
+                 if (logger) otter_logger_free(logger);
+                 if (filesystem) otter_filesystem_free(filesystem););
+}
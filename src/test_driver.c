@@ -15,6 +15,7 @@
   along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 #include "otter/allocator.h"
+#include "otter/allocator_stats.h"
 #include "otter/term_colors.h"
 #include "otter/test.h"
 #include <dlfcn.h>
@@ -38,13 +39,18 @@ static const char *license =
 
 static struct option long_opts[] = {{"list", no_argument, 0, 'l'},
                                     {"test", required_argument, 0, 't'},
+                                    {"stats", no_argument, 0, 's'},
                                     {"help", no_argument, 0, 'h'},
                                     {"license", no_argument, 0, 'L'},
                                     {0, 0, 0, 0}};
 
 static const char *opt_desc[] = {
-    "List available tests", "Run a single test by name", "Print this message",
-    "Show license information", ""};
+    "List available tests",
+    "Run a single test by name",
+    "Track allocations of each test, reporting totals and failing on leaks",
+    "Print this message",
+    "Show license information",
+    ""};
 
 static void print_usage(const char *program_name) {
   printf("Usage: %s [OPTIONS] <shared_object.so>\nOptions:\n", program_name);
@@ -58,19 +64,41 @@ static void print_usage(const char *program_name) {
 }
 
 static void run_test(void *handle, otter_allocator *allocator,
-                     const char *testname) {
+                     const char *testname, bool track_allocations) {
   otter_test_fn test_fn = dlsym(handle, testname);
   if (!test_fn) {
     fprintf(stderr, "dlsym '%s': %s\n", testname, dlerror());
     return;
   }
 
+  otter_allocator *stats = NULL;
+  if (track_allocations) {
+    stats = otter_allocator_stats_create(allocator, NULL);
+    if (stats == NULL) {
+      fprintf(stderr, "Unable to track allocations of '%s'\n", testname);
+      return;
+    }
+
+    allocator = stats;
+  }
+
   printf("Running " OTTER_TERM_CYAN("%s") "...\n", testname);
   otter_test_context ctx = {
       .allocator = allocator,
       .test_status = true,
   };
   bool passed = test_fn(&ctx);
+  if (stats != NULL) {
+    otter_allocator_stats totals;
+    otter_allocator_stats_get(stats, &totals);
+    otter_allocator_stats_report(stats, stdout);
+    if (totals.live_allocations != 0) {
+      passed = false;
+    }
+
+    otter_allocator_free(stats);
+  }
+
   if (passed) {
     printf(OTTER_TERM_GREEN("passed") "\n");
   } else {
@@ -89,9 +117,10 @@ int main(int argc, char *argv[]) {
   bool list_flag = false;
   bool show_license = false;
   bool show_help = false;
+  bool track_allocations = false;
   char *run_test_name = NULL;
 
-  while ((opt = getopt_long(argc, argv, "lt:hL", long_opts, NULL)) != -1) {
+  while ((opt = getopt_long(argc, argv, "lt:shL", long_opts, NULL)) != -1) {
     switch (opt) {
     case 'l':
       list_flag = true;
@@ -102,6 +131,9 @@ int main(int argc, char *argv[]) {
     case 't':
       run_test_name = optarg;
       break;
+    case 's':
+      track_allocations = true;
+      break;
     case 'h':
     default:
       show_help = true;
@@ -160,7 +192,7 @@ int main(int argc, char *argv[]) {
     for (int i = 0; i < count; ++i) {
       if (strcmp(testnames[i], run_test_name) == 0) {
         found = 1;
-        run_test(handle, allocator, testnames[i]);
+        run_test(handle, allocator, testnames[i], track_allocations);
         break;
       }
     }
@@ -169,7 +201,7 @@ int main(int argc, char *argv[]) {
     }
   } else {
     for (int i = 0; i < count; ++i) {
-      run_test(handle, allocator, testnames[i]);
+      run_test(handle, allocator, testnames[i], track_allocations);
     }
   }
 
@@ -0,0 +1,360 @@
+/*
+  otter Copyright (C) 2026 Nathaniel Wright
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "otter/thread_cache.h"
+#include <pthread.h>
+#include <stdalign.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#define OTTER_THREAD_CACHE_GRANULARITY alignof(max_align_t)
+#define OTTER_THREAD_CACHE_CLASSES_LENGTH                                      \
+  (OTTER_THREAD_CACHE_MAX_BLOCK_SIZE / OTTER_THREAD_CACHE_GRANULARITY)
+/* Size class recorded for blocks that come straight from the parent */
+#define OTTER_THREAD_CACHE_LARGE_CLASS OTTER_THREAD_CACHE_CLASSES_LENGTH
+#define OTTER_THREAD_CACHE_MAGAZINE_SIZE 64
+#define OTTER_THREAD_CACHE_SLAB_BLOCKS 128
+
+/* Blocks are freed without a size, so each one records its class */
+typedef struct otter_thread_cache_header {
+  alignas(max_align_t) size_t size_class;
+} otter_thread_cache_header;
+
+typedef struct otter_thread_cache_block otter_thread_cache_block;
+struct otter_thread_cache_block {
+  otter_thread_cache_block *next;
+};
+
+typedef struct otter_thread_cache_slab otter_thread_cache_slab;
+struct otter_thread_cache_slab {
+  otter_thread_cache_slab *next;
+  alignas(max_align_t) unsigned char data[];
+};
+
+typedef struct otter_thread_cache_magazine {
+  size_t length;
+  void *blocks[OTTER_THREAD_CACHE_MAGAZINE_SIZE];
+} otter_thread_cache_magazine;
+
+typedef struct otter_thread_cache otter_thread_cache;
+typedef struct otter_thread_cache_local otter_thread_cache_local;
+struct otter_thread_cache_local {
+  otter_thread_cache *owner;
+  otter_thread_cache_local *previous;
+  otter_thread_cache_local *next;
+  otter_thread_cache_magazine magazines[OTTER_THREAD_CACHE_CLASSES_LENGTH];
+};
+
+struct otter_thread_cache {
+  otter_allocator base;
+  otter_allocator *parent;
+  pthread_key_t key;
+  /* Everything below is shared between threads and guarded by lock */
+  pthread_mutex_t lock;
+  otter_thread_cache_block *depot[OTTER_THREAD_CACHE_CLASSES_LENGTH];
+  otter_thread_cache_slab *slabs;
+  otter_thread_cache_local *locals;
+};
+
+static size_t otter_thread_cache_class_size(size_t size_class) {
+  return (size_class + 1) * OTTER_THREAD_CACHE_GRANULARITY;
+}
+
+static size_t otter_thread_cache_stride(size_t size_class) {
+  return sizeof(otter_thread_cache_header) +
+         otter_thread_cache_class_size(size_class);
+}
+
+static otter_thread_cache_header *otter_thread_cache_header_of(void *pointer) {
+  return (otter_thread_cache_header *)pointer - 1;
+}
+
+static void otter_thread_cache_push(otter_thread_cache *cache,
+                                    size_t size_class, void *pointer) {
+  otter_thread_cache_block *block = pointer;
+  block->next = cache->depot[size_class];
+  cache->depot[size_class] = block;
+}
+
+/* Called with the lock held */
+static bool otter_thread_cache_add_slab(otter_thread_cache *cache,
+                                        size_t size_class) {
+  const size_t stride = otter_thread_cache_stride(size_class);
+  otter_thread_cache_slab *slab = otter_malloc(
+      cache->parent,
+      sizeof(*slab) + (stride * OTTER_THREAD_CACHE_SLAB_BLOCKS));
+  if (slab == NULL) {
+    return false;
+  }
+
+  slab->next = cache->slabs;
+  cache->slabs = slab;
+  for (size_t i = 0; i < OTTER_THREAD_CACHE_SLAB_BLOCKS; i++) {
+    otter_thread_cache_header *header =
+        (otter_thread_cache_header *)&slab->data[i * stride];
+    header->size_class = size_class;
+    otter_thread_cache_push(cache, size_class, header + 1);
+  }
+
+  return true;
+}
+
+static bool otter_thread_cache_refill(otter_thread_cache *cache,
+                                      otter_thread_cache_magazine *magazine,
+                                      size_t size_class) {
+  pthread_mutex_lock(&cache->lock);
+  if (cache->depot[size_class] == NULL &&
+      !otter_thread_cache_add_slab(cache, size_class)) {
+    pthread_mutex_unlock(&cache->lock);
+    return false;
+  }
+
+  while (magazine->length < OTTER_THREAD_CACHE_MAGAZINE_SIZE / 2 &&
+         cache->depot[size_class] != NULL) {
+    otter_thread_cache_block *block = cache->depot[size_class];
+    cache->depot[size_class] = block->next;
+    magazine->blocks[magazine->length++] = block;
+  }
+
+  pthread_mutex_unlock(&cache->lock);
+  return true;
+}
+
+static void otter_thread_cache_flush(otter_thread_cache *cache,
+                                     otter_thread_cache_magazine *magazine,
+                                     size_t size_class, size_t keep) {
+  pthread_mutex_lock(&cache->lock);
+  while (magazine->length > keep) {
+    otter_thread_cache_push(cache, size_class,
+                            magazine->blocks[--magazine->length]);
+  }
+
+  pthread_mutex_unlock(&cache->lock);
+}
+
+/* Runs when a thread exits and returns its blocks to the depot */
+static void otter_thread_cache_local_destroy(void *value) {
+  otter_thread_cache_local *local = value;
+  otter_thread_cache *cache = local->owner;
+  pthread_mutex_lock(&cache->lock);
+  for (size_t i = 0; i < OTTER_THREAD_CACHE_CLASSES_LENGTH; i++) {
+    otter_thread_cache_magazine *magazine = &local->magazines[i];
+    while (magazine->length > 0) {
+      otter_thread_cache_push(cache, i, magazine->blocks[--magazine->length]);
+    }
+  }
+
+  if (local->previous != NULL) {
+    local->previous->next = local->next;
+  } else {
+    cache->locals = local->next;
+  }
+
+  if (local->next != NULL) {
+    local->next->previous = local->previous;
+  }
+
+  pthread_mutex_unlock(&cache->lock);
+  otter_free(cache->parent, local);
+}
+
+static otter_thread_cache_local *
+otter_thread_cache_local_get(otter_thread_cache *cache) {
+  otter_thread_cache_local *local = pthread_getspecific(cache->key);
+  if (local != NULL) {
+    return local;
+  }
+
+  local = otter_malloc(cache->parent, sizeof(*local));
+  if (local == NULL) {
+    return NULL;
+  }
+
+  memset(local, 0, sizeof(*local));
+  local->owner = cache;
+  if (pthread_setspecific(cache->key, local) != 0) {
+    otter_free(cache->parent, local);
+    return NULL;
+  }
+
+  pthread_mutex_lock(&cache->lock);
+  local->next = cache->locals;
+  if (cache->locals != NULL) {
+    cache->locals->previous = local;
+  }
+
+  cache->locals = local;
+  pthread_mutex_unlock(&cache->lock);
+  return local;
+}
+
+static void *otter_thread_cache_malloc_impl(otter_allocator *allocator,
+                                            size_t size) {
+  otter_thread_cache *cache = (otter_thread_cache *)allocator;
+  if (size > OTTER_THREAD_CACHE_MAX_BLOCK_SIZE) {
+    if (size > SIZE_MAX - sizeof(otter_thread_cache_header)) {
+      return NULL;
+    }
+
+    otter_thread_cache_header *header =
+        otter_malloc(cache->parent, sizeof(*header) + size);
+    if (header == NULL) {
+      return NULL;
+    }
+
+    header->size_class = OTTER_THREAD_CACHE_LARGE_CLASS;
+    return header + 1;
+  }
+
+  otter_thread_cache_local *local = otter_thread_cache_local_get(cache);
+  if (local == NULL) {
+    return NULL;
+  }
+
+  const size_t size_class =
+      size == 0 ? 0 : (size - 1) / OTTER_THREAD_CACHE_GRANULARITY;
+  otter_thread_cache_magazine *magazine = &local->magazines[size_class];
+  if (magazine->length == 0 &&
+      !otter_thread_cache_refill(cache, magazine, size_class)) {
+    return NULL;
+  }
+
+  return magazine->blocks[--magazine->length];
+}
+
+static void otter_thread_cache_free_impl(otter_allocator *allocator,
+                                         void *pointer) {
+  otter_thread_cache *cache = (otter_thread_cache *)allocator;
+  if (pointer == NULL) {
+    return;
+  }
+
+  otter_thread_cache_header *header = otter_thread_cache_header_of(pointer);
+  const size_t size_class = header->size_class;
+  if (size_class == OTTER_THREAD_CACHE_LARGE_CLASS) {
+    otter_free(cache->parent, header);
+    return;
+  }
+
+  otter_thread_cache_local *local = otter_thread_cache_local_get(cache);
+  if (local == NULL) {
+    pthread_mutex_lock(&cache->lock);
+    otter_thread_cache_push(cache, size_class, pointer);
+    pthread_mutex_unlock(&cache->lock);
+    return;
+  }
+
+  otter_thread_cache_magazine *magazine = &local->magazines[size_class];
+  if (magazine->length == OTTER_THREAD_CACHE_MAGAZINE_SIZE) {
+    otter_thread_cache_flush(cache, magazine, size_class,
+                             OTTER_THREAD_CACHE_MAGAZINE_SIZE / 2);
+  }
+
+  magazine->blocks[magazine->length++] = pointer;
+}
+
+static void *otter_thread_cache_realloc_impl(otter_allocator *allocator,
+                                             void *pointer, size_t size) {
+  otter_thread_cache *cache = (otter_thread_cache *)allocator;
+  if (pointer == NULL) {
+    return otter_thread_cache_malloc_impl(allocator, size);
+  }
+
+  otter_thread_cache_header *header = otter_thread_cache_header_of(pointer);
+  size_t old_size = SIZE_MAX;
+  if (header->size_class == OTTER_THREAD_CACHE_LARGE_CLASS) {
+    if (size > OTTER_THREAD_CACHE_MAX_BLOCK_SIZE) {
+      if (size > SIZE_MAX - sizeof(*header)) {
+        return NULL;
+      }
+
+      otter_thread_cache_header *resized =
+          otter_realloc(cache->parent, header, sizeof(*header) + size);
+      return resized != NULL ? resized + 1 : NULL;
+    }
+  } else {
+    old_size = otter_thread_cache_class_size(header->size_class);
+    if (size <= old_size && size > old_size / 2) {
+      return pointer;
+    }
+  }
+
+  void *resized = otter_thread_cache_malloc_impl(allocator, size);
+  if (resized == NULL) {
+    return NULL;
+  }
+
+  /* A large block only moves into a size class when it shrinks, so the new
+   * size is the smaller one */
+  memcpy(resized, pointer, size < old_size ? size : old_size);
+  otter_thread_cache_free_impl(allocator, pointer);
+  return resized;
+}
+
+static void otter_thread_cache_free_allocator_impl(otter_allocator *allocator) {
+  otter_thread_cache *cache = (otter_thread_cache *)allocator;
+  pthread_key_delete(cache->key);
+  while (cache->locals != NULL) {
+    otter_thread_cache_local *local = cache->locals;
+    cache->locals = local->next;
+    otter_free(cache->parent, local);
+  }
+
+  while (cache->slabs != NULL) {
+    otter_thread_cache_slab *slab = cache->slabs;
+    cache->slabs = slab->next;
+    otter_free(cache->parent, slab);
+  }
+
+  pthread_mutex_destroy(&cache->lock);
+  otter_free(cache->parent, cache);
+}
+
+otter_allocator *otter_thread_cache_create(otter_allocator *parent) {
+  if (parent == NULL || !otter_allocator_thread_safe(parent)) {
+    return NULL;
+  }
+
+  otter_thread_cache *cache = otter_malloc(parent, sizeof(*cache));
+  if (cache == NULL) {
+    return NULL;
+  }
+
+  static otter_allocator_vtable vtable = {
+      .free_allocator = otter_thread_cache_free_allocator_impl,
+      .malloc = otter_thread_cache_malloc_impl,
+      .realloc = otter_thread_cache_realloc_impl,
+      .free = otter_thread_cache_free_impl,
+      .capabilities = OTTER_ALLOCATOR_THREAD_SAFE,
+  };
+
+  memset(cache, 0, sizeof(*cache));
+  cache->base.vtable = &vtable;
+  cache->parent = parent;
+  if (pthread_key_create(&cache->key, otter_thread_cache_local_destroy) != 0) {
+    otter_free(parent, cache);
+    return NULL;
+  }
+
+  if (pthread_mutex_init(&cache->lock, NULL) != 0) {
+    pthread_key_delete(cache->key);
+    otter_free(parent, cache);
+    return NULL;
+  }
+
+  return (otter_allocator *)cache;
+}
@@ -27,7 +27,10 @@ void otter_token_free(otter_allocator *allocator, otter_token *token) {
 
   switch (token->type) {
   case OTTER_TOKEN_IDENTIFIER:
-    otter_free(allocator, ((otter_token_identifier *)token)->value);
+    /* Interned names belong to the intern table */
+    if (((otter_token_identifier *)token)->interned == NULL) {
+      otter_free(allocator, ((otter_token_identifier *)token)->value);
+    }
     /* fallthrough */
   default:
     otter_free(allocator, token);
@@ -15,6 +15,7 @@
   along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 #include "otter/vm.h"
+#include "otter/pool.h"
 #include <stdint.h>
 
 #define OTTER_VM_STACK_SIZE 1024
@@ -38,11 +39,21 @@ otter_vm *otter_vm_create(otter_allocator *allocator, otter_bytecode *bytecode,
   virtual_machine->objects = NULL;
 
   const size_t stack_size = sizeof(otter_object *) * OTTER_VM_STACK_SIZE;
-  virtual_machine->stack = otter_malloc(allocator, stack_size);
+  virtual_machine->stack =
+      otter_aligned_malloc(allocator, OTTER_CACHE_LINE_SIZE, stack_size);
   if (virtual_machine->stack == NULL) {
     otter_log_critical(logger, "Unable to allocate %zd bytes for %s",
                        stack_size, OTTER_NAMEOF(virtual_machine->stack));
-    otter_free(allocator, virtual_machine);
+    otter_free_sized(allocator, virtual_machine, sizeof(*virtual_machine));
+    return NULL;
+  }
+
+  virtual_machine->object_allocator = otter_pool_create(allocator);
+  if (virtual_machine->object_allocator == NULL) {
+    otter_log_critical(logger, "Unable to create %s",
+                       OTTER_NAMEOF(virtual_machine->object_allocator));
+    otter_free_sized(allocator, virtual_machine->stack, stack_size);
+    otter_free_sized(allocator, virtual_machine, sizeof(*virtual_machine));
     return NULL;
   }
 
@@ -50,16 +61,13 @@ otter_vm *otter_vm_create(otter_allocator *allocator, otter_bytecode *bytecode,
 }
 
 void otter_vm_free(otter_vm *virtual_machine) {
-  /* Free all objects in the linked list */
-  otter_object *current = virtual_machine->objects;
-  while (current != NULL) {
-    otter_object *next = current->next;
-    otter_free(virtual_machine->allocator, current);
-    current = next;
-  }
-
-  otter_free(virtual_machine->allocator, virtual_machine->stack);
-  otter_free(virtual_machine->allocator, virtual_machine);
+  /* Every object lives in the pool, so the slabs are released together
+   * instead of walking the object list */
+  otter_allocator_free(virtual_machine->object_allocator);
+  otter_free_sized(virtual_machine->allocator, virtual_machine->stack,
+                   sizeof(otter_object *) * OTTER_VM_STACK_SIZE);
+  otter_free_sized(virtual_machine->allocator, virtual_machine,
+                   sizeof(*virtual_machine));
 }
 
 OTTER_DEFINE_TRIVIAL_CLEANUP_FUNC(otter_vm *, otter_vm_free);
@@ -67,7 +75,7 @@ OTTER_DEFINE_TRIVIAL_CLEANUP_FUNC(otter_vm *, otter_vm_free);
 /* Allocate an object and add it to the VM's object list */
 static inline otter_object *vm_allocate_object(otter_vm *virtual_machine,
                                                size_t size) {
-  otter_object *obj = otter_malloc(virtual_machine->allocator, size);
+  otter_object *obj = otter_malloc(virtual_machine->object_allocator, size);
   obj->next = virtual_machine->objects;
   virtual_machine->objects = obj;
   return obj;
@@ -71,7 +71,6 @@ int main(void) {
   }
 
   /* Cleanup */
-  otter_free(allocator, virtual_machine->stack[0]);
   otter_free(allocator, const1);
   otter_free(allocator, const2);
   otter_vm_free(virtual_machine);